@@ -1,7 +1,11 @@
 #include <iostream>
 #include <vector>
 #include <vulkan/vulkan.h>
-#include <dlfcn.h>
+#include "frame_scheduler.h"
+#include "timeline_queue.h"
+#include "offscreen_swapchain.h"
+#include "sample_options.h"
+#include <chrono>
 #include <cstring>
 
 struct WindowParameters{
@@ -21,23 +25,6 @@ struct QueueInfo {
     std::vector<float> Priorities;
 };
 
-struct WaitSemaphoreInfo{
-    VkSemaphore semaphore;
-    VkPipelineStageFlags waitingstage;
-};
-
-void *load_vulkan_library(){
-    void *vulkan_library = dlopen("libvulkan.so.1", RTLD_NOW);
-    if (vulkan_library == nullptr){
-        std::cout << "Could not connect with a Vulkan Runtime library." <<
-                  std::endl;
-        return nullptr;
-    }
-    std::cout << "Connect with a Vulkan Runtime library successfully." <<
-              std::endl;
-    return vulkan_library;
-}
-
 void init_window(struct WindowParameters &info) {
     uint32_t width{64};
     uint32_t height{64};
@@ -78,46 +65,30 @@ void init_window(struct WindowParameters &info) {
     }
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    SampleOptions options;
+    if (!parse_sample_options(argc, argv, options)){
+        return -1;
+    }
+    PresentationMode presentation = options.presentation;
+    bool capturing = !options.capture_basename.empty();
+
     // Load vulkan library
     void *vulkan_library = load_vulkan_library();
-    auto vkGetInstanceProcAddr = reinterpret_cast<PFN_vkGetInstanceProcAddr>(dlsym(vulkan_library, "vkGetInstanceProcAddr"));
+    auto vkGetInstanceProcAddr = load_exported_vulkan_function(vulkan_library);
     if (vkGetInstanceProcAddr == nullptr){
-        std::cout << "Could not find vkGetInstanceProcAddr in Vulkan Runtime library.\n";
         return -1;
     }
     /// Load Global Level Functions
-    PFN_vkEnumerateInstanceExtensionProperties vkEnumerateInstanceExtensionProperties{};
-    if (vkGetInstanceProcAddr != nullptr){
-        vkEnumerateInstanceExtensionProperties =
-                reinterpret_cast<PFN_vkEnumerateInstanceExtensionProperties>(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceExtensionProperties"));
-        if (vkEnumerateInstanceExtensionProperties == nullptr){
-            std::cout << "Could not load global level Vulkan function named: vkEnumerateInstanceExtensionProperties." << std::endl;
-            return -1;
-        }
-    }
-    PFN_vkEnumerateInstanceLayerProperties  vkEnumerateInstanceLayerProperties;
-    if (vkGetInstanceProcAddr != nullptr){
-        vkEnumerateInstanceLayerProperties =
-                reinterpret_cast< PFN_vkEnumerateInstanceLayerProperties >(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceLayerProperties"));
-        if (vkEnumerateInstanceLayerProperties == nullptr){
-            std::cout << "Could not load global level Vulkan function named: vkEnumerateInstanceLayerProperties." << std::endl;
-            return 1;
-        }
-    }
-    PFN_vkCreateInstance vkCreateInstance;
-    if (vkGetInstanceProcAddr != nullptr){
-        vkCreateInstance = reinterpret_cast<PFN_vkCreateInstance>(vkGetInstanceProcAddr(nullptr, "vkCreateInstance"));
-        if (vkCreateInstance == nullptr){
-            std::cout << "Could not load global level Vulkan function named: vkCreateInstance." << std::endl;
-            return -1;
-        }
+    GlobalFunctions global_functions{};
+    if (!load_global_level_functions(vkGetInstanceProcAddr, global_functions)){
+        return -1;
     }
 
     // Get available_extensions
     uint32_t extensions_count{};
-    if (vkEnumerateInstanceExtensionProperties != nullptr) {
-        VkResult result = vkEnumerateInstanceExtensionProperties(nullptr, &extensions_count, nullptr);
+    if (global_functions.vkEnumerateInstanceExtensionProperties != nullptr) {
+        VkResult result = global_functions.vkEnumerateInstanceExtensionProperties(nullptr, &extensions_count, nullptr);
         if( (result != VK_SUCCESS) || (extensions_count == 0)) {
             std::cout << "Could not get the number of Instance extensions." <<
                       std::endl;
@@ -125,8 +96,8 @@ int main() {
         }
     }
     std::vector<VkExtensionProperties> available_extensions(extensions_count);
-    if (vkEnumerateInstanceExtensionProperties != nullptr) {
-        VkResult result = vkEnumerateInstanceExtensionProperties(nullptr, &extensions_count, available_extensions.data());
+    if (global_functions.vkEnumerateInstanceExtensionProperties != nullptr) {
+        VkResult result = global_functions.vkEnumerateInstanceExtensionProperties(nullptr, &extensions_count, available_extensions.data());
         if ((result != VK_SUCCESS) || (extensions_count == 0)) {
             std::cout << "Could not enumerate Instance extensions." << std::endl;
             return -1;
@@ -134,7 +105,7 @@ int main() {
     }
 
     // Get desired_extensions
-    std::vector<char const *> desired_extensions{VK_KHR_SURFACE_EXTENSION_NAME, VK_KHR_XCB_SURFACE_EXTENSION_NAME};
+    std::vector<char const *> desired_extensions = presentation_instance_extensions(presentation);
     for (auto &extension: desired_extensions) {
         bool b_found{false};
         for (auto available : available_extensions) {
@@ -149,6 +120,8 @@ int main() {
             return -1;
         }
     }
+    // Timeline semaphores and synchronization2 depend on it on a 1.0 instance
+    bool physical_device_properties2_enabled = enable_physical_device_properties2(available_extensions, desired_extensions);
 
     // create a vulkan instance with WSI extensions enabled
     VkApplicationInfo application_info;
@@ -171,8 +144,8 @@ int main() {
     instance_create_info.ppEnabledExtensionNames = desired_extensions.empty() ? nullptr : desired_extensions.data();
 
     VkInstance instance{};
-    if (vkCreateInstance != nullptr){
-        VkResult result = vkCreateInstance(&instance_create_info, nullptr, &instance);
+    if (global_functions.vkCreateInstance != nullptr){
+        VkResult result = global_functions.vkCreateInstance(&instance_create_info, nullptr, &instance);
         if( (result != VK_SUCCESS) || (instance == VK_NULL_HANDLE) ) {
             std::cout << "Could not create Vulkan Instance." << std::endl;
             return -1;
@@ -180,119 +153,68 @@ int main() {
     }
 
     /// Load instance level function
-    PFN_vkCreateXcbSurfaceKHR vkCreateXcbSurfaceKHR;
-    vkCreateXcbSurfaceKHR =
-            reinterpret_cast<PFN_vkCreateXcbSurfaceKHR>(vkGetInstanceProcAddr(instance, "vkCreateXcbSurfaceKHR"));
-    if (vkCreateXcbSurfaceKHR == nullptr){
-        std::cout << "Could not load instance level Vulkan function named: vkCreateXcbSurfaceKHR." << std::endl;
-        return 1;
-    }
-    PFN_vkEnumeratePhysicalDevices vkEnumeratePhysicalDevices;
-    vkEnumeratePhysicalDevices =
-            reinterpret_cast<PFN_vkEnumeratePhysicalDevices>(vkGetInstanceProcAddr(instance, "vkEnumeratePhysicalDevices"));
-    PFN_vkGetPhysicalDeviceProperties vkGetPhysicalDeviceProperties;
-    vkGetPhysicalDeviceProperties =
-            reinterpret_cast<PFN_vkGetPhysicalDeviceProperties>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties"));
-    PFN_vkGetPhysicalDeviceFeatures vkGetPhysicalDeviceFeatures;
-    vkGetPhysicalDeviceFeatures =
-            reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures"));
-    PFN_vkCreateDevice vkCreateDevice;
-    vkCreateDevice =
-            reinterpret_cast<PFN_vkCreateDevice>(vkGetInstanceProcAddr(instance, "vkCreateDevice"));
-    PFN_vkDestroyInstance vkDestroyInstance;
-    vkDestroyInstance =
-            reinterpret_cast<PFN_vkDestroyInstance>(vkGetInstanceProcAddr(instance, "vkDestroyInstance"));
-    PFN_vkGetDeviceProcAddr vkGetDeviceProcAddr;
-    vkGetDeviceProcAddr =
-            reinterpret_cast<PFN_vkGetDeviceProcAddr>(vkGetInstanceProcAddr(instance, "vkGetDeviceProcAddr"));
-    // Load physical device extension function
-    PFN_vkGetPhysicalDeviceSurfaceSupportKHR vkGetPhysicalDeviceSurfaceSupportKHR;
-    PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR vkGetPhysicalDeviceSurfaceCapabilitiesKHR;
-    PFN_vkGetPhysicalDeviceSurfaceFormatsKHR vkGetPhysicalDeviceSurfaceFormatsKHR;
-    for( auto & enabled_extension : desired_extensions ) {
-        if( std::string( enabled_extension ) == std::string( VK_KHR_SURFACE_EXTENSION_NAME ) ) {
-            vkGetPhysicalDeviceSurfaceSupportKHR = (PFN_vkGetPhysicalDeviceSurfaceSupportKHR)vkGetInstanceProcAddr( instance, "vkGetPhysicalDeviceSurfaceSupportKHR" );
-            if( vkGetPhysicalDeviceSurfaceSupportKHR == nullptr ) {
-                std::cout << "Could not load instance-level Vulkan function named: vkGetPhysicalDeviceSurfaceSupportKHR" << std::endl;
-                return -1;
-            }
-            vkGetPhysicalDeviceSurfaceCapabilitiesKHR = (PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR)vkGetInstanceProcAddr( instance, "vkGetPhysicalDeviceSurfaceCapabilitiesKHR" );
-            if( vkGetPhysicalDeviceSurfaceCapabilitiesKHR == nullptr ) {
-                std::cout << "Could not load instance-level Vulkan function named: vkGetPhysicalDeviceSurfaceCapabilitiesKHR" << std::endl;
-                return -1;
-            }
-            vkGetPhysicalDeviceSurfaceFormatsKHR = (PFN_vkGetPhysicalDeviceSurfaceFormatsKHR)vkGetInstanceProcAddr( instance, "vkGetPhysicalDeviceSurfaceFormatsKHR" );
-            if( vkGetPhysicalDeviceSurfaceFormatsKHR == nullptr ) {
-                std::cout << "Could not load instance-level Vulkan function named: vkGetPhysicalDeviceSurfaceFormatsKHR" << std::endl;
-                return -1;
-            }
-        }
-    }
-
-    PFN_vkEnumerateDeviceExtensionProperties vkEnumerateDeviceExtensionProperties;
-    vkEnumerateDeviceExtensionProperties =
-            reinterpret_cast<PFN_vkEnumerateDeviceExtensionProperties>(vkGetInstanceProcAddr(instance, "vkEnumerateDeviceExtensionProperties"));
-    PFN_vkGetPhysicalDeviceQueueFamilyProperties vkGetPhysicalDeviceQueueFamilyProperties;
-    vkGetPhysicalDeviceQueueFamilyProperties =
-            reinterpret_cast<PFN_vkGetPhysicalDeviceQueueFamilyProperties>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceQueueFamilyProperties"));
-    PFN_vkGetPhysicalDeviceSurfacePresentModesKHR vkGetPhysicalDeviceSurfacePresentModesKHR;
-    vkGetPhysicalDeviceSurfacePresentModesKHR =
-            reinterpret_cast<PFN_vkGetPhysicalDeviceSurfacePresentModesKHR>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceSurfacePresentModesKHR"));
-    if (vkGetPhysicalDeviceSurfacePresentModesKHR == nullptr){
-        std::cout << "Could not load device-level Vulkan function named: vkGetPhysicalDeviceSurfacePresentModesKHR" << std::endl;
-        return -1;
-    }
-    PFN_vkDestroySurfaceKHR vkDestroySurfaceKHR;
-    vkDestroySurfaceKHR =
-            reinterpret_cast<PFN_vkDestroySurfaceKHR>(vkGetInstanceProcAddr(instance, "vkDestroySurfaceKHR"));
-    if (vkDestroySurfaceKHR == nullptr){
-        std::cout << "Could not load device-level Vulkan function named: vkDestroySurfaceKHR" << std::endl;
-        return -1;
-    }
-
-    // create a presentation surface
-    int nScreenNum = 0;
-    WindowParameters window_parameters{};
-    window_parameters.connection = xcb_connect(nullptr, &nScreenNum);
-    if (window_parameters.connection == nullptr || xcb_connection_has_error(window_parameters.connection)) {
-        std::cout << "Unable to make an XCB connection\n";
+    InstanceFunctions instance_functions{};
+    if (!load_instance_level_functions(vkGetInstanceProcAddr, instance, desired_extensions, instance_functions)){
         return -1;
     }
-    const xcb_setup_t *setup;
-    xcb_screen_iterator_t iter;
-
-    setup = xcb_get_setup(window_parameters.connection);
-    iter = xcb_setup_roots_iterator(setup);
-    while (nScreenNum-- > 0){
-        xcb_screen_next(&iter);
-    }
-    window_parameters.screen = iter.data;
-    window_parameters.window = xcb_generate_id(window_parameters.connection);
-    init_window(window_parameters);
-
-    VkXcbSurfaceCreateInfoKHR surface_create_info;
-    surface_create_info.sType = VK_STRUCTURE_TYPE_XCB_SURFACE_CREATE_INFO_KHR;
-    surface_create_info.pNext = nullptr;
-    surface_create_info.flags = 0;
-    surface_create_info.connection = window_parameters.connection;
-    surface_create_info.window = window_parameters.window;
 
+    // create a presentation surface; offscreen rendering needs none
     VkSurfaceKHR presentation_surface{VK_NULL_HANDLE};
-    VkResult result = vkCreateXcbSurfaceKHR(instance, &surface_create_info, nullptr, &presentation_surface);
-    if( (VK_SUCCESS != result) || (VK_NULL_HANDLE == presentation_surface) ) {
-        std::cout << "Could not create presentation surface." << std::endl;
-        return -1;
+    VkResult result{VK_SUCCESS};
+    if (presentation == PresentationMode::Window) {
+        int nScreenNum = 0;
+        WindowParameters window_parameters{};
+        window_parameters.connection = xcb_connect(nullptr, &nScreenNum);
+        if (window_parameters.connection == nullptr || xcb_connection_has_error(window_parameters.connection)) {
+            std::cout << "Unable to make an XCB connection\n";
+            return -1;
+        }
+        const xcb_setup_t *setup;
+        xcb_screen_iterator_t iter;
+
+        setup = xcb_get_setup(window_parameters.connection);
+        iter = xcb_setup_roots_iterator(setup);
+        while (nScreenNum-- > 0){
+            xcb_screen_next(&iter);
+        }
+        window_parameters.screen = iter.data;
+        window_parameters.window = xcb_generate_id(window_parameters.connection);
+        init_window(window_parameters);
+
+        VkXcbSurfaceCreateInfoKHR surface_create_info;
+        surface_create_info.sType = VK_STRUCTURE_TYPE_XCB_SURFACE_CREATE_INFO_KHR;
+        surface_create_info.pNext = nullptr;
+        surface_create_info.flags = 0;
+        surface_create_info.connection = window_parameters.connection;
+        surface_create_info.window = window_parameters.window;
+
+        result = instance_functions.vkCreateXcbSurfaceKHR(instance, &surface_create_info, nullptr, &presentation_surface);
+        if( (VK_SUCCESS != result) || (VK_NULL_HANDLE == presentation_surface) ) {
+            std::cout << "Could not create presentation surface." << std::endl;
+            return -1;
+        }
+    } else if (presentation == PresentationMode::HeadlessSurface) {
+        VkHeadlessSurfaceCreateInfoEXT headless_surface_create_info = {
+                VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT,
+                nullptr,
+                0
+        };
+        result = instance_functions.vkCreateHeadlessSurfaceEXT(instance, &headless_surface_create_info, nullptr, &presentation_surface);
+        if( (VK_SUCCESS != result) || (VK_NULL_HANDLE == presentation_surface) ) {
+            std::cout << "Could not create headless surface." << std::endl;
+            return -1;
+        }
     }
 
     //Get physical device
     uint32_t devices_count{0};
-    result = vkEnumeratePhysicalDevices(instance, &devices_count, nullptr);
+    result = instance_functions.vkEnumeratePhysicalDevices(instance, &devices_count, nullptr);
     if( (result != VK_SUCCESS) || (devices_count == 0) ) {
         std::cout << "Could not get the number of available physical devices." << std::endl;
         return -1;
     }
     std::vector<VkPhysicalDevice> physical_devices(devices_count);
-    result = vkEnumeratePhysicalDevices(instance, &devices_count, physical_devices.data());
+    result = instance_functions.vkEnumeratePhysicalDevices(instance, &devices_count, physical_devices.data());
     if( (result != VK_SUCCESS) || (devices_count == 0) ) {
         std::cout << "Could not enumerate physical devices." << std::endl;
         return -1;
@@ -300,13 +222,13 @@ int main() {
     // select a queue family that supports presentation to a given surface
     for (auto physical_device : physical_devices) {
         uint32_t queue_families_count;
-        vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, nullptr);
+        instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, nullptr);
         if( queue_families_count == 0 ) {
             std::cout << "Could not get the number of queue families." << std::endl;
             return -1;
         }
         std::vector<VkQueueFamilyProperties> queue_families(queue_families_count);
-        vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, queue_families.data());
+        instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, queue_families.data());
         if( queue_families_count == 0 ) {
             std::cout << "Could not acquire properties of queue families." << std::endl;
             return -1;
@@ -327,11 +249,12 @@ int main() {
         }
 
         //Selecting the index of a queue family with the desired capabilities PresentationSurface
-        uint32_t PresentQueueFamilyIndex;
-        b_found = false;
-        for( uint32_t index = 0; index < static_cast<uint32_t>(queue_families.size()); ++index ) {
+        // Without a surface the graphics queue stands in for the present queue
+        uint32_t PresentQueueFamilyIndex = GraphicsQueueFamilyIndex;
+        b_found = presentation_surface == VK_NULL_HANDLE;
+        for( uint32_t index = 0; !b_found && index < static_cast<uint32_t>(queue_families.size()); ++index ) {
             VkBool32 presentation_supported = VK_FALSE;
-            result = vkGetPhysicalDeviceSurfaceSupportKHR( physical_device, index, presentation_surface, &presentation_supported );
+            result = instance_functions.vkGetPhysicalDeviceSurfaceSupportKHR( physical_device, index, presentation_surface, &presentation_supported );
             if( (VK_SUCCESS == result) && (VK_TRUE == presentation_supported) ) {
                 PresentQueueFamilyIndex = index;
                 b_found = true;
@@ -351,20 +274,23 @@ int main() {
         //Creating a logical device with WSI extensions enabled
         // physical device extension properties
         uint32_t DeviceExtensionProperties_extensions_count = 0;
-        result = vkEnumerateDeviceExtensionProperties( physical_device, nullptr,
-                                                       &DeviceExtensionProperties_extensions_count, nullptr );
+        result = instance_functions.vkEnumerateDeviceExtensionProperties( physical_device, nullptr,
+                                                                          &DeviceExtensionProperties_extensions_count, nullptr );
         if( (result != VK_SUCCESS) || (DeviceExtensionProperties_extensions_count == 0) ) {
             std::cout << "Could not get the number of device extensions." << std::endl;
             return -1;
         }
         std::vector<VkExtensionProperties> available_extensions_DeviceExtensionProperties(DeviceExtensionProperties_extensions_count);
-        result = vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &DeviceExtensionProperties_extensions_count, available_extensions_DeviceExtensionProperties.data());
+        result = instance_functions.vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &DeviceExtensionProperties_extensions_count, available_extensions_DeviceExtensionProperties.data());
         if( (result != VK_SUCCESS) || (extensions_count == 0) ) {
             std::cout << "Could not enumerate device extensions." << std::endl;
             return -1;
         }
         // physical device desired extensions
-        std::vector<char const *> desired_extensions_DeviceExtensionProperties{VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+        std::vector<char const *> desired_extensions_DeviceExtensionProperties;
+        if (uses_swapchain(presentation)) {
+            desired_extensions_DeviceExtensionProperties.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+        }
         for (auto &extension: desired_extensions_DeviceExtensionProperties) {
             bool b_found_extensions{false};
             for (auto available : available_extensions_DeviceExtensionProperties) {
@@ -379,6 +305,13 @@ int main() {
                 return -1;
             }
         }
+        // Timeline semaphores are optional; without them frame completion is
+        // tracked with fences
+        bool use_timeline_semaphore = physical_device_properties2_enabled &&
+                                      timeline_semaphore_supported(available_extensions_DeviceExtensionProperties);
+        if (use_timeline_semaphore) {
+            desired_extensions_DeviceExtensionProperties.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+        }
 
         // Creating a device queue create info
         std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
@@ -396,8 +329,8 @@ int main() {
         //Getting features and properties of a physical device
         VkPhysicalDeviceFeatures device_features;
         VkPhysicalDeviceProperties device_properties;
-        vkGetPhysicalDeviceFeatures(physical_device, &device_features);
-        vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+        instance_functions.vkGetPhysicalDeviceFeatures(physical_device, &device_features);
+        instance_functions.vkGetPhysicalDeviceProperties(physical_device, &device_properties);
 
         if (device_features.geometryShader){
             device_features = {};   // keep only geometryShader of device_features
@@ -407,9 +340,14 @@ int main() {
         }
 
         // Creating a logical device
+        VkPhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_features = {
+                VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES,
+                nullptr,
+                VK_TRUE
+        };
         VkDeviceCreateInfo device_create_info;
         device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-        device_create_info.pNext = nullptr;
+        device_create_info.pNext = use_timeline_semaphore ? &timeline_semaphore_features : nullptr;
         device_create_info.flags = 0;
         device_create_info.queueCreateInfoCount = queue_create_infos.size();
         device_create_info.pQueueCreateInfos = queue_create_infos.data();
@@ -419,537 +357,353 @@ int main() {
         device_create_info.ppEnabledExtensionNames = desired_extensions_DeviceExtensionProperties.empty() ? nullptr : desired_extensions_DeviceExtensionProperties.data();
         device_create_info.pEnabledFeatures = &device_features;
         VkDevice logical_device;
-        result = vkCreateDevice(physical_device, &device_create_info, nullptr, &logical_device);
+        result = instance_functions.vkCreateDevice(physical_device, &device_create_info, nullptr, &logical_device);
         if( (result != VK_SUCCESS) || (logical_device == VK_NULL_HANDLE) ) {
             std::cout << "Could not create logical device." << std::endl;
             return -1;
         }
         // Load device level functions
-        PFN_vkGetDeviceQueue vkGetDeviceQueue;
-        vkGetDeviceQueue =
-                reinterpret_cast<PFN_vkGetDeviceQueue>(vkGetDeviceProcAddr(logical_device, "vkGetDeviceQueue"));
-        if( vkGetDeviceQueue == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkGetDeviceQueue." << std::endl;
-            return -1;
-        }
-        PFN_vkDeviceWaitIdle vkDeviceWaitIdle;
-        vkDeviceWaitIdle =
-                reinterpret_cast<PFN_vkDeviceWaitIdle>(vkGetDeviceProcAddr(logical_device, "vkDeviceWaitIdle"));
-        if( vkDeviceWaitIdle == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkDeviceWaitIdle." << std::endl;
-            return -1;
-        }
-        PFN_vkDestroyDevice vkDestroyDevice;
-        vkDestroyDevice =
-                reinterpret_cast<PFN_vkDestroyDevice>(vkGetDeviceProcAddr(logical_device, "vkDestroyDevice"));
-        if( vkDestroyDevice == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkDestroyDevice." << std::endl;
-            return -1;
-        }
-        PFN_vkCreateBuffer vkCreateBuffer;
-        vkCreateBuffer =
-                reinterpret_cast<PFN_vkCreateBuffer>(vkGetDeviceProcAddr(logical_device, "vkCreateBuffer"));
-        if( vkCreateBuffer == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCreateBuffer." << std::endl;
-            return -1;
-        }
-        PFN_vkGetBufferMemoryRequirements vkGetBufferMemoryRequirements;
-        vkGetBufferMemoryRequirements =
-                reinterpret_cast<PFN_vkGetBufferMemoryRequirements>(vkGetDeviceProcAddr(logical_device, "vkGetBufferMemoryRequirements"));
-        if( vkGetBufferMemoryRequirements == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkGetBufferMemoryRequirements." << std::endl;
-            return -1;
-        }
-
-        // Load device level function from extension
-        PFN_vkCreateSwapchainKHR vkCreateSwapchainKHR;
-        vkCreateSwapchainKHR =
-                reinterpret_cast<PFN_vkCreateSwapchainKHR>(vkGetDeviceProcAddr(logical_device, "vkCreateSwapchainKHR"));
-        if( vkCreateSwapchainKHR == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCreateSwapchainKHR." << std::endl;
-            return -1;
-        }
-        PFN_vkGetSwapchainImagesKHR vkGetSwapchainImagesKHR;
-        vkGetSwapchainImagesKHR =
-                reinterpret_cast<PFN_vkGetSwapchainImagesKHR>(vkGetDeviceProcAddr(logical_device, "vkGetSwapchainImagesKHR"));
-        if( vkGetSwapchainImagesKHR == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkGetSwapchainImagesKHR." << std::endl;
-            return -1;
-        }
-        PFN_vkAcquireNextImageKHR vkAcquireNextImageKHR;
-        vkAcquireNextImageKHR =
-                reinterpret_cast<PFN_vkAcquireNextImageKHR>(vkGetDeviceProcAddr(logical_device, "vkAcquireNextImageKHR"));
-        if( vkAcquireNextImageKHR == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkAcquireNextImageKHR." << std::endl;
-            return -1;
-        }
-        PFN_vkQueuePresentKHR vkQueuePresentKHR;
-        vkQueuePresentKHR =
-                reinterpret_cast<PFN_vkQueuePresentKHR>(vkGetDeviceProcAddr(logical_device, "vkQueuePresentKHR"));
-        if( vkQueuePresentKHR == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkQueuePresentKHR." << std::endl;
-            return -1;
-        }
-        PFN_vkDestroySwapchainKHR vkDestroySwapchainKHR;
-        vkDestroySwapchainKHR =
-                reinterpret_cast<PFN_vkDestroySwapchainKHR>(vkGetDeviceProcAddr(logical_device, "vkDestroySwapchainKHR"));
-        if( vkDestroySwapchainKHR == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkDestroySwapchainKHR." << std::endl;
-            return -1;
-        }
-        PFN_vkCreateSemaphore vkCreateSemaphore;
-        vkCreateSemaphore =
-                reinterpret_cast<PFN_vkCreateSemaphore>(vkGetDeviceProcAddr(logical_device, "vkCreateSemaphore"));
-        if( vkCreateSemaphore == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCreateSemaphore." << std::endl;
-            return -1;
-        }
-        PFN_vkCreateFence vkCreateFence;
-        vkCreateFence =
-                reinterpret_cast<PFN_vkCreateFence>(vkGetDeviceProcAddr(logical_device, "vkCreateFence"));
-        if( vkCreateFence == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCreateFence." << std::endl;
-            return -1;
-        }
-        PFN_vkCreateCommandPool vkCreateCommandPool;
-        vkCreateCommandPool =
-                reinterpret_cast<PFN_vkCreateCommandPool>(vkGetDeviceProcAddr(logical_device, "vkCreateCommandPool"));
-        if( vkCreateCommandPool == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCreateCommandPool." << std::endl;
-            return -1;
-        }
-        PFN_vkAllocateCommandBuffers vkAllocateCommandBuffers;
-        vkAllocateCommandBuffers =
-                reinterpret_cast<PFN_vkAllocateCommandBuffers>(vkGetDeviceProcAddr(logical_device, "vkAllocateCommandBuffers"));
-        if( vkAllocateCommandBuffers == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkAllocateCommandBuffers." << std::endl;
-            return -1;
-        }
-        PFN_vkBeginCommandBuffer vkBeginCommandBuffer;
-        vkBeginCommandBuffer =
-                reinterpret_cast<PFN_vkBeginCommandBuffer>(vkGetDeviceProcAddr(logical_device, "vkBeginCommandBuffer"));
-        if( vkBeginCommandBuffer == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkBeginCommandBuffer." << std::endl;
-            return -1;
-        }
-        PFN_vkEndCommandBuffer vkEndCommandBuffer;
-        vkEndCommandBuffer =
-                reinterpret_cast<PFN_vkEndCommandBuffer>(vkGetDeviceProcAddr(logical_device, "vkEndCommandBuffer"));
-        if( vkEndCommandBuffer == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkEndCommandBuffer." << std::endl;
-            return -1;
-        }
-        PFN_vkResetCommandBuffer vkResetCommandBuffer;
-        vkResetCommandBuffer =
-                reinterpret_cast<PFN_vkResetCommandBuffer>(vkGetDeviceProcAddr(logical_device, "vkResetCommandBuffer"));
-        if( vkResetCommandBuffer == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkResetCommandBuffer." << std::endl;
-            return -1;
-        }
-        PFN_vkResetCommandPool vkResetCommandPool;
-        vkResetCommandPool =
-                reinterpret_cast<PFN_vkResetCommandPool>(vkGetDeviceProcAddr(logical_device, "vkResetCommandPool"));
-        if( vkResetCommandPool == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkResetCommandPool." << std::endl;
-            return -1;
-        }
-        PFN_vkWaitForFences vkWaitForFences;
-        vkWaitForFences =
-                reinterpret_cast<PFN_vkWaitForFences>(vkGetDeviceProcAddr(logical_device, "vkWaitForFences"));
-        if( vkWaitForFences == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkWaitForFences." << std::endl;
-            return -1;
-        }
-        PFN_vkQueueSubmit vkQueueSubmit;
-        vkQueueSubmit =
-                reinterpret_cast<PFN_vkQueueSubmit>(vkGetDeviceProcAddr(logical_device, "vkQueueSubmit"));
-        if( vkQueueSubmit == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkQueueSubmit." << std::endl;
-            return -1;
-        }
-        PFN_vkQueueWaitIdle vkQueueWaitIdle;
-        vkQueueWaitIdle =
-                reinterpret_cast<PFN_vkQueueWaitIdle>(vkGetDeviceProcAddr(logical_device, "vkQueueWaitIdle"));
-        if( vkQueueWaitIdle == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkQueueWaitIdle." << std::endl;
-            return -1;
-        }
-        PFN_vkDestroyFence vkDestroyFence;
-        vkDestroyFence =
-                reinterpret_cast<PFN_vkDestroyFence>(vkGetDeviceProcAddr(logical_device, "vkDestroyFence"));
-        if( vkDestroyFence == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkDestroyFence." << std::endl;
-            return -1;
-        }
-        PFN_vkDestroySemaphore vkDestroySemaphore;
-        vkDestroySemaphore =
-                reinterpret_cast<PFN_vkDestroySemaphore>(vkGetDeviceProcAddr(logical_device, "vkDestroySemaphore"));
-        if( vkDestroySemaphore == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkDestroySemaphore." << std::endl;
-            return -1;
-        }
-        PFN_vkFreeCommandBuffers vkFreeCommandBuffers;
-        vkFreeCommandBuffers =
-                reinterpret_cast<PFN_vkFreeCommandBuffers>(vkGetDeviceProcAddr(logical_device, "vkFreeCommandBuffers"));
-        if( vkFreeCommandBuffers == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkFreeCommandBuffers." << std::endl;
-            return -1;
-        }
-        PFN_vkDestroyCommandPool vkDestroyCommandPool;
-        vkDestroyCommandPool =
-                reinterpret_cast<PFN_vkDestroyCommandPool>(vkGetDeviceProcAddr(logical_device, "vkDestroyCommandPool"));
-        if( vkDestroyCommandPool == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkDestroyCommandPool." << std::endl;
+        DeviceDispatch device_functions;
+        if (!create_device_dispatch(instance_functions.vkGetDeviceProcAddr, logical_device,
+                                    desired_extensions_DeviceExtensionProperties, device_functions)){
             return -1;
         }
         // Get Device Queue
         VkQueue GraphicsQueue;
-        vkGetDeviceQueue( logical_device, GraphicsQueueFamilyIndex, 0, &GraphicsQueue );
+        device_functions.vkGetDeviceQueue( logical_device, GraphicsQueueFamilyIndex, 0, &GraphicsQueue );
         VkQueue PresentQueue;
-        vkGetDeviceQueue( logical_device, PresentQueueFamilyIndex, 0, &PresentQueue );
-        //Selecting a desired presentation mode
-        uint32_t present_modes_count{};
-        result = vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, presentation_surface, &present_modes_count, nullptr);
-        if (result != VK_SUCCESS || present_modes_count==0){
-            std::cout << "Could not get the number of supported present modes." <<
-                      std::endl;
-            return -1;
-        }
-        std::vector<VkPresentModeKHR> present_modes(present_modes_count);
-        result = vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, presentation_surface, &present_modes_count, present_modes.data());
-        if( (VK_SUCCESS != result) ||  (0 == present_modes_count) ) {
-            std::cout << "Could not enumerate present modes." << std::endl;
-            return -1;
-        }
-        // Select present mode
-        VkPresentModeKHR desired_present_mode{VK_PRESENT_MODE_MAILBOX_KHR};
-        VkPresentModeKHR present_mode;
-        b_found = false;
-        for (auto current_present_mode : present_modes) {
-            if (current_present_mode == desired_present_mode){
-                present_mode = desired_present_mode;
-                b_found = true;
-                break;
-            }
-        }
-        if (!b_found){
-            std::cout << "Desired present mode is not supported. Selecting default FIFO mode." << std::endl;
-        }
-        for (auto current_present_mode : present_modes) {
-            if (current_present_mode == VK_PRESENT_MODE_FIFO_KHR){
-                present_mode = VK_PRESENT_MODE_FIFO_KHR;
-                b_found = true;
-                break;
+        device_functions.vkGetDeviceQueue( logical_device, PresentQueueFamilyIndex, 0, &PresentQueue );
+        VkSwapchainKHR swapchain{VK_NULL_HANDLE};
+        VkFormat image_format;
+        VkExtent2D size_of_images{640, 480};
+        std::vector<VkImage> swapchain_images;
+        MemoryAllocator memory_allocator;
+        OffscreenSwapchain offscreen_swapchain;
+        if (uses_swapchain(presentation)) {
+            //Selecting a desired presentation mode
+            uint32_t present_modes_count{};
+            result = instance_functions.vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, presentation_surface, &present_modes_count, nullptr);
+            if (result != VK_SUCCESS || present_modes_count==0){
+                std::cout << "Could not get the number of supported present modes." <<
+                          std::endl;
+                return -1;
             }
-        }
-        if (!b_found){
-            std::cout << "Desired present mode VK_PRESENT_MODE_FIFO_KHR is not supported though it's mandatory for all drivers!" << std::endl;
-            return -1;
-        }
-        //Getting the capabilities of a presentation surface
-        VkSurfaceCapabilitiesKHR surface_capabilities;
-        result = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, presentation_surface, &surface_capabilities);
-        if( VK_SUCCESS != result ) {
-            std::cout << "Could not get the capabilities of a presentation surface." << std::endl;
-            return -1;
-        }
-        //Selecting a number of swapchain images
-        uint32_t number_of_images;
-        number_of_images = surface_capabilities.minImageCount+1;
-        if (surface_capabilities.maxImageCount > 0 && number_of_images > surface_capabilities.maxImageCount){
-            number_of_images = surface_capabilities.maxImageCount;
-        }
-        //Choosing a size of swapchain images
-        VkExtent2D size_of_images;
-        if (surface_capabilities.currentExtent.width == 0xFFFFFFFF){
-            size_of_images.width = 640 < surface_capabilities.minImageExtent.width ? surface_capabilities.minImageExtent.width : 640;
-            size_of_images.width = size_of_images.width > surface_capabilities.maxImageExtent.width ? surface_capabilities.maxImageExtent.width : size_of_images.width;
-            size_of_images.height = 480;
-            if (size_of_images.height < surface_capabilities.minImageExtent.height){
-                size_of_images.height = surface_capabilities.minImageExtent.height;
-            } else if (size_of_images.height > surface_capabilities.maxImageExtent.height){
-                size_of_images.height = surface_capabilities.maxImageExtent.height;
+            std::vector<VkPresentModeKHR> present_modes(present_modes_count);
+            result = instance_functions.vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, presentation_surface, &present_modes_count, present_modes.data());
+            if( (VK_SUCCESS != result) ||  (0 == present_modes_count) ) {
+                std::cout << "Could not enumerate present modes." << std::endl;
+                return -1;
             }
-        }else{
-            size_of_images = surface_capabilities.currentExtent;
-        }
-
-        //Selecting desired usage scenarios of swapchain images
-        VkImageUsageFlags desired_usages{VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT}, image_usage{0};
-        image_usage = desired_usages & surface_capabilities.supportedUsageFlags;
-        if (desired_usages != image_usage){
-            std::cout << "desired_usages is not equal image_usage";
-            return -1;
-        }
-        // Selecting a transformation of swapchain images
-        VkSurfaceTransformFlagBitsKHR desired_transform{VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR}, surface_transform;
-        if (surface_capabilities.supportedTransforms & desired_transform){
-            surface_transform = desired_transform;
-        } else{
-            surface_transform = surface_capabilities.currentTransform;
-        }
-        // Selecting a format of swapchain images
-        VkSurfaceFormatKHR desired_surface_format{ VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };  // image format and color-space pair
-        uint32_t formats_count;
-        result = vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, presentation_surface, &formats_count, nullptr);
-        if (result != VK_SUCCESS || formats_count == 0){
-            std::cout << "Could not get the number of supported present formats." << std::endl;
-            return -1;
-        }
-        std::vector<VkSurfaceFormatKHR> surface_formats(formats_count);
-        result = vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, presentation_surface, &formats_count, surface_formats.data());
-        if (result != VK_SUCCESS || formats_count == 0){
-            std::cout << "Could not get the number of supported present formats." << std::endl;
-            return -1;
-        }
-        VkFormat image_format;
-        VkColorSpaceKHR image_color_space;
-        if (surface_formats.size() == 1 && surface_formats[0].format == VK_FORMAT_UNDEFINED){
-            image_format = desired_surface_format.format;
-            image_color_space = desired_surface_format.colorSpace;
-        }else{
+            // Select present mode
+            VkPresentModeKHR desired_present_mode{VK_PRESENT_MODE_MAILBOX_KHR};
+            VkPresentModeKHR present_mode;
             b_found = false;
-            for (auto& surface_format : surface_formats) {
-                if (desired_surface_format.format == surface_format.format && desired_surface_format.colorSpace == surface_format.colorSpace){
-                    image_format = desired_surface_format.format;
-                    image_color_space = desired_surface_format.colorSpace;
+            for (auto current_present_mode : present_modes) {
+                if (current_present_mode == desired_present_mode){
+                    present_mode = desired_present_mode;
+                    b_found = true;
+                    break;
+                }
+            }
+            if (!b_found){
+                std::cout << "Desired present mode is not supported. Selecting default FIFO mode." << std::endl;
+            }
+            for (auto current_present_mode : present_modes) {
+                if (current_present_mode == VK_PRESENT_MODE_FIFO_KHR){
+                    present_mode = VK_PRESENT_MODE_FIFO_KHR;
                     b_found = true;
                     break;
                 }
             }
             if (!b_found){
+                std::cout << "Desired present mode VK_PRESENT_MODE_FIFO_KHR is not supported though it's mandatory for all drivers!" << std::endl;
+                return -1;
+            }
+            //Getting the capabilities of a presentation surface
+            VkSurfaceCapabilitiesKHR surface_capabilities;
+            result = instance_functions.vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, presentation_surface, &surface_capabilities);
+            if( VK_SUCCESS != result ) {
+                std::cout << "Could not get the capabilities of a presentation surface." << std::endl;
+                return -1;
+            }
+            //Selecting a number of swapchain images
+            uint32_t number_of_images;
+            number_of_images = surface_capabilities.minImageCount+1;
+            if (surface_capabilities.maxImageCount > 0 && number_of_images > surface_capabilities.maxImageCount){
+                number_of_images = surface_capabilities.maxImageCount;
+            }
+            //Choosing a size of swapchain images
+            if (surface_capabilities.currentExtent.width == 0xFFFFFFFF){
+                size_of_images.width = 640 < surface_capabilities.minImageExtent.width ? surface_capabilities.minImageExtent.width : 640;
+                size_of_images.width = size_of_images.width > surface_capabilities.maxImageExtent.width ? surface_capabilities.maxImageExtent.width : size_of_images.width;
+                size_of_images.height = 480;
+                if (size_of_images.height < surface_capabilities.minImageExtent.height){
+                    size_of_images.height = surface_capabilities.minImageExtent.height;
+                } else if (size_of_images.height > surface_capabilities.maxImageExtent.height){
+                    size_of_images.height = surface_capabilities.maxImageExtent.height;
+                }
+            }else{
+                size_of_images = surface_capabilities.currentExtent;
+            }
+
+            //Selecting desired usage scenarios of swapchain images
+            VkImageUsageFlags desired_usages{VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT}, image_usage{0};
+            if (capturing){
+                desired_usages |= VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            }
+            image_usage = desired_usages & surface_capabilities.supportedUsageFlags;
+            if (desired_usages != image_usage){
+                std::cout << "desired_usages is not equal image_usage";
+                return -1;
+            }
+            // Selecting a transformation of swapchain images
+            VkSurfaceTransformFlagBitsKHR desired_transform{VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR}, surface_transform;
+            if (surface_capabilities.supportedTransforms & desired_transform){
+                surface_transform = desired_transform;
+            } else{
+                surface_transform = surface_capabilities.currentTransform;
+            }
+            // Selecting a format of swapchain images
+            VkSurfaceFormatKHR desired_surface_format{ VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };  // image format and color-space pair
+            uint32_t formats_count;
+            result = instance_functions.vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, presentation_surface, &formats_count, nullptr);
+            if (result != VK_SUCCESS || formats_count == 0){
+                std::cout << "Could not get the number of supported present formats." << std::endl;
+                return -1;
+            }
+            std::vector<VkSurfaceFormatKHR> surface_formats(formats_count);
+            result = instance_functions.vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, presentation_surface, &formats_count, surface_formats.data());
+            if (result != VK_SUCCESS || formats_count == 0){
+                std::cout << "Could not get the number of supported present formats." << std::endl;
+                return -1;
+            }
+            VkColorSpaceKHR image_color_space;
+            if (surface_formats.size() == 1 && surface_formats[0].format == VK_FORMAT_UNDEFINED){
+                image_format = desired_surface_format.format;
+                image_color_space = desired_surface_format.colorSpace;
+            }else{
+                b_found = false;
                 for (auto& surface_format : surface_formats) {
-                    if (desired_surface_format.format == surface_format.format){
+                    if (desired_surface_format.format == surface_format.format && desired_surface_format.colorSpace == surface_format.colorSpace){
                         image_format = desired_surface_format.format;
                         image_color_space = desired_surface_format.colorSpace;
                         b_found = true;
                         break;
                     }
                 }
+                if (!b_found){
+                    for (auto& surface_format : surface_formats) {
+                        if (desired_surface_format.format == surface_format.format){
+                            image_format = desired_surface_format.format;
+                            image_color_space = desired_surface_format.colorSpace;
+                            b_found = true;
+                            break;
+                        }
+                    }
+                }
+                if (!b_found){// the format you wanted to use is not supported.
+                    image_format = surface_formats[0].format;
+                    image_color_space = surface_formats[0].colorSpace;
+                    std::cout << "Desired format is not supported. Selecting available format-colorspace combination.\n";
+                }
             }
-            if (!b_found){// the format you wanted to use is not supported.
-                image_format = surface_formats[0].format;
-                image_color_space = surface_formats[0].colorSpace;
-                std::cout << "Desired format is not supported. Selecting available format-colorspace combination.\n";
+            //Creating a swapchain
+            VkSwapchainKHR old_swapchain{VK_NULL_HANDLE};
+            VkSwapchainCreateInfoKHR swapchain_create_info;
+            swapchain_create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+            swapchain_create_info.pNext = nullptr;
+            swapchain_create_info.flags = 0;
+            swapchain_create_info.surface = presentation_surface;
+            swapchain_create_info.minImageCount = number_of_images;
+            swapchain_create_info.imageFormat = image_format;
+            swapchain_create_info.imageColorSpace = image_color_space;
+            swapchain_create_info.imageExtent = size_of_images;
+            swapchain_create_info.imageArrayLayers = 1;
+            swapchain_create_info.imageUsage = image_usage;
+            swapchain_create_info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            swapchain_create_info.queueFamilyIndexCount = 0;
+            swapchain_create_info.pQueueFamilyIndices = nullptr;
+            swapchain_create_info.preTransform = surface_transform;
+            swapchain_create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+            swapchain_create_info.presentMode = present_mode;
+            swapchain_create_info.clipped = VK_TRUE;
+            swapchain_create_info.oldSwapchain = old_swapchain;
+            result = device_functions.vkCreateSwapchainKHR(logical_device, &swapchain_create_info, nullptr, &swapchain);
+            if (result != VK_SUCCESS || swapchain == VK_NULL_HANDLE){
+                std::cout << "couldn't create a swapchain\n";
+                return -1;
+            }
+            if (old_swapchain != VK_NULL_HANDLE){
+                device_functions.vkDestroySwapchainKHR(logical_device, old_swapchain, nullptr);
+                old_swapchain = VK_NULL_HANDLE;
+            }
+            // Getting handles of swapchain images
+            uint32_t images_count;
+            result = device_functions.vkGetSwapchainImagesKHR(logical_device, swapchain, &images_count, nullptr);
+            if (result != VK_SUCCESS || images_count == 0){
+                std::cout << "could not get the number of swapchain images.\n";
+                return -1;
+            }
+            swapchain_images.resize(images_count);
+            result = device_functions.vkGetSwapchainImagesKHR(logical_device, swapchain, &images_count, swapchain_images.data());
+            if (result != VK_SUCCESS || images_count == 0){
+                std::cout << "could not enumerate swapchain images.\n";
+                return -1;
+            }
+        } else {
+            VkPhysicalDeviceMemoryProperties physical_device_memory_properties;
+            instance_functions.vkGetPhysicalDeviceMemoryProperties(physical_device, &physical_device_memory_properties);
+            if (!memory_allocator.init(device_functions, physical_device_memory_properties, device_properties.limits)){
+                std::cout << "Could not initialize memory allocator.\n";
+                return -1;
+            }
+            // Rendering into a ring of offscreen images instead, one more
+            // than there are frames in flight like a FIFO swapchain
+            image_format = VK_FORMAT_B8G8R8A8_UNORM;
+            if (!offscreen_swapchain.init(device_functions, memory_allocator, image_format, size_of_images,
+                                          FrameScheduler::default_frames_in_flight + 1,
+                                          VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT)){
+                return -1;
+            }
+            swapchain_images = offscreen_swapchain.images();
+        }
+        // Every graphics submission signals the next value of one counter
+        TimelineQueue graphics_timeline;
+        if (!graphics_timeline.init(device_functions, GraphicsQueue, use_timeline_semaphore)) {
+            return -1;
+        }
+        // Rendering with several frames in flight; each frame slot owns its
+        // semaphores and command pool and remembers the timeline value of its
+        // last submission, so the CPU only waits for the GPU when it gets
+        // frames_in_flight frames ahead
+        FrameScheduler frame_scheduler;
+        if (!frame_scheduler.init(device_functions, GraphicsQueueFamilyIndex,
+                                  FrameScheduler::default_frames_in_flight, &graphics_timeline)) {
+            std::cout << "Could not create frame resources." << std::endl;
+            return -1;
+        }
+        // Captured frames are read back a few frames behind and written on a
+        // worker thread
+        FrameCapture frame_capture;
+        if (capturing && !frame_capture.init(device_functions, memory_allocator, graphics_timeline, image_format,
+                                             size_of_images, options.capture_format)){
+            return -1;
+        }
+        const uint32_t frames_to_render{options.frame_count != 0 ? options.frame_count : 120};
+        double cpu_frame_ms{0.0}, gpu_wait_ms{0.0};
+        auto loop_start = std::chrono::steady_clock::now();
+        for (uint32_t frame_index = 0; frame_index < frames_to_render; ++frame_index) {
+            FrameContext *frame{nullptr};
+            result = uses_swapchain(presentation) ? frame_scheduler.begin_frame(swapchain, frame) :
+                                                    frame_scheduler.begin_frame(offscreen_swapchain, frame);
+            if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR){
+                std::cout << "could not vkAcquireNextImageKHR swapchain images.\n";
+                return -1;
             }
-        }
-        //Creating a swapchain
-        VkSwapchainKHR old_swapchain{VK_NULL_HANDLE};
-        VkSwapchainCreateInfoKHR swapchain_create_info;
-        swapchain_create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-        swapchain_create_info.pNext = nullptr;
-        swapchain_create_info.flags = 0;
-        swapchain_create_info.surface = presentation_surface;
-        swapchain_create_info.minImageCount = number_of_images;
-        swapchain_create_info.imageFormat = image_format;
-        swapchain_create_info.imageColorSpace = image_color_space;
-        swapchain_create_info.imageExtent = size_of_images;
-        swapchain_create_info.imageArrayLayers = 1;
-        swapchain_create_info.imageUsage = image_usage;
-        swapchain_create_info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        swapchain_create_info.queueFamilyIndexCount = 0;
-        swapchain_create_info.pQueueFamilyIndices = nullptr;
-        swapchain_create_info.preTransform = surface_transform;
-        swapchain_create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-        swapchain_create_info.presentMode = present_mode;
-        swapchain_create_info.clipped = VK_TRUE;
-        swapchain_create_info.oldSwapchain = old_swapchain;
-        VkSwapchainKHR swapchain;
-        result = vkCreateSwapchainKHR(logical_device, &swapchain_create_info, nullptr, &swapchain);
-        if (result != VK_SUCCESS || swapchain == VK_NULL_HANDLE){
-            std::cout << "couldn't create a swapchain\n";
-            return -1;
-        }
-        if (old_swapchain != VK_NULL_HANDLE){
-            vkDestroySwapchainKHR(logical_device, old_swapchain, nullptr);
-            old_swapchain = VK_NULL_HANDLE;
-        }
-        // Getting handles of swapchain images
-        uint32_t images_count;
-        result = vkGetSwapchainImagesKHR(logical_device, swapchain, &images_count, nullptr);
-        if (result != VK_SUCCESS || images_count == 0){
-            std::cout << "could not get the number of swapchain images.\n";
-            return -1;
-        }
-        std::vector<VkImage> swapchain_images(images_count);
-        result = vkGetSwapchainImagesKHR(logical_device, swapchain, &images_count, swapchain_images.data());
-        if (result != VK_SUCCESS || images_count == 0){
-            std::cout << "could not enumerate swapchain images.\n";
-            return -1;
-        }
-        // Acquiring a swapchain image
-        VkSemaphore semaphore;
-        VkSemaphoreCreateInfo semaphore_create_info{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, nullptr, 0};
-        result = vkCreateSemaphore(logical_device, &semaphore_create_info, nullptr, &semaphore);
-        if( VK_SUCCESS != result ) {
-            std::cout << "Could not create a semaphore." << std::endl;
-            return -1;
-        }
-        VkFence fence;
-        VkFenceCreateInfo fence_create_info;
-        fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-        fence_create_info.pNext = nullptr;
-        fence_create_info.flags = 0;
-        result = vkCreateFence(logical_device, &fence_create_info, nullptr, &fence);
-        if( VK_SUCCESS != result ) {
-            std::cout << "Could not create a fence." << std::endl;
-            return -1;
-        }
-        uint32_t image_index;
-        result = vkAcquireNextImageKHR(logical_device, swapchain, 2000000000, semaphore, fence, &image_index);  // 2000000000 : 2s
-        if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR){
-            std::cout << "could not vkAcquireNextImageKHR swapchain images.\n";
-            return -1;
-        }
-
-        // Creating a command pool
-        VkCommandPoolCreateInfo command_pool_create_info;
-        command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-        command_pool_create_info.pNext = nullptr;
-        command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-        command_pool_create_info.queueFamilyIndex = GraphicsQueueFamilyIndex;
-
-        VkCommandPool command_pool;
-        result = vkCreateCommandPool(logical_device, &command_pool_create_info, nullptr, &command_pool);
-        if( VK_SUCCESS != result ) {
-            std::cout << "Could not create command pool." << std::endl;
-            return -1;
-        }
-        // Allocating command buffers
-        VkCommandBufferAllocateInfo command_buffer_allocate_info;
-        command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        command_buffer_allocate_info.pNext = nullptr;
-        command_buffer_allocate_info.commandPool = command_pool;
-        command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        command_buffer_allocate_info.commandBufferCount = 5;
-        std::vector<VkCommandBuffer> command_buffers{5};
-        result = vkAllocateCommandBuffers(logical_device, &command_buffer_allocate_info, command_buffers.data());
-        if (result != VK_SUCCESS){
-            std::cout << "could not allocate command buffers.\n";
-            return -1;
-        }
-        // Beginning a command buffer recording operation
-        VkCommandBuffer command_buffer = command_buffers[0];
-        VkCommandBufferUsageFlags usage;
-        usage = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-        VkCommandBufferInheritanceInfo *secondary_command_buffer{nullptr};
-        VkCommandBufferBeginInfo command_buffer_begin_info;
-        command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        command_buffer_begin_info.pNext = nullptr;
-        command_buffer_begin_info.flags = usage;
-        command_buffer_begin_info.pInheritanceInfo = secondary_command_buffer;
-        result = vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info);
-        if (result != VK_SUCCESS){
-            std::cout << "Could not begin command buffer recording operation.\n";
-            return -1;
-        }
-
-        // do something
-
-        // Ending a command buffer recording operation
-        result = vkEndCommandBuffer(command_buffer);
-        if (result != VK_SUCCESS){
-            std::cout << "Error occurred during command buffer recording.\n";
-            return -1;
-        }
 
-        //Submitting command buffers to a queue
-        VkSemaphore rendering_semaphore;
-        VkSemaphoreCreateInfo semaphore_create_info2{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, nullptr, 0};
-        result = vkCreateSemaphore(logical_device, &semaphore_create_info2, nullptr, &rendering_semaphore);
-        if( VK_SUCCESS != result ) {
-            std::cout << "Could not create a semaphore." << std::endl;
-            return -1;
-        }
-        std::vector<VkSemaphore> rendering_semaphores{rendering_semaphore};
-        WaitSemaphoreInfo wait_semaphore_info{semaphore, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT};
-        std::vector<VkSemaphore> wait_semaphore_handles{wait_semaphore_info.semaphore};
-        std::vector<VkPipelineStageFlags> wait_semaphore_stages{wait_semaphore_info.waitingstage};
-        VkSubmitInfo submit_info;
-        submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submit_info.pNext = nullptr;
-        submit_info.waitSemaphoreCount = static_cast<uint32_t>(wait_semaphore_handles.size());
-        submit_info.pWaitSemaphores = wait_semaphore_handles.data();
-        submit_info.pWaitDstStageMask = wait_semaphore_stages.data();
-        submit_info.commandBufferCount = static_cast<uint32_t>(command_buffers.size());
-        submit_info.pCommandBuffers = command_buffers.data();
-        submit_info.signalSemaphoreCount = static_cast<uint32_t >(rendering_semaphores.size());
-        submit_info.pSignalSemaphores = rendering_semaphores.data();
-
-        result = vkQueueSubmit(PresentQueue, 1, &submit_info, VK_NULL_HANDLE);
-        if( VK_SUCCESS != result ) {
-            std::cout << "Error occurred during command buffer submission." <<
-                      std::endl;
-            return -1;
-        }
+            VkImage frame_image = swapchain_images[frame->image_index];
+            VkImageLayout final_layout = uses_swapchain(presentation) ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR :
+                                                                        OffscreenSwapchain::final_layout;
+            auto image_barrier = [&](VkImageLayout old_layout, VkImageLayout new_layout,
+                                     VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage,
+                                     VkAccessFlags src_access, VkAccessFlags dst_access) {
+                VkImageMemoryBarrier barrier = {
+                        VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                        nullptr,
+                        src_access,
+                        dst_access,
+                        old_layout,
+                        new_layout,
+                        VK_QUEUE_FAMILY_IGNORED,
+                        VK_QUEUE_FAMILY_IGNORED,
+                        frame_image,
+                        {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}
+                };
+                device_functions.vkCmdPipelineBarrier(frame->command_buffer, src_stage, dst_stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+            };
+            if (capturing){
+                // Clearing to a colour that changes every frame and reading it back
+                image_barrier(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
+                float shade = static_cast<float>(frame_index % 64) / 63.0f;
+                VkClearColorValue clear_color = {{shade, 0.25f, 1.0f - shade, 1.0f}};
+                VkImageSubresourceRange clear_range = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+                device_functions.vkCmdClearColorImage(frame->command_buffer, frame_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                      &clear_color, 1, &clear_range);
+                image_barrier(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                              VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+                char frame_suffix[16];
+                snprintf(frame_suffix, sizeof(frame_suffix), "_%04u", frame_index);
+                if (!frame_capture.capture(frame->command_buffer, frame_image, options.capture_basename + frame_suffix)){
+                    return -1;
+                }
+                if (final_layout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL){
+                    image_barrier(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, final_layout,
+                                  VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0);
+                }
+            } else {
+                // do something; at least hand the image over to the presentation
+                // engine, or leave an offscreen image ready to be read back
+                image_barrier(VK_IMAGE_LAYOUT_UNDEFINED, final_layout, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                              VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0);
+            }
 
-        // Waiting for fences
-        std::vector<VkFence> fences{fence};
-        VkBool32 wait_for_all{VK_TRUE};
-        uint64_t timeout{2000000000};
-        result = vkWaitForFences(logical_device, static_cast<uint32_t>(fences.size()), fences.data(), wait_for_all, timeout);
-        if (result != VK_SUCCESS){
-            std::cout << "Waiting on fence failed.\n";
-            return -1;
-        }
-        // Presenting an image
-        std::vector<VkSwapchainKHR> swapchains{swapchain};
-        std::vector<uint32_t> image_indices{image_index};
-        VkPresentInfoKHR present_info;
-        present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-        present_info.pNext = nullptr;
-        present_info.waitSemaphoreCount = rendering_semaphores.size();
-        present_info.pWaitSemaphores = rendering_semaphores.data();
-        present_info.swapchainCount = swapchains.size();
-        present_info.pSwapchains = swapchains.data();
-        present_info.pImageIndices = image_indices.data();
-        present_info.pResults = nullptr;
-        result = vkQueuePresentKHR(PresentQueue, &present_info);
-        if (result != VK_SUCCESS){
-            std::cout << "could not vkQueuePresentKHR present images.\n";
-            return -1;
-        }
-        // Waiting until all commands submitted to a queue are finished
-        result = vkQueueWaitIdle(GraphicsQueue);
-        if (result != VK_SUCCESS){
-            std::cout << "Waiting for all operations submitted to queue failed.\n";
-            return -1;
+            // A clear waits for the acquired image at the transfer stage
+            result = frame_scheduler.end_frame(GraphicsQueue, PresentQueue, swapchain,
+                                               capturing ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+            if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR){
+                std::cout << "could not vkQueuePresentKHR present images.\n";
+                return -1;
+            }
+            if (capturing){
+                frame_capture.submitted(frame->submitted_value);
+            }
+            cpu_frame_ms += frame_scheduler.last_timings().cpu_frame_ms;
+            gpu_wait_ms += frame_scheduler.last_timings().gpu_wait_ms;
         }
-        // Waiting for all submitted commands to be finished
-        result = vkDeviceWaitIdle(logical_device);
+        uint64_t completed_value = graphics_timeline.completed_value();
+        // Frame rate includes the GPU finishing the last frame and, when
+        // capturing, the worker writing the last file
+        result = graphics_timeline.wait_idle();
         if (result != VK_SUCCESS){
-            std::cout << "Waiting on a device failed.\n";
-            return -1;
-        }
-        // Destroy fence
-        if (fence != VK_NULL_HANDLE){
-            vkDestroyFence(logical_device, fence, nullptr);
-            fence = VK_NULL_HANDLE;
-        }
-
-        // Destroy semaphore
-        if (semaphore != VK_NULL_HANDLE){
-            vkDestroySemaphore(logical_device, semaphore, nullptr);
-            semaphore = VK_NULL_HANDLE;
-        }
-        // Freeing command buffers
-        if (!command_buffers.empty()){
-            vkFreeCommandBuffers(logical_device, command_pool, command_buffers.size(), command_buffers.data());
-            command_buffers.clear();
-        }
-        // Destroying a command pool
-        if (command_pool != VK_NULL_HANDLE){
-            vkDestroyCommandPool(logical_device, command_pool, nullptr);
-            command_pool = VK_NULL_HANDLE;
-        }
+            std::cout << "Waiting for the last frame failed.\n";
+            return -1;
+        }
+        frame_capture.flush();
+        double loop_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loop_start).count();
+        std::cout << "presentation: " << presentation_mode_name(presentation) << std::endl;
+        std::cout << "frames in flight: " << frame_scheduler.frames_in_flight() << std::endl;
+        if (frames_to_render > 1){
+            std::cout << "average CPU frame time: " << cpu_frame_ms / (frames_to_render - 1) << " ms" << std::endl;
+        }
+        std::cout << "average GPU wait time:  " << gpu_wait_ms / frames_to_render << " ms" << std::endl;
+        std::cout << "GPU had completed submission " << completed_value
+                  << " of " << graphics_timeline.last_submitted_value() << " when the loop ended" << std::endl;
+        std::cout << frames_to_render << " frames in " << loop_ms << " ms, "
+                  << frames_to_render / (loop_ms / 1000.0) << " frames/s" << std::endl;
+        if (capturing){
+            FrameCaptureStatistics capture_statistics = frame_capture.statistics();
+            std::cout << "captured " << capture_statistics.frames_written << " frame(s), "
+                      << capture_statistics.bytes_written << " bytes, " << capture_statistics.write_failures
+                      << " failure(s), " << capture_statistics.stalls << " stall(s), " << capture_statistics.stall_ms
+                      << " ms stalled, " << capture_statistics.encode_ms << " ms encoding on the worker" << std::endl;
+        }
+
+        // Destroying frame resources; waits for the device once, at teardown
+        frame_capture.destroy();
+        frame_scheduler.destroy();
+        graphics_timeline.destroy();
+        offscreen_swapchain.destroy();
+        memory_allocator.destroy();
         // Destroying a swapchain
         if (swapchain != VK_NULL_HANDLE){
-            vkDestroySwapchainKHR(logical_device, swapchain, nullptr);
+            device_functions.vkDestroySwapchainKHR(logical_device, swapchain, nullptr);
             swapchain = VK_NULL_HANDLE;
         }
         // Destroying a presentation surface
         if (presentation_surface != VK_NULL_HANDLE){
-            vkDestroySurfaceKHR(instance, presentation_surface, nullptr);
+            instance_functions.vkDestroySurfaceKHR(instance, presentation_surface, nullptr);
             presentation_surface = VK_NULL_HANDLE;
         }
 
@@ -0,0 +1,412 @@
+//
+// Compares GPU time for the copy sequence of "Resources and Memory" with
+// barriers recorded through vkCmdPipelineBarrier and through
+// vkCmdPipelineBarrier2KHR.
+//
+// Each iteration copies buffer to buffer (while moving a cubemap to
+// TRANSFER_DST), buffer to image and image to buffer, with the barriers worked
+// out by a ResourceStateTracker. The legacy path has to OR every barrier's
+// stages into one pair per call; the synchronization2 path keeps them per
+// barrier and names the COPY stage instead of all of TRANSFER. Time is taken
+// with timestamps at the start and end of the command buffer.
+//
+
+#include "memory_allocator.h"
+#include "resource_state_tracker.h"
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+constexpr uint32_t image_size = 64;
+constexpr uint32_t image_layers = 6;
+constexpr VkDeviceSize buffer_size = VkDeviceSize(image_size) * image_size * 4 * image_layers;
+
+struct CopyResources {
+    VkBuffer source_buffer{VK_NULL_HANDLE};
+    VkBuffer destination_buffer{VK_NULL_HANDLE};
+    VkImage  cubemap{VK_NULL_HANDLE};
+    VkImage  destination_image{VK_NULL_HANDLE};
+    VkImage  source_image{VK_NULL_HANDLE};
+    MemoryAllocation allocations[5];
+};
+
+bool create_buffer(const DeviceDispatch &dispatch, MemoryAllocator &allocator, VkBufferUsageFlags usage,
+                   VkBuffer &buffer, MemoryAllocation &allocation) {
+    VkBufferCreateInfo buffer_create_info = {
+            VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            nullptr,
+            0,
+            buffer_size,
+            usage,
+            VK_SHARING_MODE_EXCLUSIVE,
+            0,
+            nullptr
+    };
+    if (dispatch.vkCreateBuffer(dispatch.device, &buffer_create_info, nullptr, &buffer) != VK_SUCCESS) {
+        std::cout << "Could not create a buffer." << std::endl;
+        return false;
+    }
+    return allocator.allocate_for_buffer(buffer, MemoryUsage::GpuOnly, 0, allocation) == VK_SUCCESS;
+}
+
+bool create_image(const DeviceDispatch &dispatch, MemoryAllocator &allocator, VkImageUsageFlags usage,
+                  VkImage &image, MemoryAllocation &allocation) {
+    VkImageCreateInfo image_create_info = {
+            VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            nullptr,
+            VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT,
+            VK_IMAGE_TYPE_2D,
+            VK_FORMAT_R8G8B8A8_UNORM,
+            {image_size, image_size, 1},
+            1,
+            image_layers,
+            VK_SAMPLE_COUNT_1_BIT,
+            VK_IMAGE_TILING_OPTIMAL,
+            usage,
+            VK_SHARING_MODE_EXCLUSIVE,
+            0,
+            nullptr,
+            VK_IMAGE_LAYOUT_UNDEFINED
+    };
+    if (dispatch.vkCreateImage(dispatch.device, &image_create_info, nullptr, &image) != VK_SUCCESS) {
+        std::cout << "Could not create an image." << std::endl;
+        return false;
+    }
+    return allocator.allocate_for_image(image, VK_IMAGE_TILING_OPTIMAL, MemoryUsage::GpuOnly, 0, allocation) == VK_SUCCESS;
+}
+
+void record_copy_sequence(const DeviceDispatch &dispatch, ResourceStateTracker &tracker,
+                          VkCommandBuffer command_buffer, const CopyResources &resources) {
+    const VkImageSubresourceRange whole_image{VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS,
+                                              0, VK_REMAINING_ARRAY_LAYERS};
+    const VkBufferImageCopy image_copy = {
+            0,
+            0,
+            0,
+            {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, image_layers},
+            {0, 0, 0},
+            {image_size, image_size, 1}
+    };
+
+    tracker.use_image(resources.cubemap, whole_image, VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    tracker.use_buffer(resources.source_buffer, 0, VK_WHOLE_SIZE, VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+    tracker.use_buffer(resources.destination_buffer, 0, VK_WHOLE_SIZE, VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+    tracker.flush(command_buffer);
+    const VkBufferCopy buffer_copy = {0, 0, buffer_size};
+    dispatch.vkCmdCopyBuffer(command_buffer, resources.source_buffer, resources.destination_buffer, 1, &buffer_copy);
+
+    tracker.use_buffer(resources.source_buffer, 0, VK_WHOLE_SIZE, VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+    tracker.use_image(resources.destination_image, whole_image, VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    tracker.flush(command_buffer);
+    dispatch.vkCmdCopyBufferToImage(command_buffer, resources.source_buffer, resources.destination_image,
+                                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &image_copy);
+
+    tracker.use_image(resources.source_image, whole_image, VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
+                      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    tracker.use_buffer(resources.destination_buffer, 0, VK_WHOLE_SIZE, VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+    tracker.flush(command_buffer);
+    dispatch.vkCmdCopyImageToBuffer(command_buffer, resources.source_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                    resources.destination_buffer, 1, &image_copy);
+}
+
+// Returns the GPU time per iteration in microseconds, or a negative value on
+// failure.
+double time_copy_sequence(const DeviceDispatch &dispatch, bool use_synchronization2, VkQueue queue,
+                          VkCommandBuffer command_buffer, VkFence fence, VkQueryPool query_pool,
+                          const CopyResources &resources, uint32_t iterations, float timestamp_period,
+                          uint32_t &barrier_calls) {
+    ResourceStateTracker tracker(dispatch, use_synchronization2);
+    // Previous contents are not needed, so every run starts from UNDEFINED.
+    tracker.track_image(resources.cubemap, VK_IMAGE_ASPECT_COLOR_BIT, 1, image_layers);
+    tracker.track_image(resources.destination_image, VK_IMAGE_ASPECT_COLOR_BIT, 1, image_layers);
+    tracker.track_image(resources.source_image, VK_IMAGE_ASPECT_COLOR_BIT, 1, image_layers);
+
+    const VkCommandBufferBeginInfo begin_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            nullptr,
+            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            nullptr
+    };
+    if (dispatch.vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+        return -1.0;
+    }
+    dispatch.vkCmdResetQueryPool(command_buffer, query_pool, 0, 2);
+    dispatch.vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, query_pool, 0);
+    for (uint32_t i = 0; i < iterations; ++i) {
+        record_copy_sequence(dispatch, tracker, command_buffer, resources);
+    }
+    dispatch.vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, query_pool, 1);
+    if (dispatch.vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+        return -1.0;
+    }
+
+    VkSubmitInfo submit_info = {
+            VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            nullptr,
+            0,
+            nullptr,
+            nullptr,
+            1,
+            &command_buffer,
+            0,
+            nullptr
+    };
+    if (dispatch.vkResetFences(dispatch.device, 1, &fence) != VK_SUCCESS ||
+        dispatch.vkQueueSubmit(queue, 1, &submit_info, fence) != VK_SUCCESS ||
+        dispatch.vkWaitForFences(dispatch.device, 1, &fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS) {
+        return -1.0;
+    }
+    uint64_t timestamps[2]{};
+    if (dispatch.vkGetQueryPoolResults(dispatch.device, query_pool, 0, 2, sizeof(timestamps), timestamps, sizeof(uint64_t),
+                                       VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS ||
+        dispatch.vkResetCommandBuffer(command_buffer, 0) != VK_SUCCESS) {
+        return -1.0;
+    }
+    barrier_calls = tracker.barrier_calls();
+    double elapsed_ns = double(timestamps[1] - timestamps[0]) * timestamp_period;
+    return elapsed_ns / 1000.0 / iterations;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    uint32_t iterations = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 256;
+    uint32_t runs = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 8;
+    if (iterations == 0) {
+        iterations = 1;
+    }
+    if (runs == 0) {
+        runs = 1;
+    }
+
+    void *vulkan_library = load_vulkan_library();
+    auto vkGetInstanceProcAddr = load_exported_vulkan_function(vulkan_library);
+    if (vkGetInstanceProcAddr == nullptr) {
+        return -1;
+    }
+    GlobalFunctions global_functions{};
+    if (!load_global_level_functions(vkGetInstanceProcAddr, global_functions)) {
+        return -1;
+    }
+
+    VkApplicationInfo application_info = {
+            VK_STRUCTURE_TYPE_APPLICATION_INFO,
+            nullptr,
+            "barrier_path_benchmark",
+            VK_MAKE_VERSION(1, 0, 0),
+            "Vulkan Cookbook",
+            VK_MAKE_VERSION(1, 0, 0),
+            VK_MAKE_VERSION(1, 1, 0)
+    };
+    VkInstanceCreateInfo instance_create_info = {
+            VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+            nullptr,
+            0,
+            &application_info,
+            0,
+            nullptr,
+            0,
+            nullptr
+    };
+    VkInstance instance{VK_NULL_HANDLE};
+    if (global_functions.vkCreateInstance(&instance_create_info, nullptr, &instance) != VK_SUCCESS) {
+        std::cout << "Could not create Vulkan instance." << std::endl;
+        return -1;
+    }
+    InstanceFunctions instance_functions{};
+    if (!load_instance_level_functions(vkGetInstanceProcAddr, instance, {}, instance_functions)) {
+        return -1;
+    }
+
+    uint32_t physical_device_count = 1;
+    VkPhysicalDevice physical_device{VK_NULL_HANDLE};
+    VkResult result = instance_functions.vkEnumeratePhysicalDevices(instance, &physical_device_count, &physical_device);
+    if ((result != VK_SUCCESS && result != VK_INCOMPLETE) || physical_device_count == 0) {
+        std::cout << "Could not enumerate physical devices." << std::endl;
+        return -1;
+    }
+    VkPhysicalDeviceProperties device_properties;
+    VkPhysicalDeviceMemoryProperties memory_properties;
+    instance_functions.vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+    instance_functions.vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
+
+    uint32_t queue_family_count = 0;
+    instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_families.data());
+    uint32_t graphics_queue_family_index = queue_family_count;
+    for (uint32_t i = 0; i < queue_family_count; ++i) {
+        if ((queue_families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0) {
+            graphics_queue_family_index = i;
+            break;
+        }
+    }
+    if (graphics_queue_family_index == queue_family_count) {
+        std::cout << "Could not find a graphics queue family." << std::endl;
+        return -1;
+    }
+    if (queue_families[graphics_queue_family_index].timestampValidBits == 0) {
+        std::cout << "The graphics queue does not support timestamps." << std::endl;
+        return -1;
+    }
+
+    uint32_t extension_count = 0;
+    instance_functions.vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, nullptr);
+    std::vector<VkExtensionProperties> available_extensions(extension_count);
+    instance_functions.vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count,
+                                                            available_extensions.data());
+    bool use_synchronization2 = synchronization2_supported(available_extensions);
+    std::vector<char const *> enabled_extensions;
+    if (use_synchronization2) {
+        enabled_extensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+    }
+
+    float queue_priority = 1.0f;
+    VkDeviceQueueCreateInfo queue_create_info = {
+            VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            nullptr,
+            0,
+            graphics_queue_family_index,
+            1,
+            &queue_priority
+    };
+    VkPhysicalDeviceSynchronization2Features synchronization2_features = {
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES,
+            nullptr,
+            VK_TRUE
+    };
+    VkDeviceCreateInfo device_create_info = {
+            VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+            use_synchronization2 ? &synchronization2_features : nullptr,
+            0,
+            1,
+            &queue_create_info,
+            0,
+            nullptr,
+            static_cast<uint32_t>(enabled_extensions.size()),
+            enabled_extensions.empty() ? nullptr : enabled_extensions.data(),
+            nullptr
+    };
+    VkDevice logical_device{VK_NULL_HANDLE};
+    if (instance_functions.vkCreateDevice(physical_device, &device_create_info, nullptr, &logical_device) != VK_SUCCESS) {
+        std::cout << "Could not create logical device." << std::endl;
+        return -1;
+    }
+    DeviceDispatch dispatch;
+    if (!create_device_dispatch(instance_functions.vkGetDeviceProcAddr, logical_device, enabled_extensions, dispatch)) {
+        return -1;
+    }
+    VkQueue queue{VK_NULL_HANDLE};
+    dispatch.vkGetDeviceQueue(logical_device, graphics_queue_family_index, 0, &queue);
+
+    MemoryAllocator allocator;
+    if (!allocator.init(dispatch, memory_properties, device_properties.limits)) {
+        return -1;
+    }
+    CopyResources resources;
+    if (!create_buffer(dispatch, allocator, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, resources.source_buffer, resources.allocations[0]) ||
+        !create_buffer(dispatch, allocator, VK_BUFFER_USAGE_TRANSFER_DST_BIT, resources.destination_buffer, resources.allocations[1]) ||
+        !create_image(dispatch, allocator, VK_IMAGE_USAGE_TRANSFER_DST_BIT, resources.cubemap, resources.allocations[2]) ||
+        !create_image(dispatch, allocator, VK_IMAGE_USAGE_TRANSFER_DST_BIT, resources.destination_image, resources.allocations[3]) ||
+        !create_image(dispatch, allocator, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, resources.source_image, resources.allocations[4])) {
+        std::cout << "Could not create copy resources." << std::endl;
+        return -1;
+    }
+
+    VkCommandPoolCreateInfo command_pool_create_info = {
+            VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            nullptr,
+            VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+            graphics_queue_family_index
+    };
+    VkCommandPool command_pool{VK_NULL_HANDLE};
+    if (dispatch.vkCreateCommandPool(logical_device, &command_pool_create_info, nullptr, &command_pool) != VK_SUCCESS) {
+        std::cout << "Could not create command pool." << std::endl;
+        return -1;
+    }
+    VkCommandBufferAllocateInfo command_buffer_allocate_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            nullptr,
+            command_pool,
+            VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            1
+    };
+    VkCommandBuffer command_buffer{VK_NULL_HANDLE};
+    if (dispatch.vkAllocateCommandBuffers(logical_device, &command_buffer_allocate_info, &command_buffer) != VK_SUCCESS) {
+        std::cout << "Could not allocate command buffer." << std::endl;
+        return -1;
+    }
+    VkFenceCreateInfo fence_create_info = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, nullptr, 0};
+    VkFence fence{VK_NULL_HANDLE};
+    if (dispatch.vkCreateFence(logical_device, &fence_create_info, nullptr, &fence) != VK_SUCCESS) {
+        std::cout << "Could not create a fence." << std::endl;
+        return -1;
+    }
+    VkQueryPoolCreateInfo query_pool_create_info = {
+            VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            nullptr,
+            0,
+            VK_QUERY_TYPE_TIMESTAMP,
+            2,
+            0
+    };
+    VkQueryPool query_pool{VK_NULL_HANDLE};
+    if (dispatch.vkCreateQueryPool(logical_device, &query_pool_create_info, nullptr, &query_pool) != VK_SUCCESS) {
+        std::cout << "Could not create a query pool." << std::endl;
+        return -1;
+    }
+
+    float timestamp_period = device_properties.limits.timestampPeriod;
+    uint32_t path_count = use_synchronization2 ? 2 : 1;
+    double path_us[2]{};
+    uint32_t path_barrier_calls[2]{};
+    for (uint32_t path = 0; path < path_count; ++path) {
+        // One untimed run so both paths start with warm caches.
+        if (time_copy_sequence(dispatch, path == 1, queue, command_buffer, fence, query_pool, resources,
+                               iterations, timestamp_period, path_barrier_calls[path]) < 0.0) {
+            std::cout << "Could not run the copy sequence." << std::endl;
+            return -1;
+        }
+        for (uint32_t run = 0; run < runs; ++run) {
+            double us = time_copy_sequence(dispatch, path == 1, queue, command_buffer, fence, query_pool, resources,
+                                           iterations, timestamp_period, path_barrier_calls[path]);
+            if (us < 0.0) {
+                std::cout << "Could not run the copy sequence." << std::endl;
+                return -1;
+            }
+            path_us[path] += us / runs;
+        }
+    }
+
+    std::cout << "copy sequences per run: " << iterations << ", runs: " << runs << std::endl;
+    std::cout << "vkCmdPipelineBarrier:     " << path_us[0] << " us/sequence, "
+              << path_barrier_calls[0] << " barrier calls/run" << std::endl;
+    if (use_synchronization2) {
+        std::cout << "vkCmdPipelineBarrier2KHR: " << path_us[1] << " us/sequence, "
+                  << path_barrier_calls[1] << " barrier calls/run" << std::endl;
+    } else {
+        std::cout << "VK_KHR_synchronization2 is not supported; only the legacy path was measured." << std::endl;
+    }
+
+    dispatch.vkDestroyQueryPool(logical_device, query_pool, nullptr);
+    dispatch.vkDestroyFence(logical_device, fence, nullptr);
+    dispatch.vkFreeCommandBuffers(logical_device, command_pool, 1, &command_buffer);
+    dispatch.vkDestroyCommandPool(logical_device, command_pool, nullptr);
+    dispatch.vkDestroyBuffer(logical_device, resources.source_buffer, nullptr);
+    dispatch.vkDestroyBuffer(logical_device, resources.destination_buffer, nullptr);
+    dispatch.vkDestroyImage(logical_device, resources.cubemap, nullptr);
+    dispatch.vkDestroyImage(logical_device, resources.destination_image, nullptr);
+    dispatch.vkDestroyImage(logical_device, resources.source_image, nullptr);
+    for (auto &allocation : resources.allocations) {
+        allocator.free(allocation);
+    }
+    allocator.destroy();
+    dispatch.vkDestroyDevice(logical_device, nullptr);
+    destroy_device_dispatch(dispatch);
+    instance_functions.vkDestroyInstance(instance, nullptr);
+    unload_vulkan_library(vulkan_library);
+    return 0;
+}
@@ -0,0 +1,680 @@
+//
+// Records draw_count draws per frame with a descriptor set of their own,
+// then the same draws against a BindlessDescriptorHeap, and compares the
+// command buffer recording time and the draw submission rate.
+//
+// The per-set path does for every draw what a sample with per-object
+// textures would: allocate a set from a DescriptorAllocator that is reset
+// each frame, write a combined image sampler into it and bind it. The
+// bindless path binds the heap once per command buffer and pushes the image
+// and sampler indices for each draw. The shaders read no descriptors, so the
+// GPU work of both paths is the same and the difference is the CPU cost of
+// getting descriptors to the draws. The first frame of each path is a
+// warm-up and is not counted.
+//
+
+#include "bindless_descriptors.h"
+#include "descriptor_allocator.h"
+#include "memory_allocator.h"
+#include "pipeline_builder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+const VkExtent2D target_extent = {64, 64};
+
+// Empty "main" shaders.
+const uint32_t vertex_shader[] = {
+        0x07230203, 0x00010000, 0x00000000, 5, 0,
+        0x00020011, 1,                                  // OpCapability Shader
+        0x0003000E, 0, 1,                               // OpMemoryModel Logical GLSL450
+        0x0005000F, 0, 1, 0x6E69616D, 0,                // OpEntryPoint Vertex %1 "main"
+        0x00020013, 2,                                  // %2 = OpTypeVoid
+        0x00030021, 3, 2,                               // %3 = OpTypeFunction %2
+        0x00050036, 2, 1, 0, 3,                         // %1 = OpFunction %2 None %3
+        0x000200F8, 4,                                  // %4 = OpLabel
+        0x000100FD,                                     // OpReturn
+        0x00010038                                      // OpFunctionEnd
+};
+
+const uint32_t fragment_shader[] = {
+        0x07230203, 0x00010000, 0x00000000, 5, 0,
+        0x00020011, 1,                                  // OpCapability Shader
+        0x0003000E, 0, 1,                               // OpMemoryModel Logical GLSL450
+        0x0005000F, 4, 1, 0x6E69616D, 0,                // OpEntryPoint Fragment %1 "main"
+        0x00030010, 1, 7,                               // OpExecutionMode %1 OriginUpperLeft
+        0x00020013, 2,                                  // %2 = OpTypeVoid
+        0x00030021, 3, 2,                               // %3 = OpTypeFunction %2
+        0x00050036, 2, 1, 0, 3,                         // %1 = OpFunction %2 None %3
+        0x000200F8, 4,                                  // %4 = OpLabel
+        0x000100FD,                                     // OpReturn
+        0x00010038                                      // OpFunctionEnd
+};
+
+// The image and sampler index of a bindless draw.
+const VkPushConstantRange index_range = {VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0,
+                                         2 * sizeof(uint32_t)};
+
+struct Image {
+    VkImage          image{VK_NULL_HANDLE};
+    VkImageView      view{VK_NULL_HANDLE};
+    MemoryAllocation allocation;
+};
+
+struct FrameTimes {
+    double record_ms{0.0};    // per frame
+    double frame_ms{0.0};     // per frame, recording to fence signal
+};
+
+bool create_image(const DeviceDispatch &dispatch, MemoryAllocator &allocator, VkFormat format, VkExtent2D extent,
+                  VkImageUsageFlags usage, Image &image) {
+    VkImageCreateInfo image_create_info = {
+            VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            nullptr,
+            0,
+            VK_IMAGE_TYPE_2D,
+            format,
+            {extent.width, extent.height, 1},
+            1,
+            1,
+            VK_SAMPLE_COUNT_1_BIT,
+            VK_IMAGE_TILING_OPTIMAL,
+            usage,
+            VK_SHARING_MODE_EXCLUSIVE,
+            0,
+            nullptr,
+            VK_IMAGE_LAYOUT_UNDEFINED
+    };
+    if (dispatch.vkCreateImage(dispatch.device, &image_create_info, nullptr, &image.image) != VK_SUCCESS) {
+        std::cout << "Could not create an image." << std::endl;
+        return false;
+    }
+    if (allocator.allocate_for_image(image.image, VK_IMAGE_TILING_OPTIMAL, MemoryUsage::GpuOnly, 0,
+                                     image.allocation) != VK_SUCCESS) {
+        return false;
+    }
+    VkImageViewCreateInfo image_view_create_info = {
+            VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            nullptr,
+            0,
+            image.image,
+            VK_IMAGE_VIEW_TYPE_2D,
+            format,
+            {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
+             VK_COMPONENT_SWIZZLE_IDENTITY},
+            {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}
+    };
+    if (dispatch.vkCreateImageView(dispatch.device, &image_view_create_info, nullptr, &image.view) != VK_SUCCESS) {
+        std::cout << "Could not create an image view." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void destroy_image(const DeviceDispatch &dispatch, MemoryAllocator &allocator, Image &image) {
+    if (image.view != VK_NULL_HANDLE) {
+        dispatch.vkDestroyImageView(dispatch.device, image.view, nullptr);
+    }
+    if (image.image != VK_NULL_HANDLE) {
+        dispatch.vkDestroyImage(dispatch.device, image.image, nullptr);
+    }
+    if (image.allocation.memory != VK_NULL_HANDLE) {
+        allocator.free(image.allocation);
+    }
+}
+
+VkResult create_pipeline(const DeviceDispatch &dispatch, const VkShaderModule shader_modules[2],
+                         VkPipelineLayout pipeline_layout, VkRenderPass render_pass, VkPipeline &pipeline) {
+    GraphicsPipelineDescription description;
+    description.stages = {
+            {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0, VK_SHADER_STAGE_VERTEX_BIT,
+             shader_modules[0], "main", nullptr},
+            {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0, VK_SHADER_STAGE_FRAGMENT_BIT,
+             shader_modules[1], "main", nullptr}
+    };
+    description.input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    description.input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    description.rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    description.rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+    description.rasterization.cullMode = VK_CULL_MODE_NONE;
+    description.rasterization.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    description.rasterization.lineWidth = 1.0f;
+    description.multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    description.multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    description.depth_stencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    VkPipelineColorBlendAttachmentState blend_attachment{};
+    blend_attachment.colorWriteMask = 0xf;
+    description.blend_attachments.push_back(blend_attachment);
+    description.dynamic_states = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    description.layout = pipeline_layout;
+    description.render_pass = render_pass;
+    return create_graphics_pipeline(dispatch, VK_NULL_HANDLE, description, pipeline);
+}
+
+// Records frame_count + 1 frames of one render pass each, calls record_draws
+// between the pipeline bind and the end of the render pass, and submits and
+// waits for every frame.
+template <typename RecordDraws>
+bool run_frames(const DeviceDispatch &dispatch, VkQueue queue, VkCommandBuffer command_buffer, VkFence fence,
+                VkRenderPass render_pass, VkFramebuffer framebuffer, VkPipeline pipeline, uint32_t frame_count,
+                RecordDraws record_draws, FrameTimes &times) {
+    const VkCommandBufferBeginInfo command_buffer_begin_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            nullptr,
+            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            nullptr
+    };
+    const VkRenderPassBeginInfo render_pass_begin_info = {
+            VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+            nullptr,
+            render_pass,
+            framebuffer,
+            {{0, 0}, target_extent},
+            0,
+            nullptr
+    };
+    const VkViewport viewport = {0.0f, 0.0f, float(target_extent.width), float(target_extent.height), 0.0f, 1.0f};
+    const VkRect2D scissor = {{0, 0}, target_extent};
+    VkSubmitInfo submit_info = {
+            VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            nullptr,
+            0,
+            nullptr,
+            nullptr,
+            1,
+            &command_buffer,
+            0,
+            nullptr
+    };
+
+    times = FrameTimes{};
+    for (uint32_t frame = 0; frame <= frame_count; ++frame) {
+        auto frame_start = std::chrono::steady_clock::now();
+        dispatch.vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info);
+        dispatch.vkCmdBeginRenderPass(command_buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+        dispatch.vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        dispatch.vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+        dispatch.vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+        if (!record_draws(command_buffer)) {
+            dispatch.vkEndCommandBuffer(command_buffer);
+            return false;
+        }
+        dispatch.vkCmdEndRenderPass(command_buffer);
+        dispatch.vkEndCommandBuffer(command_buffer);
+        auto record_end = std::chrono::steady_clock::now();
+
+        dispatch.vkResetFences(dispatch.device, 1, &fence);
+        if (dispatch.vkQueueSubmit(queue, 1, &submit_info, fence) != VK_SUCCESS ||
+            dispatch.vkWaitForFences(dispatch.device, 1, &fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS) {
+            std::cout << "Could not submit a frame." << std::endl;
+            return false;
+        }
+        dispatch.vkResetCommandBuffer(command_buffer, 0);
+        if (frame > 0) {
+            auto frame_end = std::chrono::steady_clock::now();
+            times.record_ms += std::chrono::duration<double, std::milli>(record_end - frame_start).count();
+            times.frame_ms += std::chrono::duration<double, std::milli>(frame_end - frame_start).count();
+        }
+    }
+    times.record_ms /= frame_count;
+    times.frame_ms /= frame_count;
+    return true;
+}
+
+void print_times(const char *name, uint32_t draw_count, const FrameTimes &times) {
+    std::cout << name << "record " << times.record_ms << " ms/frame ("
+              << draw_count / (times.record_ms / 1000.0) << " draws/s), frame " << times.frame_ms << " ms"
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    uint32_t draw_count = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 10000;
+    uint32_t frame_count = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 20;
+    draw_count = std::max(draw_count, 1u);
+    frame_count = std::max(frame_count, 1u);
+
+    void *vulkan_library = load_vulkan_library();
+    auto vkGetInstanceProcAddr = load_exported_vulkan_function(vulkan_library);
+    if (vkGetInstanceProcAddr == nullptr) {
+        return -1;
+    }
+    GlobalFunctions global_functions{};
+    if (!load_global_level_functions(vkGetInstanceProcAddr, global_functions)) {
+        return -1;
+    }
+
+    VkApplicationInfo application_info = {
+            VK_STRUCTURE_TYPE_APPLICATION_INFO,
+            nullptr,
+            "bindless_benchmark",
+            VK_MAKE_VERSION(1, 0, 0),
+            "Vulkan Cookbook",
+            VK_MAKE_VERSION(1, 0, 0),
+            VK_MAKE_VERSION(1, 1, 0)
+    };
+    std::vector<char const *> instance_extensions = {VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME};
+    VkInstanceCreateInfo instance_create_info = {
+            VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+            nullptr,
+            0,
+            &application_info,
+            0,
+            nullptr,
+            static_cast<uint32_t>(instance_extensions.size()),
+            instance_extensions.data()
+    };
+    VkInstance instance{VK_NULL_HANDLE};
+    if (global_functions.vkCreateInstance(&instance_create_info, nullptr, &instance) != VK_SUCCESS) {
+        std::cout << "Could not create Vulkan instance." << std::endl;
+        return -1;
+    }
+    InstanceFunctions instance_functions{};
+    if (!load_instance_level_functions(vkGetInstanceProcAddr, instance, instance_extensions, instance_functions)) {
+        return -1;
+    }
+
+    uint32_t physical_device_count = 1;
+    VkPhysicalDevice physical_device{VK_NULL_HANDLE};
+    VkResult result = instance_functions.vkEnumeratePhysicalDevices(instance, &physical_device_count, &physical_device);
+    if ((result != VK_SUCCESS && result != VK_INCOMPLETE) || physical_device_count == 0) {
+        std::cout << "Could not enumerate physical devices." << std::endl;
+        return -1;
+    }
+    VkPhysicalDeviceProperties device_properties;
+    instance_functions.vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+    VkPhysicalDeviceMemoryProperties memory_properties;
+    instance_functions.vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
+
+    uint32_t extension_count = 0;
+    instance_functions.vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, nullptr);
+    std::vector<VkExtensionProperties> available_extensions(extension_count);
+    instance_functions.vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count,
+                                                            available_extensions.data());
+    BindlessHeapSizes heap_sizes;
+    heap_sizes.sampled_images = std::min(draw_count, heap_sizes.sampled_images);
+    heap_sizes.samplers = 1;
+    heap_sizes.storage_buffers = 1;
+    if (!bindless_extensions_supported(available_extensions) ||
+        !query_bindless_support(instance_functions, physical_device, heap_sizes)) {
+        std::cout << device_properties.deviceName << " does not support bindless descriptors." << std::endl;
+        return -1;
+    }
+
+    uint32_t queue_family_count = 0;
+    instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_families.data());
+    uint32_t graphics_queue_family_index = queue_family_count;
+    for (uint32_t i = 0; i < queue_family_count; ++i) {
+        if ((queue_families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0) {
+            graphics_queue_family_index = i;
+            break;
+        }
+    }
+    if (graphics_queue_family_index == queue_family_count) {
+        std::cout << "Could not find a graphics queue family." << std::endl;
+        return -1;
+    }
+
+    float queue_priority = 1.0f;
+    VkDeviceQueueCreateInfo queue_create_info = {
+            VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            nullptr,
+            0,
+            graphics_queue_family_index,
+            1,
+            &queue_priority
+    };
+    std::vector<char const *> device_extensions = bindless_device_extensions();
+    VkPhysicalDeviceDescriptorIndexingFeatures indexing_features = bindless_required_features();
+    VkDeviceCreateInfo device_create_info = {
+            VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+            &indexing_features,
+            0,
+            1,
+            &queue_create_info,
+            0,
+            nullptr,
+            static_cast<uint32_t>(device_extensions.size()),
+            device_extensions.data(),
+            nullptr
+    };
+    VkDevice logical_device{VK_NULL_HANDLE};
+    if (instance_functions.vkCreateDevice(physical_device, &device_create_info, nullptr, &logical_device) != VK_SUCCESS) {
+        std::cout << "Could not create logical device." << std::endl;
+        return -1;
+    }
+    DeviceDispatch dispatch;
+    if (!create_device_dispatch(instance_functions.vkGetDeviceProcAddr, logical_device, device_extensions, dispatch)) {
+        return -1;
+    }
+    VkQueue queue{VK_NULL_HANDLE};
+    dispatch.vkGetDeviceQueue(logical_device, graphics_queue_family_index, 0, &queue);
+
+    MemoryAllocator allocator;
+    if (!allocator.init(dispatch, memory_properties, device_properties.limits)) {
+        return -1;
+    }
+    Image target;
+    Image texture;
+    if (!create_image(dispatch, allocator, VK_FORMAT_B8G8R8A8_UNORM, target_extent,
+                      VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, target) ||
+        !create_image(dispatch, allocator, VK_FORMAT_R8G8B8A8_UNORM, {4, 4}, VK_IMAGE_USAGE_SAMPLED_BIT, texture)) {
+        return -1;
+    }
+    VkSamplerCreateInfo sampler_create_info{};
+    sampler_create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_create_info.magFilter = VK_FILTER_NEAREST;
+    sampler_create_info.minFilter = VK_FILTER_NEAREST;
+    sampler_create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sampler_create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_create_info.maxLod = 1.0f;
+    sampler_create_info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK;
+    VkSampler sampler{VK_NULL_HANDLE};
+    if (dispatch.vkCreateSampler(logical_device, &sampler_create_info, nullptr, &sampler) != VK_SUCCESS) {
+        std::cout << "Could not create a sampler." << std::endl;
+        return -1;
+    }
+
+    VkAttachmentDescription attachment = {
+            0,
+            VK_FORMAT_B8G8R8A8_UNORM,
+            VK_SAMPLE_COUNT_1_BIT,
+            VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            VK_ATTACHMENT_STORE_OP_STORE,
+            VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+    };
+    VkAttachmentReference color_reference = {0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    VkSubpassDescription subpass = {
+            0,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            0,
+            nullptr,
+            1,
+            &color_reference,
+            nullptr,
+            nullptr,
+            0,
+            nullptr
+    };
+    VkRenderPassCreateInfo render_pass_create_info = {
+            VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+            nullptr,
+            0,
+            1,
+            &attachment,
+            1,
+            &subpass,
+            0,
+            nullptr
+    };
+    VkRenderPass render_pass{VK_NULL_HANDLE};
+    if (dispatch.vkCreateRenderPass(logical_device, &render_pass_create_info, nullptr, &render_pass) != VK_SUCCESS) {
+        std::cout << "Could not create a render pass." << std::endl;
+        return -1;
+    }
+    VkFramebufferCreateInfo framebuffer_create_info = {
+            VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+            nullptr,
+            0,
+            render_pass,
+            1,
+            &target.view,
+            target_extent.width,
+            target_extent.height,
+            1
+    };
+    VkFramebuffer framebuffer{VK_NULL_HANDLE};
+    if (dispatch.vkCreateFramebuffer(logical_device, &framebuffer_create_info, nullptr, &framebuffer) != VK_SUCCESS) {
+        std::cout << "Could not create a framebuffer." << std::endl;
+        return -1;
+    }
+
+    VkCommandPoolCreateInfo command_pool_create_info = {
+            VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            nullptr,
+            VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+            graphics_queue_family_index
+    };
+    VkCommandPool command_pool{VK_NULL_HANDLE};
+    if (dispatch.vkCreateCommandPool(logical_device, &command_pool_create_info, nullptr, &command_pool) != VK_SUCCESS) {
+        std::cout << "Could not create a command pool." << std::endl;
+        return -1;
+    }
+    VkCommandBufferAllocateInfo command_buffer_allocate_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            nullptr,
+            command_pool,
+            VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            1
+    };
+    VkCommandBuffer command_buffer{VK_NULL_HANDLE};
+    if (dispatch.vkAllocateCommandBuffers(logical_device, &command_buffer_allocate_info, &command_buffer) != VK_SUCCESS) {
+        std::cout << "Could not allocate a command buffer." << std::endl;
+        return -1;
+    }
+    VkFenceCreateInfo fence_create_info = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, nullptr, 0};
+    VkFence fence{VK_NULL_HANDLE};
+    if (dispatch.vkCreateFence(logical_device, &fence_create_info, nullptr, &fence) != VK_SUCCESS) {
+        std::cout << "Could not create a fence." << std::endl;
+        return -1;
+    }
+
+    // The texture is never written; it only has to be in the layout the
+    // descriptors name.
+    const VkCommandBufferBeginInfo command_buffer_begin_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            nullptr,
+            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            nullptr
+    };
+    VkImageMemoryBarrier texture_barrier = {
+            VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            nullptr,
+            0,
+            VK_ACCESS_SHADER_READ_BIT,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_QUEUE_FAMILY_IGNORED,
+            VK_QUEUE_FAMILY_IGNORED,
+            texture.image,
+            {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}
+    };
+    dispatch.vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info);
+    dispatch.vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                  VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                                  &texture_barrier);
+    dispatch.vkEndCommandBuffer(command_buffer);
+    VkSubmitInfo submit_info = {
+            VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            nullptr,
+            0,
+            nullptr,
+            nullptr,
+            1,
+            &command_buffer,
+            0,
+            nullptr
+    };
+    if (dispatch.vkQueueSubmit(queue, 1, &submit_info, fence) != VK_SUCCESS ||
+        dispatch.vkWaitForFences(logical_device, 1, &fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS) {
+        std::cout << "Could not transition the texture." << std::endl;
+        return -1;
+    }
+    dispatch.vkResetCommandBuffer(command_buffer, 0);
+
+    VkShaderModule shader_modules[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+    const uint32_t *shader_code[2] = {vertex_shader, fragment_shader};
+    const size_t shader_size[2] = {sizeof(vertex_shader), sizeof(fragment_shader)};
+    for (uint32_t i = 0; i < 2; ++i) {
+        VkShaderModuleCreateInfo shader_module_create_info = {
+                VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+                nullptr,
+                0,
+                shader_size[i],
+                shader_code[i]
+        };
+        if (dispatch.vkCreateShaderModule(logical_device, &shader_module_create_info, nullptr,
+                                          &shader_modules[i]) != VK_SUCCESS) {
+            std::cout << "Could not create a shader module." << std::endl;
+            return -1;
+        }
+    }
+
+    // Per-set path: one combined image sampler per draw.
+    VkDescriptorSetLayoutBinding texture_binding = {
+            0,
+            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            1,
+            VK_SHADER_STAGE_FRAGMENT_BIT,
+            nullptr
+    };
+    VkDescriptorSetLayoutCreateInfo set_layout_create_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            nullptr,
+            0,
+            1,
+            &texture_binding
+    };
+    VkDescriptorSetLayout set_layout{VK_NULL_HANDLE};
+    if (dispatch.vkCreateDescriptorSetLayout(logical_device, &set_layout_create_info, nullptr, &set_layout) != VK_SUCCESS) {
+        std::cout << "Could not create a descriptor set layout." << std::endl;
+        return -1;
+    }
+    VkPipelineLayoutCreateInfo pipeline_layout_create_info = {
+            VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            nullptr,
+            0,
+            1,
+            &set_layout,
+            0,
+            nullptr
+    };
+    VkPipelineLayout per_set_layout{VK_NULL_HANDLE};
+    if (dispatch.vkCreatePipelineLayout(logical_device, &pipeline_layout_create_info, nullptr, &per_set_layout) != VK_SUCCESS) {
+        std::cout << "Could not create a pipeline layout." << std::endl;
+        return -1;
+    }
+    VkPipeline per_set_pipeline{VK_NULL_HANDLE};
+    if (create_pipeline(dispatch, shader_modules, per_set_layout, render_pass, per_set_pipeline) != VK_SUCCESS) {
+        return -1;
+    }
+    DescriptorAllocator descriptor_allocator;
+    if (!descriptor_allocator.init(dispatch, {{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f}})) {
+        return -1;
+    }
+
+    // Bindless path: every draw gets its own image index, as if each had a
+    // texture of its own, while all slots show the same view.
+    BindlessDescriptorHeap heap;
+    if (!heap.init(dispatch, heap_sizes, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT)) {
+        return -1;
+    }
+    std::vector<uint32_t> image_indices(heap_sizes.sampled_images);
+    for (auto &index : image_indices) {
+        index = heap.add_sampled_image(texture.view);
+    }
+    uint32_t sampler_index = heap.add_sampler(sampler);
+    heap.flush();
+    VkDescriptorSetLayout heap_layout = heap.layout();
+    pipeline_layout_create_info.pSetLayouts = &heap_layout;
+    pipeline_layout_create_info.pushConstantRangeCount = 1;
+    pipeline_layout_create_info.pPushConstantRanges = &index_range;
+    VkPipelineLayout bindless_layout{VK_NULL_HANDLE};
+    if (dispatch.vkCreatePipelineLayout(logical_device, &pipeline_layout_create_info, nullptr, &bindless_layout) != VK_SUCCESS) {
+        std::cout << "Could not create a pipeline layout." << std::endl;
+        return -1;
+    }
+    VkPipeline bindless_pipeline{VK_NULL_HANDLE};
+    if (create_pipeline(dispatch, shader_modules, bindless_layout, render_pass, bindless_pipeline) != VK_SUCCESS) {
+        return -1;
+    }
+
+    FrameTimes per_set_times;
+    bool per_set_ok = run_frames(dispatch, queue, command_buffer, fence, render_pass, framebuffer, per_set_pipeline,
+                                 frame_count, [&](VkCommandBuffer command_buffer) {
+        descriptor_allocator.reset();
+        VkDescriptorImageInfo image_info = {sampler, texture.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+        VkWriteDescriptorSet write = {
+                VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                nullptr,
+                VK_NULL_HANDLE,
+                0,
+                0,
+                1,
+                VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                &image_info,
+                nullptr,
+                nullptr
+        };
+        for (uint32_t i = 0; i < draw_count; ++i) {
+            VkDescriptorSet set{VK_NULL_HANDLE};
+            if (descriptor_allocator.allocate(set_layout, set) != VK_SUCCESS) {
+                return false;
+            }
+            write.dstSet = set;
+            dispatch.vkUpdateDescriptorSets(logical_device, 1, &write, 0, nullptr);
+            dispatch.vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, per_set_layout, 0, 1,
+                                             &set, 0, nullptr);
+            dispatch.vkCmdDraw(command_buffer, 3, 1, 0, 0);
+        }
+        return true;
+    }, per_set_times);
+    uint32_t descriptor_pools = descriptor_allocator.statistics().pools;
+
+    FrameTimes bindless_times;
+    bool bindless_ok = run_frames(dispatch, queue, command_buffer, fence, render_pass, framebuffer, bindless_pipeline,
+                                  frame_count, [&](VkCommandBuffer command_buffer) {
+        heap.bind(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, bindless_layout);
+        for (uint32_t i = 0; i < draw_count; ++i) {
+            const uint32_t indices[2] = {image_indices[i % image_indices.size()], sampler_index};
+            dispatch.vkCmdPushConstants(command_buffer, bindless_layout, index_range.stageFlags, 0,
+                                        index_range.size, indices);
+            dispatch.vkCmdDraw(command_buffer, 3, 1, 0, 0);
+        }
+        return true;
+    }, bindless_times);
+
+    if (per_set_ok && bindless_ok) {
+        std::cout << draw_count << " draws per frame, " << frame_count << " frames, " << device_properties.deviceName
+                  << std::endl;
+        print_times("set per draw: ", draw_count, per_set_times);
+        print_times("bindless:     ", draw_count, bindless_times);
+        std::cout << "descriptor pools for the per-draw sets: " << descriptor_pools << std::endl;
+        std::cout << "recording speedup: " << per_set_times.record_ms / bindless_times.record_ms << "x" << std::endl;
+    }
+
+    dispatch.vkDestroyPipeline(logical_device, bindless_pipeline, nullptr);
+    dispatch.vkDestroyPipelineLayout(logical_device, bindless_layout, nullptr);
+    heap.destroy();
+    descriptor_allocator.destroy();
+    dispatch.vkDestroyPipeline(logical_device, per_set_pipeline, nullptr);
+    dispatch.vkDestroyPipelineLayout(logical_device, per_set_layout, nullptr);
+    dispatch.vkDestroyDescriptorSetLayout(logical_device, set_layout, nullptr);
+    for (auto shader_module : shader_modules) {
+        dispatch.vkDestroyShaderModule(logical_device, shader_module, nullptr);
+    }
+    dispatch.vkDestroyFence(logical_device, fence, nullptr);
+    dispatch.vkDestroyCommandPool(logical_device, command_pool, nullptr);
+    dispatch.vkDestroyFramebuffer(logical_device, framebuffer, nullptr);
+    dispatch.vkDestroyRenderPass(logical_device, render_pass, nullptr);
+    dispatch.vkDestroySampler(logical_device, sampler, nullptr);
+    destroy_image(dispatch, allocator, texture);
+    destroy_image(dispatch, allocator, target);
+    allocator.destroy();
+    dispatch.vkDestroyDevice(logical_device, nullptr);
+    destroy_device_dispatch(dispatch);
+    instance_functions.vkDestroyInstance(instance, nullptr);
+    unload_vulkan_library(vulkan_library);
+    return per_set_ok && bindless_ok ? 0 : -1;
+}
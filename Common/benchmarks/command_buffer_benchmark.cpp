@@ -0,0 +1,321 @@
+//
+// Compares three ways of getting buffers_per_frame command buffers ready for
+// recording every frame:
+//
+//   per-buffer reset  buffers allocated once from a pool created with
+//                     VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, each
+//                     reset with vkResetCommandBuffer
+//   free + allocate   buffers allocated one by one and freed with
+//                     vkFreeCommandBuffers once the frame's fence signals
+//   pool reset        a CommandBufferAllocator, one vkResetCommandPool per
+//                     frame
+//
+// Each buffer records the same few barriers, and a frame is submitted and
+// waited for before the next one starts. Allocation and reset time per frame
+// is printed next to the recording time, which the approaches should not
+// change much. The first frame of each run is a warm-up and is not counted.
+//
+
+#include "command_buffer_allocator.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+const uint32_t barriers_per_buffer = 16;
+const uint32_t allocator_frame_count = 2;
+
+enum class Path {
+    PerBufferReset,
+    FreeAndAllocate,
+    PoolReset
+};
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct FrameCosts {
+    double acquire_ms{0.0};    // resetting or allocating before recording
+    double release_ms{0.0};    // freeing after the fence
+    double record_ms{0.0};
+};
+
+void record(const DeviceDispatch &dispatch, VkCommandBuffer command_buffer) {
+    const VkCommandBufferBeginInfo command_buffer_begin_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            nullptr,
+            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            nullptr
+    };
+    const VkMemoryBarrier memory_barrier = {
+            VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            nullptr,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_TRANSFER_READ_BIT
+    };
+    dispatch.vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info);
+    for (uint32_t i = 0; i < barriers_per_buffer; ++i) {
+        dispatch.vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                      0, 1, &memory_barrier, 0, nullptr, 0, nullptr);
+    }
+    dispatch.vkEndCommandBuffer(command_buffer);
+}
+
+// Runs frame_count + 1 frames along path and returns the average costs of
+// all but the first.
+bool run_frames(const DeviceDispatch &dispatch, uint32_t queue_family_index, VkQueue queue, VkFence fence,
+                Path path, uint32_t buffers_per_frame, uint32_t frame_count, FrameCosts &costs) {
+    VkDevice device = dispatch.device;
+    VkCommandPoolCreateInfo command_pool_create_info = {
+            VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            nullptr,
+            path == Path::PerBufferReset ? VkCommandPoolCreateFlags(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT) : 0,
+            queue_family_index
+    };
+    VkCommandPool command_pool{VK_NULL_HANDLE};
+    CommandBufferAllocator allocator;
+    std::vector<VkCommandBuffer> command_buffers(buffers_per_frame, VK_NULL_HANDLE);
+    if (path == Path::PoolReset) {
+        if (!allocator.init(dispatch, queue_family_index, allocator_frame_count)) {
+            return false;
+        }
+    } else if (dispatch.vkCreateCommandPool(device, &command_pool_create_info, nullptr, &command_pool) != VK_SUCCESS) {
+        std::cout << "Could not create a command pool." << std::endl;
+        return false;
+    }
+    VkCommandBufferAllocateInfo command_buffer_allocate_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            nullptr,
+            command_pool,
+            VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            path == Path::PerBufferReset ? buffers_per_frame : 1
+    };
+    if (path == Path::PerBufferReset &&
+        dispatch.vkAllocateCommandBuffers(device, &command_buffer_allocate_info, command_buffers.data()) != VK_SUCCESS) {
+        std::cout << "Could not allocate command buffers." << std::endl;
+        dispatch.vkDestroyCommandPool(device, command_pool, nullptr);
+        return false;
+    }
+    VkSubmitInfo submit_info = {
+            VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            nullptr,
+            0,
+            nullptr,
+            nullptr,
+            buffers_per_frame,
+            command_buffers.data(),
+            0,
+            nullptr
+    };
+
+    bool ok = true;
+    costs = FrameCosts{};
+    for (uint32_t frame = 0; frame <= frame_count; ++frame) {
+        FrameCosts frame_costs;
+        auto start = std::chrono::steady_clock::now();
+        switch (path) {
+            case Path::PerBufferReset:
+                for (auto command_buffer : command_buffers) {
+                    ok = ok && dispatch.vkResetCommandBuffer(command_buffer, 0) == VK_SUCCESS;
+                }
+                break;
+            case Path::FreeAndAllocate:
+                for (auto &command_buffer : command_buffers) {
+                    ok = ok && dispatch.vkAllocateCommandBuffers(device, &command_buffer_allocate_info,
+                                                                 &command_buffer) == VK_SUCCESS;
+                }
+                break;
+            case Path::PoolReset:
+                ok = allocator.begin_frame(frame) == VK_SUCCESS;
+                for (auto &command_buffer : command_buffers) {
+                    ok = ok && allocator.allocate(command_buffer) == VK_SUCCESS;
+                }
+                break;
+        }
+        frame_costs.acquire_ms = elapsed_ms(start);
+        if (!ok) {
+            std::cout << "Could not get command buffers for a frame." << std::endl;
+            break;
+        }
+
+        start = std::chrono::steady_clock::now();
+        for (auto command_buffer : command_buffers) {
+            record(dispatch, command_buffer);
+        }
+        frame_costs.record_ms = elapsed_ms(start);
+
+        dispatch.vkResetFences(device, 1, &fence);
+        if (dispatch.vkQueueSubmit(queue, 1, &submit_info, fence) != VK_SUCCESS ||
+            dispatch.vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS) {
+            std::cout << "Could not submit a frame." << std::endl;
+            ok = false;
+            break;
+        }
+
+        if (path == Path::FreeAndAllocate) {
+            start = std::chrono::steady_clock::now();
+            dispatch.vkFreeCommandBuffers(device, command_pool, buffers_per_frame, command_buffers.data());
+            frame_costs.release_ms = elapsed_ms(start);
+        }
+        if (frame > 0) {
+            costs.acquire_ms += frame_costs.acquire_ms;
+            costs.release_ms += frame_costs.release_ms;
+            costs.record_ms += frame_costs.record_ms;
+        }
+    }
+    allocator.destroy();
+    if (command_pool != VK_NULL_HANDLE) {
+        dispatch.vkDestroyCommandPool(device, command_pool, nullptr);
+    }
+    costs.acquire_ms /= frame_count;
+    costs.release_ms /= frame_count;
+    costs.record_ms /= frame_count;
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    uint32_t buffers_per_frame = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 256;
+    uint32_t frame_count = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 100;
+    buffers_per_frame = std::max(buffers_per_frame, 1u);
+    frame_count = std::max(frame_count, 1u);
+
+    void *vulkan_library = load_vulkan_library();
+    auto vkGetInstanceProcAddr = load_exported_vulkan_function(vulkan_library);
+    if (vkGetInstanceProcAddr == nullptr) {
+        return -1;
+    }
+    GlobalFunctions global_functions{};
+    if (!load_global_level_functions(vkGetInstanceProcAddr, global_functions)) {
+        return -1;
+    }
+
+    VkApplicationInfo application_info = {
+            VK_STRUCTURE_TYPE_APPLICATION_INFO,
+            nullptr,
+            "command_buffer_benchmark",
+            VK_MAKE_VERSION(1, 0, 0),
+            "Vulkan Cookbook",
+            VK_MAKE_VERSION(1, 0, 0),
+            VK_MAKE_VERSION(1, 1, 0)
+    };
+    VkInstanceCreateInfo instance_create_info = {
+            VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+            nullptr,
+            0,
+            &application_info,
+            0,
+            nullptr,
+            0,
+            nullptr
+    };
+    VkInstance instance{VK_NULL_HANDLE};
+    if (global_functions.vkCreateInstance(&instance_create_info, nullptr, &instance) != VK_SUCCESS) {
+        std::cout << "Could not create Vulkan instance." << std::endl;
+        return -1;
+    }
+    InstanceFunctions instance_functions{};
+    if (!load_instance_level_functions(vkGetInstanceProcAddr, instance, {}, instance_functions)) {
+        return -1;
+    }
+
+    uint32_t physical_device_count = 1;
+    VkPhysicalDevice physical_device{VK_NULL_HANDLE};
+    VkResult result = instance_functions.vkEnumeratePhysicalDevices(instance, &physical_device_count, &physical_device);
+    if ((result != VK_SUCCESS && result != VK_INCOMPLETE) || physical_device_count == 0) {
+        std::cout << "Could not enumerate physical devices." << std::endl;
+        return -1;
+    }
+    VkPhysicalDeviceProperties device_properties;
+    instance_functions.vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+
+    uint32_t queue_family_count = 0;
+    instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_families.data());
+    uint32_t graphics_queue_family_index = queue_family_count;
+    for (uint32_t i = 0; i < queue_family_count; ++i) {
+        if ((queue_families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0) {
+            graphics_queue_family_index = i;
+            break;
+        }
+    }
+    if (graphics_queue_family_index == queue_family_count) {
+        std::cout << "Could not find a graphics queue family." << std::endl;
+        return -1;
+    }
+
+    float queue_priority = 1.0f;
+    VkDeviceQueueCreateInfo queue_create_info = {
+            VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            nullptr,
+            0,
+            graphics_queue_family_index,
+            1,
+            &queue_priority
+    };
+    VkDeviceCreateInfo device_create_info = {
+            VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+            nullptr,
+            0,
+            1,
+            &queue_create_info,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            nullptr
+    };
+    VkDevice logical_device{VK_NULL_HANDLE};
+    if (instance_functions.vkCreateDevice(physical_device, &device_create_info, nullptr, &logical_device) != VK_SUCCESS) {
+        std::cout << "Could not create logical device." << std::endl;
+        return -1;
+    }
+    DeviceDispatch dispatch;
+    if (!create_device_dispatch(instance_functions.vkGetDeviceProcAddr, logical_device, {}, dispatch)) {
+        return -1;
+    }
+    VkQueue queue{VK_NULL_HANDLE};
+    dispatch.vkGetDeviceQueue(logical_device, graphics_queue_family_index, 0, &queue);
+
+    VkFenceCreateInfo fence_create_info = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, nullptr, 0};
+    VkFence fence{VK_NULL_HANDLE};
+    if (dispatch.vkCreateFence(logical_device, &fence_create_info, nullptr, &fence) != VK_SUCCESS) {
+        std::cout << "Could not create a fence." << std::endl;
+        return -1;
+    }
+
+    std::cout << buffers_per_frame << " command buffers per frame, " << frame_count << " frames, "
+              << device_properties.deviceName << std::endl;
+    const struct {
+        Path        path;
+        const char *name;
+    } runs[] = {
+            {Path::PerBufferReset,  "per-buffer reset: "},
+            {Path::FreeAndAllocate, "free + allocate:  "},
+            {Path::PoolReset,       "pool reset:       "}
+    };
+    bool ok = true;
+    for (const auto &run : runs) {
+        FrameCosts costs;
+        ok = run_frames(dispatch, graphics_queue_family_index, queue, fence, run.path, buffers_per_frame, frame_count,
+                        costs);
+        if (!ok) {
+            break;
+        }
+        std::cout << run.name << costs.acquire_ms + costs.release_ms << " ms/frame allocating and resetting ("
+                  << costs.acquire_ms << " before recording, " << costs.release_ms << " after the fence), "
+                  << costs.record_ms << " ms/frame recording" << std::endl;
+    }
+
+    dispatch.vkDestroyFence(logical_device, fence, nullptr);
+    dispatch.vkDestroyDevice(logical_device, nullptr);
+    destroy_device_dispatch(dispatch);
+    instance_functions.vkDestroyInstance(instance, nullptr);
+    unload_vulkan_library(vulkan_library);
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,333 @@
+//
+// Writes set_count descriptor sets of a uniform buffer and a combined image
+// sampler, round times over, three ways, and compares the sets written per
+// second:
+//
+//   per set:  one vkUpdateDescriptorSets with a hand-built write array per
+//             set, the way init_descriptor_set() used to;
+//   batched:  DescriptorWriter without templates, one vkUpdateDescriptorSets
+//             for all sets of a round;
+//   template: DescriptorWriter with VK_KHR_descriptor_update_template, one
+//             vkUpdateDescriptorSetWithTemplateKHR per set. Skipped if the
+//             device lacks the extension.
+//
+// Only the CPU side is measured; the sets are never bound.
+//
+
+#include "descriptor_allocator.h"
+#include "descriptor_writer.h"
+#include "memory_allocator.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+// The block a template reads for one set.
+struct SetDescriptors {
+    VkDescriptorBufferInfo uniform;
+    VkDescriptorImageInfo  texture;
+};
+
+void print_rate(const char *name, uint64_t sets, double ms, uint64_t update_calls) {
+    std::cout << name << sets / (ms / 1000.0) << " sets/s (" << ms << " ms, " << update_calls << " update calls)"
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    uint32_t set_count = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 10000;
+    uint32_t round_count = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 20;
+    if (set_count == 0) {
+        set_count = 1;
+    }
+    if (round_count == 0) {
+        round_count = 1;
+    }
+
+    void *vulkan_library = load_vulkan_library();
+    auto vkGetInstanceProcAddr = load_exported_vulkan_function(vulkan_library);
+    if (vkGetInstanceProcAddr == nullptr) {
+        return -1;
+    }
+    GlobalFunctions global_functions{};
+    if (!load_global_level_functions(vkGetInstanceProcAddr, global_functions)) {
+        return -1;
+    }
+
+    VkApplicationInfo application_info = {
+            VK_STRUCTURE_TYPE_APPLICATION_INFO,
+            nullptr,
+            "descriptor_write_benchmark",
+            VK_MAKE_VERSION(1, 0, 0),
+            "Vulkan Cookbook",
+            VK_MAKE_VERSION(1, 0, 0),
+            VK_MAKE_VERSION(1, 1, 0)
+    };
+    VkInstanceCreateInfo instance_create_info = {
+            VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+            nullptr,
+            0,
+            &application_info,
+            0,
+            nullptr,
+            0,
+            nullptr
+    };
+    VkInstance instance{VK_NULL_HANDLE};
+    if (global_functions.vkCreateInstance(&instance_create_info, nullptr, &instance) != VK_SUCCESS) {
+        std::cout << "Could not create Vulkan instance." << std::endl;
+        return -1;
+    }
+    InstanceFunctions instance_functions{};
+    if (!load_instance_level_functions(vkGetInstanceProcAddr, instance, {}, instance_functions)) {
+        return -1;
+    }
+
+    uint32_t physical_device_count = 1;
+    VkPhysicalDevice physical_device{VK_NULL_HANDLE};
+    VkResult result = instance_functions.vkEnumeratePhysicalDevices(instance, &physical_device_count, &physical_device);
+    if ((result != VK_SUCCESS && result != VK_INCOMPLETE) || physical_device_count == 0) {
+        std::cout << "Could not enumerate physical devices." << std::endl;
+        return -1;
+    }
+    VkPhysicalDeviceProperties device_properties;
+    instance_functions.vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+    VkPhysicalDeviceMemoryProperties memory_properties;
+    instance_functions.vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
+
+    uint32_t extension_count = 0;
+    instance_functions.vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, nullptr);
+    std::vector<VkExtensionProperties> available_extensions(extension_count);
+    instance_functions.vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count,
+                                                            available_extensions.data());
+    std::vector<char const *> device_extensions;
+    if (descriptor_update_template_supported(available_extensions)) {
+        device_extensions.push_back(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+    }
+
+    float queue_priority = 1.0f;
+    VkDeviceQueueCreateInfo queue_create_info = {
+            VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            nullptr,
+            0,
+            0,
+            1,
+            &queue_priority
+    };
+    VkDeviceCreateInfo device_create_info = {
+            VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+            nullptr,
+            0,
+            1,
+            &queue_create_info,
+            0,
+            nullptr,
+            static_cast<uint32_t>(device_extensions.size()),
+            device_extensions.data(),
+            nullptr
+    };
+    VkDevice logical_device{VK_NULL_HANDLE};
+    if (instance_functions.vkCreateDevice(physical_device, &device_create_info, nullptr, &logical_device) != VK_SUCCESS) {
+        std::cout << "Could not create logical device." << std::endl;
+        return -1;
+    }
+    DeviceDispatch dispatch;
+    if (!create_device_dispatch(instance_functions.vkGetDeviceProcAddr, logical_device, device_extensions, dispatch)) {
+        return -1;
+    }
+
+    // The resources the descriptors point at; their contents are never read.
+    MemoryAllocator allocator;
+    if (!allocator.init(dispatch, memory_properties, device_properties.limits)) {
+        return -1;
+    }
+    VkBufferCreateInfo buffer_create_info = {
+            VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            nullptr,
+            0,
+            256,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_SHARING_MODE_EXCLUSIVE,
+            0,
+            nullptr
+    };
+    VkBuffer buffer{VK_NULL_HANDLE};
+    MemoryAllocation buffer_allocation;
+    if (dispatch.vkCreateBuffer(logical_device, &buffer_create_info, nullptr, &buffer) != VK_SUCCESS ||
+        allocator.allocate_for_buffer(buffer, MemoryUsage::GpuOnly, 0, buffer_allocation) != VK_SUCCESS) {
+        std::cout << "Could not create a uniform buffer." << std::endl;
+        return -1;
+    }
+    VkImageCreateInfo image_create_info = {
+            VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            nullptr,
+            0,
+            VK_IMAGE_TYPE_2D,
+            VK_FORMAT_R8G8B8A8_UNORM,
+            {4, 4, 1},
+            1,
+            1,
+            VK_SAMPLE_COUNT_1_BIT,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_SAMPLED_BIT,
+            VK_SHARING_MODE_EXCLUSIVE,
+            0,
+            nullptr,
+            VK_IMAGE_LAYOUT_UNDEFINED
+    };
+    VkImage image{VK_NULL_HANDLE};
+    MemoryAllocation image_allocation;
+    if (dispatch.vkCreateImage(logical_device, &image_create_info, nullptr, &image) != VK_SUCCESS ||
+        allocator.allocate_for_image(image, VK_IMAGE_TILING_OPTIMAL, MemoryUsage::GpuOnly, 0,
+                                     image_allocation) != VK_SUCCESS) {
+        std::cout << "Could not create an image." << std::endl;
+        return -1;
+    }
+    VkImageViewCreateInfo image_view_create_info = {
+            VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            nullptr,
+            0,
+            image,
+            VK_IMAGE_VIEW_TYPE_2D,
+            VK_FORMAT_R8G8B8A8_UNORM,
+            {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
+             VK_COMPONENT_SWIZZLE_IDENTITY},
+            {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}
+    };
+    VkImageView image_view{VK_NULL_HANDLE};
+    if (dispatch.vkCreateImageView(logical_device, &image_view_create_info, nullptr, &image_view) != VK_SUCCESS) {
+        std::cout << "Could not create an image view." << std::endl;
+        return -1;
+    }
+    VkSamplerCreateInfo sampler_create_info{};
+    sampler_create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_create_info.magFilter = VK_FILTER_NEAREST;
+    sampler_create_info.minFilter = VK_FILTER_NEAREST;
+    sampler_create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sampler_create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    VkSampler sampler{VK_NULL_HANDLE};
+    if (dispatch.vkCreateSampler(logical_device, &sampler_create_info, nullptr, &sampler) != VK_SUCCESS) {
+        std::cout << "Could not create a sampler." << std::endl;
+        return -1;
+    }
+
+    VkDescriptorSetLayoutBinding bindings[2] = {
+            {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr},
+            {1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr}
+    };
+    VkDescriptorSetLayoutCreateInfo set_layout_create_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            nullptr,
+            0,
+            2,
+            bindings
+    };
+    VkDescriptorSetLayout set_layout{VK_NULL_HANDLE};
+    if (dispatch.vkCreateDescriptorSetLayout(logical_device, &set_layout_create_info, nullptr, &set_layout) != VK_SUCCESS) {
+        std::cout << "Could not create a descriptor set layout." << std::endl;
+        return -1;
+    }
+    DescriptorAllocator descriptor_allocator;
+    if (!descriptor_allocator.init(dispatch, {{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f},
+                                              {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f}},
+                                   set_count, set_count)) {
+        return -1;
+    }
+    std::vector<VkDescriptorSet> sets(set_count);
+    for (auto &set : sets) {
+        if (descriptor_allocator.allocate(set_layout, set) != VK_SUCCESS) {
+            return -1;
+        }
+    }
+
+    // Each set points at a different part of the buffer, so no two writes
+    // are identical.
+    std::vector<SetDescriptors> descriptors(set_count);
+    for (uint32_t i = 0; i < set_count; ++i) {
+        descriptors[i].uniform = {buffer, (i % 4) * 64, 64};
+        descriptors[i].texture = {sampler, image_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    }
+    const std::vector<VkDescriptorUpdateTemplateEntry> entries = {
+            {0, 0, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, offsetof(SetDescriptors, uniform), 0},
+            {1, 0, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, offsetof(SetDescriptors, texture), 0}
+    };
+    const uint64_t total_sets = uint64_t(set_count) * round_count;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round < round_count; ++round) {
+        for (uint32_t i = 0; i < set_count; ++i) {
+            VkWriteDescriptorSet writes[2] = {
+                    {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, sets[i], 0, 0, 1,
+                     VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, nullptr, &descriptors[i].uniform, nullptr},
+                    {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, sets[i], 1, 0, 1,
+                     VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &descriptors[i].texture, nullptr, nullptr}
+            };
+            dispatch.vkUpdateDescriptorSets(logical_device, 2, writes, 0, nullptr);
+        }
+    }
+    double per_set_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    DescriptorWriter batched_writer;
+    batched_writer.init(dispatch, false);
+    DescriptorTemplate batched_template;
+    if (batched_writer.create_template(set_layout, entries, batched_template) != VK_SUCCESS) {
+        return -1;
+    }
+    start = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round < round_count; ++round) {
+        for (uint32_t i = 0; i < set_count; ++i) {
+            batched_writer.write(batched_template, sets[i], &descriptors[i]);
+        }
+        batched_writer.flush();
+    }
+    double batched_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    DescriptorWriter template_writer;
+    template_writer.init(dispatch, true);
+    double template_ms = 0.0;
+    if (template_writer.uses_templates()) {
+        DescriptorTemplate descriptor_template;
+        if (template_writer.create_template(set_layout, entries, descriptor_template) != VK_SUCCESS) {
+            return -1;
+        }
+        start = std::chrono::steady_clock::now();
+        for (uint32_t round = 0; round < round_count; ++round) {
+            for (uint32_t i = 0; i < set_count; ++i) {
+                template_writer.write(descriptor_template, sets[i], &descriptors[i]);
+            }
+        }
+        template_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::cout << set_count << " sets x " << round_count << " rounds, " << device_properties.deviceName << std::endl;
+    print_rate("per set:  ", total_sets, per_set_ms, total_sets);
+    print_rate("batched:  ", total_sets, batched_ms, batched_writer.statistics().update_calls);
+    if (template_writer.uses_templates()) {
+        print_rate("template: ", total_sets, template_ms, template_writer.statistics().update_calls);
+    } else {
+        std::cout << "template: " << VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME << " not supported"
+                  << std::endl;
+    }
+
+    template_writer.destroy();
+    batched_writer.destroy();
+    descriptor_allocator.destroy();
+    dispatch.vkDestroyDescriptorSetLayout(logical_device, set_layout, nullptr);
+    dispatch.vkDestroySampler(logical_device, sampler, nullptr);
+    dispatch.vkDestroyImageView(logical_device, image_view, nullptr);
+    dispatch.vkDestroyImage(logical_device, image, nullptr);
+    allocator.free(image_allocation);
+    dispatch.vkDestroyBuffer(logical_device, buffer, nullptr);
+    allocator.free(buffer_allocation);
+    allocator.destroy();
+    dispatch.vkDestroyDevice(logical_device, nullptr);
+    destroy_device_dispatch(dispatch);
+    instance_functions.vkDestroyInstance(instance, nullptr);
+    unload_vulkan_library(vulkan_library);
+    return 0;
+}
@@ -0,0 +1,243 @@
+//
+// Compares the cost of recording commands through the loader trampolines
+// (the symbols exported by libvulkan) with recording them through a
+// DeviceDispatch filled from vkGetDeviceProcAddr.
+//
+// Both paths record the same stream of vkCmdSetViewport and
+// vkCmdPipelineBarrier calls into one command buffer; the buffer is reset
+// between batches so the driver's command storage does not keep growing.
+//
+
+#include "device_dispatch.h"
+#include <chrono>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <iostream>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t commands_per_batch = 4096;
+
+struct RecordFunctions {
+    PFN_vkBeginCommandBuffer  vkBeginCommandBuffer;
+    PFN_vkEndCommandBuffer    vkEndCommandBuffer;
+    PFN_vkResetCommandBuffer  vkResetCommandBuffer;
+    PFN_vkCmdSetViewport      vkCmdSetViewport;
+    PFN_vkCmdPipelineBarrier  vkCmdPipelineBarrier;
+};
+
+// Returns the average time per recorded command in nanoseconds, or a negative
+// value if recording failed.
+double record_batches(const RecordFunctions &functions, VkCommandBuffer command_buffer, uint32_t batches) {
+    const VkCommandBufferBeginInfo begin_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            nullptr,
+            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            nullptr
+    };
+    const VkViewport viewport = {0.0f, 0.0f, 64.0f, 64.0f, 0.0f, 1.0f};
+    const VkMemoryBarrier memory_barrier = {
+            VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            nullptr,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_TRANSFER_READ_BIT
+    };
+
+    Clock::duration recording{};
+    for (uint32_t batch = 0; batch < batches; ++batch) {
+        if (functions.vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+            return -1.0;
+        }
+        auto start = Clock::now();
+        for (uint32_t i = 0; i < commands_per_batch; i += 2) {
+            functions.vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+            functions.vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                           0, 1, &memory_barrier, 0, nullptr, 0, nullptr);
+        }
+        recording += Clock::now() - start;
+        if (functions.vkEndCommandBuffer(command_buffer) != VK_SUCCESS ||
+            functions.vkResetCommandBuffer(command_buffer, 0) != VK_SUCCESS) {
+            return -1.0;
+        }
+    }
+    return std::chrono::duration<double, std::nano>(recording).count() / (double(batches) * commands_per_batch);
+}
+
+template<typename Function>
+bool load_trampoline(void *vulkan_library, char const *name, Function &function) {
+    function = reinterpret_cast<Function>(dlsym(vulkan_library, name));
+    if (function == nullptr) {
+        std::cout << "Could not find exported Vulkan function named: " << name << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    uint32_t batches = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 256;
+    if (batches == 0) {
+        batches = 1;
+    }
+
+    void *vulkan_library = load_vulkan_library();
+    auto vkGetInstanceProcAddr = load_exported_vulkan_function(vulkan_library);
+    if (vkGetInstanceProcAddr == nullptr) {
+        return -1;
+    }
+    GlobalFunctions global_functions{};
+    if (!load_global_level_functions(vkGetInstanceProcAddr, global_functions)) {
+        return -1;
+    }
+
+    VkApplicationInfo application_info = {
+            VK_STRUCTURE_TYPE_APPLICATION_INFO,
+            nullptr,
+            "dispatch_call_benchmark",
+            VK_MAKE_VERSION(1, 0, 0),
+            "Vulkan Cookbook",
+            VK_MAKE_VERSION(1, 0, 0),
+            VK_MAKE_VERSION(1, 0, 0)
+    };
+    VkInstanceCreateInfo instance_create_info = {
+            VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+            nullptr,
+            0,
+            &application_info,
+            0,
+            nullptr,
+            0,
+            nullptr
+    };
+    VkInstance instance{VK_NULL_HANDLE};
+    if (global_functions.vkCreateInstance(&instance_create_info, nullptr, &instance) != VK_SUCCESS) {
+        std::cout << "Could not create Vulkan instance." << std::endl;
+        return -1;
+    }
+    InstanceFunctions instance_functions{};
+    if (!load_instance_level_functions(vkGetInstanceProcAddr, instance, {}, instance_functions)) {
+        return -1;
+    }
+
+    uint32_t physical_device_count = 1;
+    VkPhysicalDevice physical_device{VK_NULL_HANDLE};
+    VkResult result = instance_functions.vkEnumeratePhysicalDevices(instance, &physical_device_count, &physical_device);
+    if ((result != VK_SUCCESS && result != VK_INCOMPLETE) || physical_device_count == 0) {
+        std::cout << "Could not enumerate physical devices." << std::endl;
+        return -1;
+    }
+
+    uint32_t queue_family_count = 0;
+    instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_families.data());
+    uint32_t graphics_queue_family_index = queue_family_count;
+    for (uint32_t i = 0; i < queue_family_count; ++i) {
+        if ((queue_families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0) {
+            graphics_queue_family_index = i;
+            break;
+        }
+    }
+    if (graphics_queue_family_index == queue_family_count) {
+        std::cout << "Could not find a graphics queue family." << std::endl;
+        return -1;
+    }
+
+    float queue_priority = 1.0f;
+    VkDeviceQueueCreateInfo queue_create_info = {
+            VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            nullptr,
+            0,
+            graphics_queue_family_index,
+            1,
+            &queue_priority
+    };
+    VkDeviceCreateInfo device_create_info = {
+            VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+            nullptr,
+            0,
+            1,
+            &queue_create_info,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            nullptr
+    };
+    VkDevice logical_device{VK_NULL_HANDLE};
+    if (instance_functions.vkCreateDevice(physical_device, &device_create_info, nullptr, &logical_device) != VK_SUCCESS) {
+        std::cout << "Could not create logical device." << std::endl;
+        return -1;
+    }
+    DeviceDispatch dispatch;
+    if (!create_device_dispatch(instance_functions.vkGetDeviceProcAddr, logical_device, {}, dispatch)) {
+        return -1;
+    }
+
+    VkCommandPoolCreateInfo command_pool_create_info = {
+            VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            nullptr,
+            VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+            graphics_queue_family_index
+    };
+    VkCommandPool command_pool{VK_NULL_HANDLE};
+    if (dispatch.vkCreateCommandPool(logical_device, &command_pool_create_info, nullptr, &command_pool) != VK_SUCCESS) {
+        std::cout << "Could not create command pool." << std::endl;
+        return -1;
+    }
+    VkCommandBufferAllocateInfo command_buffer_allocate_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            nullptr,
+            command_pool,
+            VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            1
+    };
+    VkCommandBuffer command_buffer{VK_NULL_HANDLE};
+    if (dispatch.vkAllocateCommandBuffers(logical_device, &command_buffer_allocate_info, &command_buffer) != VK_SUCCESS) {
+        std::cout << "Could not allocate command buffer." << std::endl;
+        return -1;
+    }
+
+    RecordFunctions trampoline{};
+    if (!load_trampoline(vulkan_library, "vkBeginCommandBuffer", trampoline.vkBeginCommandBuffer) ||
+        !load_trampoline(vulkan_library, "vkEndCommandBuffer", trampoline.vkEndCommandBuffer) ||
+        !load_trampoline(vulkan_library, "vkResetCommandBuffer", trampoline.vkResetCommandBuffer) ||
+        !load_trampoline(vulkan_library, "vkCmdSetViewport", trampoline.vkCmdSetViewport) ||
+        !load_trampoline(vulkan_library, "vkCmdPipelineBarrier", trampoline.vkCmdPipelineBarrier)) {
+        return -1;
+    }
+    RecordFunctions direct = {
+            dispatch.vkBeginCommandBuffer,
+            dispatch.vkEndCommandBuffer,
+            dispatch.vkResetCommandBuffer,
+            dispatch.vkCmdSetViewport,
+            dispatch.vkCmdPipelineBarrier
+    };
+
+    // One untimed pass over each path so both start with warm caches.
+    record_batches(trampoline, command_buffer, 1);
+    record_batches(direct, command_buffer, 1);
+
+    double trampoline_ns = record_batches(trampoline, command_buffer, batches);
+    double direct_ns = record_batches(direct, command_buffer, batches);
+    if (trampoline_ns < 0.0 || direct_ns < 0.0) {
+        std::cout << "Could not record command buffer." << std::endl;
+        return -1;
+    }
+
+    std::cout << "commands recorded per path: " << uint64_t(batches) * commands_per_batch << std::endl;
+    std::cout << "loader trampoline: " << trampoline_ns << " ns/command" << std::endl;
+    std::cout << "direct dispatch:   " << direct_ns << " ns/command" << std::endl;
+    std::cout << "saved per command: " << trampoline_ns - direct_ns << " ns" << std::endl;
+
+    dispatch.vkFreeCommandBuffers(logical_device, command_pool, 1, &command_buffer);
+    dispatch.vkDestroyCommandPool(logical_device, command_pool, nullptr);
+    dispatch.vkDestroyDevice(logical_device, nullptr);
+    destroy_device_dispatch(dispatch);
+    instance_functions.vkDestroyInstance(instance, nullptr);
+    unload_vulkan_library(vulkan_library);
+    return 0;
+}
@@ -0,0 +1,143 @@
+//
+// Measures how long the table-driven loader takes to fill each function table.
+//
+// The first load of every level is reported separately because it includes
+// the loader/driver warming up its own lookup structures; the repeated loads
+// show the steady-state cost of one resolve per symbol.
+//
+
+#include "vulkan_dispatch.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template<typename Load>
+bool measure_level(char const *level, uint32_t function_count, uint32_t repeats, Load load) {
+    auto start = Clock::now();
+    if (!load()) {
+        return false;
+    }
+    double cold_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+    start = Clock::now();
+    for (uint32_t i = 0; i < repeats; ++i) {
+        if (!load()) {
+            return false;
+        }
+    }
+    double warm_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / repeats;
+
+    std::cout << level << ": " << function_count << " functions, "
+              << "cold " << cold_us << " us (" << cold_us * 1000.0 / function_count << " ns/function), "
+              << "warm " << warm_us << " us (" << warm_us * 1000.0 / function_count << " ns/function)" << std::endl;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    uint32_t repeats = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 1000;
+    if (repeats == 0) {
+        repeats = 1;
+    }
+
+    void *vulkan_library = load_vulkan_library();
+    auto vkGetInstanceProcAddr = load_exported_vulkan_function(vulkan_library);
+    if (vkGetInstanceProcAddr == nullptr) {
+        return -1;
+    }
+
+    GlobalFunctions global_functions{};
+    if (!measure_level("global level", global_level_function_count(), repeats,
+                       [&] { return load_global_level_functions(vkGetInstanceProcAddr, global_functions); })) {
+        return -1;
+    }
+
+    VkApplicationInfo application_info = {
+            VK_STRUCTURE_TYPE_APPLICATION_INFO,
+            nullptr,
+            "dispatch_startup_benchmark",
+            VK_MAKE_VERSION(1, 0, 0),
+            "Vulkan Cookbook",
+            VK_MAKE_VERSION(1, 0, 0),
+            VK_MAKE_VERSION(1, 0, 0)
+    };
+    VkInstanceCreateInfo instance_create_info = {
+            VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+            nullptr,
+            0,
+            &application_info,
+            0,
+            nullptr,
+            0,
+            nullptr
+    };
+    VkInstance instance{VK_NULL_HANDLE};
+    if (global_functions.vkCreateInstance(&instance_create_info, nullptr, &instance) != VK_SUCCESS) {
+        std::cout << "Could not create Vulkan instance." << std::endl;
+        return -1;
+    }
+
+    // No instance extensions are enabled, so the surface entries stay nullptr
+    // and are skipped; the per-function figure still divides by the full table.
+    InstanceFunctions instance_functions{};
+    const std::vector<char const *> no_extensions;
+    if (!measure_level("instance-level", instance_level_function_count(), repeats,
+                       [&] { return load_instance_level_functions(vkGetInstanceProcAddr, instance, no_extensions,
+                                                                  instance_functions); })) {
+        return -1;
+    }
+
+    uint32_t physical_device_count = 1;
+    VkPhysicalDevice physical_device{VK_NULL_HANDLE};
+    VkResult result = instance_functions.vkEnumeratePhysicalDevices(instance, &physical_device_count, &physical_device);
+    if ((result != VK_SUCCESS && result != VK_INCOMPLETE) || physical_device_count == 0) {
+        std::cout << "Could not enumerate physical devices." << std::endl;
+        instance_functions.vkDestroyInstance(instance, nullptr);
+        return -1;
+    }
+
+    float queue_priority = 1.0f;
+    VkDeviceQueueCreateInfo queue_create_info = {
+            VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            nullptr,
+            0,
+            0,
+            1,
+            &queue_priority
+    };
+    VkDeviceCreateInfo device_create_info = {
+            VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+            nullptr,
+            0,
+            1,
+            &queue_create_info,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            nullptr
+    };
+    VkDevice logical_device{VK_NULL_HANDLE};
+    if (instance_functions.vkCreateDevice(physical_device, &device_create_info, nullptr, &logical_device) != VK_SUCCESS) {
+        std::cout << "Could not create logical device." << std::endl;
+        instance_functions.vkDestroyInstance(instance, nullptr);
+        return -1;
+    }
+
+    DeviceFunctions device_functions{};
+    if (!measure_level("device-level", device_level_function_count(), repeats,
+                       [&] { return load_device_level_functions(instance_functions.vkGetDeviceProcAddr, logical_device,
+                                                                no_extensions, device_functions); })) {
+        return -1;
+    }
+
+    device_functions.vkDestroyDevice(logical_device, nullptr);
+    instance_functions.vkDestroyInstance(instance, nullptr);
+    unload_vulkan_library(vulkan_library);
+    return 0;
+}
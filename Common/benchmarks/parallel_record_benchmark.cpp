@@ -0,0 +1,518 @@
+//
+// Records draw_count draws per frame on the main thread straight into the
+// primary command buffer, then through a ParallelRecorder with 1, 2, 4, ...
+// threads up to max_threads, and compares the recording time per frame.
+//
+// Each draw pushes its own constants and draws one triangle, so the cost is
+// in the driver's command encoding rather than on the GPU. Every chunk of
+// secondary commands binds the pipeline and sets the viewport again, which
+// the inline path does once; the 1-thread row shows that overhead plus the
+// hand-off to the worker. The first frame of each run is a warm-up and is
+// not counted.
+//
+
+#include "memory_allocator.h"
+#include "parallel_recorder.h"
+#include "pipeline_builder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+const VkExtent2D target_extent = {64, 64};
+const uint32_t recorder_frame_count = 2;
+
+// Empty "main" shaders.
+const uint32_t vertex_shader[] = {
+        0x07230203, 0x00010000, 0x00000000, 5, 0,
+        0x00020011, 1,                                  // OpCapability Shader
+        0x0003000E, 0, 1,                               // OpMemoryModel Logical GLSL450
+        0x0005000F, 0, 1, 0x6E69616D, 0,                // OpEntryPoint Vertex %1 "main"
+        0x00020013, 2,                                  // %2 = OpTypeVoid
+        0x00030021, 3, 2,                               // %3 = OpTypeFunction %2
+        0x00050036, 2, 1, 0, 3,                         // %1 = OpFunction %2 None %3
+        0x000200F8, 4,                                  // %4 = OpLabel
+        0x000100FD,                                     // OpReturn
+        0x00010038                                      // OpFunctionEnd
+};
+
+const uint32_t fragment_shader[] = {
+        0x07230203, 0x00010000, 0x00000000, 5, 0,
+        0x00020011, 1,                                  // OpCapability Shader
+        0x0003000E, 0, 1,                               // OpMemoryModel Logical GLSL450
+        0x0005000F, 4, 1, 0x6E69616D, 0,                // OpEntryPoint Fragment %1 "main"
+        0x00030010, 1, 7,                               // OpExecutionMode %1 OriginUpperLeft
+        0x00020013, 2,                                  // %2 = OpTypeVoid
+        0x00030021, 3, 2,                               // %3 = OpTypeFunction %2
+        0x00050036, 2, 1, 0, 3,                         // %1 = OpFunction %2 None %3
+        0x000200F8, 4,                                  // %4 = OpLabel
+        0x000100FD,                                     // OpReturn
+        0x00010038                                      // OpFunctionEnd
+};
+
+// A per-draw object index and color, as a scene would push them.
+const VkPushConstantRange draw_constants = {VK_SHADER_STAGE_VERTEX_BIT, 0, 4 * sizeof(uint32_t)};
+
+struct FrameTarget {
+    VkRenderPass  render_pass{VK_NULL_HANDLE};
+    VkFramebuffer framebuffer{VK_NULL_HANDLE};
+};
+
+// Records frame_count + 1 frames, each one render pass of draw_count draws,
+// through recorder if there is one, and returns the average recording time
+// of all but the first frame.
+bool run_frames(const DeviceDispatch &dispatch, VkQueue queue, VkCommandBuffer primary, VkFence fence,
+                const FrameTarget &target, uint32_t draw_count, uint32_t frame_count, ParallelRecorder *recorder,
+                const RecordChunkFunction &record_draws, double &record_ms) {
+    const VkCommandBufferBeginInfo command_buffer_begin_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            nullptr,
+            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            nullptr
+    };
+    const VkRenderPassBeginInfo render_pass_begin_info = {
+            VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+            nullptr,
+            target.render_pass,
+            target.framebuffer,
+            {{0, 0}, target_extent},
+            0,
+            nullptr
+    };
+    const VkCommandBufferInheritanceInfo inheritance = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+            nullptr,
+            target.render_pass,
+            0,
+            target.framebuffer,
+            VK_FALSE,
+            0,
+            0
+    };
+    VkSubmitInfo submit_info = {
+            VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            nullptr,
+            0,
+            nullptr,
+            nullptr,
+            1,
+            &primary,
+            0,
+            nullptr
+    };
+
+    record_ms = 0.0;
+    for (uint32_t frame = 0; frame <= frame_count; ++frame) {
+        if (recorder != nullptr && recorder->begin_frame(frame) != VK_SUCCESS) {
+            return false;
+        }
+        auto start = std::chrono::steady_clock::now();
+        dispatch.vkBeginCommandBuffer(primary, &command_buffer_begin_info);
+        if (recorder != nullptr) {
+            dispatch.vkCmdBeginRenderPass(primary, &render_pass_begin_info,
+                                          VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+            if (recorder->record(primary, inheritance, draw_count, record_draws) != VK_SUCCESS) {
+                dispatch.vkCmdEndRenderPass(primary);
+                dispatch.vkEndCommandBuffer(primary);
+                return false;
+            }
+        } else {
+            dispatch.vkCmdBeginRenderPass(primary, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+            record_draws(primary, 0, draw_count);
+        }
+        dispatch.vkCmdEndRenderPass(primary);
+        dispatch.vkEndCommandBuffer(primary);
+        if (frame > 0) {
+            record_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        dispatch.vkResetFences(dispatch.device, 1, &fence);
+        if (dispatch.vkQueueSubmit(queue, 1, &submit_info, fence) != VK_SUCCESS ||
+            dispatch.vkWaitForFences(dispatch.device, 1, &fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS) {
+            std::cout << "Could not submit a frame." << std::endl;
+            return false;
+        }
+        dispatch.vkResetCommandBuffer(primary, 0);
+    }
+    record_ms /= frame_count;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    uint32_t draw_count = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 100000;
+    uint32_t frame_count = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 10;
+    uint32_t max_threads = argc > 3 ? static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 10)) : 0;
+    draw_count = std::max(draw_count, 1u);
+    frame_count = std::max(frame_count, 1u);
+    if (max_threads == 0) {
+        max_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    void *vulkan_library = load_vulkan_library();
+    auto vkGetInstanceProcAddr = load_exported_vulkan_function(vulkan_library);
+    if (vkGetInstanceProcAddr == nullptr) {
+        return -1;
+    }
+    GlobalFunctions global_functions{};
+    if (!load_global_level_functions(vkGetInstanceProcAddr, global_functions)) {
+        return -1;
+    }
+
+    VkApplicationInfo application_info = {
+            VK_STRUCTURE_TYPE_APPLICATION_INFO,
+            nullptr,
+            "parallel_record_benchmark",
+            VK_MAKE_VERSION(1, 0, 0),
+            "Vulkan Cookbook",
+            VK_MAKE_VERSION(1, 0, 0),
+            VK_MAKE_VERSION(1, 1, 0)
+    };
+    VkInstanceCreateInfo instance_create_info = {
+            VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+            nullptr,
+            0,
+            &application_info,
+            0,
+            nullptr,
+            0,
+            nullptr
+    };
+    VkInstance instance{VK_NULL_HANDLE};
+    if (global_functions.vkCreateInstance(&instance_create_info, nullptr, &instance) != VK_SUCCESS) {
+        std::cout << "Could not create Vulkan instance." << std::endl;
+        return -1;
+    }
+    InstanceFunctions instance_functions{};
+    if (!load_instance_level_functions(vkGetInstanceProcAddr, instance, {}, instance_functions)) {
+        return -1;
+    }
+
+    uint32_t physical_device_count = 1;
+    VkPhysicalDevice physical_device{VK_NULL_HANDLE};
+    VkResult result = instance_functions.vkEnumeratePhysicalDevices(instance, &physical_device_count, &physical_device);
+    if ((result != VK_SUCCESS && result != VK_INCOMPLETE) || physical_device_count == 0) {
+        std::cout << "Could not enumerate physical devices." << std::endl;
+        return -1;
+    }
+    VkPhysicalDeviceProperties device_properties;
+    instance_functions.vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+    VkPhysicalDeviceMemoryProperties memory_properties;
+    instance_functions.vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
+
+    uint32_t queue_family_count = 0;
+    instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_families.data());
+    uint32_t graphics_queue_family_index = queue_family_count;
+    for (uint32_t i = 0; i < queue_family_count; ++i) {
+        if ((queue_families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0) {
+            graphics_queue_family_index = i;
+            break;
+        }
+    }
+    if (graphics_queue_family_index == queue_family_count) {
+        std::cout << "Could not find a graphics queue family." << std::endl;
+        return -1;
+    }
+
+    float queue_priority = 1.0f;
+    VkDeviceQueueCreateInfo queue_create_info = {
+            VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            nullptr,
+            0,
+            graphics_queue_family_index,
+            1,
+            &queue_priority
+    };
+    VkDeviceCreateInfo device_create_info = {
+            VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+            nullptr,
+            0,
+            1,
+            &queue_create_info,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            nullptr
+    };
+    VkDevice logical_device{VK_NULL_HANDLE};
+    if (instance_functions.vkCreateDevice(physical_device, &device_create_info, nullptr, &logical_device) != VK_SUCCESS) {
+        std::cout << "Could not create logical device." << std::endl;
+        return -1;
+    }
+    DeviceDispatch dispatch;
+    if (!create_device_dispatch(instance_functions.vkGetDeviceProcAddr, logical_device, {}, dispatch)) {
+        return -1;
+    }
+    VkQueue queue{VK_NULL_HANDLE};
+    dispatch.vkGetDeviceQueue(logical_device, graphics_queue_family_index, 0, &queue);
+
+    MemoryAllocator allocator;
+    if (!allocator.init(dispatch, memory_properties, device_properties.limits)) {
+        return -1;
+    }
+    VkImageCreateInfo image_create_info = {
+            VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            nullptr,
+            0,
+            VK_IMAGE_TYPE_2D,
+            VK_FORMAT_B8G8R8A8_UNORM,
+            {target_extent.width, target_extent.height, 1},
+            1,
+            1,
+            VK_SAMPLE_COUNT_1_BIT,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+            VK_SHARING_MODE_EXCLUSIVE,
+            0,
+            nullptr,
+            VK_IMAGE_LAYOUT_UNDEFINED
+    };
+    VkImage image{VK_NULL_HANDLE};
+    MemoryAllocation image_allocation;
+    if (dispatch.vkCreateImage(logical_device, &image_create_info, nullptr, &image) != VK_SUCCESS ||
+        allocator.allocate_for_image(image, VK_IMAGE_TILING_OPTIMAL, MemoryUsage::GpuOnly, 0,
+                                     image_allocation) != VK_SUCCESS) {
+        std::cout << "Could not create the color target." << std::endl;
+        return -1;
+    }
+    VkImageViewCreateInfo image_view_create_info = {
+            VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            nullptr,
+            0,
+            image,
+            VK_IMAGE_VIEW_TYPE_2D,
+            VK_FORMAT_B8G8R8A8_UNORM,
+            {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
+             VK_COMPONENT_SWIZZLE_IDENTITY},
+            {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}
+    };
+    VkImageView image_view{VK_NULL_HANDLE};
+    if (dispatch.vkCreateImageView(logical_device, &image_view_create_info, nullptr, &image_view) != VK_SUCCESS) {
+        std::cout << "Could not create an image view." << std::endl;
+        return -1;
+    }
+
+    VkAttachmentDescription attachment = {
+            0,
+            VK_FORMAT_B8G8R8A8_UNORM,
+            VK_SAMPLE_COUNT_1_BIT,
+            VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            VK_ATTACHMENT_STORE_OP_STORE,
+            VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+    };
+    VkAttachmentReference color_reference = {0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    VkSubpassDescription subpass = {
+            0,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            0,
+            nullptr,
+            1,
+            &color_reference,
+            nullptr,
+            nullptr,
+            0,
+            nullptr
+    };
+    VkRenderPassCreateInfo render_pass_create_info = {
+            VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+            nullptr,
+            0,
+            1,
+            &attachment,
+            1,
+            &subpass,
+            0,
+            nullptr
+    };
+    FrameTarget target;
+    if (dispatch.vkCreateRenderPass(logical_device, &render_pass_create_info, nullptr, &target.render_pass) != VK_SUCCESS) {
+        std::cout << "Could not create a render pass." << std::endl;
+        return -1;
+    }
+    VkFramebufferCreateInfo framebuffer_create_info = {
+            VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+            nullptr,
+            0,
+            target.render_pass,
+            1,
+            &image_view,
+            target_extent.width,
+            target_extent.height,
+            1
+    };
+    if (dispatch.vkCreateFramebuffer(logical_device, &framebuffer_create_info, nullptr, &target.framebuffer) != VK_SUCCESS) {
+        std::cout << "Could not create a framebuffer." << std::endl;
+        return -1;
+    }
+
+    VkCommandPoolCreateInfo command_pool_create_info = {
+            VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            nullptr,
+            VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+            graphics_queue_family_index
+    };
+    VkCommandPool command_pool{VK_NULL_HANDLE};
+    if (dispatch.vkCreateCommandPool(logical_device, &command_pool_create_info, nullptr, &command_pool) != VK_SUCCESS) {
+        std::cout << "Could not create a command pool." << std::endl;
+        return -1;
+    }
+    VkCommandBufferAllocateInfo command_buffer_allocate_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            nullptr,
+            command_pool,
+            VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            1
+    };
+    VkCommandBuffer primary{VK_NULL_HANDLE};
+    if (dispatch.vkAllocateCommandBuffers(logical_device, &command_buffer_allocate_info, &primary) != VK_SUCCESS) {
+        std::cout << "Could not allocate a command buffer." << std::endl;
+        return -1;
+    }
+    VkFenceCreateInfo fence_create_info = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, nullptr, 0};
+    VkFence fence{VK_NULL_HANDLE};
+    if (dispatch.vkCreateFence(logical_device, &fence_create_info, nullptr, &fence) != VK_SUCCESS) {
+        std::cout << "Could not create a fence." << std::endl;
+        return -1;
+    }
+
+    VkShaderModule shader_modules[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+    const uint32_t *shader_code[2] = {vertex_shader, fragment_shader};
+    const size_t shader_size[2] = {sizeof(vertex_shader), sizeof(fragment_shader)};
+    for (uint32_t i = 0; i < 2; ++i) {
+        VkShaderModuleCreateInfo shader_module_create_info = {
+                VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+                nullptr,
+                0,
+                shader_size[i],
+                shader_code[i]
+        };
+        if (dispatch.vkCreateShaderModule(logical_device, &shader_module_create_info, nullptr,
+                                          &shader_modules[i]) != VK_SUCCESS) {
+            std::cout << "Could not create a shader module." << std::endl;
+            return -1;
+        }
+    }
+    VkPipelineLayoutCreateInfo pipeline_layout_create_info = {
+            VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            nullptr,
+            0,
+            0,
+            nullptr,
+            1,
+            &draw_constants
+    };
+    VkPipelineLayout pipeline_layout{VK_NULL_HANDLE};
+    if (dispatch.vkCreatePipelineLayout(logical_device, &pipeline_layout_create_info, nullptr, &pipeline_layout) != VK_SUCCESS) {
+        std::cout << "Could not create a pipeline layout." << std::endl;
+        return -1;
+    }
+    GraphicsPipelineDescription description;
+    description.stages = {
+            {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0, VK_SHADER_STAGE_VERTEX_BIT,
+             shader_modules[0], "main", nullptr},
+            {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0, VK_SHADER_STAGE_FRAGMENT_BIT,
+             shader_modules[1], "main", nullptr}
+    };
+    description.input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    description.input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    description.rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    description.rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+    description.rasterization.cullMode = VK_CULL_MODE_NONE;
+    description.rasterization.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    description.rasterization.lineWidth = 1.0f;
+    description.multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    description.multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    description.depth_stencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    VkPipelineColorBlendAttachmentState blend_attachment{};
+    blend_attachment.colorWriteMask = 0xf;
+    description.blend_attachments.push_back(blend_attachment);
+    description.dynamic_states = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    description.layout = pipeline_layout;
+    description.render_pass = target.render_pass;
+    VkPipeline pipeline{VK_NULL_HANDLE};
+    if (create_graphics_pipeline(dispatch, VK_NULL_HANDLE, description, pipeline) != VK_SUCCESS) {
+        return -1;
+    }
+
+    const VkViewport viewport = {0.0f, 0.0f, float(target_extent.width), float(target_extent.height), 0.0f, 1.0f};
+    const VkRect2D scissor = {{0, 0}, target_extent};
+    RecordChunkFunction record_draws = [&](VkCommandBuffer command_buffer, uint32_t first, uint32_t count) {
+        dispatch.vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        dispatch.vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+        dispatch.vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+        for (uint32_t i = first; i < first + count; ++i) {
+            const uint32_t constants[4] = {i, i * 2654435761u, 0, 0};
+            dispatch.vkCmdPushConstants(command_buffer, pipeline_layout, draw_constants.stageFlags, 0,
+                                        draw_constants.size, constants);
+            dispatch.vkCmdDraw(command_buffer, 3, 1, 0, 0);
+        }
+    };
+
+    std::cout << draw_count << " draws per frame, " << frame_count << " frames, " << device_properties.deviceName
+              << std::endl;
+    double inline_ms = 0.0;
+    bool ok = run_frames(dispatch, queue, primary, fence, target, draw_count, frame_count, nullptr, record_draws,
+                         inline_ms);
+    if (ok) {
+        std::cout << "inline:     " << inline_ms << " ms/frame" << std::endl;
+    }
+    std::vector<uint32_t> thread_counts;
+    for (uint32_t threads = 1; threads < max_threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+    double single_thread_ms = 0.0;
+    for (uint32_t threads : thread_counts) {
+        if (!ok) {
+            break;
+        }
+        ParallelRecorder recorder;
+        if (!recorder.init(dispatch, graphics_queue_family_index, recorder_frame_count, threads)) {
+            ok = false;
+            break;
+        }
+        double parallel_ms = 0.0;
+        ok = run_frames(dispatch, queue, primary, fence, target, draw_count, frame_count, &recorder, record_draws,
+                        parallel_ms);
+        recorder.destroy();
+        if (ok) {
+            if (threads == 1) {
+                single_thread_ms = parallel_ms;
+            }
+            std::cout << threads << (threads == 1 ? " thread:   " : " threads:  ") << parallel_ms << " ms/frame, "
+                      << inline_ms / parallel_ms << "x inline";
+            if (threads > 1 && single_thread_ms > 0.0) {
+                std::cout << ", " << single_thread_ms / parallel_ms << "x 1 thread";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    dispatch.vkDestroyPipeline(logical_device, pipeline, nullptr);
+    dispatch.vkDestroyPipelineLayout(logical_device, pipeline_layout, nullptr);
+    for (auto shader_module : shader_modules) {
+        dispatch.vkDestroyShaderModule(logical_device, shader_module, nullptr);
+    }
+    dispatch.vkDestroyFence(logical_device, fence, nullptr);
+    dispatch.vkDestroyCommandPool(logical_device, command_pool, nullptr);
+    dispatch.vkDestroyFramebuffer(logical_device, target.framebuffer, nullptr);
+    dispatch.vkDestroyRenderPass(logical_device, target.render_pass, nullptr);
+    dispatch.vkDestroyImageView(logical_device, image_view, nullptr);
+    dispatch.vkDestroyImage(logical_device, image, nullptr);
+    allocator.free(image_allocation);
+    allocator.destroy();
+    dispatch.vkDestroyDevice(logical_device, nullptr);
+    destroy_device_dispatch(dispatch);
+    instance_functions.vkDestroyInstance(instance, nullptr);
+    unload_vulkan_library(vulkan_library);
+    return ok ? 0 : -1;
+}
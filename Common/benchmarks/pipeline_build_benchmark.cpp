@@ -0,0 +1,362 @@
+//
+// Compiles pipeline_count graphics pipeline permutations one after another on
+// the calling thread, then again on a PipelineBuildService, and compares the
+// wall-clock time and the per-pipeline compile latency.
+//
+// The permutations differ in a specialization constant of both shaders. The
+// two runs use different constants and separate in-memory caches, so neither
+// hits the other's cache entries; drivers with a disk cache of their own
+// (Mesa: MESA_SHADER_CACHE_DISABLE=true turns it off) will still remember
+// earlier runs of the benchmark.
+//
+
+#include "pipeline_builder.h"
+#include "pipeline_cache.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+// Empty "main" shaders with one unused specialization constant, SpecId 0.
+const uint32_t vertex_shader[] = {
+        0x07230203, 0x00010000, 0x00000000, 7, 0,
+        0x00020011, 1,                                  // OpCapability Shader
+        0x0003000E, 0, 1,                               // OpMemoryModel Logical GLSL450
+        0x0005000F, 0, 1, 0x6E69616D, 0,                // OpEntryPoint Vertex %1 "main"
+        0x00040047, 5, 1, 0,                            // OpDecorate %5 SpecId 0
+        0x00020013, 2,                                  // %2 = OpTypeVoid
+        0x00030021, 3, 2,                               // %3 = OpTypeFunction %2
+        0x00040015, 4, 32, 0,                           // %4 = OpTypeInt 32 0
+        0x00040032, 4, 5, 0,                            // %5 = OpSpecConstant %4 0
+        0x00050036, 2, 1, 0, 3,                         // %1 = OpFunction %2 None %3
+        0x000200F8, 6,                                  // %6 = OpLabel
+        0x000100FD,                                     // OpReturn
+        0x00010038                                      // OpFunctionEnd
+};
+
+const uint32_t fragment_shader[] = {
+        0x07230203, 0x00010000, 0x00000000, 7, 0,
+        0x00020011, 1,                                  // OpCapability Shader
+        0x0003000E, 0, 1,                               // OpMemoryModel Logical GLSL450
+        0x0005000F, 4, 1, 0x6E69616D, 0,                // OpEntryPoint Fragment %1 "main"
+        0x00030010, 1, 7,                               // OpExecutionMode %1 OriginUpperLeft
+        0x00040047, 5, 1, 0,                            // OpDecorate %5 SpecId 0
+        0x00020013, 2,                                  // %2 = OpTypeVoid
+        0x00030021, 3, 2,                               // %3 = OpTypeFunction %2
+        0x00040015, 4, 32, 0,                           // %4 = OpTypeInt 32 0
+        0x00040032, 4, 5, 0,                            // %5 = OpSpecConstant %4 0
+        0x00050036, 2, 1, 0, 3,                         // %1 = OpFunction %2 None %3
+        0x000200F8, 6,                                  // %6 = OpLabel
+        0x000100FD,                                     // OpReturn
+        0x00010038                                      // OpFunctionEnd
+};
+
+const VkSpecializationMapEntry specialization_entry = {0, 0, sizeof(uint32_t)};
+
+// The same fixed-function state init_pipeline_description() sets up,
+// without vertex input or depth.
+GraphicsPipelineDescription make_description(VkShaderModule vertex_module, VkShaderModule fragment_module,
+                                             const VkSpecializationInfo *specialization_info,
+                                             VkPipelineLayout pipeline_layout, VkRenderPass render_pass) {
+    GraphicsPipelineDescription description;
+    description.stages = {
+            {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0, VK_SHADER_STAGE_VERTEX_BIT,
+             vertex_module, "main", specialization_info},
+            {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0, VK_SHADER_STAGE_FRAGMENT_BIT,
+             fragment_module, "main", specialization_info}
+    };
+    description.input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    description.input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    description.rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    description.rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+    description.rasterization.cullMode = VK_CULL_MODE_BACK_BIT;
+    description.rasterization.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    description.rasterization.lineWidth = 1.0f;
+    description.multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    description.multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    description.depth_stencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    VkPipelineColorBlendAttachmentState blend_attachment{};
+    blend_attachment.colorWriteMask = 0xf;
+    description.blend_attachments.push_back(blend_attachment);
+    description.dynamic_states = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    description.layout = pipeline_layout;
+    description.render_pass = render_pass;
+    return description;
+}
+
+void print_latencies(const char *name, double wall_ms, std::vector<double> &compile_ms) {
+    std::sort(compile_ms.begin(), compile_ms.end());
+    double total_ms = 0.0;
+    for (double ms : compile_ms) {
+        total_ms += ms;
+    }
+    std::cout << name << wall_ms << " ms wall, per pipeline: mean " << total_ms / compile_ms.size()
+              << " ms, median " << compile_ms[compile_ms.size() / 2] << " ms, max " << compile_ms.back() << " ms"
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    uint32_t pipeline_count = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 256;
+    uint32_t thread_count = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 0;
+    if (pipeline_count == 0) {
+        pipeline_count = 1;
+    }
+
+    void *vulkan_library = load_vulkan_library();
+    auto vkGetInstanceProcAddr = load_exported_vulkan_function(vulkan_library);
+    if (vkGetInstanceProcAddr == nullptr) {
+        return -1;
+    }
+    GlobalFunctions global_functions{};
+    if (!load_global_level_functions(vkGetInstanceProcAddr, global_functions)) {
+        return -1;
+    }
+
+    VkApplicationInfo application_info = {
+            VK_STRUCTURE_TYPE_APPLICATION_INFO,
+            nullptr,
+            "pipeline_build_benchmark",
+            VK_MAKE_VERSION(1, 0, 0),
+            "Vulkan Cookbook",
+            VK_MAKE_VERSION(1, 0, 0),
+            VK_MAKE_VERSION(1, 1, 0)
+    };
+    VkInstanceCreateInfo instance_create_info = {
+            VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+            nullptr,
+            0,
+            &application_info,
+            0,
+            nullptr,
+            0,
+            nullptr
+    };
+    VkInstance instance{VK_NULL_HANDLE};
+    if (global_functions.vkCreateInstance(&instance_create_info, nullptr, &instance) != VK_SUCCESS) {
+        std::cout << "Could not create Vulkan instance." << std::endl;
+        return -1;
+    }
+    InstanceFunctions instance_functions{};
+    if (!load_instance_level_functions(vkGetInstanceProcAddr, instance, {}, instance_functions)) {
+        return -1;
+    }
+
+    uint32_t physical_device_count = 1;
+    VkPhysicalDevice physical_device{VK_NULL_HANDLE};
+    VkResult result = instance_functions.vkEnumeratePhysicalDevices(instance, &physical_device_count, &physical_device);
+    if ((result != VK_SUCCESS && result != VK_INCOMPLETE) || physical_device_count == 0) {
+        std::cout << "Could not enumerate physical devices." << std::endl;
+        return -1;
+    }
+    VkPhysicalDeviceProperties device_properties;
+    instance_functions.vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+
+    uint32_t queue_family_count = 0;
+    instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_families.data());
+    uint32_t graphics_queue_family_index = queue_family_count;
+    for (uint32_t i = 0; i < queue_family_count; ++i) {
+        if ((queue_families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0) {
+            graphics_queue_family_index = i;
+            break;
+        }
+    }
+    if (graphics_queue_family_index == queue_family_count) {
+        std::cout << "Could not find a graphics queue family." << std::endl;
+        return -1;
+    }
+
+    float queue_priority = 1.0f;
+    VkDeviceQueueCreateInfo queue_create_info = {
+            VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            nullptr,
+            0,
+            graphics_queue_family_index,
+            1,
+            &queue_priority
+    };
+    VkDeviceCreateInfo device_create_info = {
+            VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+            nullptr,
+            0,
+            1,
+            &queue_create_info,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            nullptr
+    };
+    VkDevice logical_device{VK_NULL_HANDLE};
+    if (instance_functions.vkCreateDevice(physical_device, &device_create_info, nullptr, &logical_device) != VK_SUCCESS) {
+        std::cout << "Could not create logical device." << std::endl;
+        return -1;
+    }
+    DeviceDispatch dispatch;
+    if (!create_device_dispatch(instance_functions.vkGetDeviceProcAddr, logical_device, {}, dispatch)) {
+        return -1;
+    }
+
+    VkShaderModule shader_modules[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+    const uint32_t *shader_code[2] = {vertex_shader, fragment_shader};
+    const size_t shader_size[2] = {sizeof(vertex_shader), sizeof(fragment_shader)};
+    for (uint32_t i = 0; i < 2; ++i) {
+        VkShaderModuleCreateInfo shader_module_create_info = {
+                VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+                nullptr,
+                0,
+                shader_size[i],
+                shader_code[i]
+        };
+        if (dispatch.vkCreateShaderModule(logical_device, &shader_module_create_info, nullptr,
+                                          &shader_modules[i]) != VK_SUCCESS) {
+            std::cout << "Could not create a shader module." << std::endl;
+            return -1;
+        }
+    }
+    VkPipelineLayoutCreateInfo pipeline_layout_create_info = {
+            VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            nullptr,
+            0,
+            0,
+            nullptr,
+            0,
+            nullptr
+    };
+    VkPipelineLayout pipeline_layout{VK_NULL_HANDLE};
+    if (dispatch.vkCreatePipelineLayout(logical_device, &pipeline_layout_create_info, nullptr, &pipeline_layout) != VK_SUCCESS) {
+        std::cout << "Could not create a pipeline layout." << std::endl;
+        return -1;
+    }
+    VkAttachmentDescription attachment = {
+            0,
+            VK_FORMAT_B8G8R8A8_UNORM,
+            VK_SAMPLE_COUNT_1_BIT,
+            VK_ATTACHMENT_LOAD_OP_CLEAR,
+            VK_ATTACHMENT_STORE_OP_STORE,
+            VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+    };
+    VkAttachmentReference color_reference = {0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    VkSubpassDescription subpass = {
+            0,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            0,
+            nullptr,
+            1,
+            &color_reference,
+            nullptr,
+            nullptr,
+            0,
+            nullptr
+    };
+    VkRenderPassCreateInfo render_pass_create_info = {
+            VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+            nullptr,
+            0,
+            1,
+            &attachment,
+            1,
+            &subpass,
+            0,
+            nullptr
+    };
+    VkRenderPass render_pass{VK_NULL_HANDLE};
+    if (dispatch.vkCreateRenderPass(logical_device, &render_pass_create_info, nullptr, &render_pass) != VK_SUCCESS) {
+        std::cout << "Could not create a render pass." << std::endl;
+        return -1;
+    }
+
+    // One specialization constant per pipeline and run; the service reads
+    // them from its workers, so they live until everything is built.
+    std::vector<uint32_t> constants(2 * size_t(pipeline_count));
+    std::vector<VkSpecializationInfo> specialization_infos(constants.size());
+    for (size_t i = 0; i < constants.size(); ++i) {
+        constants[i] = static_cast<uint32_t>(i);
+        specialization_infos[i] = {1, &specialization_entry, sizeof(uint32_t), &constants[i]};
+    }
+    std::vector<VkPipeline> pipelines;
+    pipelines.reserve(constants.size());
+
+    PipelineCache serial_cache;
+    if (!serial_cache.init(dispatch, device_properties, "")) {
+        return -1;
+    }
+    std::vector<double> serial_compile_ms;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < pipeline_count; ++i) {
+        auto description = make_description(shader_modules[0], shader_modules[1], &specialization_infos[i],
+                                            pipeline_layout, render_pass);
+        auto compile_start = std::chrono::steady_clock::now();
+        VkPipeline pipeline{VK_NULL_HANDLE};
+        if (create_graphics_pipeline(dispatch, serial_cache.handle(), description, pipeline) != VK_SUCCESS) {
+            std::cout << "Could not create a graphics pipeline." << std::endl;
+            return -1;
+        }
+        serial_compile_ms.push_back(std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - compile_start).count());
+        pipelines.push_back(pipeline);
+    }
+    double serial_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    PipelineCache parallel_cache;
+    if (!parallel_cache.init(dispatch, device_properties, "")) {
+        return -1;
+    }
+    PipelineBuildService service;
+    service.init(dispatch, parallel_cache.handle(), thread_count);
+    std::vector<std::future<PipelineBuildResult>> futures;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < pipeline_count; ++i) {
+        futures.push_back(service.submit(make_description(shader_modules[0], shader_modules[1],
+                                                          &specialization_infos[pipeline_count + i],
+                                                          pipeline_layout, render_pass)));
+    }
+    std::vector<double> parallel_compile_ms;
+    double max_queue_ms = 0.0;
+    bool built = true;
+    for (auto &future : futures) {
+        PipelineBuildResult result = future.get();
+        built = built && result.result == VK_SUCCESS;
+        pipelines.push_back(result.pipeline);
+        parallel_compile_ms.push_back(result.compile_ms);
+        max_queue_ms = std::max(max_queue_ms, result.queue_ms);
+    }
+    double parallel_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    uint32_t workers = service.thread_count();
+    service.destroy();
+
+    if (built) {
+        std::cout << pipeline_count << " graphics pipelines, " << device_properties.deviceName << std::endl;
+        print_latencies("serial:             ", serial_ms, serial_compile_ms);
+        print_latencies("build service:      ", parallel_ms, parallel_compile_ms);
+        std::cout << "build service threads: " << workers << ", longest queue wait " << max_queue_ms << " ms"
+                  << std::endl;
+        std::cout << "speedup: " << serial_ms / parallel_ms << "x" << std::endl;
+    }
+
+    for (auto pipeline : pipelines) {
+        if (pipeline != VK_NULL_HANDLE) {
+            dispatch.vkDestroyPipeline(logical_device, pipeline, nullptr);
+        }
+    }
+    parallel_cache.destroy();
+    serial_cache.destroy();
+    dispatch.vkDestroyRenderPass(logical_device, render_pass, nullptr);
+    dispatch.vkDestroyPipelineLayout(logical_device, pipeline_layout, nullptr);
+    for (auto shader_module : shader_modules) {
+        dispatch.vkDestroyShaderModule(logical_device, shader_module, nullptr);
+    }
+    dispatch.vkDestroyDevice(logical_device, nullptr);
+    destroy_device_dispatch(dispatch);
+    instance_functions.vkDestroyInstance(instance, nullptr);
+    unload_vulkan_library(vulkan_library);
+    return built ? 0 : -1;
+}
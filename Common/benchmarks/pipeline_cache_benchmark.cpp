@@ -0,0 +1,273 @@
+//
+// Compares compute pipeline creation with an empty (cold) PipelineCache and
+// with the cache the cold run saved to disk (warm).
+//
+// Each run builds pipeline_count pipelines that differ only in a
+// specialization constant, so every one is a separate cache entry. The
+// built-in shader is tiny; pass a SPIR-V compute shader as the third argument
+// to measure a real one. Drivers may keep a disk cache of their own (Mesa:
+// MESA_SHADER_CACHE_DISABLE=true turns it off), which makes the cold run
+// faster than a true first start.
+//
+
+#include "pipeline_cache.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+// OpEntryPoint GLCompute "main", LocalSize 1 1 1, one unused specialization
+// constant with SpecId 0, an empty body.
+const uint32_t builtin_shader[] = {
+        0x07230203, 0x00010000, 0x00000000, 7, 0,
+        0x00020011, 1,                                  // OpCapability Shader
+        0x0003000E, 0, 1,                               // OpMemoryModel Logical GLSL450
+        0x0005000F, 5, 1, 0x6E69616D, 0,                // OpEntryPoint GLCompute %1 "main"
+        0x00060010, 1, 17, 1, 1, 1,                     // OpExecutionMode %1 LocalSize 1 1 1
+        0x00040047, 5, 1, 0,                            // OpDecorate %5 SpecId 0
+        0x00020013, 2,                                  // %2 = OpTypeVoid
+        0x00030021, 3, 2,                               // %3 = OpTypeFunction %2
+        0x00040015, 4, 32, 0,                           // %4 = OpTypeInt 32 0
+        0x00040032, 4, 5, 0,                            // %5 = OpSpecConstant %4 0
+        0x00050036, 2, 1, 0, 3,                         // %1 = OpFunction %2 None %3
+        0x000200F8, 6,                                  // %6 = OpLabel
+        0x000100FD,                                     // OpReturn
+        0x00010038                                      // OpFunctionEnd
+};
+
+bool read_spirv(const char *path, std::vector<uint32_t> &code) {
+    FILE *file = fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    code.resize(size > 0 ? size_t(size) / 4 : 0);
+    bool read = size > 0 && size % 4 == 0 && fread(code.data(), size, 1, file) == 1;
+    fclose(file);
+    return read;
+}
+
+// Builds and destroys pipeline_count pipelines; returns the total creation
+// time in milliseconds, or a negative value on failure.
+double build_pipelines(const DeviceDispatch &dispatch, VkPipelineCache cache, VkShaderModule shader_module,
+                       VkPipelineLayout pipeline_layout, uint32_t pipeline_count) {
+    const VkSpecializationMapEntry map_entry = {0, 0, sizeof(uint32_t)};
+    double total_ms = 0.0;
+    for (uint32_t i = 0; i < pipeline_count; ++i) {
+        const VkSpecializationInfo specialization_info = {1, &map_entry, sizeof(i), &i};
+        const VkComputePipelineCreateInfo pipeline_create_info = {
+                VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+                nullptr,
+                0,
+                {
+                        VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                        nullptr,
+                        0,
+                        VK_SHADER_STAGE_COMPUTE_BIT,
+                        shader_module,
+                        "main",
+                        &specialization_info
+                },
+                pipeline_layout,
+                VK_NULL_HANDLE,
+                -1
+        };
+        VkPipeline pipeline{VK_NULL_HANDLE};
+        auto start = std::chrono::steady_clock::now();
+        VkResult result = dispatch.vkCreateComputePipelines(dispatch.device, cache, 1, &pipeline_create_info,
+                                                            nullptr, &pipeline);
+        total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (result != VK_SUCCESS) {
+            std::cout << "Could not create a compute pipeline." << std::endl;
+            return -1.0;
+        }
+        dispatch.vkDestroyPipeline(dispatch.device, pipeline, nullptr);
+    }
+    return total_ms;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    uint32_t pipeline_count = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 64;
+    std::string cache_path = argc > 2 ? argv[2] : "pipeline_cache_benchmark.bin";
+    if (pipeline_count == 0) {
+        pipeline_count = 1;
+    }
+    std::vector<uint32_t> shader_code(std::begin(builtin_shader), std::end(builtin_shader));
+    if (argc > 3 && !read_spirv(argv[3], shader_code)) {
+        std::cout << "Could not read SPIR-V from " << argv[3] << std::endl;
+        return -1;
+    }
+
+    void *vulkan_library = load_vulkan_library();
+    auto vkGetInstanceProcAddr = load_exported_vulkan_function(vulkan_library);
+    if (vkGetInstanceProcAddr == nullptr) {
+        return -1;
+    }
+    GlobalFunctions global_functions{};
+    if (!load_global_level_functions(vkGetInstanceProcAddr, global_functions)) {
+        return -1;
+    }
+
+    VkApplicationInfo application_info = {
+            VK_STRUCTURE_TYPE_APPLICATION_INFO,
+            nullptr,
+            "pipeline_cache_benchmark",
+            VK_MAKE_VERSION(1, 0, 0),
+            "Vulkan Cookbook",
+            VK_MAKE_VERSION(1, 0, 0),
+            VK_MAKE_VERSION(1, 1, 0)
+    };
+    VkInstanceCreateInfo instance_create_info = {
+            VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+            nullptr,
+            0,
+            &application_info,
+            0,
+            nullptr,
+            0,
+            nullptr
+    };
+    VkInstance instance{VK_NULL_HANDLE};
+    if (global_functions.vkCreateInstance(&instance_create_info, nullptr, &instance) != VK_SUCCESS) {
+        std::cout << "Could not create Vulkan instance." << std::endl;
+        return -1;
+    }
+    InstanceFunctions instance_functions{};
+    if (!load_instance_level_functions(vkGetInstanceProcAddr, instance, {}, instance_functions)) {
+        return -1;
+    }
+
+    uint32_t physical_device_count = 1;
+    VkPhysicalDevice physical_device{VK_NULL_HANDLE};
+    VkResult result = instance_functions.vkEnumeratePhysicalDevices(instance, &physical_device_count, &physical_device);
+    if ((result != VK_SUCCESS && result != VK_INCOMPLETE) || physical_device_count == 0) {
+        std::cout << "Could not enumerate physical devices." << std::endl;
+        return -1;
+    }
+    VkPhysicalDeviceProperties device_properties;
+    instance_functions.vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+
+    uint32_t queue_family_count = 0;
+    instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_families.data());
+    uint32_t compute_queue_family_index = queue_family_count;
+    for (uint32_t i = 0; i < queue_family_count; ++i) {
+        if ((queue_families[i].queueFlags & VK_QUEUE_COMPUTE_BIT) != 0) {
+            compute_queue_family_index = i;
+            break;
+        }
+    }
+    if (compute_queue_family_index == queue_family_count) {
+        std::cout << "Could not find a compute queue family." << std::endl;
+        return -1;
+    }
+
+    float queue_priority = 1.0f;
+    VkDeviceQueueCreateInfo queue_create_info = {
+            VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            nullptr,
+            0,
+            compute_queue_family_index,
+            1,
+            &queue_priority
+    };
+    VkDeviceCreateInfo device_create_info = {
+            VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+            nullptr,
+            0,
+            1,
+            &queue_create_info,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            nullptr
+    };
+    VkDevice logical_device{VK_NULL_HANDLE};
+    if (instance_functions.vkCreateDevice(physical_device, &device_create_info, nullptr, &logical_device) != VK_SUCCESS) {
+        std::cout << "Could not create logical device." << std::endl;
+        return -1;
+    }
+    DeviceDispatch dispatch;
+    if (!create_device_dispatch(instance_functions.vkGetDeviceProcAddr, logical_device, {}, dispatch)) {
+        return -1;
+    }
+
+    VkShaderModuleCreateInfo shader_module_create_info = {
+            VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+            nullptr,
+            0,
+            shader_code.size() * sizeof(uint32_t),
+            shader_code.data()
+    };
+    VkShaderModule shader_module{VK_NULL_HANDLE};
+    if (dispatch.vkCreateShaderModule(logical_device, &shader_module_create_info, nullptr, &shader_module) != VK_SUCCESS) {
+        std::cout << "Could not create a shader module." << std::endl;
+        return -1;
+    }
+    VkPipelineLayoutCreateInfo pipeline_layout_create_info = {
+            VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            nullptr,
+            0,
+            0,
+            nullptr,
+            0,
+            nullptr
+    };
+    VkPipelineLayout pipeline_layout{VK_NULL_HANDLE};
+    if (dispatch.vkCreatePipelineLayout(logical_device, &pipeline_layout_create_info, nullptr, &pipeline_layout) != VK_SUCCESS) {
+        std::cout << "Could not create a pipeline layout." << std::endl;
+        return -1;
+    }
+
+    // Cold: no file, so the cache starts empty; destroy() saves it.
+    std::remove(cache_path.c_str());
+    double cold_ms, warm_ms;
+    {
+        PipelineCache cache;
+        if (!cache.init(dispatch, device_properties, cache_path)) {
+            return -1;
+        }
+        cold_ms = build_pipelines(dispatch, cache.handle(), shader_module, pipeline_layout, pipeline_count);
+        cache.destroy();
+    }
+    // Warm: the same pipelines again, from the file the cold run wrote.
+    size_t loaded_bytes;
+    {
+        PipelineCache cache;
+        if (!cache.init(dispatch, device_properties, cache_path)) {
+            return -1;
+        }
+        if (!cache.loaded()) {
+            std::cout << "The saved cache was not loaded: " << cache.rejection() << std::endl;
+        }
+        loaded_bytes = cache.loaded_bytes();
+        warm_ms = build_pipelines(dispatch, cache.handle(), shader_module, pipeline_layout, pipeline_count);
+        cache.destroy();
+    }
+    if (cold_ms < 0.0 || warm_ms < 0.0) {
+        return -1;
+    }
+
+    std::cout << pipeline_count << " compute pipelines, " << device_properties.deviceName << std::endl;
+    std::cout << "cold cache: " << cold_ms << " ms, " << cold_ms / pipeline_count << " ms/pipeline" << std::endl;
+    std::cout << "warm cache: " << warm_ms << " ms, " << warm_ms / pipeline_count << " ms/pipeline ("
+              << loaded_bytes << " bytes loaded)" << std::endl;
+    std::cout << "speedup:    " << cold_ms / warm_ms << "x" << std::endl;
+
+    std::remove(cache_path.c_str());
+    dispatch.vkDestroyPipelineLayout(logical_device, pipeline_layout, nullptr);
+    dispatch.vkDestroyShaderModule(logical_device, shader_module, nullptr);
+    dispatch.vkDestroyDevice(logical_device, nullptr);
+    destroy_device_dispatch(dispatch);
+    instance_functions.vkDestroyInstance(instance, nullptr);
+    unload_vulkan_library(vulkan_library);
+    return 0;
+}
@@ -0,0 +1,104 @@
+//
+// Reports the throughput of every pixel conversion on every path the CPU
+// supports.
+//
+// Each conversion runs over an image of width x height pixels (4K by
+// default, larger than the last-level cache of most CPUs) and the best of
+// runs passes is kept. GB/s counts source and destination bytes, so the
+// figures compare directly with memory bandwidth.
+//
+
+#include "pixel_convert.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+struct Buffers {
+    std::vector<uint8_t>  rgb;
+    std::vector<uint8_t>  rgba;
+    std::vector<uint8_t>  output8;
+    std::vector<uint16_t> rgba16;
+    std::vector<uint16_t> output16;
+};
+
+struct Conversion {
+    const char *name;
+    size_t      bytes_per_pixel;   // source plus destination
+    void (*run)(Buffers &buffers, size_t pixel_count);
+};
+
+const Conversion conversions[] = {
+        {"RGB -> RGBA", 3 + 4, [](Buffers &b, size_t n) { convert_rgb_to_rgba(b.rgb.data(), b.output8.data(), n); }},
+        {"RGBA -> RGB", 4 + 3, [](Buffers &b, size_t n) { convert_rgba_to_rgb(b.rgba.data(), b.output8.data(), n); }},
+        {"BGRA -> RGB", 4 + 3, [](Buffers &b, size_t n) { convert_bgra_to_rgb(b.rgba.data(), b.output8.data(), n); }},
+        {"BGRA <-> RGBA", 4 + 4, [](Buffers &b, size_t n) { convert_bgra_to_rgba(b.rgba.data(), b.output8.data(), n); }},
+        {"sRGB -> linear", 4 + 8, [](Buffers &b, size_t n) { convert_srgb_to_linear(b.rgba.data(), b.output16.data(), n); }},
+        {"linear -> sRGB", 8 + 4, [](Buffers &b, size_t n) { convert_linear_to_srgb(b.rgba16.data(), b.output8.data(), n); }},
+        {"8 -> 16 bit", 4 + 8, [](Buffers &b, size_t n) { convert_8_to_16(b.rgba.data(), b.output16.data(), n * 4); }},
+        {"16 -> 8 bit", 8 + 4, [](Buffers &b, size_t n) { convert_16_to_8(b.rgba16.data(), b.output8.data(), n * 4); }},
+};
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    size_t width = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 3840;
+    size_t height = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2160;
+    uint32_t runs = argc > 3 ? static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 10)) : 10;
+    if (width == 0 || height == 0) {
+        std::cout << "Width and height must not be zero." << std::endl;
+        return -1;
+    }
+    if (runs == 0) {
+        runs = 1;
+    }
+
+    size_t pixel_count = width * height;
+    Buffers buffers;
+    buffers.rgb.resize(pixel_count * 3);
+    buffers.rgba.resize(pixel_count * 4);
+    buffers.output8.resize(pixel_count * 4);
+    buffers.rgba16.resize(pixel_count * 4);
+    buffers.output16.resize(pixel_count * 4);
+    for (size_t i = 0; i < buffers.rgba.size(); ++i) {
+        buffers.rgba[i] = static_cast<uint8_t>(i * 7);
+        buffers.rgba16[i] = static_cast<uint16_t>(i * 263);
+    }
+    for (size_t i = 0; i < buffers.rgb.size(); ++i) {
+        buffers.rgb[i] = static_cast<uint8_t>(i * 5);
+    }
+
+    PixelConvertPath supported = supported_pixel_convert_path();
+    std::cout << width << "x" << height << " pixels, best of " << runs << " runs, GB/s" << std::endl;
+    std::cout << std::setw(16) << "";
+    for (int path = 0; path <= static_cast<int>(supported); ++path) {
+        std::cout << std::setw(10) << pixel_convert_path_name(static_cast<PixelConvertPath>(path));
+    }
+    std::cout << std::endl << std::fixed << std::setprecision(2);
+
+    for (const auto &conversion : conversions) {
+        std::cout << std::setw(16) << std::left << conversion.name << std::right;
+        for (int path = 0; path <= static_cast<int>(supported); ++path) {
+            set_pixel_convert_path(static_cast<PixelConvertPath>(path));
+            // One untimed pass faults in the destination pages.
+            conversion.run(buffers, pixel_count);
+            double best_seconds = 0.0;
+            for (uint32_t run = 0; run < runs; ++run) {
+                auto start = std::chrono::steady_clock::now();
+                conversion.run(buffers, pixel_count);
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                if (run == 0 || seconds < best_seconds) {
+                    best_seconds = seconds;
+                }
+            }
+            double bytes = double(pixel_count) * conversion.bytes_per_pixel;
+            std::cout << std::setw(10) << bytes / best_seconds / 1e9;
+        }
+        std::cout << std::endl;
+    }
+    set_pixel_convert_path(supported);
+    return 0;
+}
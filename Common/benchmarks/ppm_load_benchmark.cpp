@@ -0,0 +1,140 @@
+//
+// Compares loading a large PPM texture with the original read_ppm() path and
+// with PpmImage.
+//
+// The original path opens the file twice, once for the dimensions and once
+// for the data, parses the header with fscanf and reads every pixel with its
+// own fread call, writing alpha by hand. PpmImage maps the file once and
+// expands whole rows with a SIMD kernel. Both write RGBA8 rows at the same
+// pitch and the outputs are compared. The test image is written first, 8K
+// (7680x4320) by default, and stays in the page cache, so the comparison is
+// of parsing and expansion rather than of disk reads.
+//
+
+#include "ppm_image.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+bool write_test_image(const char *path, uint32_t width, uint32_t height) {
+    FILE *file = fopen(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    // No comment: the original parser rejects them.
+    fprintf(file, "P6\n%u %u\n255\n", width, height);
+    std::vector<uint8_t> row(size_t(width) * 3);
+    bool written = true;
+    for (uint32_t y = 0; y < height && written; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            row[x * 3 + 0] = static_cast<uint8_t>(x);
+            row[x * 3 + 1] = static_cast<uint8_t>(y);
+            row[x * 3 + 2] = static_cast<uint8_t>(x ^ y);
+        }
+        written = fwrite(row.data(), row.size(), 1, file) == 1;
+    }
+    return fclose(file) == 0 && written;
+}
+
+// The original read_ppm(), minus its Android and assert plumbing.
+bool legacy_read_ppm(const char *path, int &width, int &height, uint64_t row_pitch, unsigned char *data) {
+    char magic[3] = {}, height_string[6] = {}, width_string[6] = {}, format_string[6] = {};
+    FILE *file = fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    int count = fscanf(file, "%s %s %s %s ", magic, width_string, height_string, format_string);
+    if (count != 4 || magic[0] == '#' || width_string[0] == '#' || height_string[0] == '#' ||
+        format_string[0] == '#' || strncmp(magic, "P6", sizeof(magic)) != 0) {
+        fclose(file);
+        return false;
+    }
+    width = atoi(width_string);
+    height = atoi(height_string);
+    if (data == nullptr) {
+        fclose(file);
+        return true;
+    }
+    for (int y = 0; y < height; y++) {
+        unsigned char *row = data;
+        for (int x = 0; x < width; x++) {
+            if (fread(row, 3, 1, file) != 1) {
+                fclose(file);
+                return false;
+            }
+            row[3] = 255;
+            row += 4;
+        }
+        data += row_pitch;
+    }
+    fclose(file);
+    return true;
+}
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed_ms(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    uint32_t width = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 7680;
+    uint32_t height = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 4320;
+    uint32_t runs = argc > 3 ? static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 10)) : 5;
+    const char *path = argc > 4 ? argv[4] : "ppm_load_benchmark.ppm";
+    if (width == 0 || height == 0 || width > PpmImage::max_dimension || height > PpmImage::max_dimension) {
+        std::cout << "Dimensions must be between 1 and " << PpmImage::max_dimension << "." << std::endl;
+        return -1;
+    }
+    if (runs == 0) {
+        runs = 1;
+    }
+    if (!write_test_image(path, width, height)) {
+        std::cout << "Could not write " << path << std::endl;
+        return -1;
+    }
+
+    size_t row_pitch = size_t(width) * 4;
+    std::vector<unsigned char> legacy_pixels(row_pitch * height);
+    std::vector<unsigned char> mapped_pixels(row_pitch * height);
+    double legacy_ms = 0.0, mapped_ms = 0.0;
+    for (uint32_t run = 0; run < runs; ++run) {
+        auto start = Clock::now();
+        int legacy_width, legacy_height;
+        if (!legacy_read_ppm(path, legacy_width, legacy_height, 0, nullptr) ||
+            !legacy_read_ppm(path, legacy_width, legacy_height, row_pitch, legacy_pixels.data())) {
+            std::cout << "The original path could not read " << path << std::endl;
+            return -1;
+        }
+        legacy_ms += elapsed_ms(start) / runs;
+
+        start = Clock::now();
+        PpmImage image;
+        if (!image.open(path)) {
+            return -1;
+        }
+        image.read_rgba(mapped_pixels.data(), row_pitch);
+        image.close();
+        mapped_ms += elapsed_ms(start) / runs;
+    }
+    if (std::memcmp(legacy_pixels.data(), mapped_pixels.data(), legacy_pixels.size()) != 0) {
+        std::cout << "The two paths produced different pixels." << std::endl;
+        return -1;
+    }
+
+    double megabytes = double(width) * height * 3 / (1024.0 * 1024.0);
+    std::cout << width << "x" << height << " RGB, " << runs << " runs" << std::endl;
+    std::cout << "fscanf + fread per pixel: " << legacy_ms << " ms, " << megabytes / (legacy_ms / 1000.0)
+              << " MB/s" << std::endl;
+    std::cout << "mmap + SIMD expansion:    " << mapped_ms << " ms, " << megabytes / (mapped_ms / 1000.0)
+              << " MB/s" << std::endl;
+    std::remove(path);
+    return 0;
+}
@@ -0,0 +1,319 @@
+//
+// Measures sustained host-to-device upload bandwidth through UploadEngine
+// for several staging pool configurations.
+//
+// Each configuration streams total_mb megabytes into a device-local buffer of
+// buffer_mb megabytes, wrapping around at its end, in pieces of piece_mb
+// megabytes read from one host allocation. Time runs from the first upload
+// until the graphics queue has acquired the last one, so it covers the
+// memcpy into the chunks, the copies on the transfer queue and every stall
+// waiting for a chunk to drain. With one chunk the host and the GPU take
+// turns; with two or more they overlap.
+//
+
+#include "upload_engine.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+struct PoolConfiguration {
+    VkDeviceSize chunk_size;
+    uint32_t     chunk_count;
+};
+
+constexpr VkDeviceSize megabyte = 1024 * 1024;
+
+const PoolConfiguration configurations[] = {
+        {1 * megabyte,  1},
+        {1 * megabyte,  2},
+        {4 * megabyte,  1},
+        {4 * megabyte,  2},
+        {16 * megabyte, 1},
+        {16 * megabyte, 2},
+        {16 * megabyte, 3},
+};
+
+// Streams the data and returns the elapsed milliseconds, or a negative value
+// on failure.
+double stream_uploads(UploadEngine &engine, TimelineQueue &consumer, const DeviceDispatch &dispatch,
+                      VkCommandBuffer command_buffer, VkBuffer buffer, VkDeviceSize buffer_size,
+                      const std::vector<char> &piece, VkDeviceSize total_size) {
+    std::vector<VkSemaphore> wait_semaphores;
+    std::vector<VkPipelineStageFlags> wait_stages;
+    const VkCommandBufferBeginInfo begin_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            nullptr,
+            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            nullptr
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    VkDeviceSize streamed = 0;
+    VkDeviceSize offset = 0;
+    while (streamed < total_size) {
+        VkDeviceSize size = piece.size();
+        if (size > total_size - streamed) {
+            size = total_size - streamed;
+        }
+        if (size > buffer_size - offset) {
+            size = buffer_size - offset;
+        }
+        if (!engine.upload_buffer(buffer, offset, piece.data(), size,
+                                  VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_READ_BIT)) {
+            return -1.0;
+        }
+        streamed += size;
+        offset = (offset + size) % buffer_size;
+    }
+    uint64_t value;
+    if (engine.flush(value) != VK_SUCCESS ||
+        dispatch.vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+        return -1.0;
+    }
+    engine.acquire(command_buffer, wait_semaphores, wait_stages);
+    if (dispatch.vkEndCommandBuffer(command_buffer) != VK_SUCCESS ||
+        consumer.submit(1, &command_buffer, value, static_cast<uint32_t>(wait_semaphores.size()),
+                        wait_semaphores.data(), wait_stages.data()) != VK_SUCCESS ||
+        consumer.wait(value) != VK_SUCCESS) {
+        return -1.0;
+    }
+    auto end = std::chrono::steady_clock::now();
+    engine.collect();
+    dispatch.vkResetCommandBuffer(command_buffer, 0);
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    VkDeviceSize total_mb = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1024;
+    VkDeviceSize buffer_mb = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 256;
+    VkDeviceSize piece_mb = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 64;
+    if (total_mb == 0) {
+        total_mb = 1;
+    }
+    if (buffer_mb == 0) {
+        buffer_mb = 1;
+    }
+    if (piece_mb == 0) {
+        piece_mb = 1;
+    }
+
+    void *vulkan_library = load_vulkan_library();
+    auto vkGetInstanceProcAddr = load_exported_vulkan_function(vulkan_library);
+    if (vkGetInstanceProcAddr == nullptr) {
+        return -1;
+    }
+    GlobalFunctions global_functions{};
+    if (!load_global_level_functions(vkGetInstanceProcAddr, global_functions)) {
+        return -1;
+    }
+
+    VkApplicationInfo application_info = {
+            VK_STRUCTURE_TYPE_APPLICATION_INFO,
+            nullptr,
+            "staging_upload_benchmark",
+            VK_MAKE_VERSION(1, 0, 0),
+            "Vulkan Cookbook",
+            VK_MAKE_VERSION(1, 0, 0),
+            VK_MAKE_VERSION(1, 1, 0)
+    };
+    VkInstanceCreateInfo instance_create_info = {
+            VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+            nullptr,
+            0,
+            &application_info,
+            0,
+            nullptr,
+            0,
+            nullptr
+    };
+    VkInstance instance{VK_NULL_HANDLE};
+    if (global_functions.vkCreateInstance(&instance_create_info, nullptr, &instance) != VK_SUCCESS) {
+        std::cout << "Could not create Vulkan instance." << std::endl;
+        return -1;
+    }
+    InstanceFunctions instance_functions{};
+    if (!load_instance_level_functions(vkGetInstanceProcAddr, instance, {}, instance_functions)) {
+        return -1;
+    }
+
+    uint32_t physical_device_count = 1;
+    VkPhysicalDevice physical_device{VK_NULL_HANDLE};
+    VkResult result = instance_functions.vkEnumeratePhysicalDevices(instance, &physical_device_count, &physical_device);
+    if ((result != VK_SUCCESS && result != VK_INCOMPLETE) || physical_device_count == 0) {
+        std::cout << "Could not enumerate physical devices." << std::endl;
+        return -1;
+    }
+    VkPhysicalDeviceProperties device_properties;
+    VkPhysicalDeviceMemoryProperties memory_properties;
+    instance_functions.vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+    instance_functions.vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
+
+    uint32_t queue_family_count = 0;
+    instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_families.data());
+    uint32_t graphics_queue_family_index = queue_family_count;
+    for (uint32_t i = 0; i < queue_family_count; ++i) {
+        if ((queue_families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0) {
+            graphics_queue_family_index = i;
+            break;
+        }
+    }
+    if (graphics_queue_family_index == queue_family_count) {
+        std::cout << "Could not find a graphics queue family." << std::endl;
+        return -1;
+    }
+    uint32_t transfer_queue_family_index = find_transfer_queue_family(queue_families, graphics_queue_family_index);
+
+    uint32_t extension_count = 0;
+    instance_functions.vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, nullptr);
+    std::vector<VkExtensionProperties> available_extensions(extension_count);
+    instance_functions.vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count,
+                                                            available_extensions.data());
+    bool use_timeline_semaphore = timeline_semaphore_supported(available_extensions);
+    std::vector<char const *> enabled_extensions;
+    if (use_timeline_semaphore) {
+        enabled_extensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+    }
+
+    float queue_priority = 1.0f;
+    std::vector<VkDeviceQueueCreateInfo> queue_create_infos = {{
+            VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            nullptr,
+            0,
+            graphics_queue_family_index,
+            1,
+            &queue_priority
+    }};
+    if (transfer_queue_family_index != graphics_queue_family_index) {
+        queue_create_infos.push_back(queue_create_infos.front());
+        queue_create_infos.back().queueFamilyIndex = transfer_queue_family_index;
+    }
+    VkPhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_features = {
+            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES,
+            nullptr,
+            VK_TRUE
+    };
+    VkDeviceCreateInfo device_create_info = {
+            VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+            use_timeline_semaphore ? &timeline_semaphore_features : nullptr,
+            0,
+            static_cast<uint32_t>(queue_create_infos.size()),
+            queue_create_infos.data(),
+            0,
+            nullptr,
+            static_cast<uint32_t>(enabled_extensions.size()),
+            enabled_extensions.empty() ? nullptr : enabled_extensions.data(),
+            nullptr
+    };
+    VkDevice logical_device{VK_NULL_HANDLE};
+    if (instance_functions.vkCreateDevice(physical_device, &device_create_info, nullptr, &logical_device) != VK_SUCCESS) {
+        std::cout << "Could not create logical device." << std::endl;
+        return -1;
+    }
+    DeviceDispatch dispatch;
+    if (!create_device_dispatch(instance_functions.vkGetDeviceProcAddr, logical_device, enabled_extensions, dispatch)) {
+        return -1;
+    }
+    VkQueue graphics_queue{VK_NULL_HANDLE}, transfer_queue{VK_NULL_HANDLE};
+    dispatch.vkGetDeviceQueue(logical_device, graphics_queue_family_index, 0, &graphics_queue);
+    dispatch.vkGetDeviceQueue(logical_device, transfer_queue_family_index, 0, &transfer_queue);
+
+    MemoryAllocator allocator;
+    if (!allocator.init(dispatch, memory_properties, device_properties.limits)) {
+        return -1;
+    }
+    VkDeviceSize buffer_size = buffer_mb * megabyte;
+    VkBufferCreateInfo buffer_create_info = {
+            VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            nullptr,
+            0,
+            buffer_size,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_SHARING_MODE_EXCLUSIVE,
+            0,
+            nullptr
+    };
+    VkBuffer buffer{VK_NULL_HANDLE};
+    MemoryAllocation buffer_allocation;
+    if (dispatch.vkCreateBuffer(logical_device, &buffer_create_info, nullptr, &buffer) != VK_SUCCESS ||
+        allocator.allocate_for_buffer(buffer, MemoryUsage::GpuOnly, 0, buffer_allocation) != VK_SUCCESS) {
+        std::cout << "Could not create a " << buffer_mb << " MB device-local buffer." << std::endl;
+        return -1;
+    }
+
+    VkCommandPoolCreateInfo command_pool_create_info = {
+            VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            nullptr,
+            VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+            graphics_queue_family_index
+    };
+    VkCommandPool command_pool{VK_NULL_HANDLE};
+    if (dispatch.vkCreateCommandPool(logical_device, &command_pool_create_info, nullptr, &command_pool) != VK_SUCCESS) {
+        std::cout << "Could not create command pool." << std::endl;
+        return -1;
+    }
+    VkCommandBufferAllocateInfo command_buffer_allocate_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            nullptr,
+            command_pool,
+            VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            1
+    };
+    VkCommandBuffer command_buffer{VK_NULL_HANDLE};
+    if (dispatch.vkAllocateCommandBuffers(logical_device, &command_buffer_allocate_info, &command_buffer) != VK_SUCCESS) {
+        std::cout << "Could not allocate command buffer." << std::endl;
+        return -1;
+    }
+    TimelineQueue consumer;
+    if (!consumer.init(dispatch, graphics_queue, use_timeline_semaphore)) {
+        return -1;
+    }
+
+    std::vector<char> piece(piece_mb * megabyte);
+    for (size_t byte = 0; byte < piece.size(); ++byte) {
+        piece[byte] = static_cast<char>(byte * 31);
+    }
+
+    VkDeviceSize total_size = total_mb * megabyte;
+    std::cout << "streaming " << total_mb << " MB into a " << buffer_mb << " MB buffer in " << piece_mb
+              << " MB pieces through queue family " << transfer_queue_family_index
+              << (transfer_queue_family_index != graphics_queue_family_index ? " (transfer only)" : " (graphics)")
+              << std::endl;
+    for (const auto &configuration : configurations) {
+        UploadEngine engine;
+        if (!engine.init(dispatch, allocator, transfer_queue, transfer_queue_family_index,
+                         consumer, graphics_queue_family_index, use_timeline_semaphore, false,
+                         configuration.chunk_size, configuration.chunk_count)) {
+            std::cout << "Could not create the upload engine." << std::endl;
+            return -1;
+        }
+        double ms = stream_uploads(engine, consumer, dispatch, command_buffer, buffer, buffer_size, piece, total_size);
+        if (ms < 0.0) {
+            std::cout << "Could not stream the uploads." << std::endl;
+            return -1;
+        }
+        const StagingPoolStatistics &statistics = engine.staging().statistics();
+        std::cout << configuration.chunk_count << " x " << configuration.chunk_size / megabyte << " MB chunks: "
+                  << double(total_size) / megabyte / (ms / 1000.0) << " MB/s, "
+                  << engine.batches_submitted() << " batches, " << statistics.stalls << " stalls, "
+                  << statistics.stall_ms << " ms stalled" << std::endl;
+        engine.destroy();
+    }
+
+    consumer.destroy();
+    dispatch.vkFreeCommandBuffers(logical_device, command_pool, 1, &command_buffer);
+    dispatch.vkDestroyCommandPool(logical_device, command_pool, nullptr);
+    dispatch.vkDestroyBuffer(logical_device, buffer, nullptr);
+    allocator.free(buffer_allocation);
+    allocator.destroy();
+    dispatch.vkDestroyDevice(logical_device, nullptr);
+    destroy_device_dispatch(dispatch);
+    instance_functions.vkDestroyInstance(instance, nullptr);
+    unload_vulkan_library(vulkan_library);
+    return 0;
+}
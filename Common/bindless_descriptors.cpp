@@ -0,0 +1,314 @@
+//
+// Bindless descriptor heap on VK_EXT_descriptor_indexing.
+//
+
+#include "bindless_descriptors.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+std::vector<char const *> bindless_device_extensions() {
+    return {VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME, VK_KHR_MAINTENANCE3_EXTENSION_NAME};
+}
+
+bool bindless_extensions_supported(const std::vector<VkExtensionProperties> &available_extensions) {
+    for (const char *name : bindless_device_extensions()) {
+        bool found = false;
+        for (const auto &extension : available_extensions) {
+            found = found || std::strcmp(extension.extensionName, name) == 0;
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool query_bindless_support(const InstanceFunctions &instance_functions, VkPhysicalDevice physical_device,
+                            BindlessHeapSizes &sizes) {
+    if (instance_functions.vkGetPhysicalDeviceFeatures2KHR == nullptr ||
+        instance_functions.vkGetPhysicalDeviceProperties2KHR == nullptr) {
+        std::cout << "Querying descriptor indexing support needs "
+                  << VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME << "." << std::endl;
+        return false;
+    }
+    VkPhysicalDeviceDescriptorIndexingFeatures indexing_features = {};
+    indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+    VkPhysicalDeviceFeatures2 features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &indexing_features, {}};
+    instance_functions.vkGetPhysicalDeviceFeatures2KHR(physical_device, &features);
+
+    VkPhysicalDeviceDescriptorIndexingFeatures required = bindless_required_features();
+    if ((required.runtimeDescriptorArray && !indexing_features.runtimeDescriptorArray) ||
+        (required.descriptorBindingPartiallyBound && !indexing_features.descriptorBindingPartiallyBound) ||
+        (required.descriptorBindingUpdateUnusedWhilePending &&
+         !indexing_features.descriptorBindingUpdateUnusedWhilePending) ||
+        (required.descriptorBindingSampledImageUpdateAfterBind &&
+         !indexing_features.descriptorBindingSampledImageUpdateAfterBind) ||
+        (required.descriptorBindingStorageBufferUpdateAfterBind &&
+         !indexing_features.descriptorBindingStorageBufferUpdateAfterBind) ||
+        (required.shaderSampledImageArrayNonUniformIndexing &&
+         !indexing_features.shaderSampledImageArrayNonUniformIndexing) ||
+        (required.shaderStorageBufferArrayNonUniformIndexing &&
+         !indexing_features.shaderStorageBufferArrayNonUniformIndexing)) {
+        std::cout << "The device lacks descriptor indexing features needed for bindless descriptors." << std::endl;
+        return false;
+    }
+
+    VkPhysicalDeviceDescriptorIndexingProperties indexing_properties = {};
+    indexing_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, &indexing_properties, {}};
+    instance_functions.vkGetPhysicalDeviceProperties2KHR(physical_device, &properties);
+    // Samplers do not count against the per-stage sampled image limit, but
+    // every array counts against the total.
+    sizes.sampled_images = std::min({sizes.sampled_images,
+                                     indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                                     indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages});
+    sizes.samplers = std::min({sizes.samplers,
+                               indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers,
+                               indexing_properties.maxDescriptorSetUpdateAfterBindSamplers});
+    sizes.storage_buffers = std::min({sizes.storage_buffers,
+                                      indexing_properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+                                      indexing_properties.maxDescriptorSetUpdateAfterBindStorageBuffers});
+    // With every binding visible to every stage, sampled images and storage
+    // buffers also share each stage's resource limit; separate samplers do
+    // not count. Both arrays shrink in proportion to fit it.
+    uint64_t per_stage = uint64_t(sizes.sampled_images) + sizes.storage_buffers;
+    uint32_t per_stage_limit = indexing_properties.maxPerStageUpdateAfterBindResources;
+    if (per_stage > per_stage_limit) {
+        sizes.sampled_images = static_cast<uint32_t>(uint64_t(sizes.sampled_images) * per_stage_limit / per_stage);
+        sizes.storage_buffers = per_stage_limit - sizes.sampled_images;
+    }
+    uint64_t total = uint64_t(sizes.sampled_images) + sizes.samplers + sizes.storage_buffers;
+    if (total > indexing_properties.maxUpdateAfterBindDescriptorsInAllPools) {
+        std::cout << "The bindless heap exceeds maxUpdateAfterBindDescriptorsInAllPools." << std::endl;
+        return false;
+    }
+    return sizes.sampled_images != 0 && sizes.samplers != 0 && sizes.storage_buffers != 0;
+}
+
+VkPhysicalDeviceDescriptorIndexingFeatures bindless_required_features() {
+    VkPhysicalDeviceDescriptorIndexingFeatures features = {};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+    features.pNext = nullptr;
+    features.runtimeDescriptorArray = VK_TRUE;
+    features.descriptorBindingPartiallyBound = VK_TRUE;
+    features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+    features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    features.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+    return features;
+}
+
+BindlessDescriptorHeap::~BindlessDescriptorHeap() {
+    destroy();
+}
+
+bool BindlessDescriptorHeap::init(const DeviceDispatch &dispatch, const BindlessHeapSizes &sizes,
+                                  VkShaderStageFlags stages) {
+    dispatch_ = &dispatch;
+    sizes_ = sizes;
+
+    const VkDescriptorSetLayoutBinding bindings[] = {
+            {sampled_image_binding, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, sizes.sampled_images, stages, nullptr},
+            {sampler_binding, VK_DESCRIPTOR_TYPE_SAMPLER, sizes.samplers, stages, nullptr},
+            {storage_buffer_binding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, sizes.storage_buffers, stages, nullptr}
+    };
+    const VkDescriptorBindingFlags binding_flag = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                                                  VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                                                  VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+    const VkDescriptorBindingFlags binding_flags[] = {binding_flag, binding_flag, binding_flag};
+    VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_create_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+            nullptr,
+            3,
+            binding_flags
+    };
+    VkDescriptorSetLayoutCreateInfo layout_create_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            &binding_flags_create_info,
+            VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+            3,
+            bindings
+    };
+    if (dispatch.vkCreateDescriptorSetLayout(dispatch.device, &layout_create_info, nullptr, &layout_) != VK_SUCCESS) {
+        std::cout << "Could not create the bindless descriptor set layout." << std::endl;
+        layout_ = VK_NULL_HANDLE;
+        destroy();
+        return false;
+    }
+
+    const VkDescriptorPoolSize pool_sizes[] = {
+            {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, sizes.sampled_images},
+            {VK_DESCRIPTOR_TYPE_SAMPLER, sizes.samplers},
+            {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, sizes.storage_buffers}
+    };
+    VkDescriptorPoolCreateInfo pool_create_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            nullptr,
+            VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+            1,
+            3,
+            pool_sizes
+    };
+    if (dispatch.vkCreateDescriptorPool(dispatch.device, &pool_create_info, nullptr, &pool_) != VK_SUCCESS) {
+        std::cout << "Could not create the bindless descriptor pool." << std::endl;
+        pool_ = VK_NULL_HANDLE;
+        destroy();
+        return false;
+    }
+    VkDescriptorSetAllocateInfo allocate_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            nullptr,
+            pool_,
+            1,
+            &layout_
+    };
+    if (dispatch.vkAllocateDescriptorSets(dispatch.device, &allocate_info, &set_) != VK_SUCCESS) {
+        std::cout << "Could not allocate the bindless descriptor set." << std::endl;
+        set_ = VK_NULL_HANDLE;
+        destroy();
+        return false;
+    }
+
+    images_.reset(sizes.sampled_images);
+    samplers_.reset(sizes.samplers);
+    buffers_.reset(sizes.storage_buffers);
+    return true;
+}
+
+void BindlessDescriptorHeap::destroy() {
+    if (dispatch_ == nullptr) {
+        return;
+    }
+    // The set goes with its pool.
+    if (pool_ != VK_NULL_HANDLE) {
+        dispatch_->vkDestroyDescriptorPool(dispatch_->device, pool_, nullptr);
+    }
+    if (layout_ != VK_NULL_HANDLE) {
+        dispatch_->vkDestroyDescriptorSetLayout(dispatch_->device, layout_, nullptr);
+    }
+    pool_ = VK_NULL_HANDLE;
+    layout_ = VK_NULL_HANDLE;
+    set_ = VK_NULL_HANDLE;
+    pending_.clear();
+    image_infos_.clear();
+    buffer_infos_.clear();
+    dispatch_ = nullptr;
+}
+
+uint32_t BindlessDescriptorHeap::add_sampled_image(VkImageView view, VkImageLayout layout) {
+    uint32_t index = images_.acquire();
+    if (index != invalid_index) {
+        pending_.push_back({sampled_image_binding, index, image_infos_.size()});
+        image_infos_.push_back({VK_NULL_HANDLE, view, layout});
+    }
+    return index;
+}
+
+uint32_t BindlessDescriptorHeap::add_sampler(VkSampler sampler) {
+    uint32_t index = samplers_.acquire();
+    if (index != invalid_index) {
+        pending_.push_back({sampler_binding, index, image_infos_.size()});
+        image_infos_.push_back({sampler, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED});
+    }
+    return index;
+}
+
+uint32_t BindlessDescriptorHeap::add_storage_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+    uint32_t index = buffers_.acquire();
+    if (index != invalid_index) {
+        pending_.push_back({storage_buffer_binding, index, buffer_infos_.size()});
+        buffer_infos_.push_back({buffer, offset, range});
+    }
+    return index;
+}
+
+void BindlessDescriptorHeap::collect(uint64_t completed_value) {
+    images_.collect(completed_value);
+    samplers_.collect(completed_value);
+    buffers_.collect(completed_value);
+}
+
+void BindlessDescriptorHeap::flush() {
+    if (pending_.empty()) {
+        return;
+    }
+    // The info arrays no longer grow, so pointers into them stay valid.
+    writes_.clear();
+    for (const auto &pending : pending_) {
+        VkWriteDescriptorSet write = {};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = set_;
+        write.dstBinding = pending.binding;
+        write.dstArrayElement = pending.index;
+        write.descriptorCount = 1;
+        switch (pending.binding) {
+            case sampled_image_binding:
+                write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+                write.pImageInfo = &image_infos_[pending.info];
+                break;
+            case sampler_binding:
+                write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+                write.pImageInfo = &image_infos_[pending.info];
+                break;
+            default:
+                write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                write.pBufferInfo = &buffer_infos_[pending.info];
+                break;
+        }
+        writes_.push_back(write);
+    }
+    dispatch_->vkUpdateDescriptorSets(dispatch_->device, static_cast<uint32_t>(writes_.size()), writes_.data(),
+                                      0, nullptr);
+    pending_.clear();
+    image_infos_.clear();
+    buffer_infos_.clear();
+}
+
+void BindlessDescriptorHeap::bind(VkCommandBuffer command_buffer, VkPipelineBindPoint bind_point,
+                                  VkPipelineLayout layout, uint32_t set_index) const {
+    dispatch_->vkCmdBindDescriptorSets(command_buffer, bind_point, layout, set_index, 1, &set_, 0, nullptr);
+}
+
+void BindlessDescriptorHeap::Slots::reset(uint32_t capacity) {
+    capacity_ = capacity;
+    next_ = 0;
+    live_.assign(capacity, false);
+    free_.clear();
+    retired_.clear();
+}
+
+uint32_t BindlessDescriptorHeap::Slots::acquire() {
+    if (!free_.empty()) {
+        uint32_t index = free_.back();
+        free_.pop_back();
+        live_[index] = true;
+        return index;
+    }
+    if (next_ < capacity_) {
+        live_[next_] = true;
+        return next_++;
+    }
+    std::cout << "A bindless descriptor array is full." << std::endl;
+    return invalid_index;
+}
+
+void BindlessDescriptorHeap::Slots::release(uint32_t index, uint64_t last_use_value) {
+    if (index >= capacity_ || !live_[index]) {
+        // A second release would put the index on the free list twice and
+        // hand it to two resources.
+        std::cout << "Bindless descriptor index " << index << " is not in use." << std::endl;
+        return;
+    }
+    live_[index] = false;
+    retired_.emplace_back(last_use_value, index);
+}
+
+void BindlessDescriptorHeap::Slots::collect(uint64_t completed_value) {
+    // Released in submission order, so the values only grow.
+    while (!retired_.empty() && retired_.front().first <= completed_value) {
+        free_.push_back(retired_.front().second);
+        retired_.pop_front();
+    }
+}
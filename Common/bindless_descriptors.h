@@ -0,0 +1,135 @@
+//
+// Bindless descriptor heap on VK_EXT_descriptor_indexing.
+//
+// One descriptor set holds three large arrays: sampled images at binding 0,
+// samplers at binding 1 and storage buffers at binding 2. Resources are
+// added once and addressed by their array index, which shaders receive
+// through push constants or a buffer and use to index the arrays:
+//
+//     layout(set = 0, binding = 0) uniform texture2D textures[];
+//     layout(set = 0, binding = 1) uniform sampler samplers[];
+//     layout(set = 0, binding = 2) buffer Buffers { uint data[]; } buffers[];
+//     texture(sampler2D(textures[nonuniformEXT(image)], samplers[sampler]), uv)
+//
+// The set is bound once per command buffer. Draws then need no descriptor
+// set allocation, update or bind of their own, only the indices.
+//
+// Every binding is PARTIALLY_BOUND, UPDATE_AFTER_BIND and
+// UPDATE_UNUSED_WHILE_PENDING. Unused slots may stay empty, and slots can be
+// written while command buffers that use other slots are pending. add_*()
+// only queue the write. flush() applies everything queued with one
+// vkUpdateDescriptorSets, and must run before submitting work that uses the
+// new indices. A released index is recycled only after collect() is called
+// with a timeline value at or past the release value, so the GPU never reads
+// a slot that has been reused under it.
+//
+// The device needs VK_EXT_descriptor_indexing and VK_KHR_maintenance3 (see
+// bindless_device_extensions()), with the features from
+// bindless_required_features() chained into VkDeviceCreateInfo. The instance
+// needs VK_KHR_get_physical_device_properties2 for query_bindless_support().
+//
+// Not thread-safe.
+//
+
+#ifndef COMMON_BINDLESS_DESCRIPTORS_H
+#define COMMON_BINDLESS_DESCRIPTORS_H
+
+#include "device_dispatch.h"
+#include <deque>
+
+struct BindlessHeapSizes {
+    uint32_t sampled_images{4096};
+    uint32_t samplers{64};
+    uint32_t storage_buffers{1024};
+};
+
+std::vector<char const *> bindless_device_extensions();
+// True if every extension in bindless_device_extensions() is available.
+bool bindless_extensions_supported(const std::vector<VkExtensionProperties> &available_extensions);
+// Checks the descriptor indexing features and clamps sizes to the device's
+// update-after-bind limits, including the per-stage resource limit. Needs vkGetPhysicalDeviceFeatures2KHR and
+// vkGetPhysicalDeviceProperties2KHR in instance_functions.
+bool query_bindless_support(const InstanceFunctions &instance_functions, VkPhysicalDevice physical_device,
+                            BindlessHeapSizes &sizes);
+// The features to enable. Link them into the pNext chain of
+// VkDeviceCreateInfo.
+VkPhysicalDeviceDescriptorIndexingFeatures bindless_required_features();
+
+class BindlessDescriptorHeap {
+public:
+    static constexpr uint32_t sampled_image_binding = 0;
+    static constexpr uint32_t sampler_binding = 1;
+    static constexpr uint32_t storage_buffer_binding = 2;
+    static constexpr uint32_t invalid_index = UINT32_MAX;
+
+    BindlessDescriptorHeap() = default;
+    ~BindlessDescriptorHeap();
+    BindlessDescriptorHeap(const BindlessDescriptorHeap &) = delete;
+    BindlessDescriptorHeap &operator=(const BindlessDescriptorHeap &) = delete;
+
+    bool init(const DeviceDispatch &dispatch, const BindlessHeapSizes &sizes,
+              VkShaderStageFlags stages = VK_SHADER_STAGE_ALL);
+    void destroy();
+
+    // Each returns the new index, or invalid_index if the array is full.
+    uint32_t add_sampled_image(VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    uint32_t add_sampler(VkSampler sampler);
+    uint32_t add_storage_buffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+
+    // The index can be reused once the timeline has reached last_use_value.
+    void release_sampled_image(uint32_t index, uint64_t last_use_value) { images_.release(index, last_use_value); }
+    void release_sampler(uint32_t index, uint64_t last_use_value) { samplers_.release(index, last_use_value); }
+    void release_storage_buffer(uint32_t index, uint64_t last_use_value) { buffers_.release(index, last_use_value); }
+    // Recycles the indices released with values up to completed_value.
+    void collect(uint64_t completed_value);
+
+    // Writes every descriptor added since the last flush.
+    void flush();
+
+    // Binds the heap as set_index of layout, whose set layout at that index
+    // must be layout().
+    void bind(VkCommandBuffer command_buffer, VkPipelineBindPoint bind_point, VkPipelineLayout layout,
+              uint32_t set_index = 0) const;
+
+    VkDescriptorSetLayout layout() const { return layout_; }
+    VkDescriptorSet set() const { return set_; }
+    const BindlessHeapSizes &sizes() const { return sizes_; }
+
+private:
+    // Index allocator for one array.
+    class Slots {
+    public:
+        void reset(uint32_t capacity);
+        uint32_t acquire();
+        void release(uint32_t index, uint64_t last_use_value);
+        void collect(uint64_t completed_value);
+
+    private:
+        uint32_t                                  capacity_{0};
+        uint32_t                                  next_{0};    // first never-used index
+        std::vector<bool>                         live_;       // acquired and not yet released
+        std::vector<uint32_t>                     free_;
+        std::deque<std::pair<uint64_t, uint32_t>> retired_;    // in release order
+    };
+
+    struct PendingWrite {
+        uint32_t binding;
+        uint32_t index;
+        size_t   info;    // into image_infos_ or buffer_infos_
+    };
+
+    const DeviceDispatch               *dispatch_{nullptr};
+    BindlessHeapSizes                   sizes_;
+    VkDescriptorSetLayout               layout_{VK_NULL_HANDLE};
+    VkDescriptorPool                    pool_{VK_NULL_HANDLE};
+    VkDescriptorSet                     set_{VK_NULL_HANDLE};
+    Slots                               images_;
+    Slots                               samplers_;
+    Slots                               buffers_;
+    std::vector<PendingWrite>           pending_;
+    std::vector<VkDescriptorImageInfo>  image_infos_;
+    std::vector<VkDescriptorBufferInfo> buffer_infos_;
+    std::vector<VkWriteDescriptorSet>   writes_;    // scratch for flush()
+};
+
+#endif // COMMON_BINDLESS_DESCRIPTORS_H
@@ -0,0 +1,110 @@
+//
+// Per-frame command buffer allocator with whole-pool resets.
+//
+
+#include "command_buffer_allocator.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace {
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+CommandBufferAllocator::~CommandBufferAllocator() {
+    destroy();
+}
+
+bool CommandBufferAllocator::init(const DeviceDispatch &dispatch, uint32_t queue_family_index, uint32_t frame_count) {
+    dispatch_ = &dispatch;
+    VkCommandPoolCreateInfo command_pool_create_info = {
+            VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            nullptr,
+            VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+            queue_family_index
+    };
+    frames_ = std::vector<FramePool>(std::max(frame_count, 1u));
+    for (auto &frame : frames_) {
+        if (dispatch.vkCreateCommandPool(dispatch.device, &command_pool_create_info, nullptr, &frame.pool) != VK_SUCCESS) {
+            std::cout << "Could not create a command pool." << std::endl;
+            destroy();
+            return false;
+        }
+    }
+    current_frame_ = 0;
+    current_ = CommandBufferFrameStatistics{};
+    last_ = CommandBufferFrameStatistics{};
+    return true;
+}
+
+void CommandBufferAllocator::destroy() {
+    if (dispatch_ == nullptr) {
+        return;
+    }
+    for (auto &frame : frames_) {
+        if (frame.pool != VK_NULL_HANDLE) {
+            dispatch_->vkDestroyCommandPool(dispatch_->device, frame.pool, nullptr);
+        }
+    }
+    frames_.clear();
+    dispatch_ = nullptr;
+}
+
+VkResult CommandBufferAllocator::begin_frame(uint32_t frame_index, VkFence fence) {
+    last_ = current_;
+    current_ = CommandBufferFrameStatistics{};
+    current_frame_ = frame_index % frame_count();
+    FramePool &frame = frames_[current_frame_];
+    if (fence != VK_NULL_HANDLE) {
+        VkResult result = dispatch_->vkWaitForFences(dispatch_->device, 1, &fence, VK_TRUE, UINT64_MAX);
+        if (result != VK_SUCCESS) {
+            std::cout << "Could not wait for a frame fence." << std::endl;
+            return result;
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+    VkResult result = dispatch_->vkResetCommandPool(dispatch_->device, frame.pool, 0);
+    current_.reset_ms = elapsed_ms(start);
+    if (result != VK_SUCCESS) {
+        std::cout << "Could not reset a command pool." << std::endl;
+        return result;
+    }
+    frame.used = {0, 0};
+    return VK_SUCCESS;
+}
+
+VkResult CommandBufferAllocator::allocate(VkCommandBuffer &command_buffer, VkCommandBufferLevel level) {
+    auto start = std::chrono::steady_clock::now();
+    FramePool &frame = frames_[current_frame_];
+    size_t index = level == VK_COMMAND_BUFFER_LEVEL_SECONDARY ? 1 : 0;
+    std::vector<VkCommandBuffer> &buffers = frame.buffers[index];
+    if (frame.used[index] == buffers.size()) {
+        // Grow by the size so far so that a frame needing n buffers costs
+        // O(log n) allocation calls the first time and none after.
+        auto batch = static_cast<uint32_t>(std::max<size_t>(initial_batch_size, buffers.size()));
+        VkCommandBufferAllocateInfo command_buffer_allocate_info = {
+                VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                nullptr,
+                frame.pool,
+                level,
+                batch
+        };
+        buffers.resize(buffers.size() + batch);
+        VkResult result = dispatch_->vkAllocateCommandBuffers(dispatch_->device, &command_buffer_allocate_info,
+                                                              buffers.data() + buffers.size() - batch);
+        if (result != VK_SUCCESS) {
+            buffers.resize(buffers.size() - batch);
+            std::cout << "Could not allocate command buffers." << std::endl;
+            return result;
+        }
+        current_.buffers_created += batch;
+    }
+    command_buffer = buffers[frame.used[index]++];
+    ++current_.buffers_used;
+    current_.allocate_ms += elapsed_ms(start);
+    return VK_SUCCESS;
+}
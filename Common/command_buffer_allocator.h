@@ -0,0 +1,75 @@
+//
+// Per-frame command buffer allocator with whole-pool resets.
+//
+// Each frame slot owns one TRANSIENT command pool, created without
+// VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT. allocate() hands out the
+// slot's command buffers in order and allocates more, in growing batches,
+// only when a frame needs more than any before it. begin_frame() makes every
+// buffer of the slot available again with one vkResetCommandPool. Buffers
+// are never reset or freed one by one: drivers can then keep the pool's
+// command memory in a simple linear allocator and drop it all at once,
+// instead of tracking each buffer's memory separately.
+//
+// The caller must make sure the GPU is done with the slot's previous frame
+// before begin_frame(), e.g. by passing the fence that frame was submitted
+// with. last_frame() reports the CPU time the previous frame spent
+// allocating and resetting.
+//
+// Not thread-safe; give each recording thread its own allocator.
+//
+
+#ifndef COMMON_COMMAND_BUFFER_ALLOCATOR_H
+#define COMMON_COMMAND_BUFFER_ALLOCATOR_H
+
+#include "device_dispatch.h"
+#include <array>
+#include <vector>
+
+struct CommandBufferFrameStatistics {
+    uint32_t buffers_used{0};      // handed out by allocate()
+    uint32_t buffers_created{0};   // of those, newly allocated from the driver
+    double   allocate_ms{0.0};     // spent in allocate()
+    double   reset_ms{0.0};        // spent in vkResetCommandPool, not waiting
+};
+
+class CommandBufferAllocator {
+public:
+    static constexpr uint32_t initial_batch_size = 4;
+
+    CommandBufferAllocator() = default;
+    ~CommandBufferAllocator();
+    CommandBufferAllocator(const CommandBufferAllocator &) = delete;
+    CommandBufferAllocator &operator=(const CommandBufferAllocator &) = delete;
+
+    bool init(const DeviceDispatch &dispatch, uint32_t queue_family_index, uint32_t frame_count);
+    // Destroys the pools and with them every buffer; none may be pending.
+    void destroy();
+
+    // Switches to the slot of frame_index % frame_count, waits for fence if
+    // one is given, and resets the slot's pool.
+    VkResult begin_frame(uint32_t frame_index, VkFence fence = VK_NULL_HANDLE);
+    // The buffer is in the initial state and valid until its slot comes
+    // round again.
+    VkResult allocate(VkCommandBuffer &command_buffer, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+    // The frame being recorded, and the one begun before it.
+    const CommandBufferFrameStatistics &current_frame() const { return current_; }
+    const CommandBufferFrameStatistics &last_frame() const { return last_; }
+    uint32_t frame_count() const { return static_cast<uint32_t>(frames_.size()); }
+
+private:
+    struct FramePool {
+        VkCommandPool                               pool{VK_NULL_HANDLE};
+        // Primary at index 0, secondary at index 1.
+        std::array<std::vector<VkCommandBuffer>, 2> buffers;
+        std::array<uint32_t, 2>                     used{0, 0};
+    };
+
+    const DeviceDispatch        *dispatch_{nullptr};
+    std::vector<FramePool>       frames_;
+    uint32_t                     current_frame_{0};
+    CommandBufferFrameStatistics current_;
+    CommandBufferFrameStatistics last_;
+};
+
+#endif // COMMON_COMMAND_BUFFER_ALLOCATOR_H
@@ -0,0 +1,175 @@
+//
+// Deferred destruction of device objects.
+//
+
+#include "deferred_deletion.h"
+#include <iostream>
+
+DeferredDeletionQueue::~DeferredDeletionQueue() {
+    destroy();
+}
+
+bool DeferredDeletionQueue::init(const DeviceDispatch &dispatch, TimelineQueue &timeline, MemoryAllocator *allocator) {
+    if (dispatch.device == VK_NULL_HANDLE) {
+        return false;
+    }
+    dispatch_ = &dispatch;
+    timeline_ = &timeline;
+    allocator_ = allocator;
+    return true;
+}
+
+void DeferredDeletionQueue::destroy() {
+    if (dispatch_ == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!entries_.empty()) {
+        timeline_->wait_idle();
+    }
+    for (auto &entry : entries_) {
+        destroy_entry(entry);
+    }
+    entries_.clear();
+    dispatch_ = nullptr;
+    timeline_ = nullptr;
+    allocator_ = nullptr;
+}
+
+void DeferredDeletionQueue::push(VkObjectType type, uint64_t handle, uint64_t last_use_value) {
+    if (handle == 0) {
+        return;
+    }
+    Entry entry;
+    entry.value = last_use_value;
+    entry.type = type;
+    entry.handle = handle;
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_back(std::move(entry));
+}
+
+void DeferredDeletionQueue::push(VkCommandPool pool, uint32_t count, const VkCommandBuffer *command_buffers,
+                                 uint64_t last_use_value) {
+    if (pool == VK_NULL_HANDLE || count == 0) {
+        return;
+    }
+    Entry entry;
+    entry.value = last_use_value;
+    entry.type = VK_OBJECT_TYPE_COMMAND_BUFFER;
+    entry.command_pool = pool;
+    entry.command_buffers.assign(command_buffers, command_buffers + count);
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_back(std::move(entry));
+}
+
+void DeferredDeletionQueue::push(MemoryAllocation &allocation, uint64_t last_use_value) {
+    if (allocation.memory == VK_NULL_HANDLE) {
+        return;
+    }
+    if (allocator_ == nullptr) {
+        std::cout << "No allocator to return deferred memory to." << std::endl;
+        return;
+    }
+    Entry entry;
+    entry.value = last_use_value;
+    entry.type = VK_OBJECT_TYPE_DEVICE_MEMORY;
+    entry.allocation = allocation;
+    allocation = MemoryAllocation{};
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_back(std::move(entry));
+}
+
+void DeferredDeletionQueue::push(std::function<void()> destroy_function, uint64_t last_use_value) {
+    if (!destroy_function) {
+        return;
+    }
+    Entry entry;
+    entry.value = last_use_value;
+    entry.destroy_function = std::move(destroy_function);
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_back(std::move(entry));
+}
+
+size_t DeferredDeletionQueue::collect() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entries_.empty()) {
+        return 0;
+    }
+    uint64_t completed = timeline_->completed_value();
+    size_t retired{0};
+    while (!entries_.empty() && entries_.front().value <= completed) {
+        destroy_entry(entries_.front());
+        entries_.pop_front();
+        ++retired;
+    }
+    return retired;
+}
+
+void DeferredDeletionQueue::destroy_entry(Entry &entry) {
+    if (entry.destroy_function) {
+        entry.destroy_function();
+        return;
+    }
+    VkDevice device = dispatch_->device;
+    switch (entry.type) {
+        case VK_OBJECT_TYPE_BUFFER:
+            dispatch_->vkDestroyBuffer(device, (VkBuffer)entry.handle, nullptr);
+            break;
+        case VK_OBJECT_TYPE_BUFFER_VIEW:
+            dispatch_->vkDestroyBufferView(device, (VkBufferView)entry.handle, nullptr);
+            break;
+        case VK_OBJECT_TYPE_IMAGE:
+            dispatch_->vkDestroyImage(device, (VkImage)entry.handle, nullptr);
+            break;
+        case VK_OBJECT_TYPE_IMAGE_VIEW:
+            dispatch_->vkDestroyImageView(device, (VkImageView)entry.handle, nullptr);
+            break;
+        case VK_OBJECT_TYPE_SAMPLER:
+            dispatch_->vkDestroySampler(device, (VkSampler)entry.handle, nullptr);
+            break;
+        case VK_OBJECT_TYPE_FRAMEBUFFER:
+            dispatch_->vkDestroyFramebuffer(device, (VkFramebuffer)entry.handle, nullptr);
+            break;
+        case VK_OBJECT_TYPE_RENDER_PASS:
+            dispatch_->vkDestroyRenderPass(device, (VkRenderPass)entry.handle, nullptr);
+            break;
+        case VK_OBJECT_TYPE_PIPELINE:
+            dispatch_->vkDestroyPipeline(device, (VkPipeline)entry.handle, nullptr);
+            break;
+        case VK_OBJECT_TYPE_PIPELINE_LAYOUT:
+            dispatch_->vkDestroyPipelineLayout(device, (VkPipelineLayout)entry.handle, nullptr);
+            break;
+        case VK_OBJECT_TYPE_SHADER_MODULE:
+            dispatch_->vkDestroyShaderModule(device, (VkShaderModule)entry.handle, nullptr);
+            break;
+        case VK_OBJECT_TYPE_DESCRIPTOR_POOL:
+            dispatch_->vkDestroyDescriptorPool(device, (VkDescriptorPool)entry.handle, nullptr);
+            break;
+        case VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT:
+            dispatch_->vkDestroyDescriptorSetLayout(device, (VkDescriptorSetLayout)entry.handle, nullptr);
+            break;
+        case VK_OBJECT_TYPE_SEMAPHORE:
+            dispatch_->vkDestroySemaphore(device, (VkSemaphore)entry.handle, nullptr);
+            break;
+        case VK_OBJECT_TYPE_FENCE:
+            dispatch_->vkDestroyFence(device, (VkFence)entry.handle, nullptr);
+            break;
+        case VK_OBJECT_TYPE_COMMAND_POOL:
+            dispatch_->vkDestroyCommandPool(device, (VkCommandPool)entry.handle, nullptr);
+            break;
+        case VK_OBJECT_TYPE_COMMAND_BUFFER:
+            dispatch_->vkFreeCommandBuffers(device, entry.command_pool,
+                                            static_cast<uint32_t>(entry.command_buffers.size()),
+                                            entry.command_buffers.data());
+            break;
+        case VK_OBJECT_TYPE_SWAPCHAIN_KHR:
+            dispatch_->vkDestroySwapchainKHR(device, (VkSwapchainKHR)entry.handle, nullptr);
+            break;
+        case VK_OBJECT_TYPE_DEVICE_MEMORY:
+            allocator_->free(entry.allocation);
+            break;
+        default:
+            std::cout << "Cannot destroy deferred object of type " << entry.type << "." << std::endl;
+            break;
+    }
+}
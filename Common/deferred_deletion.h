@@ -0,0 +1,93 @@
+//
+// Deferred destruction of device objects.
+//
+// Instead of waiting for the device to go idle before destroying something
+// the GPU may still use, callers hand the handle over together with the
+// TimelineQueue value of the last submission that referenced it. collect()
+// destroys every entry whose value the queue has reached; it costs one
+// counter read and never blocks, so it can run once per frame.
+//
+// Entries retire in the order they were queued. An entry queued with an
+// older value than the one before it waits for that one too, which is late
+// but never early.
+//
+// The typed overloads rely on non-dispatchable handles being distinct pointer
+// types. Without VK_USE_64_BIT_PTR_DEFINES they are all uint64_t, so 32-bit
+// builds get only the VkObjectType form.
+//
+
+#ifndef COMMON_DEFERRED_DELETION_H
+#define COMMON_DEFERRED_DELETION_H
+
+#include "memory_allocator.h"
+#include "timeline_queue.h"
+#include <functional>
+
+class DeferredDeletionQueue {
+public:
+    DeferredDeletionQueue() = default;
+    ~DeferredDeletionQueue();
+    DeferredDeletionQueue(const DeferredDeletionQueue &) = delete;
+    DeferredDeletionQueue &operator=(const DeferredDeletionQueue &) = delete;
+
+    // allocator may be nullptr if no memory allocations are queued.
+    bool init(const DeviceDispatch &dispatch, TimelineQueue &timeline, MemoryAllocator *allocator = nullptr);
+    // Waits for the timeline and destroys everything still queued.
+    void destroy();
+
+    // The handle is destroyed once the timeline reaches last_use_value.
+    // Queuing VK_NULL_HANDLE does nothing.
+    void push(VkObjectType type, uint64_t handle, uint64_t last_use_value);
+#if VK_USE_64_BIT_PTR_DEFINES
+    void push(VkBuffer buffer, uint64_t last_use_value) { push(VK_OBJECT_TYPE_BUFFER, handle_bits(buffer), last_use_value); }
+    void push(VkBufferView view, uint64_t last_use_value) { push(VK_OBJECT_TYPE_BUFFER_VIEW, handle_bits(view), last_use_value); }
+    void push(VkImage image, uint64_t last_use_value) { push(VK_OBJECT_TYPE_IMAGE, handle_bits(image), last_use_value); }
+    void push(VkImageView view, uint64_t last_use_value) { push(VK_OBJECT_TYPE_IMAGE_VIEW, handle_bits(view), last_use_value); }
+    void push(VkSampler sampler, uint64_t last_use_value) { push(VK_OBJECT_TYPE_SAMPLER, handle_bits(sampler), last_use_value); }
+    void push(VkFramebuffer framebuffer, uint64_t last_use_value) { push(VK_OBJECT_TYPE_FRAMEBUFFER, handle_bits(framebuffer), last_use_value); }
+    void push(VkRenderPass render_pass, uint64_t last_use_value) { push(VK_OBJECT_TYPE_RENDER_PASS, handle_bits(render_pass), last_use_value); }
+    void push(VkPipeline pipeline, uint64_t last_use_value) { push(VK_OBJECT_TYPE_PIPELINE, handle_bits(pipeline), last_use_value); }
+    void push(VkPipelineLayout layout, uint64_t last_use_value) { push(VK_OBJECT_TYPE_PIPELINE_LAYOUT, handle_bits(layout), last_use_value); }
+    void push(VkShaderModule module, uint64_t last_use_value) { push(VK_OBJECT_TYPE_SHADER_MODULE, handle_bits(module), last_use_value); }
+    void push(VkDescriptorPool pool, uint64_t last_use_value) { push(VK_OBJECT_TYPE_DESCRIPTOR_POOL, handle_bits(pool), last_use_value); }
+    void push(VkDescriptorSetLayout layout, uint64_t last_use_value) { push(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, handle_bits(layout), last_use_value); }
+    void push(VkSemaphore semaphore, uint64_t last_use_value) { push(VK_OBJECT_TYPE_SEMAPHORE, handle_bits(semaphore), last_use_value); }
+    void push(VkFence fence, uint64_t last_use_value) { push(VK_OBJECT_TYPE_FENCE, handle_bits(fence), last_use_value); }
+    void push(VkCommandPool pool, uint64_t last_use_value) { push(VK_OBJECT_TYPE_COMMAND_POOL, handle_bits(pool), last_use_value); }
+    void push(VkSwapchainKHR swapchain, uint64_t last_use_value) { push(VK_OBJECT_TYPE_SWAPCHAIN_KHR, handle_bits(swapchain), last_use_value); }
+#endif
+    // Frees command buffers back to the pool they came from.
+    void push(VkCommandPool pool, uint32_t count, const VkCommandBuffer *command_buffers, uint64_t last_use_value);
+    // Returns the allocation to the allocator and clears it.
+    void push(MemoryAllocation &allocation, uint64_t last_use_value);
+    // Anything else, e.g. objects owned by the instance.
+    void push(std::function<void()> destroy_function, uint64_t last_use_value);
+
+    // Destroys every entry the timeline has reached. Returns how many retired.
+    size_t collect();
+    size_t pending() const { return entries_.size(); }
+
+private:
+    struct Entry {
+        uint64_t                     value{0};
+        VkObjectType                 type{VK_OBJECT_TYPE_UNKNOWN};
+        uint64_t                     handle{0};
+        VkCommandPool                command_pool{VK_NULL_HANDLE};
+        std::vector<VkCommandBuffer> command_buffers;
+        MemoryAllocation             allocation;
+        std::function<void()>        destroy_function;
+    };
+
+    template<typename T>
+    static uint64_t handle_bits(T handle) { return (uint64_t)handle; }
+
+    void destroy_entry(Entry &entry);
+
+    const DeviceDispatch *dispatch_{nullptr};
+    TimelineQueue        *timeline_{nullptr};
+    MemoryAllocator      *allocator_{nullptr};
+    std::deque<Entry>     entries_;
+    std::mutex            mutex_;
+};
+
+#endif // COMMON_DEFERRED_DELETION_H
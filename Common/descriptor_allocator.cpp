@@ -0,0 +1,166 @@
+//
+// Growable descriptor set allocator built on a list of descriptor pools.
+//
+
+#include "descriptor_allocator.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+DescriptorAllocator::~DescriptorAllocator() {
+    destroy();
+}
+
+bool DescriptorAllocator::init(const DeviceDispatch &dispatch, std::vector<DescriptorPoolRatio> ratios,
+                               uint32_t initial_sets_per_pool, uint32_t max_sets_per_pool,
+                               VkDescriptorPoolCreateFlags flags) {
+    if (ratios.empty() || initial_sets_per_pool == 0) {
+        std::cout << "A descriptor allocator needs descriptor types and a pool size." << std::endl;
+        return false;
+    }
+    dispatch_ = &dispatch;
+    ratios_ = std::move(ratios);
+    flags_ = flags;
+    sets_per_pool_ = initial_sets_per_pool;
+    max_sets_per_pool_ = std::max(initial_sets_per_pool, max_sets_per_pool);
+    sets_allocated_ = 0;
+    grows_ = 0;
+    return true;
+}
+
+void DescriptorAllocator::destroy() {
+    if (dispatch_ == nullptr) {
+        return;
+    }
+    if (current_ != VK_NULL_HANDLE) {
+        full_.push_back(current_);
+        current_ = VK_NULL_HANDLE;
+    }
+    for (auto pool : full_) {
+        dispatch_->vkDestroyDescriptorPool(dispatch_->device, pool, nullptr);
+    }
+    for (auto pool : ready_) {
+        dispatch_->vkDestroyDescriptorPool(dispatch_->device, pool, nullptr);
+    }
+    full_.clear();
+    ready_.clear();
+    dispatch_ = nullptr;
+}
+
+VkResult DescriptorAllocator::allocate(VkDescriptorSetLayout layout, VkDescriptorSet &set, const void *next) {
+    if (current_ == VK_NULL_HANDLE) {
+        VkResult result = next_pool();
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+    }
+    VkDescriptorSetAllocateInfo allocate_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            next,
+            current_,
+            1,
+            &layout
+    };
+    VkResult result = dispatch_->vkAllocateDescriptorSets(dispatch_->device, &allocate_info, &set);
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+        full_.push_back(current_);
+        current_ = VK_NULL_HANDLE;
+        ++grows_;
+        result = next_pool();
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+        // A fresh pool that cannot hold one set means the ratios do not
+        // cover the layout; the error is passed on rather than retried.
+        allocate_info.descriptorPool = current_;
+        result = dispatch_->vkAllocateDescriptorSets(dispatch_->device, &allocate_info, &set);
+    }
+    if (result != VK_SUCCESS) {
+        std::cout << "Could not allocate a descriptor set." << std::endl;
+        return result;
+    }
+    ++sets_allocated_;
+    return VK_SUCCESS;
+}
+
+void DescriptorAllocator::reset() {
+    if (current_ != VK_NULL_HANDLE) {
+        full_.push_back(current_);
+        current_ = VK_NULL_HANDLE;
+    }
+    for (auto pool : full_) {
+        dispatch_->vkResetDescriptorPool(dispatch_->device, pool, 0);
+        ready_.push_back(pool);
+    }
+    full_.clear();
+    sets_allocated_ = 0;
+}
+
+DescriptorAllocatorStatistics DescriptorAllocator::statistics() const {
+    DescriptorAllocatorStatistics statistics;
+    statistics.pools_in_use = static_cast<uint32_t>(full_.size()) + (current_ != VK_NULL_HANDLE ? 1 : 0);
+    statistics.pools = statistics.pools_in_use + static_cast<uint32_t>(ready_.size());
+    statistics.sets_allocated = sets_allocated_;
+    statistics.grows = grows_;
+    return statistics;
+}
+
+VkResult DescriptorAllocator::create_pool(VkDescriptorPool &pool) {
+    sizes_.clear();
+    for (const auto &ratio : ratios_) {
+        auto count = static_cast<uint32_t>(std::ceil(ratio.per_set * float(sets_per_pool_)));
+        sizes_.push_back({ratio.type, std::max(count, 1u)});
+    }
+    VkDescriptorPoolCreateInfo descriptor_pool_create_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            nullptr,
+            flags_,
+            sets_per_pool_,
+            static_cast<uint32_t>(sizes_.size()),
+            sizes_.data()
+    };
+    VkResult result = dispatch_->vkCreateDescriptorPool(dispatch_->device, &descriptor_pool_create_info, nullptr,
+                                                        &pool);
+    if (result != VK_SUCCESS) {
+        std::cout << "Could not create a descriptor pool." << std::endl;
+        return result;
+    }
+    // Frames that needed this pool will likely need more next time.
+    sets_per_pool_ = std::min(sets_per_pool_ * 2, max_sets_per_pool_);
+    return VK_SUCCESS;
+}
+
+VkResult DescriptorAllocator::next_pool() {
+    if (!ready_.empty()) {
+        current_ = ready_.back();
+        ready_.pop_back();
+        return VK_SUCCESS;
+    }
+    return create_pool(current_);
+}
+
+bool FrameDescriptorAllocator::init(const DeviceDispatch &dispatch, const std::vector<DescriptorPoolRatio> &ratios,
+                                    uint32_t frame_count, uint32_t initial_sets_per_pool, uint32_t max_sets_per_pool,
+                                    VkDescriptorPoolCreateFlags flags) {
+    frames_ = std::vector<DescriptorAllocator>(std::max(frame_count, 1u));
+    current_ = 0;
+    for (auto &frame : frames_) {
+        if (!frame.init(dispatch, ratios, initial_sets_per_pool, max_sets_per_pool, flags)) {
+            destroy();
+            return false;
+        }
+    }
+    return true;
+}
+
+void FrameDescriptorAllocator::destroy() {
+    for (auto &frame : frames_) {
+        frame.destroy();
+    }
+    frames_.clear();
+}
+
+void FrameDescriptorAllocator::begin_frame(uint32_t frame_index) {
+    current_ = frame_index % frame_count();
+    frames_[current_].reset();
+}
@@ -0,0 +1,106 @@
+//
+// Growable descriptor set allocator built on a list of descriptor pools.
+//
+// Pools are sized from per-set ratios: a pool for N sets gets
+// ceil(ratio * N) descriptors of each listed type. allocate() bumps out of
+// the current pool. When the pool reports VK_ERROR_OUT_OF_POOL_MEMORY or
+// VK_ERROR_FRAGMENTED_POOL, the allocator moves it to the full list and
+// retries once in another pool: a previously reset one if there is one,
+// else a new pool twice the size of the last, up to max_sets_per_pool.
+// Sets are never freed one by one. reset() returns every set at once with
+// one vkResetDescriptorPool per pool, so allocation costs amortized O(1)
+// however many sets a frame uses, and the pools are kept for the next
+// frame.
+//
+// FrameDescriptorAllocator keeps one DescriptorAllocator per frame in flight
+// and resets the one whose frame comes round again, the same way
+// FrameRingBuffer partitions its buffer. The caller must have waited for the
+// GPU work that used those sets first.
+//
+// Not thread-safe; give each recording thread its own allocator.
+//
+
+#ifndef COMMON_DESCRIPTOR_ALLOCATOR_H
+#define COMMON_DESCRIPTOR_ALLOCATOR_H
+
+#include "device_dispatch.h"
+
+struct DescriptorPoolRatio {
+    VkDescriptorType type;
+    float            per_set;    // descriptors of this type per set
+};
+
+struct DescriptorAllocatorStatistics {
+    uint32_t pools{0};             // pools owned, in use or not
+    uint32_t pools_in_use{0};      // pools handed sets since the last reset
+    uint64_t sets_allocated{0};    // since the last reset
+    uint32_t grows{0};             // times allocate() needed another pool
+};
+
+class DescriptorAllocator {
+public:
+    static constexpr uint32_t default_initial_sets_per_pool = 64;
+    static constexpr uint32_t default_max_sets_per_pool = 4096;
+
+    DescriptorAllocator() = default;
+    ~DescriptorAllocator();
+    DescriptorAllocator(const DescriptorAllocator &) = delete;
+    DescriptorAllocator &operator=(const DescriptorAllocator &) = delete;
+
+    // flags must not include VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT
+    // for the allocator to be of any use; UPDATE_AFTER_BIND is fine.
+    bool init(const DeviceDispatch &dispatch, std::vector<DescriptorPoolRatio> ratios,
+              uint32_t initial_sets_per_pool = default_initial_sets_per_pool,
+              uint32_t max_sets_per_pool = default_max_sets_per_pool,
+              VkDescriptorPoolCreateFlags flags = 0);
+    void destroy();
+
+    // next is chained into VkDescriptorSetAllocateInfo, e.g. a
+    // VkDescriptorSetVariableDescriptorCountAllocateInfo.
+    VkResult allocate(VkDescriptorSetLayout layout, VkDescriptorSet &set, const void *next = nullptr);
+    // Frees every set allocated since the last reset.
+    void reset();
+
+    DescriptorAllocatorStatistics statistics() const;
+
+private:
+    VkResult create_pool(VkDescriptorPool &pool);
+    // Makes current_ a pool with room, reusing a reset one if possible.
+    VkResult next_pool();
+
+    const DeviceDispatch             *dispatch_{nullptr};
+    std::vector<DescriptorPoolRatio>  ratios_;
+    std::vector<VkDescriptorPoolSize> sizes_;            // scratch for create_pool()
+    VkDescriptorPoolCreateFlags       flags_{0};
+    uint32_t                          sets_per_pool_{0};  // size of the next new pool
+    uint32_t                          max_sets_per_pool_{0};
+    VkDescriptorPool                  current_{VK_NULL_HANDLE};
+    std::vector<VkDescriptorPool>     full_;              // used since the last reset
+    std::vector<VkDescriptorPool>     ready_;             // reset and empty
+    uint64_t                          sets_allocated_{0};
+    uint32_t                          grows_{0};
+};
+
+class FrameDescriptorAllocator {
+public:
+    bool init(const DeviceDispatch &dispatch, const std::vector<DescriptorPoolRatio> &ratios, uint32_t frame_count,
+              uint32_t initial_sets_per_pool = DescriptorAllocator::default_initial_sets_per_pool,
+              uint32_t max_sets_per_pool = DescriptorAllocator::default_max_sets_per_pool,
+              VkDescriptorPoolCreateFlags flags = 0);
+    void destroy();
+
+    // Switches to the allocator of frame_index % frame_count and resets it.
+    void begin_frame(uint32_t frame_index);
+    VkResult allocate(VkDescriptorSetLayout layout, VkDescriptorSet &set, const void *next = nullptr) {
+        return frames_[current_].allocate(layout, set, next);
+    }
+
+    DescriptorAllocator &current() { return frames_[current_]; }
+    uint32_t frame_count() const { return static_cast<uint32_t>(frames_.size()); }
+
+private:
+    std::vector<DescriptorAllocator> frames_;
+    uint32_t                         current_{0};
+};
+
+#endif // COMMON_DESCRIPTOR_ALLOCATOR_H
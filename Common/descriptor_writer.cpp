@@ -0,0 +1,246 @@
+//
+// Descriptor set writer with update templates and batched writes.
+//
+
+#include "descriptor_writer.h"
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+enum class InfoKind {
+    Image,
+    Buffer,
+    TexelBuffer,
+    Unsupported
+};
+
+InfoKind info_kind(VkDescriptorType type) {
+    switch (type) {
+        case VK_DESCRIPTOR_TYPE_SAMPLER:
+        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+        case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+            return InfoKind::Image;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+            return InfoKind::Buffer;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+            return InfoKind::TexelBuffer;
+        default:
+            return InfoKind::Unsupported;
+    }
+}
+
+// Copies count values of T spaced stride bytes apart, as the template
+// entries describe them; the caller's block need not be aligned for T.
+template <typename T>
+void copy_infos(const char *source, uint32_t count, size_t stride, std::vector<T> &infos) {
+    for (uint32_t i = 0; i < count; ++i) {
+        T info;
+        std::memcpy(&info, source + i * stride, sizeof(T));
+        infos.push_back(info);
+    }
+}
+
+bool same_entries(const std::vector<VkDescriptorUpdateTemplateEntry> &a,
+                  const std::vector<VkDescriptorUpdateTemplateEntry> &b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].dstBinding != b[i].dstBinding || a[i].dstArrayElement != b[i].dstArrayElement ||
+            a[i].descriptorCount != b[i].descriptorCount || a[i].descriptorType != b[i].descriptorType ||
+            a[i].offset != b[i].offset || a[i].stride != b[i].stride) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool descriptor_update_template_supported(const std::vector<VkExtensionProperties> &available_extensions) {
+    for (const auto &extension : available_extensions) {
+        if (std::strcmp(extension.extensionName, VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+DescriptorWriter::~DescriptorWriter() {
+    destroy();
+}
+
+bool DescriptorWriter::init(const DeviceDispatch &dispatch, bool use_templates) {
+    dispatch_ = &dispatch;
+    use_templates_ = use_templates && dispatch.vkCreateDescriptorUpdateTemplateKHR != nullptr &&
+                     dispatch.vkUpdateDescriptorSetWithTemplateKHR != nullptr;
+    statistics_ = DescriptorWriterStatistics{};
+    return true;
+}
+
+void DescriptorWriter::destroy() {
+    if (dispatch_ == nullptr) {
+        return;
+    }
+    for (auto &descriptor_template : templates_) {
+        if (descriptor_template.handle != VK_NULL_HANDLE) {
+            dispatch_->vkDestroyDescriptorUpdateTemplateKHR(dispatch_->device, descriptor_template.handle, nullptr);
+        }
+    }
+    templates_.clear();
+    writes_.clear();
+    write_infos_.clear();
+    image_infos_.clear();
+    buffer_infos_.clear();
+    texel_buffer_views_.clear();
+    dispatch_ = nullptr;
+}
+
+VkResult DescriptorWriter::create_template(VkDescriptorSetLayout layout,
+                                           const std::vector<VkDescriptorUpdateTemplateEntry> &entries,
+                                           DescriptorTemplate &descriptor_template) {
+    for (const auto &entry : entries) {
+        if (info_kind(entry.descriptorType) == InfoKind::Unsupported) {
+            std::cout << "Descriptor templates support only image, buffer and texel buffer descriptors." << std::endl;
+            return VK_ERROR_FEATURE_NOT_PRESENT;
+        }
+    }
+    for (uint32_t i = 0; i < templates_.size(); ++i) {
+        if (templates_[i].layout == layout && same_entries(templates_[i].entries, entries)) {
+            descriptor_template = i;
+            return VK_SUCCESS;
+        }
+    }
+
+    Template created;
+    created.layout = layout;
+    created.entries = entries;
+    if (use_templates_) {
+        VkDescriptorUpdateTemplateCreateInfo template_create_info = {
+                VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO,
+                nullptr,
+                0,
+                static_cast<uint32_t>(entries.size()),
+                entries.data(),
+                VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET,
+                layout,
+                VK_PIPELINE_BIND_POINT_GRAPHICS,    // ignored for set templates
+                VK_NULL_HANDLE,
+                0
+        };
+        VkResult result = dispatch_->vkCreateDescriptorUpdateTemplateKHR(dispatch_->device, &template_create_info,
+                                                                         nullptr, &created.handle);
+        if (result != VK_SUCCESS) {
+            std::cout << "Could not create a descriptor update template." << std::endl;
+            return result;
+        }
+    }
+    descriptor_template = static_cast<DescriptorTemplate>(templates_.size());
+    templates_.push_back(std::move(created));
+    return VK_SUCCESS;
+}
+
+void DescriptorWriter::write(DescriptorTemplate descriptor_template, VkDescriptorSet set, const void *data) {
+    const Template &entry_list = templates_[descriptor_template];
+    ++statistics_.sets_written;
+    if (entry_list.handle != VK_NULL_HANDLE) {
+        dispatch_->vkUpdateDescriptorSetWithTemplateKHR(dispatch_->device, set, entry_list.handle, data);
+        ++statistics_.update_calls;
+        return;
+    }
+    for (const auto &entry : entry_list.entries) {
+        const char *source = static_cast<const char *>(data) + entry.offset;
+        size_t info = 0;
+        switch (info_kind(entry.descriptorType)) {
+            case InfoKind::Image:
+                info = image_infos_.size();
+                copy_infos(source, entry.descriptorCount, entry.stride, image_infos_);
+                break;
+            case InfoKind::Buffer:
+                info = buffer_infos_.size();
+                copy_infos(source, entry.descriptorCount, entry.stride, buffer_infos_);
+                break;
+            case InfoKind::TexelBuffer:
+                info = texel_buffer_views_.size();
+                copy_infos(source, entry.descriptorCount, entry.stride, texel_buffer_views_);
+                break;
+            case InfoKind::Unsupported:
+                continue;
+        }
+        queue(set, entry.dstBinding, entry.dstArrayElement, entry.descriptorCount, entry.descriptorType, info);
+    }
+}
+
+void DescriptorWriter::write_buffer(VkDescriptorSet set, uint32_t binding, VkDescriptorType type,
+                                    const VkDescriptorBufferInfo &buffer_info, uint32_t array_element) {
+    buffer_infos_.push_back(buffer_info);
+    queue(set, binding, array_element, 1, type, buffer_infos_.size() - 1);
+}
+
+void DescriptorWriter::write_image(VkDescriptorSet set, uint32_t binding, VkDescriptorType type,
+                                   const VkDescriptorImageInfo &image_info, uint32_t array_element) {
+    image_infos_.push_back(image_info);
+    queue(set, binding, array_element, 1, type, image_infos_.size() - 1);
+}
+
+void DescriptorWriter::write_texel_buffer(VkDescriptorSet set, uint32_t binding, VkDescriptorType type,
+                                          VkBufferView view, uint32_t array_element) {
+    texel_buffer_views_.push_back(view);
+    queue(set, binding, array_element, 1, type, texel_buffer_views_.size() - 1);
+}
+
+void DescriptorWriter::flush() {
+    if (writes_.empty()) {
+        return;
+    }
+    // The info arrays may have moved while writes were queued, so the
+    // pointers are only filled in now.
+    for (size_t i = 0; i < writes_.size(); ++i) {
+        switch (info_kind(writes_[i].descriptorType)) {
+            case InfoKind::Image:
+                writes_[i].pImageInfo = &image_infos_[write_infos_[i]];
+                break;
+            case InfoKind::Buffer:
+                writes_[i].pBufferInfo = &buffer_infos_[write_infos_[i]];
+                break;
+            case InfoKind::TexelBuffer:
+                writes_[i].pTexelBufferView = &texel_buffer_views_[write_infos_[i]];
+                break;
+            case InfoKind::Unsupported:
+                break;
+        }
+    }
+    dispatch_->vkUpdateDescriptorSets(dispatch_->device, static_cast<uint32_t>(writes_.size()), writes_.data(), 0,
+                                      nullptr);
+    ++statistics_.update_calls;
+    writes_.clear();
+    write_infos_.clear();
+    image_infos_.clear();
+    buffer_infos_.clear();
+    texel_buffer_views_.clear();
+}
+
+void DescriptorWriter::queue(VkDescriptorSet set, uint32_t binding, uint32_t array_element, uint32_t count,
+                             VkDescriptorType type, size_t info) {
+    writes_.push_back({
+            VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            nullptr,
+            set,
+            binding,
+            array_element,
+            count,
+            type,
+            nullptr,
+            nullptr,
+            nullptr
+    });
+    write_infos_.push_back(info);
+    statistics_.descriptors_batched += count;
+}
@@ -0,0 +1,100 @@
+//
+// Descriptor set writer with update templates and batched writes.
+//
+// A template describes how to fill one set layout from a block of caller
+// data. Each VkDescriptorUpdateTemplateEntry names a binding range and says
+// where its VkDescriptorImageInfo, VkDescriptorBufferInfo or VkBufferView
+// structures sit in the block (offset, and stride between array elements).
+// write() then needs only the set and a pointer to the block. Asking again
+// for a layout and entry list that already have a template returns that
+// template, so callers need not keep the index themselves. The layout must
+// stay alive while the writer holds templates made from it, or a new layout
+// that reuses its handle would be given the old template.
+//
+// With VK_KHR_descriptor_update_template enabled, write() is a single
+// vkUpdateDescriptorSetWithTemplateKHR call. The driver walks an entry list
+// it prepared at creation instead of decoding a VkWriteDescriptorSet array
+// on every update. Without the extension, write() copies the descriptor
+// infos into the writer and queues one VkWriteDescriptorSet per entry.
+// write_buffer(), write_image() and write_texel_buffer() queue single
+// descriptors the same way in both modes. flush() hands everything queued to
+// one vkUpdateDescriptorSets, so a frame that writes thousands of sets makes
+// one call for them. Queued writes reach their sets only at flush(), which
+// must come before the sets are bound.
+//
+// Not thread-safe.
+//
+
+#ifndef COMMON_DESCRIPTOR_WRITER_H
+#define COMMON_DESCRIPTOR_WRITER_H
+
+#include "device_dispatch.h"
+
+bool descriptor_update_template_supported(const std::vector<VkExtensionProperties> &available_extensions);
+
+// Index of a template created by DescriptorWriter::create_template().
+using DescriptorTemplate = uint32_t;
+
+struct DescriptorWriterStatistics {
+    uint64_t sets_written{0};           // by write()
+    uint64_t descriptors_batched{0};    // queued for vkUpdateDescriptorSets
+    uint64_t update_calls{0};           // vkUpdateDescriptorSets and template updates
+};
+
+class DescriptorWriter {
+public:
+    DescriptorWriter() = default;
+    ~DescriptorWriter();
+    DescriptorWriter(const DescriptorWriter &) = delete;
+    DescriptorWriter &operator=(const DescriptorWriter &) = delete;
+
+    // use_templates is ignored if the dispatch table has no template
+    // functions, i.e. the extension was not enabled on the device.
+    bool init(const DeviceDispatch &dispatch, bool use_templates);
+    // Destroys the templates. Queued writes are dropped.
+    void destroy();
+
+    // Fails with VK_ERROR_FEATURE_NOT_PRESENT for descriptor types that are
+    // not described by image, buffer or texel buffer infos. Creates nothing
+    // if the same layout and entries were seen before.
+    VkResult create_template(VkDescriptorSetLayout layout, const std::vector<VkDescriptorUpdateTemplateEntry> &entries,
+                             DescriptorTemplate &descriptor_template);
+    void write(DescriptorTemplate descriptor_template, VkDescriptorSet set, const void *data);
+
+    void write_buffer(VkDescriptorSet set, uint32_t binding, VkDescriptorType type,
+                      const VkDescriptorBufferInfo &buffer_info, uint32_t array_element = 0);
+    void write_image(VkDescriptorSet set, uint32_t binding, VkDescriptorType type,
+                     const VkDescriptorImageInfo &image_info, uint32_t array_element = 0);
+    void write_texel_buffer(VkDescriptorSet set, uint32_t binding, VkDescriptorType type, VkBufferView view,
+                            uint32_t array_element = 0);
+
+    // Applies every queued write with one vkUpdateDescriptorSets.
+    void flush();
+
+    bool uses_templates() const { return use_templates_; }
+    DescriptorWriterStatistics statistics() const { return statistics_; }
+
+private:
+    struct Template {
+        VkDescriptorSetLayout                        layout{VK_NULL_HANDLE};
+        VkDescriptorUpdateTemplate                   handle{VK_NULL_HANDLE};
+        std::vector<VkDescriptorUpdateTemplateEntry> entries;    // for reuse and the fallback
+    };
+
+    // Queues a write whose count infos start at index info of the array
+    // that holds its descriptor type.
+    void queue(VkDescriptorSet set, uint32_t binding, uint32_t array_element, uint32_t count, VkDescriptorType type,
+               size_t info);
+
+    const DeviceDispatch               *dispatch_{nullptr};
+    bool                                use_templates_{false};
+    std::vector<Template>               templates_;
+    std::vector<VkWriteDescriptorSet>   writes_;
+    std::vector<size_t>                 write_infos_;    // first info of each write
+    std::vector<VkDescriptorImageInfo>  image_infos_;
+    std::vector<VkDescriptorBufferInfo> buffer_infos_;
+    std::vector<VkBufferView>           texel_buffer_views_;
+    DescriptorWriterStatistics          statistics_;
+};
+
+#endif // COMMON_DESCRIPTOR_WRITER_H
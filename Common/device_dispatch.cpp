@@ -0,0 +1,80 @@
+//
+// Registry of live DeviceDispatch objects, keyed by loader dispatch key.
+//
+
+#include "device_dispatch.h"
+#include <algorithm>
+#include <mutex>
+
+namespace {
+
+struct RegisteredDispatch {
+    void           *key;
+    DeviceDispatch *dispatch;
+};
+
+// A handful of devices at most, so a flat vector beats a hash map here.
+std::mutex                      registry_mutex;
+std::vector<RegisteredDispatch> registry;
+
+// The loader writes a pointer to its dispatch table into the first word of
+// every dispatchable object, and all children of a device share it.
+template<typename Handle>
+void *dispatch_key(Handle handle) {
+    return *reinterpret_cast<void **>(handle);
+}
+
+DeviceDispatch *find_by_key(void *key) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (const auto &entry : registry) {
+        if (entry.key == key) {
+            return entry.dispatch;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+bool create_device_dispatch(PFN_vkGetDeviceProcAddr vkGetDeviceProcAddr,
+                            VkDevice logical_device,
+                            const std::vector<char const *> &enabled_extensions,
+                            DeviceDispatch &dispatch) {
+    if (!load_device_level_functions(vkGetDeviceProcAddr, logical_device, enabled_extensions, dispatch)) {
+        return false;
+    }
+    dispatch.device = logical_device;
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    void *key = dispatch_key(logical_device);
+    auto it = std::find_if(registry.begin(), registry.end(),
+                           [&](const RegisteredDispatch &entry) { return entry.key == key; });
+    if (it != registry.end()) {
+        it->dispatch = &dispatch;
+    } else {
+        registry.push_back({key, &dispatch});
+    }
+    return true;
+}
+
+void destroy_device_dispatch(DeviceDispatch &dispatch) {
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.erase(std::remove_if(registry.begin(), registry.end(),
+                                      [&](const RegisteredDispatch &entry) { return entry.dispatch == &dispatch; }),
+                       registry.end());
+    }
+    dispatch = DeviceDispatch{};
+}
+
+DeviceDispatch *find_device_dispatch(VkDevice logical_device) {
+    return logical_device == VK_NULL_HANDLE ? nullptr : find_by_key(dispatch_key(logical_device));
+}
+
+DeviceDispatch *find_device_dispatch(VkQueue queue) {
+    return queue == VK_NULL_HANDLE ? nullptr : find_by_key(dispatch_key(queue));
+}
+
+DeviceDispatch *find_device_dispatch(VkCommandBuffer command_buffer) {
+    return command_buffer == VK_NULL_HANDLE ? nullptr : find_by_key(dispatch_key(command_buffer));
+}
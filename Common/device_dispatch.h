@@ -0,0 +1,40 @@
+//
+// Per-VkDevice dispatch objects.
+//
+// The exported vk* symbols of the loader are trampolines: every call looks up
+// the device's dispatch table before jumping into the driver. A DeviceDispatch
+// holds the pointers returned by vkGetDeviceProcAddr, which already point into
+// the driver (or the first enabled layer), so calls made through it skip that
+// extra hop.
+//
+// Several devices can be live at the same time. Every dispatchable handle
+// created from a device (the device itself, its queues and its command
+// buffers) starts with the same loader dispatch key, so helpers that only get
+// a queue or a command buffer can find the right DeviceDispatch from it.
+//
+
+#ifndef COMMON_DEVICE_DISPATCH_H
+#define COMMON_DEVICE_DISPATCH_H
+
+#include "vulkan_dispatch.h"
+
+struct DeviceDispatch : DeviceFunctions {
+    VkDevice device{VK_NULL_HANDLE};
+};
+
+// Loads the device-level table for logical_device and registers it so that
+// find_device_dispatch() can resolve handles that belong to that device.
+bool create_device_dispatch(PFN_vkGetDeviceProcAddr vkGetDeviceProcAddr,
+                            VkDevice logical_device,
+                            const std::vector<char const *> &enabled_extensions,
+                            DeviceDispatch &dispatch);
+
+// Unregisters the dispatch and clears it. Call after vkDestroyDevice.
+void destroy_device_dispatch(DeviceDispatch &dispatch);
+
+// Returns nullptr if the handle does not belong to a registered device.
+DeviceDispatch *find_device_dispatch(VkDevice logical_device);
+DeviceDispatch *find_device_dispatch(VkQueue queue);
+DeviceDispatch *find_device_dispatch(VkCommandBuffer command_buffer);
+
+#endif // COMMON_DEVICE_DISPATCH_H
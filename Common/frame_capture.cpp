@@ -0,0 +1,294 @@
+//
+// Asynchronous frame readback to image files.
+//
+
+#include "frame_capture.h"
+#include "pixel_convert.h"
+#include <cstdio>
+#include <iostream>
+
+namespace {
+
+bool capture_format_supported(VkFormat format) {
+    return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB ||
+           format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB;
+}
+
+bool is_bgra(VkFormat format) {
+    return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+}
+
+double to_ms(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+} // namespace
+
+FrameCapture::~FrameCapture() {
+    destroy();
+}
+
+bool FrameCapture::init(const DeviceDispatch &dispatch, MemoryAllocator &allocator, TimelineQueue &timeline,
+                        VkFormat format, VkExtent2D extent, CaptureFileFormat file_format, uint32_t slot_count) {
+    if (!capture_format_supported(format)) {
+        std::cout << "Frames can only be captured from RGBA8 or BGRA8 images." << std::endl;
+        return false;
+    }
+    if (slot_count == 0 || extent.width == 0 || extent.height == 0) {
+        std::cout << "A frame capture needs at least one non-empty buffer." << std::endl;
+        return false;
+    }
+    dispatch_ = &dispatch;
+    allocator_ = &allocator;
+    timeline_ = &timeline;
+    format_ = format;
+    extent_ = extent;
+    file_format_ = file_format;
+    frame_size_ = VkDeviceSize(extent.width) * extent.height * 4;
+    statistics_ = FrameCaptureStatistics{};
+    slots_.resize(slot_count);
+    for (auto &slot : slots_) {
+        VkBufferCreateInfo buffer_create_info = {
+                VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                nullptr,
+                0,
+                frame_size_,
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_SHARING_MODE_EXCLUSIVE,
+                0,
+                nullptr
+        };
+        if (dispatch.vkCreateBuffer(dispatch.device, &buffer_create_info, nullptr, &slot.buffer) != VK_SUCCESS) {
+            std::cout << "Could not create a readback buffer." << std::endl;
+            slot.buffer = VK_NULL_HANDLE;
+            destroy();
+            return false;
+        }
+        if (allocator.allocate_for_buffer(slot.buffer, MemoryUsage::Readback, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+                                          slot.allocation) != VK_SUCCESS || slot.allocation.mapped == nullptr) {
+            std::cout << "Could not allocate mapped memory for a readback buffer." << std::endl;
+            destroy();
+            return false;
+        }
+    }
+    stop_ = false;
+    worker_ = std::thread(&FrameCapture::worker_main, this);
+    return true;
+}
+
+void FrameCapture::destroy() {
+    if (dispatch_ == nullptr) {
+        return;
+    }
+    if (worker_.joinable()) {
+        flush();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        work_ready_.notify_one();
+        worker_.join();
+    }
+    // Copies that were recorded but never submitted are dropped.
+    for (auto &slot : slots_) {
+        if (slot.buffer != VK_NULL_HANDLE) {
+            dispatch_->vkDestroyBuffer(dispatch_->device, slot.buffer, nullptr);
+        }
+        allocator_->free(slot.allocation);
+    }
+    slots_.clear();
+    in_flight_.clear();
+    jobs_.clear();
+    dispatch_ = nullptr;
+    allocator_ = nullptr;
+    timeline_ = nullptr;
+}
+
+bool FrameCapture::capture(VkCommandBuffer command_buffer, VkImage image, const std::string &basename) {
+    poll();
+
+    uint32_t index = UINT32_MAX;
+    Clock::time_point stall_start{};
+    while (index == UINT32_MAX) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            bool writing = false;
+            for (uint32_t i = 0; i < slots_.size() && index == UINT32_MAX; ++i) {
+                if (slots_[i].state == SlotState::Free) {
+                    index = i;
+                }
+                writing = writing || slots_[i].state == SlotState::Writing;
+            }
+            if (index != UINT32_MAX) {
+                break;
+            }
+            if (stall_start == Clock::time_point{}) {
+                stall_start = Clock::now();
+            }
+            if (in_flight_.empty()) {
+                if (!writing) {
+                    std::cout << "Every readback buffer holds a copy that was never submitted." << std::endl;
+                    return false;
+                }
+                // Only the worker can free a buffer now.
+                slot_freed_.wait(lock);
+                continue;
+            }
+        }
+        VkResult result = timeline_->wait(slots_[in_flight_.front()].value);
+        if (result != VK_SUCCESS) {
+            std::cout << "Waiting for a captured frame failed." << std::endl;
+            return false;
+        }
+        poll();
+    }
+    if (stall_start != Clock::time_point{}) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++statistics_.stalls;
+        statistics_.stall_ms += to_ms(Clock::now() - stall_start);
+    }
+
+    Slot &slot = slots_[index];
+    VkBufferImageCopy region = {
+            0,
+            0,
+            0,
+            {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+            {0, 0, 0},
+            {extent_.width, extent_.height, 1}
+    };
+    dispatch_->vkCmdCopyImageToBuffer(command_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer,
+                                      1, &region);
+    // The host reads the buffer once the submission has completed.
+    VkBufferMemoryBarrier host_barrier = {
+            VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            nullptr,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_ACCESS_HOST_READ_BIT,
+            VK_QUEUE_FAMILY_IGNORED,
+            VK_QUEUE_FAMILY_IGNORED,
+            slot.buffer,
+            0,
+            VK_WHOLE_SIZE
+    };
+    dispatch_->vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+                                    0, nullptr, 1, &host_barrier, 0, nullptr);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    slot.state = SlotState::Recorded;
+    slot.path = basename + (file_format_ == CaptureFileFormat::Ppm ? ".ppm" : ".raw");
+    return true;
+}
+
+void FrameCapture::submitted(uint64_t submitted_value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (uint32_t i = 0; i < slots_.size(); ++i) {
+        if (slots_[i].state == SlotState::Recorded) {
+            slots_[i].state = SlotState::InFlight;
+            slots_[i].value = submitted_value;
+            in_flight_.push_back(i);
+        }
+    }
+}
+
+void FrameCapture::poll() {
+    bool queued = false;
+    // Submission values only grow, so the oldest capture completes first.
+    while (!in_flight_.empty() && timeline_->is_complete(slots_[in_flight_.front()].value)) {
+        uint32_t index = in_flight_.front();
+        in_flight_.pop_front();
+        allocator_->invalidate(slots_[index].allocation);
+        std::lock_guard<std::mutex> lock(mutex_);
+        slots_[index].state = SlotState::Writing;
+        jobs_.push_back(index);
+        queued = true;
+    }
+    if (queued) {
+        work_ready_.notify_one();
+    }
+}
+
+void FrameCapture::flush() {
+    while (!in_flight_.empty()) {
+        if (timeline_->wait(slots_[in_flight_.front()].value) != VK_SUCCESS) {
+            std::cout << "Waiting for a captured frame failed." << std::endl;
+            return;
+        }
+        poll();
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    slot_freed_.wait(lock, [this] {
+        for (const auto &slot : slots_) {
+            if (slot.state == SlotState::Writing) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+FrameCaptureStatistics FrameCapture::statistics() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return statistics_;
+}
+
+void FrameCapture::worker_main() {
+    std::vector<uint8_t> rgb;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        work_ready_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+        if (jobs_.empty()) {
+            return;
+        }
+        uint32_t index = jobs_.front();
+        jobs_.pop_front();
+        lock.unlock();
+
+        auto start = Clock::now();
+        size_t bytes = write(slots_[index], rgb);
+        double encode_ms = to_ms(Clock::now() - start);
+
+        lock.lock();
+        if (bytes != 0) {
+            ++statistics_.frames_written;
+            statistics_.bytes_written += bytes;
+        } else {
+            ++statistics_.write_failures;
+        }
+        statistics_.encode_ms += encode_ms;
+        slots_[index].state = SlotState::Free;
+        slot_freed_.notify_all();
+    }
+}
+
+size_t FrameCapture::write(const Slot &slot, std::vector<uint8_t> &rgb) const {
+    FILE *file = fopen(slot.path.c_str(), "wb");
+    if (file == nullptr) {
+        std::cout << "Could not open " << slot.path << " for writing." << std::endl;
+        return 0;
+    }
+    const auto *texels = static_cast<const uint8_t *>(slot.allocation.mapped);
+    size_t pixel_count = size_t(extent_.width) * extent_.height;
+    size_t bytes = 0;
+    bool written;
+    if (file_format_ == CaptureFileFormat::Ppm) {
+        // Rows are tightly packed, so the whole frame converts in one call.
+        rgb.resize(pixel_count * 3);
+        if (is_bgra(format_)) {
+            convert_bgra_to_rgb(texels, rgb.data(), pixel_count);
+        } else {
+            convert_rgba_to_rgb(texels, rgb.data(), pixel_count);
+        }
+        int header = fprintf(file, "P6\n%u %u\n255\n", extent_.width, extent_.height);
+        written = header > 0 && fwrite(rgb.data(), rgb.size(), 1, file) == 1;
+        bytes = written ? size_t(header) + rgb.size() : 0;
+    } else {
+        written = fwrite(texels, frame_size_, 1, file) == 1;
+        bytes = written ? size_t(frame_size_) : 0;
+    }
+    if (fclose(file) != 0 || !written) {
+        std::cout << "Could not write " << slot.path << std::endl;
+        return 0;
+    }
+    return bytes;
+}
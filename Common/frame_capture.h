@@ -0,0 +1,123 @@
+//
+// Asynchronous frame readback to image files.
+//
+// The pool owns slot_count persistently mapped host-visible buffers, each big
+// enough for one frame. capture() records a copy of the frame's image into a
+// free buffer inside the frame's own command buffer, so no extra submission
+// and no wait is needed. Once the frame's submission value is known,
+// submitted() stamps the buffer with it; poll() then hands every buffer the
+// GPU has finished writing to a worker thread, which encodes and writes the
+// file and returns the buffer to the pool. The render thread therefore reads
+// frames back slot_count frames behind and only blocks when every buffer is
+// still in use, which is counted as a stall.
+//
+// Images must be 4 bytes per texel: RGBA8 or BGRA8, UNORM or SRGB. PPM files
+// drop alpha and are written in RGB order. Raw files are the texels exactly
+// as the GPU stored them, width * 4 bytes per row, top row first, with no
+// header.
+//
+// Apart from the worker, the pool is not thread-safe.
+//
+
+#ifndef COMMON_FRAME_CAPTURE_H
+#define COMMON_FRAME_CAPTURE_H
+
+#include "memory_allocator.h"
+#include "timeline_queue.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <string>
+#include <thread>
+
+enum class CaptureFileFormat {
+    Ppm,
+    Raw
+};
+
+struct FrameCaptureStatistics {
+    uint64_t frames_written{0};
+    uint64_t bytes_written{0};
+    uint32_t write_failures{0};
+    uint32_t stalls{0};          // times capture() waited for a free buffer
+    double   stall_ms{0.0};      // total time capture() waited
+    double   encode_ms{0.0};     // worker time spent converting and writing
+};
+
+class FrameCapture {
+public:
+    static constexpr uint32_t default_slot_count = 3;
+
+    FrameCapture() = default;
+    ~FrameCapture();
+    FrameCapture(const FrameCapture &) = delete;
+    FrameCapture &operator=(const FrameCapture &) = delete;
+
+    // timeline is the queue that executes the frames' command buffers.
+    bool init(const DeviceDispatch &dispatch, MemoryAllocator &allocator, TimelineQueue &timeline,
+              VkFormat format, VkExtent2D extent, CaptureFileFormat file_format,
+              uint32_t slot_count = default_slot_count);
+    // Writes every capture still pending, stops the worker and frees the
+    // buffers.
+    void destroy();
+
+    // Records a copy of image into a free buffer, to be written to
+    // basename + ".ppm" or ".raw". The image must be in
+    // VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL with its writes made available to
+    // the transfer stage; it is left in that layout.
+    bool capture(VkCommandBuffer command_buffer, VkImage image, const std::string &basename);
+    // Records that the submission with submitted_value executes the copies
+    // recorded since the last call.
+    void submitted(uint64_t submitted_value);
+    // Hands the captures the GPU has completed to the worker. Never blocks.
+    void poll();
+    // Waits until every submitted capture has been written.
+    void flush();
+
+    CaptureFileFormat file_format() const { return file_format_; }
+    uint32_t slot_count() const { return static_cast<uint32_t>(slots_.size()); }
+    FrameCaptureStatistics statistics();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    enum class SlotState {
+        Free,
+        Recorded,    // copy recorded, submission value not known yet
+        InFlight,    // waiting for the GPU
+        Writing      // owned by the worker
+    };
+
+    struct Slot {
+        VkBuffer         buffer{VK_NULL_HANDLE};
+        MemoryAllocation allocation;
+        SlotState        state{SlotState::Free};
+        uint64_t         value{0};
+        std::string      path;
+    };
+
+    void worker_main();
+    // Returns the number of bytes written, 0 on failure.
+    size_t write(const Slot &slot, std::vector<uint8_t> &rgb) const;
+
+    const DeviceDispatch      *dispatch_{nullptr};
+    MemoryAllocator           *allocator_{nullptr};
+    TimelineQueue             *timeline_{nullptr};
+    VkFormat                   format_{VK_FORMAT_UNDEFINED};
+    VkExtent2D                 extent_{0, 0};
+    CaptureFileFormat          file_format_{CaptureFileFormat::Ppm};
+    VkDeviceSize               frame_size_{0};
+    std::vector<Slot>          slots_;
+    std::deque<uint32_t>       in_flight_;    // oldest submission first
+
+    // Shared with the worker; slot states are only changed under mutex_.
+    std::thread                worker_;
+    std::mutex                 mutex_;
+    std::condition_variable    work_ready_;
+    std::condition_variable    slot_freed_;
+    std::deque<uint32_t>       jobs_;
+    bool                       stop_{false};
+    FrameCaptureStatistics     statistics_;
+};
+
+#endif // COMMON_FRAME_CAPTURE_H
@@ -0,0 +1,264 @@
+//
+// Frames-in-flight scheduler.
+//
+
+#include "frame_scheduler.h"
+#include "offscreen_swapchain.h"
+#include <iostream>
+
+namespace {
+
+double to_ms(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+} // namespace
+
+FrameScheduler::~FrameScheduler() {
+    destroy();
+}
+
+bool FrameScheduler::init(const DeviceDispatch &dispatch, uint32_t queue_family_index, uint32_t frames_in_flight,
+                          TimelineQueue *timeline) {
+    if (dispatch.device == VK_NULL_HANDLE || frames_in_flight == 0) {
+        return false;
+    }
+    dispatch_ = &dispatch;
+    timeline_ = timeline;
+    frames_.resize(frames_in_flight);
+
+    VkCommandPoolCreateInfo command_pool_create_info = {
+            VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            nullptr,
+            VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+            queue_family_index
+    };
+    // Created signalled so the first wait on every slot returns at once.
+    VkFenceCreateInfo fence_create_info = {
+            VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+            nullptr,
+            VK_FENCE_CREATE_SIGNALED_BIT
+    };
+    VkSemaphoreCreateInfo semaphore_create_info = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, nullptr, 0};
+
+    for (auto &frame : frames_) {
+        if (dispatch.vkCreateCommandPool(dispatch.device, &command_pool_create_info, nullptr, &frame.command_pool) != VK_SUCCESS) {
+            std::cout << "Could not create command pool." << std::endl;
+            destroy();
+            return false;
+        }
+        VkCommandBufferAllocateInfo command_buffer_allocate_info = {
+                VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                nullptr,
+                frame.command_pool,
+                VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                1
+        };
+        if (dispatch.vkAllocateCommandBuffers(dispatch.device, &command_buffer_allocate_info, &frame.command_buffer) != VK_SUCCESS) {
+            std::cout << "Could not allocate command buffers." << std::endl;
+            destroy();
+            return false;
+        }
+        if (timeline_ == nullptr &&
+            dispatch.vkCreateFence(dispatch.device, &fence_create_info, nullptr, &frame.fence) != VK_SUCCESS) {
+            std::cout << "Could not create a fence." << std::endl;
+            destroy();
+            return false;
+        }
+        if (dispatch.vkCreateSemaphore(dispatch.device, &semaphore_create_info, nullptr, &frame.image_acquired) != VK_SUCCESS) {
+            std::cout << "Could not create a semaphore." << std::endl;
+            destroy();
+            return false;
+        }
+    }
+    current_ = 0;
+    frame_number_ = 0;
+    timings_ = FrameTimings{};
+    last_begin_ = Clock::time_point{};
+    return true;
+}
+
+void FrameScheduler::destroy() {
+    if (dispatch_ == nullptr) {
+        return;
+    }
+    VkDevice device = dispatch_->device;
+    // Teardown is the one place an idle wait is right: the presentation
+    // engine may still hold the last render-finished semaphores.
+    dispatch_->vkDeviceWaitIdle(device);
+    for (auto &frame : frames_) {
+        if (frame.image_acquired != VK_NULL_HANDLE) {
+            dispatch_->vkDestroySemaphore(device, frame.image_acquired, nullptr);
+        }
+        if (frame.fence != VK_NULL_HANDLE) {
+            dispatch_->vkDestroyFence(device, frame.fence, nullptr);
+        }
+        if (frame.command_pool != VK_NULL_HANDLE) {
+            // Destroying the pool frees its command buffer too.
+            dispatch_->vkDestroyCommandPool(device, frame.command_pool, nullptr);
+        }
+    }
+    for (auto semaphore : render_finished_) {
+        if (semaphore != VK_NULL_HANDLE) {
+            dispatch_->vkDestroySemaphore(device, semaphore, nullptr);
+        }
+    }
+    frames_.clear();
+    render_finished_.clear();
+    dispatch_ = nullptr;
+    timeline_ = nullptr;
+}
+
+VkSemaphore FrameScheduler::render_finished(uint32_t image_index) {
+    if (image_index >= render_finished_.size()) {
+        render_finished_.resize(image_index + 1, VK_NULL_HANDLE);
+    }
+    if (render_finished_[image_index] == VK_NULL_HANDLE) {
+        VkSemaphoreCreateInfo semaphore_create_info = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, nullptr, 0};
+        if (dispatch_->vkCreateSemaphore(dispatch_->device, &semaphore_create_info, nullptr,
+                                         &render_finished_[image_index]) != VK_SUCCESS) {
+            std::cout << "Could not create a semaphore." << std::endl;
+            render_finished_[image_index] = VK_NULL_HANDLE;
+        }
+    }
+    return render_finished_[image_index];
+}
+
+VkResult FrameScheduler::begin_frame(VkSwapchainKHR swapchain, FrameContext *&frame) {
+    VkDevice device = dispatch_->device;
+    FrameContext &slot = frames_[current_];
+
+    auto begin = Clock::now();
+    if (last_begin_ != Clock::time_point{}) {
+        timings_.cpu_frame_ms = to_ms(begin - last_begin_);
+    }
+    // A slot that was never submitted has value 0, which is always reached.
+    VkResult result = timeline_ != nullptr ?
+                      timeline_->wait(slot.submitted_value) :
+                      dispatch_->vkWaitForFences(device, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+    if (result != VK_SUCCESS) {
+        std::cout << "Waiting on fence failed." << std::endl;
+        return result;
+    }
+    auto waited = Clock::now();
+    timings_.gpu_wait_ms = to_ms(waited - begin);
+
+    VkResult acquire_result = VK_SUCCESS;
+    if (swapchain != VK_NULL_HANDLE) {
+        acquire_result = dispatch_->vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, slot.image_acquired,
+                                                          VK_NULL_HANDLE, &slot.image_index);
+        if (acquire_result != VK_SUCCESS && acquire_result != VK_SUBOPTIMAL_KHR) {
+            return acquire_result;
+        }
+    }
+    timings_.acquire_ms = to_ms(Clock::now() - waited);
+
+    // Only reset once an image is in hand, so an out-of-date swapchain does
+    // not leave an unsignalled fence behind.
+    if (timeline_ == nullptr) {
+        result = dispatch_->vkResetFences(device, 1, &slot.fence);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+    }
+    result = dispatch_->vkResetCommandPool(device, slot.command_pool, 0);
+    if (result != VK_SUCCESS) {
+        std::cout << "Could not reset command pool." << std::endl;
+        return result;
+    }
+    VkCommandBufferBeginInfo command_buffer_begin_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            nullptr,
+            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            nullptr
+    };
+    result = dispatch_->vkBeginCommandBuffer(slot.command_buffer, &command_buffer_begin_info);
+    if (result != VK_SUCCESS) {
+        std::cout << "Could not begin command buffer recording operation." << std::endl;
+        return result;
+    }
+
+    last_begin_ = begin;
+    slot.frame_number = frame_number_;
+    frame = &slot;
+    return acquire_result;
+}
+
+VkResult FrameScheduler::begin_frame(OffscreenSwapchain &swapchain, FrameContext *&frame) {
+    VkResult result = begin_frame(VK_NULL_HANDLE, frame);
+    if (result == VK_SUCCESS) {
+        frame->image_index = swapchain.acquire();
+    }
+    return result;
+}
+
+VkResult FrameScheduler::end_frame(VkQueue queue, VkQueue present_queue, VkSwapchainKHR swapchain,
+                                   VkPipelineStageFlags wait_stage,
+                                   uint32_t extra_wait_count, const VkSemaphore *extra_wait_semaphores,
+                                   const VkPipelineStageFlags *extra_wait_stages) {
+    FrameContext &slot = frames_[current_];
+
+    VkResult result = dispatch_->vkEndCommandBuffer(slot.command_buffer);
+    if (result != VK_SUCCESS) {
+        std::cout << "Error occurred during command buffer recording." << std::endl;
+        return result;
+    }
+
+    bool presenting = swapchain != VK_NULL_HANDLE;
+    VkSemaphore signal_semaphore = presenting ? render_finished(slot.image_index) : VK_NULL_HANDLE;
+    if (presenting && signal_semaphore == VK_NULL_HANDLE) {
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+    wait_semaphores_.clear();
+    wait_stages_.clear();
+    if (presenting) {
+        wait_semaphores_.push_back(slot.image_acquired);
+        wait_stages_.push_back(wait_stage);
+    }
+    wait_semaphores_.insert(wait_semaphores_.end(), extra_wait_semaphores, extra_wait_semaphores + extra_wait_count);
+    wait_stages_.insert(wait_stages_.end(), extra_wait_stages, extra_wait_stages + extra_wait_count);
+    uint32_t wait_count = static_cast<uint32_t>(wait_semaphores_.size());
+
+    if (timeline_ != nullptr) {
+        result = timeline_->submit(1, &slot.command_buffer, slot.submitted_value,
+                                   wait_count, wait_semaphores_.data(), wait_stages_.data(),
+                                   presenting ? 1u : 0u, &signal_semaphore);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+    } else {
+        VkSubmitInfo submit_info = {
+                VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                nullptr,
+                wait_count,
+                wait_semaphores_.data(),
+                wait_stages_.data(),
+                1,
+                &slot.command_buffer,
+                presenting ? 1u : 0u,
+                &signal_semaphore
+        };
+        result = dispatch_->vkQueueSubmit(queue, 1, &submit_info, slot.fence);
+        if (result != VK_SUCCESS) {
+            std::cout << "Error occurred during command buffer submission." << std::endl;
+            return result;
+        }
+    }
+    current_ = (current_ + 1) % static_cast<uint32_t>(frames_.size());
+    ++frame_number_;
+
+    if (!presenting) {
+        return VK_SUCCESS;
+    }
+    VkPresentInfoKHR present_info = {
+            VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+            nullptr,
+            1,
+            &signal_semaphore,
+            1,
+            &swapchain,
+            &slot.image_index,
+            nullptr
+    };
+    return dispatch_->vkQueuePresentKHR(present_queue, &present_info);
+}
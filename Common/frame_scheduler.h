@@ -0,0 +1,102 @@
+//
+// Frames-in-flight render loop.
+//
+// Each of the N frames in flight owns a fence, an image-acquired semaphore and
+// a transient command pool with one primary command buffer. begin_frame()
+// waits only for the submission that last used the same frame slot, resets
+// its pool and starts recording; end_frame() submits and presents. The CPU
+// can therefore run up to N frames ahead of the GPU without any queue or
+// device idle waits.
+//
+// Render-finished semaphores are kept per swapchain image rather than per
+// frame: a frame's fence says nothing about when the presentation engine is
+// done with the semaphore the present waited on, but the image cannot be
+// acquired again before that.
+//
+// Passing VK_NULL_HANDLE as the swapchain skips acquire and present, which
+// turns the scheduler into a plain N-deep submission ring. Headless samples
+// pass an OffscreenSwapchain to begin_frame() instead, which hands out its
+// images round-robin, and VK_NULL_HANDLE to end_frame().
+//
+// Given a TimelineQueue, frames are submitted through it and each slot waits
+// on the timeline value of its last submission instead of owning a fence.
+//
+
+#ifndef COMMON_FRAME_SCHEDULER_H
+#define COMMON_FRAME_SCHEDULER_H
+
+#include "device_dispatch.h"
+#include "timeline_queue.h"
+#include <chrono>
+
+class OffscreenSwapchain;
+
+struct FrameContext {
+    VkCommandPool   command_pool{VK_NULL_HANDLE};
+    VkCommandBuffer command_buffer{VK_NULL_HANDLE};
+    VkFence         fence{VK_NULL_HANDLE};
+    VkSemaphore     image_acquired{VK_NULL_HANDLE};
+    uint32_t        image_index{0};
+    uint64_t        frame_number{0};
+    uint64_t        submitted_value{0};    // timeline value of the last submit
+};
+
+struct FrameTimings {
+    double cpu_frame_ms{0.0};   // begin_frame() to the next begin_frame()
+    double gpu_wait_ms{0.0};    // time begin_frame() blocked on the frame's fence
+    double acquire_ms{0.0};     // time spent in vkAcquireNextImageKHR
+};
+
+class FrameScheduler {
+public:
+    static constexpr uint32_t default_frames_in_flight = 2;
+
+    FrameScheduler() = default;
+    ~FrameScheduler();
+    FrameScheduler(const FrameScheduler &) = delete;
+    FrameScheduler &operator=(const FrameScheduler &) = delete;
+
+    bool init(const DeviceDispatch &dispatch, uint32_t queue_family_index,
+              uint32_t frames_in_flight = default_frames_in_flight,
+              TimelineQueue *timeline = nullptr);
+    // Waits for the device and destroys every per-frame object.
+    void destroy();
+
+    // Waits for this frame slot, acquires a swapchain image and begins the
+    // slot's command buffer. VK_ERROR_OUT_OF_DATE_KHR leaves the slot untouched
+    // so the caller can recreate the swapchain and try again.
+    VkResult begin_frame(VkSwapchainKHR swapchain, FrameContext *&frame);
+    // Same as begin_frame(VK_NULL_HANDLE, frame), with image_index taken from
+    // the offscreen swapchain.
+    VkResult begin_frame(OffscreenSwapchain &swapchain, FrameContext *&frame);
+    // Ends the command buffer, submits it and presents the acquired image.
+    // With a TimelineQueue the submission goes to its queue and queue is
+    // ignored. Extra wait semaphores, e.g. from an UploadEngine, are waited
+    // on alongside the image-acquired semaphore.
+    VkResult end_frame(VkQueue queue, VkQueue present_queue, VkSwapchainKHR swapchain,
+                       VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                       uint32_t extra_wait_count = 0, const VkSemaphore *extra_wait_semaphores = nullptr,
+                       const VkPipelineStageFlags *extra_wait_stages = nullptr);
+
+    const FrameTimings &last_timings() const { return timings_; }
+    uint32_t frames_in_flight() const { return static_cast<uint32_t>(frames_.size()); }
+    uint64_t frame_number() const { return frame_number_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    VkSemaphore render_finished(uint32_t image_index);
+
+    const DeviceDispatch             *dispatch_{nullptr};
+    TimelineQueue                    *timeline_{nullptr};
+    std::vector<FrameContext>         frames_;
+    std::vector<VkSemaphore>          render_finished_;
+    std::vector<VkSemaphore>          wait_semaphores_;    // scratch for end_frame()
+    std::vector<VkPipelineStageFlags> wait_stages_;
+    uint32_t                          current_{0};
+    uint64_t                          frame_number_{0};
+    FrameTimings                      timings_;
+    Clock::time_point                 last_begin_{};
+};
+
+#endif // COMMON_FRAME_SCHEDULER_H
@@ -0,0 +1,546 @@
+//
+// TLSF sub-allocator on top of vkAllocateMemory.
+//
+
+#include "memory_allocator.h"
+#include <algorithm>
+#include <bit>
+#include <iostream>
+
+namespace {
+
+constexpr uint32_t     nil_index = UINT32_MAX;
+constexpr uint32_t     sl_bits = 4;
+constexpr uint32_t     sl_count = 1u << sl_bits;
+constexpr uint32_t     fl_count = 64 - sl_bits + 1;
+// Fragments smaller than this are left attached to the allocation next to
+// them instead of becoming free nodes of their own.
+constexpr VkDeviceSize min_fragment_size = 64;
+
+VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment) {
+    return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+VkDeviceSize align_down(VkDeviceSize value, VkDeviceSize alignment) {
+    return alignment > 1 ? value / alignment * alignment : value;
+}
+
+// Sizes below sl_count map linearly into the first list; above that, the
+// first level is the power of two and the second level splits it into
+// sl_count equal ranges.
+void mapping_insert(VkDeviceSize size, uint32_t &fl, uint32_t &sl) {
+    if (size < sl_count) {
+        fl = 0;
+        sl = static_cast<uint32_t>(size);
+    } else {
+        uint32_t msb = static_cast<uint32_t>(std::bit_width(size)) - 1;
+        sl = static_cast<uint32_t>(size >> (msb - sl_bits)) ^ sl_count;
+        fl = msb - sl_bits + 1;
+    }
+}
+
+// Rounds size up to the next list boundary so any node found there fits.
+void mapping_search(VkDeviceSize size, uint32_t &fl, uint32_t &sl) {
+    if (size >= sl_count) {
+        uint32_t msb = static_cast<uint32_t>(std::bit_width(size)) - 1;
+        size += (VkDeviceSize{1} << (msb - sl_bits)) - 1;
+    }
+    mapping_insert(size, fl, sl);
+}
+
+} // namespace
+
+struct MemoryBlock {
+    struct Node {
+        VkDeviceSize offset;
+        VkDeviceSize size;
+        VkDeviceSize requested;     // bytes the caller asked for, 0 when free
+        uint32_t     prev_physical;
+        uint32_t     next_physical;
+        uint32_t     prev_free;
+        uint32_t     next_free;
+        bool         free;
+    };
+
+    VkDeviceMemory    memory{VK_NULL_HANDLE};
+    VkDeviceSize      size{0};
+    uint32_t          memory_type_index{0};
+    bool              dedicated{false};
+    void             *mapped{nullptr};
+    uint32_t          allocation_count{0};
+
+    uint64_t          fl_bitmap{0};
+    uint32_t          sl_bitmap[fl_count]{};
+    uint32_t          free_heads[fl_count][sl_count];
+    std::vector<Node> nodes;
+    std::vector<uint32_t> unused_nodes;
+
+    MemoryBlock(VkDeviceSize block_size) : size(block_size) {
+        std::fill(&free_heads[0][0], &free_heads[0][0] + fl_count * sl_count, nil_index);
+        uint32_t node = new_node({0, block_size, 0, nil_index, nil_index, nil_index, nil_index, true});
+        insert_free(node);
+    }
+
+    uint32_t new_node(const Node &value) {
+        if (!unused_nodes.empty()) {
+            uint32_t index = unused_nodes.back();
+            unused_nodes.pop_back();
+            nodes[index] = value;
+            return index;
+        }
+        nodes.push_back(value);
+        return static_cast<uint32_t>(nodes.size() - 1);
+    }
+
+    void insert_free(uint32_t index) {
+        uint32_t fl, sl;
+        mapping_insert(nodes[index].size, fl, sl);
+        Node &node = nodes[index];
+        node.free = true;
+        node.requested = 0;
+        node.prev_free = nil_index;
+        node.next_free = free_heads[fl][sl];
+        if (node.next_free != nil_index) {
+            nodes[node.next_free].prev_free = index;
+        }
+        free_heads[fl][sl] = index;
+        fl_bitmap |= uint64_t{1} << fl;
+        sl_bitmap[fl] |= 1u << sl;
+    }
+
+    void remove_free(uint32_t index) {
+        uint32_t fl, sl;
+        mapping_insert(nodes[index].size, fl, sl);
+        Node &node = nodes[index];
+        if (node.prev_free != nil_index) {
+            nodes[node.prev_free].next_free = node.next_free;
+        } else {
+            free_heads[fl][sl] = node.next_free;
+            if (node.next_free == nil_index) {
+                sl_bitmap[fl] &= ~(1u << sl);
+                if (sl_bitmap[fl] == 0) {
+                    fl_bitmap &= ~(uint64_t{1} << fl);
+                }
+            }
+        }
+        if (node.next_free != nil_index) {
+            nodes[node.next_free].prev_free = node.prev_free;
+        }
+        node.free = false;
+    }
+
+    // Good fit: size is rounded up to the next class first, so the head of
+    // whichever list the bitmaps lead to always fits and no list is walked.
+    // A node in size's own class that happens to be large enough is passed
+    // over; the price is at most 1/sl_count of the request.
+    uint32_t find_free(VkDeviceSize size) const {
+        uint32_t fl, sl;
+        mapping_search(size, fl, sl);
+        if (fl >= fl_count) {
+            return nil_index;
+        }
+        uint32_t sl_map = sl_bitmap[fl] & (~0u << sl);
+        if (sl_map == 0) {
+            uint64_t fl_map = fl + 1 < 64 ? fl_bitmap & (~uint64_t{0} << (fl + 1)) : 0;
+            if (fl_map == 0) {
+                return nil_index;
+            }
+            fl = static_cast<uint32_t>(std::countr_zero(fl_map));
+            sl_map = sl_bitmap[fl];
+        }
+        return free_heads[fl][static_cast<uint32_t>(std::countr_zero(sl_map))];
+    }
+
+    // Keeps the first keep bytes of node index and turns the rest into a new
+    // free node.
+    void split_tail(uint32_t index, VkDeviceSize keep) {
+        uint32_t tail = new_node({nodes[index].offset + keep, nodes[index].size - keep, 0,
+                                  index, nodes[index].next_physical, nil_index, nil_index, true});
+        Node &head = nodes[index];
+        if (head.next_physical != nil_index) {
+            nodes[head.next_physical].prev_physical = tail;
+        }
+        head.next_physical = tail;
+        head.size = keep;
+        insert_free(tail);
+    }
+
+    // request is the padded size that has to fit, requested what the caller
+    // asked for; the difference is reported as waste.
+    bool allocate(VkDeviceSize request, VkDeviceSize alignment, VkDeviceSize requested,
+                  uint32_t &node_index, VkDeviceSize &offset) {
+        uint32_t index = find_free(request + (alignment > 1 ? alignment - 1 : 0));
+        if (index == nil_index) {
+            return false;
+        }
+        allocate_at(index, request, alignment, requested, node_index, offset);
+        return true;
+    }
+
+    // Takes the whole of a block that has just been created. A dedicated
+    // block is exactly as large as its request, which the rounded-up search
+    // in find_free would not accept.
+    bool allocate_fresh(VkDeviceSize request, VkDeviceSize requested, uint32_t &node_index, VkDeviceSize &offset) {
+        if (allocation_count != 0 || request > size) {
+            return false;
+        }
+        allocate_at(0, request, 1, requested, node_index, offset);
+        return true;
+    }
+
+    // Carves the allocation out of free node index, which must fit it.
+    void allocate_at(uint32_t index, VkDeviceSize request, VkDeviceSize alignment, VkDeviceSize requested,
+                     uint32_t &node_index, VkDeviceSize &offset) {
+        remove_free(index);
+
+        VkDeviceSize front = align_up(nodes[index].offset, alignment) - nodes[index].offset;
+        if (front >= min_fragment_size) {
+            // Give the padding in front back to the free lists.
+            split_tail(index, front);
+            uint32_t padding = index;
+            index = nodes[padding].next_physical;
+            remove_free(index);
+            insert_free(padding);
+            front = 0;
+        }
+        if (nodes[index].size - front - request >= min_fragment_size) {
+            split_tail(index, front + request);
+        }
+        nodes[index].requested = requested;
+        node_index = index;
+        offset = nodes[index].offset + front;
+        ++allocation_count;
+    }
+
+    void release(uint32_t index) {
+        --allocation_count;
+        uint32_t prev = nodes[index].prev_physical;
+        if (prev != nil_index && nodes[prev].free) {
+            remove_free(prev);
+            nodes[prev].size += nodes[index].size;
+            nodes[prev].next_physical = nodes[index].next_physical;
+            if (nodes[index].next_physical != nil_index) {
+                nodes[nodes[index].next_physical].prev_physical = prev;
+            }
+            unused_nodes.push_back(index);
+            index = prev;
+        }
+        uint32_t next = nodes[index].next_physical;
+        if (next != nil_index && nodes[next].free) {
+            remove_free(next);
+            nodes[index].size += nodes[next].size;
+            nodes[index].next_physical = nodes[next].next_physical;
+            if (nodes[next].next_physical != nil_index) {
+                nodes[nodes[next].next_physical].prev_physical = index;
+            }
+            unused_nodes.push_back(next);
+        }
+        insert_free(index);
+    }
+};
+
+MemoryAllocator::MemoryAllocator() = default;
+
+MemoryAllocator::~MemoryAllocator() {
+    destroy();
+}
+
+bool MemoryAllocator::init(const DeviceDispatch &dispatch,
+                           const VkPhysicalDeviceMemoryProperties &memory_properties,
+                           const VkPhysicalDeviceLimits &limits,
+                           VkDeviceSize block_size) {
+    if (dispatch.device == VK_NULL_HANDLE) {
+        return false;
+    }
+    dispatch_ = &dispatch;
+    memory_properties_ = memory_properties;
+    memory_type_resolver_.init(memory_properties);
+    std::fill(std::begin(heap_usage_), std::end(heap_usage_), 0);
+    buffer_image_granularity_ = std::max<VkDeviceSize>(limits.bufferImageGranularity, 1);
+    non_coherent_atom_size_ = std::max<VkDeviceSize>(limits.nonCoherentAtomSize, 1);
+    max_memory_allocation_count_ = limits.maxMemoryAllocationCount;
+    block_size_ = block_size;
+    return true;
+}
+
+void MemoryAllocator::destroy() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (uint32_t i = 0; i < blocks_.size(); ++i) {
+        if (blocks_[i] != nullptr) {
+            if (blocks_[i]->allocation_count != 0) {
+                std::cout << "Memory block " << i << " still has " << blocks_[i]->allocation_count
+                          << " live allocations." << std::endl;
+            }
+            release_block(i);
+        }
+    }
+    blocks_.clear();
+}
+
+VkResult MemoryAllocator::create_block(uint32_t memory_type_index, VkDeviceSize size, bool dedicated,
+                                       uint32_t &block_index) {
+    if (max_memory_allocation_count_ != 0 && device_memory_count_ >= max_memory_allocation_count_) {
+        return VK_ERROR_TOO_MANY_OBJECTS;
+    }
+    VkMemoryAllocateInfo memory_allocate_info{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, nullptr, size, memory_type_index};
+    VkDeviceMemory memory{VK_NULL_HANDLE};
+    VkResult result = dispatch_->vkAllocateMemory(dispatch_->device, &memory_allocate_info, nullptr, &memory);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+    void *mapped{nullptr};
+    if (memory_properties_.memoryTypes[memory_type_index].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        result = dispatch_->vkMapMemory(dispatch_->device, memory, 0, VK_WHOLE_SIZE, 0, &mapped);
+        if (result != VK_SUCCESS) {
+            dispatch_->vkFreeMemory(dispatch_->device, memory, nullptr);
+            return result;
+        }
+    }
+    ++device_memory_count_;
+    heap_usage_[memory_properties_.memoryTypes[memory_type_index].heapIndex] += size;
+
+    auto block = std::make_unique<MemoryBlock>(size);
+    block->memory = memory;
+    block->memory_type_index = memory_type_index;
+    block->dedicated = dedicated;
+    block->mapped = mapped;
+
+    auto slot = std::find(blocks_.begin(), blocks_.end(), nullptr);
+    if (slot == blocks_.end()) {
+        slot = blocks_.insert(blocks_.end(), nullptr);
+    }
+    *slot = std::move(block);
+    block_index = static_cast<uint32_t>(slot - blocks_.begin());
+    return VK_SUCCESS;
+}
+
+void MemoryAllocator::release_block(uint32_t block_index) {
+    MemoryBlock &block = *blocks_[block_index];
+    if (block.mapped != nullptr) {
+        dispatch_->vkUnmapMemory(dispatch_->device, block.memory);
+    }
+    dispatch_->vkFreeMemory(dispatch_->device, block.memory, nullptr);
+    --device_memory_count_;
+    heap_usage_[memory_properties_.memoryTypes[block.memory_type_index].heapIndex] -= block.size;
+    blocks_[block_index].reset();
+}
+
+VkResult MemoryAllocator::allocate_from_type(uint32_t memory_type_index, VkDeviceSize size, VkDeviceSize alignment,
+                                             VkDeviceSize requested, bool dedicated, bool within_budget,
+                                             MemoryAllocation &allocation) {
+    // Small heaps get proportionally smaller blocks so one block cannot eat
+    // the whole heap.
+    uint32_t heap_index = memory_properties_.memoryTypes[memory_type_index].heapIndex;
+    VkDeviceSize block_size = std::min(block_size_, align_up(memory_properties_.memoryHeaps[heap_index].size / 8,
+                                                             non_coherent_atom_size_));
+    dedicated = dedicated || size > block_size / 2;
+
+    uint32_t block_index = nil_index;
+    uint32_t node_index = nil_index;
+    VkDeviceSize offset = 0;
+
+    if (!dedicated) {
+        for (uint32_t i = 0; i < blocks_.size(); ++i) {
+            MemoryBlock *block = blocks_[i].get();
+            if (block != nullptr && !block->dedicated && block->memory_type_index == memory_type_index &&
+                block->allocate(size, alignment, requested, node_index, offset)) {
+                block_index = i;
+                break;
+            }
+        }
+    }
+    if (block_index == nil_index) {
+        VkDeviceSize new_block_size = dedicated ? size : std::max(block_size, size);
+        if (within_budget &&
+            heap_usage_[heap_index] + new_block_size > memory_type_resolver_.heap_budget(heap_index)) {
+            return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        }
+        VkResult result = create_block(memory_type_index, new_block_size, dedicated, block_index);
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+        // A fresh block starts at offset 0, which satisfies any alignment.
+        if (!blocks_[block_index]->allocate_fresh(size, requested, node_index, offset)) {
+            release_block(block_index);
+            return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        }
+    }
+
+    MemoryBlock &block = *blocks_[block_index];
+    allocation.memory = block.memory;
+    allocation.offset = offset;
+    allocation.size = requested;
+    allocation.memory_type_index = memory_type_index;
+    allocation.mapped = block.mapped != nullptr ? static_cast<char *>(block.mapped) + offset : nullptr;
+    allocation.block_index = block_index;
+    allocation.node_index = node_index;
+    return VK_SUCCESS;
+}
+
+VkResult MemoryAllocator::allocate(const VkMemoryRequirements &requirements,
+                                   MemoryUsage usage,
+                                   VkMemoryPropertyFlags required_properties,
+                                   VkMemoryPropertyFlags preferred_properties,
+                                   MemoryResourceKind kind,
+                                   bool dedicated,
+                                   MemoryAllocation &allocation) {
+    if (dispatch_ == nullptr) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    VkDeviceSize size = requirements.size;
+    VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+    if (kind == MemoryResourceKind::Optimal && buffer_image_granularity_ > 1) {
+        alignment = std::max(alignment, buffer_image_granularity_);
+        size = align_up(size, buffer_image_granularity_);
+    }
+
+    MemoryTypeCandidates candidates = memory_type_resolver_.candidates(requirements.memoryTypeBits, required_properties,
+                                                                       preferred_properties, usage);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    VkResult result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    // First pass keeps every heap within its budget; only if that fails is a
+    // heap allowed to go over.
+    for (int pass = 0; pass < 2 && result != VK_SUCCESS; ++pass) {
+        for (uint32_t i = 0; i < candidates.count; ++i) {
+            result = allocate_from_type(candidates.types[i], size, alignment, requirements.size, dedicated, pass == 0,
+                                        allocation);
+            if (result == VK_SUCCESS) {
+                break;
+            }
+        }
+    }
+    if (result != VK_SUCCESS) {
+        std::cout << "Could not allocate " << requirements.size << " bytes of device memory." << std::endl;
+    }
+    return result;
+}
+
+VkResult MemoryAllocator::allocate_for_buffer(VkBuffer buffer, MemoryUsage usage, VkMemoryPropertyFlags required_properties,
+                                              MemoryAllocation &allocation) {
+    VkMemoryRequirements memory_requirements;
+    dispatch_->vkGetBufferMemoryRequirements(dispatch_->device, buffer, &memory_requirements);
+    VkResult result = allocate(memory_requirements, usage, required_properties, 0, MemoryResourceKind::Linear, false,
+                               allocation);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+    result = dispatch_->vkBindBufferMemory(dispatch_->device, buffer, allocation.memory, allocation.offset);
+    if (result != VK_SUCCESS) {
+        std::cout << "Could not bind memory object to a buffer." << std::endl;
+        free(allocation);
+    }
+    return result;
+}
+
+VkResult MemoryAllocator::allocate_for_image(VkImage image, VkImageTiling tiling, MemoryUsage usage,
+                                             VkMemoryPropertyFlags required_properties, MemoryAllocation &allocation,
+                                             bool dedicated) {
+    VkMemoryRequirements memory_requirements;
+    dispatch_->vkGetImageMemoryRequirements(dispatch_->device, image, &memory_requirements);
+    MemoryResourceKind kind = tiling == VK_IMAGE_TILING_OPTIMAL ? MemoryResourceKind::Optimal : MemoryResourceKind::Linear;
+    VkResult result = allocate(memory_requirements, usage, required_properties, 0, kind, dedicated, allocation);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+    result = dispatch_->vkBindImageMemory(dispatch_->device, image, allocation.memory, allocation.offset);
+    if (result != VK_SUCCESS) {
+        std::cout << "Could not bind memory object to an image." << std::endl;
+        free(allocation);
+    }
+    return result;
+}
+
+void MemoryAllocator::free(MemoryAllocation &allocation) {
+    if (allocation.memory == VK_NULL_HANDLE) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    MemoryBlock &block = *blocks_[allocation.block_index];
+    block.release(allocation.node_index);
+
+    if (block.allocation_count == 0) {
+        // Keep one empty shared block per memory type around so that a
+        // create/destroy cycle does not hit vkAllocateMemory every time.
+        bool keep = !block.dedicated;
+        for (uint32_t i = 0; keep && i < blocks_.size(); ++i) {
+            const MemoryBlock *other = blocks_[i].get();
+            if (i != allocation.block_index && other != nullptr && !other->dedicated &&
+                other->memory_type_index == block.memory_type_index && other->allocation_count == 0) {
+                keep = false;
+            }
+        }
+        if (!keep) {
+            release_block(allocation.block_index);
+        }
+    }
+    allocation = MemoryAllocation{};
+}
+
+bool MemoryAllocator::mapped_range(const MemoryAllocation &allocation, VkDeviceSize offset, VkDeviceSize size,
+                                   VkMappedMemoryRange &range) const {
+    if (allocation.mapped == nullptr ||
+        (memory_properties_.memoryTypes[allocation.memory_type_index].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+        return false;
+    }
+    if (size == VK_WHOLE_SIZE) {
+        size = allocation.size - offset;
+    }
+    VkDeviceSize block_size;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        block_size = blocks_[allocation.block_index]->size;
+    }
+    VkDeviceSize begin = align_down(allocation.offset + offset, non_coherent_atom_size_);
+    VkDeviceSize end = align_up(allocation.offset + offset + size, non_coherent_atom_size_);
+    range = {VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE, nullptr, allocation.memory, begin,
+             end >= block_size ? VK_WHOLE_SIZE : end - begin};
+    return true;
+}
+
+VkResult MemoryAllocator::flush(const MemoryAllocation &allocation, VkDeviceSize offset, VkDeviceSize size) {
+    VkMappedMemoryRange range;
+    if (!mapped_range(allocation, offset, size, range)) {
+        return VK_SUCCESS;
+    }
+    return dispatch_->vkFlushMappedMemoryRanges(dispatch_->device, 1, &range);
+}
+
+VkResult MemoryAllocator::invalidate(const MemoryAllocation &allocation, VkDeviceSize offset, VkDeviceSize size) {
+    VkMappedMemoryRange range;
+    if (!mapped_range(allocation, offset, size, range)) {
+        return VK_SUCCESS;
+    }
+    return dispatch_->vkInvalidateMappedMemoryRanges(dispatch_->device, 1, &range);
+}
+
+MemoryAllocatorStatistics MemoryAllocator::statistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    MemoryAllocatorStatistics statistics;
+    for (const auto &block : blocks_) {
+        if (block == nullptr) {
+            continue;
+        }
+        if (block->dedicated) {
+            ++statistics.dedicated_allocation_count;
+        } else {
+            ++statistics.block_count;
+        }
+        statistics.reserved_bytes += block->size;
+        for (uint32_t index = 0; index != nil_index; index = block->nodes[index].next_physical) {
+            const MemoryBlock::Node &node = block->nodes[index];
+            if (node.free) {
+                statistics.free_bytes += node.size;
+                statistics.largest_free_range = std::max(statistics.largest_free_range, node.size);
+            } else {
+                ++statistics.allocation_count;
+                statistics.allocated_bytes += node.requested;
+                statistics.wasted_bytes += node.size - node.requested;
+            }
+        }
+    }
+    if (statistics.free_bytes != 0) {
+        statistics.fragmentation = 1.0f - float(statistics.largest_free_range) / float(statistics.free_bytes);
+    }
+    return statistics;
+}
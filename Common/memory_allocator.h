@@ -0,0 +1,121 @@
+//
+// Sub-allocating device memory allocator.
+//
+// Instead of one vkAllocateMemory per buffer or image, the allocator reserves
+// large blocks per memory type and carves resources out of them with a TLSF
+// (two-level segregated fit) free list, so allocation and release are O(1)
+// and the number of VkDeviceMemory objects stays far below
+// maxMemoryAllocationCount.
+//
+// Optimal-tiling images are rounded out to whole bufferImageGranularity pages,
+// which keeps linear and non-linear resources from ever sharing a page.
+// Large resources, or callers that ask for it, get a dedicated VkDeviceMemory.
+// Host-visible blocks are mapped once when they are created and stay mapped.
+//
+// Memory types are picked by a MemoryTypeResolver. Blocks are only created in
+// heaps that stay within their budget while any other candidate heap would.
+//
+
+#ifndef COMMON_MEMORY_ALLOCATOR_H
+#define COMMON_MEMORY_ALLOCATOR_H
+
+#include "device_dispatch.h"
+#include "memory_type_resolver.h"
+#include <memory>
+#include <mutex>
+
+struct MemoryAllocation {
+    VkDeviceMemory memory{VK_NULL_HANDLE};
+    VkDeviceSize   offset{0};
+    VkDeviceSize   size{0};
+    uint32_t       memory_type_index{0};
+    void          *mapped{nullptr};        // host pointer to offset, or nullptr
+
+    uint32_t       block_index{UINT32_MAX};
+    uint32_t       node_index{UINT32_MAX};
+};
+
+enum class MemoryResourceKind {
+    Linear,     // buffers and linear-tiling images
+    Optimal     // optimal-tiling images
+};
+
+struct MemoryAllocatorStatistics {
+    uint32_t     block_count{0};
+    uint32_t     dedicated_allocation_count{0};
+    uint32_t     allocation_count{0};
+    VkDeviceSize reserved_bytes{0};     // all VkDeviceMemory owned by the allocator
+    VkDeviceSize allocated_bytes{0};    // bytes callers asked for
+    VkDeviceSize wasted_bytes{0};       // alignment padding, granularity rounding, unsplit tails
+    VkDeviceSize free_bytes{0};
+    VkDeviceSize largest_free_range{0};
+    float        fragmentation{0.0f};   // 1 - largest_free_range / free_bytes
+};
+
+struct MemoryBlock;
+
+class MemoryAllocator {
+public:
+    static constexpr VkDeviceSize default_block_size = 64ull * 1024 * 1024;
+
+    MemoryAllocator();
+    ~MemoryAllocator();
+    MemoryAllocator(const MemoryAllocator &) = delete;
+    MemoryAllocator &operator=(const MemoryAllocator &) = delete;
+
+    bool init(const DeviceDispatch &dispatch,
+              const VkPhysicalDeviceMemoryProperties &memory_properties,
+              const VkPhysicalDeviceLimits &limits,
+              VkDeviceSize block_size = default_block_size);
+    // Releases every block. All allocations must have been freed.
+    void destroy();
+
+    VkResult allocate(const VkMemoryRequirements &requirements,
+                      MemoryUsage usage,
+                      VkMemoryPropertyFlags required_properties,
+                      VkMemoryPropertyFlags preferred_properties,
+                      MemoryResourceKind kind,
+                      bool dedicated,
+                      MemoryAllocation &allocation);
+    // Allocate and bind in one step.
+    VkResult allocate_for_buffer(VkBuffer buffer, MemoryUsage usage, VkMemoryPropertyFlags required_properties,
+                                 MemoryAllocation &allocation);
+    VkResult allocate_for_image(VkImage image, VkImageTiling tiling, MemoryUsage usage,
+                                VkMemoryPropertyFlags required_properties, MemoryAllocation &allocation,
+                                bool dedicated = false);
+    void free(MemoryAllocation &allocation);
+
+    // Flushes a range of a mapped allocation, rounded to nonCoherentAtomSize.
+    // Does nothing for host-coherent memory.
+    VkResult flush(const MemoryAllocation &allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+    // Makes device writes visible to the host before reading a mapped range.
+    VkResult invalidate(const MemoryAllocation &allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+
+    MemoryAllocatorStatistics statistics() const;
+
+    MemoryTypeResolver &memory_type_resolver() { return memory_type_resolver_; }
+    const MemoryTypeResolver &memory_type_resolver() const { return memory_type_resolver_; }
+
+private:
+    VkResult allocate_from_type(uint32_t memory_type_index, VkDeviceSize size, VkDeviceSize alignment,
+                                VkDeviceSize requested, bool dedicated, bool within_budget,
+                                MemoryAllocation &allocation);
+    VkResult create_block(uint32_t memory_type_index, VkDeviceSize size, bool dedicated, uint32_t &block_index);
+    void release_block(uint32_t block_index);
+    bool mapped_range(const MemoryAllocation &allocation, VkDeviceSize offset, VkDeviceSize size,
+                      VkMappedMemoryRange &range) const;
+
+    const DeviceDispatch                     *dispatch_{nullptr};
+    VkPhysicalDeviceMemoryProperties          memory_properties_{};
+    MemoryTypeResolver                        memory_type_resolver_;
+    VkDeviceSize                              heap_usage_[VK_MAX_MEMORY_HEAPS]{};
+    VkDeviceSize                              buffer_image_granularity_{1};
+    VkDeviceSize                              non_coherent_atom_size_{1};
+    uint32_t                                  max_memory_allocation_count_{0};
+    VkDeviceSize                              block_size_{default_block_size};
+    uint32_t                                  device_memory_count_{0};
+    std::vector<std::unique_ptr<MemoryBlock>> blocks_;
+    mutable std::mutex                        mutex_;
+};
+
+#endif // COMMON_MEMORY_ALLOCATOR_H
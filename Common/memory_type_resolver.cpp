@@ -0,0 +1,167 @@
+//
+// Scored memory-type lookup.
+//
+
+#include "memory_type_resolver.h"
+#include <algorithm>
+#include <bit>
+
+namespace {
+
+constexpr int32_t excluded = INT32_MIN;
+constexpr int32_t preferred_weight = 30;
+
+// Lazily allocated memory only backs transient attachments and protected
+// memory needs a protected queue; neither is picked unless asked for.
+constexpr VkMemoryPropertyFlags special_properties =
+        VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT | VK_MEMORY_PROPERTY_PROTECTED_BIT;
+
+int32_t usage_score(MemoryUsage usage, VkMemoryPropertyFlags flags) {
+    bool device_local = flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    bool host_visible = flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    bool host_coherent = flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    bool host_cached = flags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+
+    switch (usage) {
+        case MemoryUsage::GpuOnly:
+            // Leave host-visible device memory (the BAR window) to Dynamic.
+            return (device_local ? 100 : 0) - (host_visible ? 10 : 0);
+        case MemoryUsage::Upload:
+            if (!host_visible) {
+                return excluded;
+            }
+            return (host_coherent ? 20 : 0) - (host_cached ? 5 : 0) - (device_local ? 10 : 0);
+        case MemoryUsage::Dynamic:
+            if (!host_visible) {
+                return excluded;
+            }
+            return (device_local ? 40 : 0) + (host_coherent ? 20 : 0);
+        case MemoryUsage::Readback:
+            if (!host_visible) {
+                return excluded;
+            }
+            return (host_cached ? 100 : 0) + (host_coherent ? 20 : 0);
+        default:
+            return 0;
+    }
+}
+
+} // namespace
+
+void MemoryTypeResolver::init(const VkPhysicalDeviceMemoryProperties &memory_properties) {
+    memory_properties_ = memory_properties;
+    VkMemoryPropertyFlags reported = 0;
+    for (uint32_t type = 0; type < memory_properties_.memoryTypeCount; ++type) {
+        reported |= memory_properties_.memoryTypes[type].propertyFlags;
+    }
+    ranked_properties_ = 0;
+    for (uint32_t i = 0; i < max_ranked_properties && reported != 0; ++i) {
+        ranked_properties_ |= reported & (~reported + 1);
+        reported &= reported - 1;
+    }
+    rankings_per_usage_ = 1u << std::popcount(ranked_properties_);
+
+    for (uint32_t usage = 0; usage < static_cast<uint32_t>(MemoryUsage::Count); ++usage) {
+        for (uint32_t type = 0; type < memory_properties_.memoryTypeCount; ++type) {
+            scores_[usage][type] = usage_score(static_cast<MemoryUsage>(usage),
+                                               memory_properties_.memoryTypes[type].propertyFlags);
+        }
+    }
+    rankings_.assign(static_cast<uint32_t>(MemoryUsage::Count) * rankings_per_usage_, MemoryTypeCandidates{});
+    for (uint32_t usage = 0; usage < static_cast<uint32_t>(MemoryUsage::Count); ++usage) {
+        // Enumerate every subset of the ranked bits.
+        VkMemoryPropertyFlags preferred = 0;
+        do {
+            rankings_[usage * rankings_per_usage_ + ranking_index(preferred)] =
+                    rank(preferred, static_cast<MemoryUsage>(usage));
+            preferred = (preferred - ranked_properties_) & ranked_properties_;
+        } while (preferred != 0);
+    }
+    for (uint32_t heap = 0; heap < memory_properties_.memoryHeapCount; ++heap) {
+        heap_budgets_[heap] = memory_properties_.memoryHeaps[heap].size / 10 * 8;
+    }
+}
+
+void MemoryTypeResolver::set_heap_budget(uint32_t heap_index, VkDeviceSize budget) {
+    if (heap_index < memory_properties_.memoryHeapCount) {
+        heap_budgets_[heap_index] = budget;
+    }
+}
+
+VkDeviceSize MemoryTypeResolver::heap_budget(uint32_t heap_index) const {
+    return heap_index < memory_properties_.memoryHeapCount ? heap_budgets_[heap_index] : 0;
+}
+
+MemoryTypeCandidates MemoryTypeResolver::rank(VkMemoryPropertyFlags preferred_properties, MemoryUsage usage) const {
+    int32_t scores[VK_MAX_MEMORY_TYPES];
+    MemoryTypeCandidates candidates;
+    for (uint32_t type = 0; type < memory_properties_.memoryTypeCount; ++type) {
+        VkMemoryPropertyFlags flags = memory_properties_.memoryTypes[type].propertyFlags;
+        int32_t score = scores_[static_cast<uint32_t>(usage)][type];
+        if (score == excluded) {
+            continue;
+        }
+        scores[type] = score + preferred_weight * std::popcount(flags & preferred_properties);
+        candidates.types[candidates.count++] = static_cast<uint8_t>(type);
+    }
+    std::stable_sort(candidates.types, candidates.types + candidates.count, [&](uint8_t a, uint8_t b) {
+        if (scores[a] != scores[b]) {
+            return scores[a] > scores[b];
+        }
+        return usage != MemoryUsage::Unknown &&
+               memory_properties_.memoryHeaps[memory_properties_.memoryTypes[a].heapIndex].size >
+               memory_properties_.memoryHeaps[memory_properties_.memoryTypes[b].heapIndex].size;
+    });
+    return candidates;
+}
+
+uint32_t MemoryTypeResolver::ranking_index(VkMemoryPropertyFlags preferred_properties) const {
+    // Packs the preferred bits that are ranked on into consecutive bits.
+    uint32_t index = 0;
+    uint32_t bit = 0;
+    for (VkMemoryPropertyFlags rest = ranked_properties_; rest != 0; rest &= rest - 1, ++bit) {
+        if (preferred_properties & rest & (~rest + 1)) {
+            index |= 1u << bit;
+        }
+    }
+    return index;
+}
+
+MemoryTypeCandidates MemoryTypeResolver::candidates(uint32_t memory_type_bits,
+                                                    VkMemoryPropertyFlags required_properties,
+                                                    VkMemoryPropertyFlags preferred_properties,
+                                                    MemoryUsage usage) const {
+    MemoryTypeCandidates candidates;
+    if (rankings_.empty()) {
+        return candidates;
+    }
+    if (usage >= MemoryUsage::Count) {
+        usage = MemoryUsage::Unknown;
+    }
+    const MemoryTypeCandidates &ranked =
+            rankings_[static_cast<uint32_t>(usage) * rankings_per_usage_ + ranking_index(preferred_properties)];
+    for (uint32_t i = 0; i < ranked.count; ++i) {
+        uint32_t type = ranked.types[i];
+        VkMemoryPropertyFlags flags = memory_properties_.memoryTypes[type].propertyFlags;
+        if (!(memory_type_bits & (1u << type)) ||
+            (flags & required_properties) != required_properties ||
+            (flags & special_properties & ~(required_properties | preferred_properties))) {
+            continue;
+        }
+        candidates.types[candidates.count++] = static_cast<uint8_t>(type);
+    }
+    return candidates;
+}
+
+bool MemoryTypeResolver::resolve(uint32_t memory_type_bits,
+                                 VkMemoryPropertyFlags required_properties,
+                                 VkMemoryPropertyFlags preferred_properties,
+                                 MemoryUsage usage,
+                                 uint32_t &memory_type_index) const {
+    MemoryTypeCandidates ranked = candidates(memory_type_bits, required_properties, preferred_properties, usage);
+    if (ranked.count == 0) {
+        return false;
+    }
+    memory_type_index = ranked.types[0];
+    return true;
+}
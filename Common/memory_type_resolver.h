@@ -0,0 +1,84 @@
+//
+// Memory-type selection with preference scoring.
+//
+// init() ranks the memory types for every MemoryUsage and every set of
+// preferred properties the device's types can have, so a query for
+// (memoryTypeBits, required, preferred, usage) is an array index followed by
+// a filter over at most VK_MAX_MEMORY_TYPES entries. Filtering a stable
+// ranking keeps its order, so the result is the same as ranking only the
+// types that qualify. Queries take no lock and allocate nothing; init() must
+// not run concurrently with them.
+//
+// Only the lowest max_ranked_properties property bits the device reports
+// are ranked on. Real devices use far fewer; a preferred bit past those is
+// ignored, while required bits are always honoured.
+//
+// Ties are broken by heap size, except for MemoryUsage::Unknown, which keeps
+// the order the driver reports. Heap budgets are not part of the ranking;
+// callers walk the candidates best-first and skip heaps that are over
+// budget (see MemoryAllocator).
+//
+
+#ifndef COMMON_MEMORY_TYPE_RESOLVER_H
+#define COMMON_MEMORY_TYPE_RESOLVER_H
+
+#include "vulkan_dispatch.h"
+#include <vector>
+
+enum class MemoryUsage : uint32_t {
+    Unknown,    // no preference beyond the caller's flags; keeps the driver's type order
+    GpuOnly,    // never touched by the host: DEVICE_LOCAL, away from host-visible heaps
+    Upload,     // staging written once by the host: HOST_VISIBLE, preferably COHERENT
+    Dynamic,    // rewritten by the host and read by the GPU every frame: HOST_VISIBLE, preferably DEVICE_LOCAL
+    Readback,   // written by the GPU and read by the host: HOST_VISIBLE, preferably HOST_CACHED
+    Count
+};
+
+// Memory types ordered best-first.
+struct MemoryTypeCandidates {
+    uint32_t count{0};
+    uint8_t  types[VK_MAX_MEMORY_TYPES]{};
+};
+
+class MemoryTypeResolver {
+public:
+    static constexpr uint32_t max_ranked_properties = 10;
+
+    // Scores every memory type and sets each heap's budget to 80% of its
+    // size, the usual estimate when VK_EXT_memory_budget is not available.
+    void init(const VkPhysicalDeviceMemoryProperties &memory_properties);
+
+    void set_heap_budget(uint32_t heap_index, VkDeviceSize budget);
+    VkDeviceSize heap_budget(uint32_t heap_index) const;
+
+    MemoryTypeCandidates candidates(uint32_t memory_type_bits,
+                                    VkMemoryPropertyFlags required_properties,
+                                    VkMemoryPropertyFlags preferred_properties,
+                                    MemoryUsage usage) const;
+    // Best candidate only. Returns false if no memory type qualifies.
+    bool resolve(uint32_t memory_type_bits,
+                 VkMemoryPropertyFlags required_properties,
+                 VkMemoryPropertyFlags preferred_properties,
+                 MemoryUsage usage,
+                 uint32_t &memory_type_index) const;
+
+    const VkPhysicalDeviceMemoryProperties &memory_properties() const { return memory_properties_; }
+
+private:
+    // Every memory type the usage does not exclude, best-first for these
+    // preferred properties.
+    MemoryTypeCandidates rank(VkMemoryPropertyFlags preferred_properties, MemoryUsage usage) const;
+    // Index of the ranking for preferred_properties within one usage.
+    uint32_t ranking_index(VkMemoryPropertyFlags preferred_properties) const;
+
+    VkPhysicalDeviceMemoryProperties  memory_properties_{};
+    int32_t                           scores_[static_cast<uint32_t>(MemoryUsage::Count)][VK_MAX_MEMORY_TYPES]{};
+    VkDeviceSize                      heap_budgets_[VK_MAX_MEMORY_HEAPS]{};
+    // Property bits the rankings are indexed by, and one ranking per usage
+    // and subset of them.
+    VkMemoryPropertyFlags             ranked_properties_{0};
+    uint32_t                          rankings_per_usage_{1};
+    std::vector<MemoryTypeCandidates> rankings_;
+};
+
+#endif // COMMON_MEMORY_TYPE_RESOLVER_H
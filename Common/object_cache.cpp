@@ -0,0 +1,555 @@
+//
+// Deduplicating caches for samplers, shader modules, layouts, render passes
+// and pipelines.
+//
+
+#include "object_cache.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <tuple>
+
+namespace {
+
+class KeyWriter {
+public:
+    void add(uint64_t value) { key.push_back(value); }
+
+    void add_float(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        add(bits);
+    }
+
+    template <typename Handle>
+    void add_handle(Handle handle) {
+        // Non-dispatchable handles are pointers or uint64_t depending on the
+        // platform.
+        uint64_t bits = 0;
+        memcpy(&bits, &handle, sizeof(handle));
+        add(bits);
+    }
+
+    void add_bytes(const void *data, size_t size) {
+        add(size);
+        const auto *bytes = static_cast<const uint8_t *>(data);
+        for (size_t offset = 0; offset < size; offset += sizeof(uint64_t)) {
+            uint64_t word = 0;
+            memcpy(&word, bytes + offset, std::min(sizeof(word), size - offset));
+            add(word);
+        }
+    }
+
+    void add_string(const char *string) { add_bytes(string, string != nullptr ? strlen(string) : 0); }
+
+    void add_attachment_references(uint32_t count, const VkAttachmentReference *references) {
+        add(references != nullptr ? count : 0);
+        for (uint32_t i = 0; references != nullptr && i < count; ++i) {
+            add(references[i].attachment);
+            add(references[i].layout);
+        }
+    }
+
+    void add_stencil_op_state(const VkStencilOpState &state) {
+        add(state.failOp);
+        add(state.passOp);
+        add(state.depthFailOp);
+        add(state.compareOp);
+        add(state.compareMask);
+        add(state.writeMask);
+        add(state.reference);
+    }
+
+    ObjectKey key;
+};
+
+bool refuse(const char *what) {
+    std::cout << "Cannot cache " << what << " with a pNext chain." << std::endl;
+    return false;
+}
+
+bool sampler_key(const VkSamplerCreateInfo &create_info, ObjectKey &key) {
+    if (create_info.pNext != nullptr) {
+        return refuse("a sampler");
+    }
+    bool border = create_info.addressModeU == VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER ||
+                  create_info.addressModeV == VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER ||
+                  create_info.addressModeW == VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+
+    // Adding 0.0f turns -0.0f into 0.0f, which samples the same.
+    KeyWriter writer;
+    writer.add(create_info.flags);
+    writer.add(create_info.magFilter);
+    writer.add(create_info.minFilter);
+    writer.add(create_info.mipmapMode);
+    writer.add(create_info.addressModeU);
+    writer.add(create_info.addressModeV);
+    writer.add(create_info.addressModeW);
+    writer.add_float(create_info.mipLodBias + 0.0f);
+    writer.add(create_info.anisotropyEnable != VK_FALSE);
+    writer.add_float(create_info.anisotropyEnable != VK_FALSE ? create_info.maxAnisotropy : 1.0f);
+    writer.add(create_info.compareEnable != VK_FALSE);
+    writer.add(create_info.compareEnable != VK_FALSE ? create_info.compareOp : VK_COMPARE_OP_NEVER);
+    writer.add_float(create_info.minLod + 0.0f);
+    writer.add_float(create_info.maxLod + 0.0f);
+    writer.add(border ? create_info.borderColor : VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK);
+    writer.add(create_info.unnormalizedCoordinates != VK_FALSE);
+    key = std::move(writer.key);
+    return true;
+}
+
+bool shader_module_key(const VkShaderModuleCreateInfo &create_info, ObjectKey &key) {
+    if (create_info.pNext != nullptr) {
+        return refuse("a shader module");
+    }
+    KeyWriter writer;
+    writer.add(create_info.flags);
+    writer.add_bytes(create_info.pCode, create_info.codeSize);
+    key = std::move(writer.key);
+    return true;
+}
+
+bool descriptor_set_layout_key(const VkDescriptorSetLayoutCreateInfo &create_info, ObjectKey &key) {
+    const VkDescriptorBindingFlags *binding_flags = nullptr;
+    for (auto *next = static_cast<const VkBaseInStructure *>(create_info.pNext); next != nullptr; next = next->pNext) {
+        if (next->sType != VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO) {
+            return refuse("a descriptor set layout");
+        }
+        auto *flags_info = reinterpret_cast<const VkDescriptorSetLayoutBindingFlagsCreateInfo *>(next);
+        if (flags_info->bindingCount != 0) {
+            binding_flags = flags_info->pBindingFlags;
+        }
+    }
+
+    // Bindings can be listed in any order.
+    std::vector<uint32_t> order(create_info.bindingCount);
+    for (uint32_t i = 0; i < create_info.bindingCount; ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&create_info](uint32_t a, uint32_t b) {
+        return create_info.pBindings[a].binding < create_info.pBindings[b].binding;
+    });
+
+    KeyWriter writer;
+    writer.add(create_info.flags);
+    writer.add(create_info.bindingCount);
+    for (uint32_t index : order) {
+        const VkDescriptorSetLayoutBinding &binding = create_info.pBindings[index];
+        writer.add(binding.binding);
+        writer.add(binding.descriptorType);
+        writer.add(binding.descriptorCount);
+        writer.add(binding.stageFlags);
+        writer.add(binding_flags != nullptr ? binding_flags[index] : 0);
+        bool immutable_samplers = binding.pImmutableSamplers != nullptr &&
+                                  (binding.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER ||
+                                   binding.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+        writer.add(immutable_samplers);
+        for (uint32_t i = 0; immutable_samplers && i < binding.descriptorCount; ++i) {
+            writer.add_handle(binding.pImmutableSamplers[i]);
+        }
+    }
+    key = std::move(writer.key);
+    return true;
+}
+
+bool pipeline_layout_key(const VkPipelineLayoutCreateInfo &create_info, ObjectKey &key) {
+    if (create_info.pNext != nullptr) {
+        return refuse("a pipeline layout");
+    }
+    std::vector<VkPushConstantRange> ranges(create_info.pPushConstantRanges,
+                                            create_info.pPushConstantRanges + create_info.pushConstantRangeCount);
+    std::sort(ranges.begin(), ranges.end(), [](const VkPushConstantRange &a, const VkPushConstantRange &b) {
+        return std::tie(a.offset, a.size, a.stageFlags) < std::tie(b.offset, b.size, b.stageFlags);
+    });
+
+    KeyWriter writer;
+    writer.add(create_info.flags);
+    writer.add(create_info.setLayoutCount);
+    for (uint32_t i = 0; i < create_info.setLayoutCount; ++i) {
+        writer.add_handle(create_info.pSetLayouts[i]);
+    }
+    writer.add(ranges.size());
+    for (const auto &range : ranges) {
+        writer.add(range.stageFlags);
+        writer.add(range.offset);
+        writer.add(range.size);
+    }
+    key = std::move(writer.key);
+    return true;
+}
+
+bool render_pass_key(const VkRenderPassCreateInfo &create_info, ObjectKey &key) {
+    if (create_info.pNext != nullptr) {
+        return refuse("a render pass");
+    }
+    KeyWriter writer;
+    writer.add(create_info.flags);
+    writer.add(create_info.attachmentCount);
+    for (uint32_t i = 0; i < create_info.attachmentCount; ++i) {
+        const VkAttachmentDescription &attachment = create_info.pAttachments[i];
+        writer.add(attachment.flags);
+        writer.add(attachment.format);
+        writer.add(attachment.samples);
+        writer.add(attachment.loadOp);
+        writer.add(attachment.storeOp);
+        writer.add(attachment.stencilLoadOp);
+        writer.add(attachment.stencilStoreOp);
+        writer.add(attachment.initialLayout);
+        writer.add(attachment.finalLayout);
+    }
+    writer.add(create_info.subpassCount);
+    for (uint32_t i = 0; i < create_info.subpassCount; ++i) {
+        const VkSubpassDescription &subpass = create_info.pSubpasses[i];
+        writer.add(subpass.flags);
+        writer.add(subpass.pipelineBindPoint);
+        writer.add_attachment_references(subpass.inputAttachmentCount, subpass.pInputAttachments);
+        writer.add_attachment_references(subpass.colorAttachmentCount, subpass.pColorAttachments);
+        writer.add_attachment_references(subpass.colorAttachmentCount, subpass.pResolveAttachments);
+        writer.add_attachment_references(1, subpass.pDepthStencilAttachment);
+        writer.add(subpass.preserveAttachmentCount);
+        for (uint32_t j = 0; j < subpass.preserveAttachmentCount; ++j) {
+            writer.add(subpass.pPreserveAttachments[j]);
+        }
+    }
+    writer.add(create_info.dependencyCount);
+    for (uint32_t i = 0; i < create_info.dependencyCount; ++i) {
+        const VkSubpassDependency &dependency = create_info.pDependencies[i];
+        writer.add(dependency.srcSubpass);
+        writer.add(dependency.dstSubpass);
+        writer.add(dependency.srcStageMask);
+        writer.add(dependency.dstStageMask);
+        writer.add(dependency.srcAccessMask);
+        writer.add(dependency.dstAccessMask);
+        writer.add(dependency.dependencyFlags);
+    }
+    key = std::move(writer.key);
+    return true;
+}
+
+bool graphics_pipeline_key(const GraphicsPipelineDescription &description, ObjectKey &key) {
+    bool chained = description.input_assembly.pNext != nullptr || description.rasterization.pNext != nullptr ||
+                   description.multisample.pNext != nullptr || description.depth_stencil.pNext != nullptr ||
+                   description.color_blend.pNext != nullptr;
+    for (const auto &stage : description.stages) {
+        chained = chained || stage.pNext != nullptr;
+    }
+    if (chained) {
+        return refuse("a graphics pipeline");
+    }
+
+    KeyWriter writer;
+    writer.add(description.flags);
+    writer.add(description.stages.size());
+    for (const auto &stage : description.stages) {
+        writer.add(stage.flags);
+        writer.add(stage.stage);
+        writer.add_handle(stage.module);
+        writer.add_string(stage.pName);
+        const VkSpecializationInfo *specialization = stage.pSpecializationInfo;
+        writer.add(specialization != nullptr ? specialization->mapEntryCount : 0);
+        if (specialization != nullptr) {
+            for (uint32_t i = 0; i < specialization->mapEntryCount; ++i) {
+                writer.add(specialization->pMapEntries[i].constantID);
+                writer.add(specialization->pMapEntries[i].offset);
+                writer.add(specialization->pMapEntries[i].size);
+            }
+            writer.add_bytes(specialization->pData, specialization->dataSize);
+        }
+    }
+
+    writer.add(description.vertex_bindings.size());
+    for (const auto &binding : description.vertex_bindings) {
+        writer.add(binding.binding);
+        writer.add(binding.stride);
+        writer.add(binding.inputRate);
+    }
+    writer.add(description.vertex_attributes.size());
+    for (const auto &attribute : description.vertex_attributes) {
+        writer.add(attribute.location);
+        writer.add(attribute.binding);
+        writer.add(attribute.format);
+        writer.add(attribute.offset);
+    }
+
+    const auto &input_assembly = description.input_assembly;
+    writer.add(input_assembly.flags);
+    writer.add(input_assembly.topology);
+    writer.add(input_assembly.primitiveRestartEnable);
+
+    const auto &rasterization = description.rasterization;
+    writer.add(rasterization.flags);
+    writer.add(rasterization.depthClampEnable);
+    writer.add(rasterization.rasterizerDiscardEnable);
+    writer.add(rasterization.polygonMode);
+    writer.add(rasterization.cullMode);
+    writer.add(rasterization.frontFace);
+    writer.add(rasterization.depthBiasEnable);
+    writer.add_float(rasterization.depthBiasConstantFactor);
+    writer.add_float(rasterization.depthBiasClamp);
+    writer.add_float(rasterization.depthBiasSlopeFactor);
+    writer.add_float(rasterization.lineWidth);
+
+    const auto &multisample = description.multisample;
+    writer.add(multisample.flags);
+    writer.add(multisample.rasterizationSamples);
+    writer.add(multisample.sampleShadingEnable);
+    writer.add_float(multisample.minSampleShading);
+    uint32_t sample_mask_words =
+            multisample.pSampleMask != nullptr ? (uint32_t(multisample.rasterizationSamples) + 31) / 32 : 0;
+    writer.add(sample_mask_words);
+    for (uint32_t i = 0; i < sample_mask_words; ++i) {
+        writer.add(multisample.pSampleMask[i]);
+    }
+    writer.add(multisample.alphaToCoverageEnable);
+    writer.add(multisample.alphaToOneEnable);
+
+    const auto &depth_stencil = description.depth_stencil;
+    writer.add(depth_stencil.flags);
+    writer.add(depth_stencil.depthTestEnable);
+    writer.add(depth_stencil.depthWriteEnable);
+    writer.add(depth_stencil.depthCompareOp);
+    writer.add(depth_stencil.depthBoundsTestEnable);
+    writer.add(depth_stencil.stencilTestEnable);
+    writer.add_stencil_op_state(depth_stencil.front);
+    writer.add_stencil_op_state(depth_stencil.back);
+    writer.add_float(depth_stencil.minDepthBounds);
+    writer.add_float(depth_stencil.maxDepthBounds);
+
+    const auto &color_blend = description.color_blend;
+    writer.add(color_blend.flags);
+    writer.add(color_blend.logicOpEnable);
+    writer.add(color_blend.logicOp);
+    for (float constant : color_blend.blendConstants) {
+        writer.add_float(constant);
+    }
+    writer.add(description.blend_attachments.size());
+    for (const auto &attachment : description.blend_attachments) {
+        writer.add(attachment.blendEnable);
+        writer.add(attachment.srcColorBlendFactor);
+        writer.add(attachment.dstColorBlendFactor);
+        writer.add(attachment.colorBlendOp);
+        writer.add(attachment.srcAlphaBlendFactor);
+        writer.add(attachment.dstAlphaBlendFactor);
+        writer.add(attachment.alphaBlendOp);
+        writer.add(attachment.colorWriteMask);
+    }
+
+    writer.add(description.viewport_count);
+    writer.add(description.scissor_count);
+    writer.add(description.viewports.size());
+    for (const auto &viewport : description.viewports) {
+        writer.add_float(viewport.x);
+        writer.add_float(viewport.y);
+        writer.add_float(viewport.width);
+        writer.add_float(viewport.height);
+        writer.add_float(viewport.minDepth);
+        writer.add_float(viewport.maxDepth);
+    }
+    writer.add(description.scissors.size());
+    for (const auto &scissor : description.scissors) {
+        writer.add(uint32_t(scissor.offset.x));
+        writer.add(uint32_t(scissor.offset.y));
+        writer.add(scissor.extent.width);
+        writer.add(scissor.extent.height);
+    }
+    std::vector<VkDynamicState> dynamic_states = description.dynamic_states;
+    std::sort(dynamic_states.begin(), dynamic_states.end());
+    writer.add(dynamic_states.size());
+    for (auto state : dynamic_states) {
+        writer.add(state);
+    }
+
+    writer.add_handle(description.layout);
+    writer.add_handle(description.render_pass);
+    writer.add(description.subpass);
+    key = std::move(writer.key);
+    return true;
+}
+
+} // namespace
+
+size_t ObjectKeyHash::operator()(const ObjectKey &key) const {
+    // FNV-1a over whole words, then a final avalanche so that keys differing
+    // only in their last word still spread over the buckets.
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (uint64_t word : key) {
+        hash = (hash ^ word) * 0x100000001b3ull;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return static_cast<size_t>(hash);
+}
+
+ObjectCache::~ObjectCache() {
+    destroy();
+}
+
+void ObjectCache::init(const DeviceDispatch &dispatch) {
+    dispatch_ = &dispatch;
+    statistics_ = ObjectCacheStatistics{};
+}
+
+void ObjectCache::destroy() {
+    if (dispatch_ == nullptr) {
+        return;
+    }
+    // Pipelines first: they were built from the layouts and render passes.
+    for (auto &entry : pipelines_) {
+        destroy_object(entry.second);
+    }
+    for (auto &entry : shader_modules_) {
+        destroy_object(entry.second);
+    }
+    for (auto &entry : render_passes_) {
+        destroy_object(entry.second);
+    }
+    for (auto &entry : pipeline_layouts_) {
+        destroy_object(entry.second);
+    }
+    for (auto &entry : descriptor_set_layouts_) {
+        destroy_object(entry.second);
+    }
+    // Samplers last: set layouts may hold them as immutable samplers.
+    for (auto &entry : samplers_) {
+        destroy_object(entry.second);
+    }
+    pipelines_.clear();
+    shader_modules_.clear();
+    render_passes_.clear();
+    pipeline_layouts_.clear();
+    descriptor_set_layouts_.clear();
+    samplers_.clear();
+    dispatch_ = nullptr;
+}
+
+template <typename Handle, typename Create>
+VkResult ObjectCache::find_or_create(Map<Handle> &map, ObjectCacheCounters &counters, ObjectKey &&key,
+                                     Create create, Handle &handle) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = map.find(key);
+        if (found != map.end()) {
+            ++counters.hits;
+            handle = found->second;
+            return VK_SUCCESS;
+        }
+        ++counters.misses;
+    }
+
+    Handle created{VK_NULL_HANDLE};
+    VkResult result = create(created);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto inserted = map.emplace(std::move(key), created);
+    if (!inserted.second) {
+        // Another thread created the same object meanwhile; keep theirs.
+        destroy_object(created);
+    }
+    handle = inserted.first->second;
+    return VK_SUCCESS;
+}
+
+VkResult ObjectCache::get_sampler(const VkSamplerCreateInfo &create_info, VkSampler &sampler) {
+    ObjectKey key;
+    if (!sampler_key(create_info, key)) {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+    return find_or_create(samplers_, statistics_.samplers, std::move(key),
+                          [&](VkSampler &created) {
+                              return dispatch_->vkCreateSampler(dispatch_->device, &create_info, nullptr, &created);
+                          }, sampler);
+}
+
+VkResult ObjectCache::get_shader_module(const VkShaderModuleCreateInfo &create_info, VkShaderModule &module) {
+    ObjectKey key;
+    if (!shader_module_key(create_info, key)) {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+    return find_or_create(shader_modules_, statistics_.shader_modules, std::move(key),
+                          [&](VkShaderModule &created) {
+                              return dispatch_->vkCreateShaderModule(dispatch_->device, &create_info, nullptr,
+                                                                     &created);
+                          }, module);
+}
+
+VkResult ObjectCache::get_descriptor_set_layout(const VkDescriptorSetLayoutCreateInfo &create_info,
+                                                VkDescriptorSetLayout &layout) {
+    ObjectKey key;
+    if (!descriptor_set_layout_key(create_info, key)) {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+    return find_or_create(descriptor_set_layouts_, statistics_.descriptor_set_layouts, std::move(key),
+                          [&](VkDescriptorSetLayout &created) {
+                              return dispatch_->vkCreateDescriptorSetLayout(dispatch_->device, &create_info, nullptr,
+                                                                            &created);
+                          }, layout);
+}
+
+VkResult ObjectCache::get_pipeline_layout(const VkPipelineLayoutCreateInfo &create_info, VkPipelineLayout &layout) {
+    ObjectKey key;
+    if (!pipeline_layout_key(create_info, key)) {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+    return find_or_create(pipeline_layouts_, statistics_.pipeline_layouts, std::move(key),
+                          [&](VkPipelineLayout &created) {
+                              return dispatch_->vkCreatePipelineLayout(dispatch_->device, &create_info, nullptr,
+                                                                       &created);
+                          }, layout);
+}
+
+VkResult ObjectCache::get_render_pass(const VkRenderPassCreateInfo &create_info, VkRenderPass &render_pass) {
+    ObjectKey key;
+    if (!render_pass_key(create_info, key)) {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+    return find_or_create(render_passes_, statistics_.render_passes, std::move(key),
+                          [&](VkRenderPass &created) {
+                              return dispatch_->vkCreateRenderPass(dispatch_->device, &create_info, nullptr,
+                                                                   &created);
+                          }, render_pass);
+}
+
+VkResult ObjectCache::get_graphics_pipeline(VkPipelineCache cache, const GraphicsPipelineDescription &description,
+                                            VkPipeline &pipeline) {
+    ObjectKey key;
+    if (!graphics_pipeline_key(description, key)) {
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+    return find_or_create(pipelines_, statistics_.pipelines, std::move(key),
+                          [&](VkPipeline &created) {
+                              return create_graphics_pipeline(*dispatch_, cache, description, created);
+                          }, pipeline);
+}
+
+ObjectCacheStatistics ObjectCache::statistics() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return statistics_;
+}
+
+void ObjectCache::destroy_object(VkSampler sampler) {
+    dispatch_->vkDestroySampler(dispatch_->device, sampler, nullptr);
+}
+
+void ObjectCache::destroy_object(VkShaderModule module) {
+    dispatch_->vkDestroyShaderModule(dispatch_->device, module, nullptr);
+}
+
+void ObjectCache::destroy_object(VkDescriptorSetLayout layout) {
+    dispatch_->vkDestroyDescriptorSetLayout(dispatch_->device, layout, nullptr);
+}
+
+void ObjectCache::destroy_object(VkPipelineLayout layout) {
+    dispatch_->vkDestroyPipelineLayout(dispatch_->device, layout, nullptr);
+}
+
+void ObjectCache::destroy_object(VkRenderPass render_pass) {
+    dispatch_->vkDestroyRenderPass(dispatch_->device, render_pass, nullptr);
+}
+
+void ObjectCache::destroy_object(VkPipeline pipeline) {
+    dispatch_->vkDestroyPipeline(dispatch_->device, pipeline, nullptr);
+}
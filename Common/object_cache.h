@@ -0,0 +1,117 @@
+//
+// Deduplicating caches for samplers, shader modules, descriptor set layouts,
+// pipeline layouts, render passes and graphics pipelines.
+//
+// Every get_*() call turns its create info into a canonical key: the values
+// of every field and of everything the create info points to, handles by
+// value, with order-insensitive arrays (descriptor bindings, push constant
+// ranges, dynamic states) sorted. Two create infos that describe the same
+// object give the same key however they were laid out in memory, so the
+// second request returns the first object from a hash table lookup instead
+// of creating a duplicate. Keys are compared in full on lookup; a hash
+// collision can never return the wrong object.
+//
+// Sampler keys also drop the fields Vulkan ignores: maxAnisotropy without
+// anisotropyEnable, compareOp without compareEnable, and borderColor unless
+// an address mode is CLAMP_TO_BORDER. Every texture that asks for the same
+// filtering shares one VkSampler, which keeps sampler counts well under
+// maxSamplerAllocationCount.
+//
+// Because the keys hold handles, caching the inputs as well pays off
+// transitively: pipeline layouts built from cached set layouts, and pipelines
+// built from cached layouts and render passes, hit too.
+//
+// The same keys make a handle that is destroyed and then reused by the
+// driver for a different object look like the old one. Everything a
+// pipeline key names must therefore live as long as the cache: take shader
+// modules from get_shader_module(), whose keys are the SPIR-V words, rather
+// than creating and destroying them around each pipeline build. Modules
+// created elsewhere must outlive the cache.
+//
+// Create infos with a pNext chain the cache cannot hash (anything except
+// VkDescriptorSetLayoutBindingFlagsCreateInfo on set layouts) are refused
+// with VK_ERROR_FEATURE_NOT_PRESENT. Build those objects directly instead.
+//
+// The cache owns every object it returns. Callers must not destroy them;
+// destroy() does, once the device is idle. All functions are thread-safe.
+// Creation runs outside the lock, so pipeline compiles on different threads
+// do not serialize. If two threads miss on the same key at once, both
+// create the object, and the one that loses the race destroys its copy.
+//
+
+#ifndef COMMON_OBJECT_CACHE_H
+#define COMMON_OBJECT_CACHE_H
+
+#include "pipeline_builder.h"
+#include <mutex>
+#include <unordered_map>
+
+using ObjectKey = std::vector<uint64_t>;
+
+struct ObjectKeyHash {
+    size_t operator()(const ObjectKey &key) const;
+};
+
+struct ObjectCacheCounters {
+    uint64_t hits{0};
+    uint64_t misses{0};
+};
+
+struct ObjectCacheStatistics {
+    ObjectCacheCounters samplers;
+    ObjectCacheCounters shader_modules;
+    ObjectCacheCounters descriptor_set_layouts;
+    ObjectCacheCounters pipeline_layouts;
+    ObjectCacheCounters render_passes;
+    ObjectCacheCounters pipelines;
+};
+
+class ObjectCache {
+public:
+    ObjectCache() = default;
+    ~ObjectCache();
+    ObjectCache(const ObjectCache &) = delete;
+    ObjectCache &operator=(const ObjectCache &) = delete;
+
+    void init(const DeviceDispatch &dispatch);
+    // Destroys every cached object; nothing may still use them.
+    void destroy();
+
+    VkResult get_sampler(const VkSamplerCreateInfo &create_info, VkSampler &sampler);
+    VkResult get_shader_module(const VkShaderModuleCreateInfo &create_info, VkShaderModule &module);
+    VkResult get_descriptor_set_layout(const VkDescriptorSetLayoutCreateInfo &create_info,
+                                       VkDescriptorSetLayout &layout);
+    VkResult get_pipeline_layout(const VkPipelineLayoutCreateInfo &create_info, VkPipelineLayout &layout);
+    VkResult get_render_pass(const VkRenderPassCreateInfo &create_info, VkRenderPass &render_pass);
+    // cache is only used to compile on a miss and is not part of the key.
+    VkResult get_graphics_pipeline(VkPipelineCache cache, const GraphicsPipelineDescription &description,
+                                   VkPipeline &pipeline);
+
+    ObjectCacheStatistics statistics();
+
+private:
+    template <typename Handle>
+    using Map = std::unordered_map<ObjectKey, Handle, ObjectKeyHash>;
+
+    template <typename Handle, typename Create>
+    VkResult find_or_create(Map<Handle> &map, ObjectCacheCounters &counters, ObjectKey &&key, Create create,
+                            Handle &handle);
+    void destroy_object(VkSampler sampler);
+    void destroy_object(VkShaderModule module);
+    void destroy_object(VkDescriptorSetLayout layout);
+    void destroy_object(VkPipelineLayout layout);
+    void destroy_object(VkRenderPass render_pass);
+    void destroy_object(VkPipeline pipeline);
+
+    const DeviceDispatch        *dispatch_{nullptr};
+    std::mutex                   mutex_;
+    Map<VkSampler>               samplers_;
+    Map<VkShaderModule>          shader_modules_;
+    Map<VkDescriptorSetLayout>   descriptor_set_layouts_;
+    Map<VkPipelineLayout>        pipeline_layouts_;
+    Map<VkRenderPass>            render_passes_;
+    Map<VkPipeline>              pipelines_;
+    ObjectCacheStatistics        statistics_;
+};
+
+#endif // COMMON_OBJECT_CACHE_H
@@ -0,0 +1,81 @@
+//
+// Virtual swapchain for rendering without a window system.
+//
+
+#include "offscreen_swapchain.h"
+#include <iostream>
+
+OffscreenSwapchain::~OffscreenSwapchain() {
+    destroy();
+}
+
+bool OffscreenSwapchain::init(const DeviceDispatch &dispatch, MemoryAllocator &allocator, VkFormat format,
+                              VkExtent2D extent, uint32_t image_count, VkImageUsageFlags usage) {
+    if (image_count == 0 || extent.width == 0 || extent.height == 0) {
+        std::cout << "An offscreen swapchain needs at least one non-empty image." << std::endl;
+        return false;
+    }
+    dispatch_ = &dispatch;
+    allocator_ = &allocator;
+    format_ = format;
+    extent_ = extent;
+    usage_ = usage | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    next_ = 0;
+    images_.assign(image_count, VK_NULL_HANDLE);
+    allocations_.assign(image_count, MemoryAllocation{});
+
+    VkImageCreateInfo image_create_info = {
+            VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            nullptr,
+            0,
+            VK_IMAGE_TYPE_2D,
+            format,
+            {extent.width, extent.height, 1},
+            1,
+            1,
+            VK_SAMPLE_COUNT_1_BIT,
+            VK_IMAGE_TILING_OPTIMAL,
+            usage_,
+            VK_SHARING_MODE_EXCLUSIVE,
+            0,
+            nullptr,
+            VK_IMAGE_LAYOUT_UNDEFINED
+    };
+    for (uint32_t i = 0; i < image_count; ++i) {
+        if (dispatch.vkCreateImage(dispatch.device, &image_create_info, nullptr, &images_[i]) != VK_SUCCESS) {
+            std::cout << "Could not create an offscreen swapchain image." << std::endl;
+            images_[i] = VK_NULL_HANDLE;
+            destroy();
+            return false;
+        }
+        if (allocator.allocate_for_image(images_[i], VK_IMAGE_TILING_OPTIMAL, MemoryUsage::GpuOnly,
+                                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocations_[i]) != VK_SUCCESS) {
+            std::cout << "Could not allocate memory for an offscreen swapchain image." << std::endl;
+            destroy();
+            return false;
+        }
+    }
+    return true;
+}
+
+void OffscreenSwapchain::destroy() {
+    if (dispatch_ == nullptr) {
+        return;
+    }
+    for (size_t i = 0; i < images_.size(); ++i) {
+        if (images_[i] != VK_NULL_HANDLE) {
+            dispatch_->vkDestroyImage(dispatch_->device, images_[i], nullptr);
+        }
+        allocator_->free(allocations_[i]);
+    }
+    images_.clear();
+    allocations_.clear();
+    dispatch_ = nullptr;
+    allocator_ = nullptr;
+}
+
+uint32_t OffscreenSwapchain::acquire() {
+    uint32_t index = next_;
+    next_ = (next_ + 1) % static_cast<uint32_t>(images_.size());
+    return index;
+}
@@ -0,0 +1,55 @@
+//
+// Virtual swapchain for rendering without a window system.
+//
+// A ring of optimal-tiling device-local images stands in for the images of a
+// VkSwapchainKHR. acquire() hands them out round-robin and never blocks:
+// paired with FrameScheduler::begin_frame(OffscreenSwapchain &, ...) and at
+// least as many images as frames in flight, an image is only handed out again
+// once the frame slot that last rendered into it has been waited on.
+//
+// Nothing is presented. Images start out in VK_IMAGE_LAYOUT_UNDEFINED; frames
+// should leave them in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL (final_layout) in
+// place of PRESENT_SRC_KHR, so the result can be copied out for inspection.
+//
+
+#ifndef COMMON_OFFSCREEN_SWAPCHAIN_H
+#define COMMON_OFFSCREEN_SWAPCHAIN_H
+
+#include "memory_allocator.h"
+
+class OffscreenSwapchain {
+public:
+    static constexpr VkImageLayout final_layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+    OffscreenSwapchain() = default;
+    ~OffscreenSwapchain();
+    OffscreenSwapchain(const OffscreenSwapchain &) = delete;
+    OffscreenSwapchain &operator=(const OffscreenSwapchain &) = delete;
+
+    // TRANSFER_SRC is always added to usage.
+    bool init(const DeviceDispatch &dispatch, MemoryAllocator &allocator, VkFormat format, VkExtent2D extent,
+              uint32_t image_count, VkImageUsageFlags usage);
+    // The images must no longer be in use by the device.
+    void destroy();
+
+    // Index of the image to render the next frame into.
+    uint32_t acquire();
+
+    VkFormat format() const { return format_; }
+    VkExtent2D extent() const { return extent_; }
+    VkImageUsageFlags usage() const { return usage_; }
+    uint32_t image_count() const { return static_cast<uint32_t>(images_.size()); }
+    const std::vector<VkImage> &images() const { return images_; }
+
+private:
+    const DeviceDispatch          *dispatch_{nullptr};
+    MemoryAllocator               *allocator_{nullptr};
+    std::vector<VkImage>           images_;
+    std::vector<MemoryAllocation>  allocations_;
+    VkFormat                       format_{VK_FORMAT_UNDEFINED};
+    VkExtent2D                     extent_{0, 0};
+    VkImageUsageFlags              usage_{0};
+    uint32_t                       next_{0};
+};
+
+#endif // COMMON_OFFSCREEN_SWAPCHAIN_H
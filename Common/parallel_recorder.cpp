@@ -0,0 +1,197 @@
+//
+// Parallel command recording into secondary command buffers.
+//
+
+#include "parallel_recorder.h"
+#include <algorithm>
+#include <iostream>
+
+ParallelRecorder::~ParallelRecorder() {
+    destroy();
+}
+
+bool ParallelRecorder::init(const DeviceDispatch &dispatch, uint32_t queue_family_index, uint32_t frame_count,
+                            uint32_t thread_count) {
+    dispatch_ = &dispatch;
+    frame_count_ = std::max(frame_count, 1u);
+    frame_ = 0;
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // Secondaries are re-recorded every frame, hence transient pools.
+    VkCommandPoolCreateInfo command_pool_create_info = {
+            VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            nullptr,
+            VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+            queue_family_index
+    };
+    pools_.assign(thread_count, std::vector<FramePool>(frame_count_));
+    for (auto &worker_pools : pools_) {
+        for (auto &frame_pool : worker_pools) {
+            if (dispatch.vkCreateCommandPool(dispatch.device, &command_pool_create_info, nullptr,
+                                             &frame_pool.pool) != VK_SUCCESS) {
+                std::cout << "Could not create a command pool." << std::endl;
+                destroy();
+                return false;
+            }
+        }
+    }
+    stop_ = false;
+    generation_ = 0;
+    statistics_ = ParallelRecorderStatistics{};
+    for (uint32_t i = 0; i < thread_count; ++i) {
+        workers_.emplace_back(&ParallelRecorder::worker_main, this, i);
+    }
+    return true;
+}
+
+void ParallelRecorder::destroy() {
+    if (dispatch_ == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_ready_.notify_all();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+    // Destroying a pool frees its command buffers.
+    for (auto &worker_pools : pools_) {
+        for (auto &frame_pool : worker_pools) {
+            if (frame_pool.pool != VK_NULL_HANDLE) {
+                dispatch_->vkDestroyCommandPool(dispatch_->device, frame_pool.pool, nullptr);
+            }
+        }
+    }
+    pools_.clear();
+    dispatch_ = nullptr;
+}
+
+VkResult ParallelRecorder::begin_frame(uint32_t frame_index) {
+    frame_ = frame_index % frame_count_;
+    // The workers are idle between record() calls, so their pools can be
+    // touched from here.
+    for (auto &worker_pools : pools_) {
+        FramePool &frame_pool = worker_pools[frame_];
+        VkResult result = dispatch_->vkResetCommandPool(dispatch_->device, frame_pool.pool, 0);
+        if (result != VK_SUCCESS) {
+            std::cout << "Could not reset a command pool." << std::endl;
+            return result;
+        }
+        frame_pool.used = 0;
+    }
+    return VK_SUCCESS;
+}
+
+VkResult ParallelRecorder::record(VkCommandBuffer primary, const VkCommandBufferInheritanceInfo &inheritance,
+                                  uint32_t item_count, const RecordChunkFunction &record_chunk, uint32_t chunk_count) {
+    if (item_count == 0) {
+        return VK_SUCCESS;
+    }
+    if (chunk_count == 0) {
+        chunk_count = thread_count();
+    }
+    chunk_count = std::min(chunk_count, item_count);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    inheritance_ = &inheritance;
+    record_chunk_ = &record_chunk;
+    item_count_ = item_count;
+    chunk_count_ = chunk_count;
+    next_chunk_ = 0;
+    chunk_buffers_.assign(chunk_count, VK_NULL_HANDLE);
+    result_ = VK_SUCCESS;
+    running_ = thread_count();
+    ++generation_;
+    work_ready_.notify_all();
+    work_done_.wait(lock, [this] { return running_ == 0; });
+    inheritance_ = nullptr;
+    record_chunk_ = nullptr;
+    if (result_ != VK_SUCCESS) {
+        return result_;
+    }
+    statistics_.secondaries_recorded += chunk_count;
+    lock.unlock();
+
+    dispatch_->vkCmdExecuteCommands(primary, chunk_count, chunk_buffers_.data());
+    return VK_SUCCESS;
+}
+
+ParallelRecorderStatistics ParallelRecorder::statistics() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return statistics_;
+}
+
+void ParallelRecorder::worker_main(uint32_t worker_index) {
+    uint64_t seen_generation = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        work_ready_.wait(lock, [&] { return stop_ || generation_ != seen_generation; });
+        if (stop_) {
+            return;
+        }
+        seen_generation = generation_;
+        FramePool &frame_pool = pools_[worker_index][frame_];
+        while (next_chunk_ < chunk_count_) {
+            uint32_t chunk = next_chunk_++;
+            size_t allocated = frame_pool.secondaries.size();
+            lock.unlock();
+            VkResult result = record_chunk(frame_pool, chunk);
+            lock.lock();
+            statistics_.secondaries_allocated += frame_pool.secondaries.size() - allocated;
+            if (result != VK_SUCCESS && result_ == VK_SUCCESS) {
+                result_ = result;
+            }
+        }
+        if (--running_ == 0) {
+            work_done_.notify_one();
+        }
+    }
+}
+
+VkResult ParallelRecorder::record_chunk(FramePool &frame_pool, uint32_t chunk) {
+    if (frame_pool.used == frame_pool.secondaries.size()) {
+        VkCommandBufferAllocateInfo command_buffer_allocate_info = {
+                VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                nullptr,
+                frame_pool.pool,
+                VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+                1
+        };
+        VkCommandBuffer secondary{VK_NULL_HANDLE};
+        VkResult result = dispatch_->vkAllocateCommandBuffers(dispatch_->device, &command_buffer_allocate_info,
+                                                              &secondary);
+        if (result != VK_SUCCESS) {
+            std::cout << "Could not allocate a secondary command buffer." << std::endl;
+            return result;
+        }
+        frame_pool.secondaries.push_back(secondary);
+    }
+    VkCommandBuffer secondary = frame_pool.secondaries[frame_pool.used++];
+
+    VkCommandBufferBeginInfo command_buffer_begin_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            nullptr,
+            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+            inheritance_
+    };
+    VkResult result = dispatch_->vkBeginCommandBuffer(secondary, &command_buffer_begin_info);
+    if (result != VK_SUCCESS) {
+        std::cout << "Could not begin a secondary command buffer." << std::endl;
+        return result;
+    }
+    // Chunk sizes differ by at most one item.
+    uint32_t first = static_cast<uint32_t>(uint64_t(item_count_) * chunk / chunk_count_);
+    uint32_t end = static_cast<uint32_t>(uint64_t(item_count_) * (chunk + 1) / chunk_count_);
+    (*record_chunk_)(secondary, first, end - first);
+    result = dispatch_->vkEndCommandBuffer(secondary);
+    if (result != VK_SUCCESS) {
+        std::cout << "Could not end a secondary command buffer." << std::endl;
+        return result;
+    }
+    chunk_buffers_[chunk] = secondary;
+    return VK_SUCCESS;
+}
@@ -0,0 +1,105 @@
+//
+// Parallel command recording into secondary command buffers.
+//
+// record() splits item_count items (draws, objects, anything the callback
+// understands) into chunks. Worker threads take chunks in turn and record
+// each into a secondary command buffer that continues the caller's render
+// pass. Once every chunk is done, the secondaries are stitched into the
+// primary with a single vkCmdExecuteCommands, in chunk order, so the result
+// does not depend on which thread recorded what.
+//
+// Command pools need external synchronization, so each worker owns one pool
+// per frame in flight and is the only thread that records from it.
+// begin_frame() resets the frame's pools with vkResetCommandPool, which
+// recycles all of their secondaries at once. As with FrameRingBuffer, the
+// caller must have waited for the GPU work that last used that frame.
+//
+// The callback runs on the workers concurrently and must be thread-safe for
+// disjoint item ranges. Secondaries inherit the render pass but no dynamic
+// or bound state, so the callback binds its pipeline and sets its viewport
+// in every chunk. The primary's render pass must have been begun with
+// VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+//
+// record() and begin_frame() are called from one thread.
+//
+
+#ifndef COMMON_PARALLEL_RECORDER_H
+#define COMMON_PARALLEL_RECORDER_H
+
+#include "device_dispatch.h"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Records items [first, first + count) into command_buffer.
+using RecordChunkFunction = std::function<void(VkCommandBuffer command_buffer, uint32_t first, uint32_t count)>;
+
+struct ParallelRecorderStatistics {
+    uint64_t secondaries_recorded{0};
+    uint64_t secondaries_allocated{0};    // total over every pool
+};
+
+class ParallelRecorder {
+public:
+    ParallelRecorder() = default;
+    ~ParallelRecorder();
+    ParallelRecorder(const ParallelRecorder &) = delete;
+    ParallelRecorder &operator=(const ParallelRecorder &) = delete;
+
+    // Starts thread_count workers, or one per hardware thread if 0, each with
+    // frame_count command pools on queue_family_index.
+    bool init(const DeviceDispatch &dispatch, uint32_t queue_family_index, uint32_t frame_count,
+              uint32_t thread_count = 0);
+    // Stops the workers and destroys the pools; nothing may still execute
+    // their command buffers.
+    void destroy();
+
+    // Switches to the pools of frame_index % frame_count and resets them.
+    VkResult begin_frame(uint32_t frame_index);
+
+    // Records item_count items in chunk_count chunks (thread_count if 0) and
+    // executes them in primary. inheritance names the render pass, subpass
+    // and framebuffer the primary is in.
+    VkResult record(VkCommandBuffer primary, const VkCommandBufferInheritanceInfo &inheritance, uint32_t item_count,
+                    const RecordChunkFunction &record_chunk, uint32_t chunk_count = 0);
+
+    uint32_t thread_count() const { return static_cast<uint32_t>(workers_.size()); }
+    ParallelRecorderStatistics statistics();
+
+private:
+    // One worker's command pool for one frame.
+    struct FramePool {
+        VkCommandPool                pool{VK_NULL_HANDLE};
+        std::vector<VkCommandBuffer> secondaries;
+        uint32_t                     used{0};
+    };
+
+    void worker_main(uint32_t worker_index);
+    VkResult record_chunk(FramePool &frame_pool, uint32_t chunk);
+
+    const DeviceDispatch                *dispatch_{nullptr};
+    uint32_t                             frame_count_{0};
+    uint32_t                             frame_{0};
+    std::vector<std::vector<FramePool>>  pools_;          // [worker][frame]
+    std::vector<std::thread>             workers_;
+
+    std::mutex                           mutex_;
+    std::condition_variable              work_ready_;
+    std::condition_variable              work_done_;
+    uint64_t                             generation_{0};  // bumped by each record()
+    uint32_t                             running_{0};     // workers still on this generation
+    bool                                 stop_{false};
+
+    // The current record() call; written before generation_ is bumped.
+    const VkCommandBufferInheritanceInfo *inheritance_{nullptr};
+    const RecordChunkFunction            *record_chunk_{nullptr};
+    uint32_t                             item_count_{0};
+    uint32_t                             chunk_count_{0};
+    uint32_t                             next_chunk_{0};    // under mutex_
+    std::vector<VkCommandBuffer>         chunk_buffers_;
+    VkResult                             result_{VK_SUCCESS};
+    ParallelRecorderStatistics           statistics_;
+};
+
+#endif // COMMON_PARALLEL_RECORDER_H
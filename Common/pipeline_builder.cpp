@@ -0,0 +1,168 @@
+//
+// Graphics pipeline compilation on a pool of worker threads.
+//
+
+#include "pipeline_builder.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+double to_ms(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+} // namespace
+
+VkResult create_graphics_pipeline(const DeviceDispatch &dispatch, VkPipelineCache cache,
+                                  const GraphicsPipelineDescription &description, VkPipeline &pipeline) {
+    VkPipelineVertexInputStateCreateInfo vertex_input = {
+            VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+            nullptr,
+            0,
+            static_cast<uint32_t>(description.vertex_bindings.size()),
+            description.vertex_bindings.data(),
+            static_cast<uint32_t>(description.vertex_attributes.size()),
+            description.vertex_attributes.data()
+    };
+    VkPipelineViewportStateCreateInfo viewport = {
+            VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+            nullptr,
+            0,
+            description.viewport_count,
+            description.viewports.empty() ? nullptr : description.viewports.data(),
+            description.scissor_count,
+            description.scissors.empty() ? nullptr : description.scissors.data()
+    };
+    VkPipelineDynamicStateCreateInfo dynamic = {
+            VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+            nullptr,
+            0,
+            static_cast<uint32_t>(description.dynamic_states.size()),
+            description.dynamic_states.data()
+    };
+    VkPipelineColorBlendStateCreateInfo color_blend = description.color_blend;
+    color_blend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    color_blend.attachmentCount = static_cast<uint32_t>(description.blend_attachments.size());
+    color_blend.pAttachments = description.blend_attachments.data();
+
+    VkGraphicsPipelineCreateInfo pipeline_create_info = {
+            VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+            nullptr,
+            description.flags,
+            static_cast<uint32_t>(description.stages.size()),
+            description.stages.data(),
+            &vertex_input,
+            &description.input_assembly,
+            nullptr,
+            &viewport,
+            &description.rasterization,
+            &description.multisample,
+            &description.depth_stencil,
+            &color_blend,
+            description.dynamic_states.empty() ? nullptr : &dynamic,
+            description.layout,
+            description.render_pass,
+            description.subpass,
+            VK_NULL_HANDLE,
+            -1
+    };
+    return dispatch.vkCreateGraphicsPipelines(dispatch.device, cache, 1, &pipeline_create_info, nullptr, &pipeline);
+}
+
+PipelineBuildService::~PipelineBuildService() {
+    destroy();
+}
+
+bool PipelineBuildService::init(const DeviceDispatch &dispatch, VkPipelineCache cache, uint32_t thread_count) {
+    dispatch_ = &dispatch;
+    cache_ = cache;
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    stop_ = false;
+    busy_ = 0;
+    statistics_ = PipelineBuildStatistics{};
+    for (uint32_t i = 0; i < thread_count; ++i) {
+        workers_.emplace_back(&PipelineBuildService::worker_main, this);
+    }
+    return true;
+}
+
+void PipelineBuildService::destroy() {
+    if (workers_.empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_ready_.notify_all();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+    dispatch_ = nullptr;
+    cache_ = VK_NULL_HANDLE;
+}
+
+std::future<PipelineBuildResult> PipelineBuildService::submit(GraphicsPipelineDescription description) {
+    Job job{std::move(description), {}, Clock::now()};
+    auto future = job.promise.get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(std::move(job));
+    }
+    work_ready_.notify_one();
+    return future;
+}
+
+void PipelineBuildService::wait_idle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return jobs_.empty() && busy_ == 0; });
+}
+
+PipelineBuildStatistics PipelineBuildService::statistics() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return statistics_;
+}
+
+void PipelineBuildService::worker_main() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        work_ready_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+        if (jobs_.empty()) {
+            return;
+        }
+        Job job = std::move(jobs_.front());
+        jobs_.pop_front();
+        ++busy_;
+        lock.unlock();
+
+        PipelineBuildResult result;
+        auto start = Clock::now();
+        result.queue_ms = to_ms(start - job.submitted);
+        result.result = create_graphics_pipeline(*dispatch_, cache_, job.description, result.pipeline);
+        result.compile_ms = to_ms(Clock::now() - start);
+        if (result.result != VK_SUCCESS) {
+            std::cout << "Could not create a graphics pipeline." << std::endl;
+            result.pipeline = VK_NULL_HANDLE;
+        }
+
+        lock.lock();
+        if (result.result == VK_SUCCESS) {
+            ++statistics_.pipelines_built;
+        } else {
+            ++statistics_.failures;
+        }
+        statistics_.compile_ms += result.compile_ms;
+        statistics_.max_compile_ms = std::max(statistics_.max_compile_ms, result.compile_ms);
+        --busy_;
+        // Fulfilled under the lock so wait_idle() never returns before the
+        // future is ready.
+        job.promise.set_value(result);
+        if (jobs_.empty() && busy_ == 0) {
+            idle_.notify_all();
+        }
+    }
+}
@@ -0,0 +1,117 @@
+//
+// Graphics pipeline compilation on a pool of worker threads.
+//
+// A GraphicsPipelineDescription holds by value the state that
+// VkGraphicsPipelineCreateInfo points to, so it can be queued and built on
+// another thread after the code that filled it in has returned. Only the
+// pNext chains, the shader stages' pSpecializationInfo and pName, and the
+// handles it names are referenced, and those must stay valid until the
+// pipeline is built.
+//
+// PipelineBuildService::submit() queues a description and returns a future
+// for the pipeline. thread_count workers take descriptions off the queue and
+// call vkCreateGraphicsPipelines concurrently on one shared VkPipelineCache;
+// pipeline caches are internally synchronized, so the workers need no lock
+// around it, and every pipeline one worker compiles is a cache hit for the
+// others. Each result carries the time the description waited in the queue
+// and the time vkCreateGraphicsPipelines took, so slow permutations can be
+// found.
+//
+// The pipelines belong to the caller, who destroys them with
+// vkDestroyPipeline.
+//
+
+#ifndef COMMON_PIPELINE_BUILDER_H
+#define COMMON_PIPELINE_BUILDER_H
+
+#include "device_dispatch.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <thread>
+
+struct GraphicsPipelineDescription {
+    std::vector<VkPipelineShaderStageCreateInfo>     stages;
+    std::vector<VkVertexInputBindingDescription>     vertex_bindings;
+    std::vector<VkVertexInputAttributeDescription>   vertex_attributes;
+    VkPipelineInputAssemblyStateCreateInfo           input_assembly{};
+    VkPipelineRasterizationStateCreateInfo           rasterization{};
+    VkPipelineMultisampleStateCreateInfo             multisample{};
+    VkPipelineDepthStencilStateCreateInfo            depth_stencil{};
+    VkPipelineColorBlendStateCreateInfo              color_blend{};    // pAttachments comes from blend_attachments
+    std::vector<VkPipelineColorBlendAttachmentState> blend_attachments;
+    uint32_t                                         viewport_count{1};
+    uint32_t                                         scissor_count{1};
+    std::vector<VkViewport>                          viewports;        // empty if the viewport is dynamic
+    std::vector<VkRect2D>                            scissors;         // empty if the scissor is dynamic
+    std::vector<VkDynamicState>                      dynamic_states;
+    VkPipelineCreateFlags                            flags{0};
+    VkPipelineLayout                                 layout{VK_NULL_HANDLE};
+    VkRenderPass                                     render_pass{VK_NULL_HANDLE};
+    uint32_t                                         subpass{0};
+};
+
+// Builds one pipeline from description on the calling thread.
+VkResult create_graphics_pipeline(const DeviceDispatch &dispatch, VkPipelineCache cache,
+                                  const GraphicsPipelineDescription &description, VkPipeline &pipeline);
+
+struct PipelineBuildResult {
+    VkResult   result{VK_NOT_READY};
+    VkPipeline pipeline{VK_NULL_HANDLE};
+    double     queue_ms{0.0};      // from submit() until a worker took it
+    double     compile_ms{0.0};    // inside vkCreateGraphicsPipelines
+};
+
+struct PipelineBuildStatistics {
+    uint64_t pipelines_built{0};
+    uint32_t failures{0};
+    double   compile_ms{0.0};        // summed over all workers
+    double   max_compile_ms{0.0};
+};
+
+class PipelineBuildService {
+public:
+    PipelineBuildService() = default;
+    ~PipelineBuildService();
+    PipelineBuildService(const PipelineBuildService &) = delete;
+    PipelineBuildService &operator=(const PipelineBuildService &) = delete;
+
+    // Starts thread_count workers, or one per hardware thread if 0. cache may
+    // be VK_NULL_HANDLE and must outlive the service.
+    bool init(const DeviceDispatch &dispatch, VkPipelineCache cache, uint32_t thread_count = 0);
+    // Builds everything still queued and stops the workers.
+    void destroy();
+
+    std::future<PipelineBuildResult> submit(GraphicsPipelineDescription description);
+    // Waits until the queue is empty and no worker is building.
+    void wait_idle();
+
+    uint32_t thread_count() const { return static_cast<uint32_t>(workers_.size()); }
+    PipelineBuildStatistics statistics();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Job {
+        GraphicsPipelineDescription        description;
+        std::promise<PipelineBuildResult>  promise;
+        Clock::time_point                  submitted;
+    };
+
+    void worker_main();
+
+    const DeviceDispatch     *dispatch_{nullptr};
+    VkPipelineCache           cache_{VK_NULL_HANDLE};
+    std::vector<std::thread>  workers_;
+
+    std::mutex                mutex_;
+    std::condition_variable   work_ready_;
+    std::condition_variable   idle_;
+    std::deque<Job>           jobs_;
+    uint32_t                  busy_{0};
+    bool                      stop_{false};
+    PipelineBuildStatistics   statistics_;
+};
+
+#endif // COMMON_PIPELINE_BUILDER_H
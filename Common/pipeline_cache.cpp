@@ -0,0 +1,207 @@
+//
+// VkPipelineCache persisted on disk between runs.
+//
+
+#include "pipeline_cache.h"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+
+namespace {
+
+uint64_t fnv1a(const uint8_t *data, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+} // namespace
+
+PipelineCache::~PipelineCache() {
+    destroy();
+}
+
+bool PipelineCache::init(const DeviceDispatch &dispatch, const VkPhysicalDeviceProperties &properties,
+                         const std::string &path) {
+    dispatch_ = &dispatch;
+    properties_ = properties;
+    path_ = path;
+    loaded_bytes_ = 0;
+    rejection_.clear();
+
+    std::vector<uint8_t> data;
+    if (!path_.empty() && read_file(data)) {
+        loaded_bytes_ = data.size();
+    }
+    VkPipelineCacheCreateInfo pipeline_cache_create_info = {
+            VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+            nullptr,
+            0,
+            data.size(),
+            data.empty() ? nullptr : data.data()
+    };
+    VkResult result = dispatch.vkCreatePipelineCache(dispatch.device, &pipeline_cache_create_info, nullptr, &cache_);
+    if (result != VK_SUCCESS && !data.empty()) {
+        // The driver may still refuse data that passed our checks.
+        rejection_ = "the driver rejected the cache data";
+        loaded_bytes_ = 0;
+        pipeline_cache_create_info.initialDataSize = 0;
+        pipeline_cache_create_info.pInitialData = nullptr;
+        result = dispatch.vkCreatePipelineCache(dispatch.device, &pipeline_cache_create_info, nullptr, &cache_);
+    }
+    if (result != VK_SUCCESS) {
+        std::cout << "Could not create a pipeline cache." << std::endl;
+        cache_ = VK_NULL_HANDLE;
+        dispatch_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void PipelineCache::destroy() {
+    if (dispatch_ == nullptr) {
+        return;
+    }
+    if (!path_.empty()) {
+        save();
+    }
+    for (auto thread_cache : thread_caches_) {
+        dispatch_->vkDestroyPipelineCache(dispatch_->device, thread_cache, nullptr);
+    }
+    thread_caches_.clear();
+    dispatch_->vkDestroyPipelineCache(dispatch_->device, cache_, nullptr);
+    cache_ = VK_NULL_HANDLE;
+    dispatch_ = nullptr;
+}
+
+VkPipelineCache PipelineCache::create_thread_cache() {
+    VkPipelineCacheCreateInfo pipeline_cache_create_info = {
+            VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+            nullptr,
+            0,
+            0,
+            nullptr
+    };
+    VkPipelineCache thread_cache{VK_NULL_HANDLE};
+    if (dispatch_->vkCreatePipelineCache(dispatch_->device, &pipeline_cache_create_info, nullptr,
+                                         &thread_cache) != VK_SUCCESS) {
+        std::cout << "Could not create a pipeline cache." << std::endl;
+        return VK_NULL_HANDLE;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    thread_caches_.push_back(thread_cache);
+    return thread_cache;
+}
+
+VkResult PipelineCache::merge_thread_caches() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (thread_caches_.empty()) {
+        return VK_SUCCESS;
+    }
+    VkResult result = dispatch_->vkMergePipelineCaches(dispatch_->device, cache_,
+                                                       static_cast<uint32_t>(thread_caches_.size()),
+                                                       thread_caches_.data());
+    if (result != VK_SUCCESS) {
+        std::cout << "Could not merge pipeline caches." << std::endl;
+        return result;
+    }
+    for (auto thread_cache : thread_caches_) {
+        dispatch_->vkDestroyPipelineCache(dispatch_->device, thread_cache, nullptr);
+    }
+    thread_caches_.clear();
+    return VK_SUCCESS;
+}
+
+bool PipelineCache::save() {
+    if (path_.empty() || merge_thread_caches() != VK_SUCCESS) {
+        return false;
+    }
+    size_t data_size = 0;
+    if (dispatch_->vkGetPipelineCacheData(dispatch_->device, cache_, &data_size, nullptr) != VK_SUCCESS) {
+        std::cout << "Could not get the size of the pipeline cache data." << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> data(data_size);
+    if (data_size != 0 &&
+        dispatch_->vkGetPipelineCacheData(dispatch_->device, cache_, &data_size, data.data()) != VK_SUCCESS) {
+        std::cout << "Could not get the pipeline cache data." << std::endl;
+        return false;
+    }
+    data.resize(data_size);
+
+    PipelineCacheFileHeader header{};
+    header.magic = file_magic;
+    header.version = file_version;
+    header.vendor_id = properties_.vendorID;
+    header.device_id = properties_.deviceID;
+    header.driver_version = properties_.driverVersion;
+    memcpy(header.pipeline_cache_uuid, properties_.pipelineCacheUUID, VK_UUID_SIZE);
+    header.data_size = data.size();
+    header.data_checksum = fnv1a(data.data(), data.size());
+
+    // Written next to the old file and renamed over it, which is atomic on
+    // POSIX file systems; fsync makes sure the rename never outruns the data.
+    std::string temporary_path = path_ + ".tmp";
+    FILE *file = fopen(temporary_path.c_str(), "wb");
+    if (file == nullptr) {
+        std::cout << "Could not open " << temporary_path << " for writing." << std::endl;
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   (data.empty() || fwrite(data.data(), data.size(), 1, file) == 1) &&
+                   fflush(file) == 0 && fsync(fileno(file)) == 0;
+    if (fclose(file) != 0 || !written || rename(temporary_path.c_str(), path_.c_str()) != 0) {
+        std::cout << "Could not write the pipeline cache to " << path_ << std::endl;
+        std::remove(temporary_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool PipelineCache::read_file(std::vector<uint8_t> &data) {
+    FILE *file = fopen(path_.c_str(), "rb");
+    if (file == nullptr) {
+        rejection_ = "no cache file";
+        return false;
+    }
+    PipelineCacheFileHeader header{};
+    bool valid = fread(&header, sizeof(header), 1, file) == 1;
+    if (!valid || header.magic != file_magic || header.version != file_version) {
+        rejection_ = "not a pipeline cache file";
+    } else if (header.vendor_id != properties_.vendorID || header.device_id != properties_.deviceID) {
+        rejection_ = "written for a different device";
+    } else if (header.driver_version != properties_.driverVersion ||
+               memcmp(header.pipeline_cache_uuid, properties_.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+        rejection_ = "written by a different driver";
+    } else if (header.data_size < sizeof(VkPipelineCacheHeaderVersionOne) || header.data_size > (1ull << 31)) {
+        rejection_ = "implausible data size";
+    } else {
+        data.resize(header.data_size);
+        if (fread(data.data(), data.size(), 1, file) != 1 || fgetc(file) != EOF) {
+            rejection_ = "truncated or oversized";
+        } else if (fnv1a(data.data(), data.size()) != header.data_checksum) {
+            rejection_ = "checksum mismatch";
+        }
+    }
+    fclose(file);
+    if (!rejection_.empty()) {
+        data.clear();
+        return false;
+    }
+
+    // The driver's own header has to agree with ours.
+    VkPipelineCacheHeaderVersionOne vulkan_header;
+    memcpy(&vulkan_header, data.data(), sizeof(vulkan_header));
+    if (vulkan_header.headerSize < sizeof(vulkan_header) || vulkan_header.headerSize > data.size() ||
+        vulkan_header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        vulkan_header.vendorID != properties_.vendorID || vulkan_header.deviceID != properties_.deviceID ||
+        memcmp(vulkan_header.pipelineCacheUUID, properties_.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+        rejection_ = "cache data header does not match the device";
+        data.clear();
+        return false;
+    }
+    return true;
+}
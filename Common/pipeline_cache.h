@@ -0,0 +1,82 @@
+//
+// VkPipelineCache persisted on disk between runs.
+//
+// init() reads the cache file and only hands its contents to the driver if
+// they were written for the same device and driver: the file starts with a
+// header holding vendorID, deviceID, driverVersion, pipelineCacheUUID, the
+// data size and a checksum, and the Vulkan cache header inside the data must
+// agree with it. Anything else (a missing, truncated or foreign file, or a
+// driver update) starts from an empty cache, so a bad file costs one cold
+// start rather than undefined behaviour in the driver.
+//
+// Threads that build pipelines can take a cache of their own from
+// create_thread_cache() and avoid contending on the shared one; destroy()
+// and save() merge them back with vkMergePipelineCaches first. save() writes
+// to a temporary file and renames it over the old one, so an interrupted
+// write never leaves a corrupt cache behind.
+//
+
+#ifndef COMMON_PIPELINE_CACHE_H
+#define COMMON_PIPELINE_CACHE_H
+
+#include "device_dispatch.h"
+#include <mutex>
+#include <string>
+
+struct PipelineCacheFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint32_t driver_version;
+    uint8_t  pipeline_cache_uuid[VK_UUID_SIZE];
+    uint32_t reserved;
+    uint64_t data_size;
+    uint64_t data_checksum;     // FNV-1a over the data
+};
+
+class PipelineCache {
+public:
+    static constexpr uint32_t file_magic = 0x43504b56;    // "VKPC"
+    static constexpr uint32_t file_version = 1;
+
+    PipelineCache() = default;
+    ~PipelineCache();
+    PipelineCache(const PipelineCache &) = delete;
+    PipelineCache &operator=(const PipelineCache &) = delete;
+
+    // Creates the cache, seeded from path if the file is valid for this
+    // device. An empty path keeps the cache in memory only.
+    bool init(const DeviceDispatch &dispatch, const VkPhysicalDeviceProperties &properties, const std::string &path);
+    // Saves the cache if it has a path, then destroys it and every thread
+    // cache.
+    void destroy();
+
+    // An empty cache for one building thread; merged back by save() and
+    // destroy(). The thread must be done with it by then.
+    VkPipelineCache create_thread_cache();
+    VkResult merge_thread_caches();
+    // Merges the thread caches and atomically replaces the file.
+    bool save();
+
+    VkPipelineCache handle() const { return cache_; }
+    // True if init() found a valid file, i.e. pipeline creation runs warm.
+    bool loaded() const { return loaded_bytes_ != 0; }
+    size_t loaded_bytes() const { return loaded_bytes_; }
+    // Why the file was not used, or empty.
+    const std::string &rejection() const { return rejection_; }
+
+private:
+    bool read_file(std::vector<uint8_t> &data);
+
+    const DeviceDispatch        *dispatch_{nullptr};
+    VkPhysicalDeviceProperties   properties_{};
+    std::string                  path_;
+    VkPipelineCache              cache_{VK_NULL_HANDLE};
+    std::vector<VkPipelineCache> thread_caches_;
+    std::mutex                   mutex_;
+    size_t                       loaded_bytes_{0};
+    std::string                  rejection_;
+};
+
+#endif // COMMON_PIPELINE_CACHE_H
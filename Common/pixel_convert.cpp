@@ -0,0 +1,427 @@
+//
+// Vectorized pixel format conversions with runtime dispatch.
+//
+
+#include "pixel_convert.h"
+#include <cmath>
+#if defined(__x86_64__) || defined(__i386__)
+#define PIXEL_CONVERT_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// Scalar kernels.
+
+void rgb_to_rgba_scalar(const uint8_t *rgb, uint8_t *rgba, size_t pixel_count) {
+#if defined(__ARM_NEON)
+    const uint8x16_t alpha = vdupq_n_u8(255);
+    for (; pixel_count >= 16; pixel_count -= 16) {
+        uint8x16x3_t pixels = vld3q_u8(rgb);
+        uint8x16x4_t expanded = {{pixels.val[0], pixels.val[1], pixels.val[2], alpha}};
+        vst4q_u8(rgba, expanded);
+        rgb += 48;
+        rgba += 64;
+    }
+#endif
+    for (size_t i = 0; i < pixel_count; ++i) {
+        rgba[0] = rgb[0];
+        rgba[1] = rgb[1];
+        rgba[2] = rgb[2];
+        rgba[3] = 255;
+        rgb += 3;
+        rgba += 4;
+    }
+}
+
+void rgba_to_rgb_scalar(const uint8_t *rgba, uint8_t *rgb, size_t pixel_count) {
+    for (size_t i = 0; i < pixel_count; ++i) {
+        rgb[0] = rgba[0];
+        rgb[1] = rgba[1];
+        rgb[2] = rgba[2];
+        rgba += 4;
+        rgb += 3;
+    }
+}
+
+void bgra_to_rgb_scalar(const uint8_t *bgra, uint8_t *rgb, size_t pixel_count) {
+    for (size_t i = 0; i < pixel_count; ++i) {
+        rgb[0] = bgra[2];
+        rgb[1] = bgra[1];
+        rgb[2] = bgra[0];
+        bgra += 4;
+        rgb += 3;
+    }
+}
+
+void bgra_to_rgba_scalar(const uint8_t *bgra, uint8_t *rgba, size_t pixel_count) {
+    for (size_t i = 0; i < pixel_count; ++i) {
+        rgba[0] = bgra[2];
+        rgba[1] = bgra[1];
+        rgba[2] = bgra[0];
+        rgba[3] = bgra[3];
+        bgra += 4;
+        rgba += 4;
+    }
+}
+
+void convert_8_to_16_scalar(const uint8_t *source, uint16_t *destination, size_t channel_count) {
+    for (size_t i = 0; i < channel_count; ++i) {
+        destination[i] = static_cast<uint16_t>(source[i] * 257);
+    }
+}
+
+void convert_16_to_8_scalar(const uint16_t *source, uint8_t *destination, size_t channel_count) {
+    for (size_t i = 0; i < channel_count; ++i) {
+        destination[i] = static_cast<uint8_t>((source[i] * 255u + 32895u) >> 16);
+    }
+}
+
+#if defined(PIXEL_CONVERT_X86)
+// SSE2 and SSSE3 kernels. Loads and stores that run past the pixels of one
+// step are covered by stopping early and leaving the tail to scalar code.
+
+__attribute__((target("sse2")))
+void bgra_to_rgba_sse2(const uint8_t *bgra, uint8_t *rgba, size_t pixel_count) {
+    const __m128i green_alpha = _mm_set1_epi32(static_cast<int>(0xFF00FF00u));
+    const __m128i low_byte = _mm_set1_epi32(0xFF);
+    size_t i = 0;
+    for (; i + 4 <= pixel_count; i += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bgra + i * 4));
+        __m128i swapped = _mm_or_si128(_mm_and_si128(pixels, green_alpha),
+                                       _mm_or_si128(_mm_and_si128(_mm_srli_epi32(pixels, 16), low_byte),
+                                                    _mm_slli_epi32(_mm_and_si128(pixels, low_byte), 16)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(rgba + i * 4), swapped);
+    }
+    bgra_to_rgba_scalar(bgra + i * 4, rgba + i * 4, pixel_count - i);
+}
+
+__attribute__((target("sse2")))
+void convert_8_to_16_sse2(const uint8_t *source, uint16_t *destination, size_t channel_count) {
+    size_t i = 0;
+    for (; i + 16 <= channel_count; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+        // Interleaving a byte with itself gives x * 257.
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i), _mm_unpacklo_epi8(bytes, bytes));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i + 8), _mm_unpackhi_epi8(bytes, bytes));
+    }
+    convert_8_to_16_scalar(source + i, destination + i, channel_count - i);
+}
+
+// round(x / 257) as (v - (v >> 8)) >> 8 with v = x + 128, saturated; exact
+// for every 16-bit x.
+__attribute__((target("sse2")))
+inline __m128i narrow_16_to_8_sse2(__m128i words) {
+    __m128i v = _mm_adds_epu16(words, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_sub_epi16(v, _mm_srli_epi16(v, 8)), 8);
+}
+
+__attribute__((target("sse2")))
+void convert_16_to_8_sse2(const uint16_t *source, uint8_t *destination, size_t channel_count) {
+    size_t i = 0;
+    for (; i + 16 <= channel_count; i += 16) {
+        __m128i low = narrow_16_to_8_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i)));
+        __m128i high = narrow_16_to_8_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i + 8)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i), _mm_packus_epi16(low, high));
+    }
+    convert_16_to_8_scalar(source + i, destination + i, channel_count - i);
+}
+
+// Four pixels per shuffle; the 16-byte load uses 12 bytes, so the loop
+// stops 2 pixels early.
+__attribute__((target("ssse3")))
+void rgb_to_rgba_ssse3(const uint8_t *rgb, uint8_t *rgba, size_t pixel_count) {
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+    size_t i = 0;
+    for (; i + 6 <= pixel_count; i += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rgb + i * 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(rgba + i * 4),
+                         _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha));
+    }
+    rgb_to_rgba_scalar(rgb + i * 3, rgba + i * 4, pixel_count - i);
+}
+
+// Four pixels packed into the low 12 bytes; the 16-byte store spills 4
+// bytes that the next step overwrites, so the loop stops 2 pixels early.
+__attribute__((target("ssse3")))
+void pack_rgb_ssse3(const uint8_t *source, uint8_t *rgb, size_t pixel_count, __m128i shuffle,
+                    void (*tail)(const uint8_t *, uint8_t *, size_t)) {
+    size_t i = 0;
+    for (; i + 6 <= pixel_count; i += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(rgb + i * 3), _mm_shuffle_epi8(pixels, shuffle));
+    }
+    tail(source + i * 4, rgb + i * 3, pixel_count - i);
+}
+
+__attribute__((target("ssse3")))
+void rgba_to_rgb_ssse3(const uint8_t *rgba, uint8_t *rgb, size_t pixel_count) {
+    pack_rgb_ssse3(rgba, rgb, pixel_count, _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1),
+                   rgba_to_rgb_scalar);
+}
+
+__attribute__((target("ssse3")))
+void bgra_to_rgb_ssse3(const uint8_t *bgra, uint8_t *rgb, size_t pixel_count) {
+    pack_rgb_ssse3(bgra, rgb, pixel_count, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1),
+                   bgra_to_rgb_scalar);
+}
+
+// AVX2 kernels. vpshufb works within 128-bit lanes, so 3-byte pixels are
+// moved between lanes with a dword permute first (or after, for packing).
+
+__attribute__((target("avx2")))
+void rgb_to_rgba_avx2(const uint8_t *rgb, uint8_t *rgba, size_t pixel_count) {
+    const __m256i spread = _mm256_setr_epi32(0, 1, 2, 0, 3, 4, 5, 0);
+    const __m256i shuffle = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                             0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+    size_t i = 0;
+    // The 32-byte load uses 24 bytes.
+    for (; i + 11 <= pixel_count; i += 8) {
+        __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rgb + i * 3));
+        pixels = _mm256_permutevar8x32_epi32(pixels, spread);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(rgba + i * 4),
+                            _mm256_or_si256(_mm256_shuffle_epi8(pixels, shuffle), alpha));
+    }
+    rgb_to_rgba_ssse3(rgb + i * 3, rgba + i * 4, pixel_count - i);
+}
+
+__attribute__((target("avx2")))
+void pack_rgb_avx2(const uint8_t *source, uint8_t *rgb, size_t pixel_count, __m256i shuffle,
+                   void (*tail)(const uint8_t *, uint8_t *, size_t)) {
+    const __m256i gather = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+    size_t i = 0;
+    // The 32-byte store spills 8 bytes that the next step overwrites.
+    for (; i + 11 <= pixel_count; i += 8) {
+        __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i * 4));
+        pixels = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(pixels, shuffle), gather);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(rgb + i * 3), pixels);
+    }
+    tail(source + i * 4, rgb + i * 3, pixel_count - i);
+}
+
+__attribute__((target("avx2")))
+void rgba_to_rgb_avx2(const uint8_t *rgba, uint8_t *rgb, size_t pixel_count) {
+    pack_rgb_avx2(rgba, rgb, pixel_count,
+                  _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                   0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1),
+                  rgba_to_rgb_ssse3);
+}
+
+__attribute__((target("avx2")))
+void bgra_to_rgb_avx2(const uint8_t *bgra, uint8_t *rgb, size_t pixel_count) {
+    pack_rgb_avx2(bgra, rgb, pixel_count,
+                  _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                   2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1),
+                  bgra_to_rgb_ssse3);
+}
+
+__attribute__((target("avx2")))
+void bgra_to_rgba_avx2(const uint8_t *bgra, uint8_t *rgba, size_t pixel_count) {
+    const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                             2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    size_t i = 0;
+    for (; i + 8 <= pixel_count; i += 8) {
+        __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bgra + i * 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(rgba + i * 4), _mm256_shuffle_epi8(pixels, shuffle));
+    }
+    bgra_to_rgba_sse2(bgra + i * 4, rgba + i * 4, pixel_count - i);
+}
+
+__attribute__((target("avx2")))
+void convert_8_to_16_avx2(const uint8_t *source, uint16_t *destination, size_t channel_count) {
+    size_t i = 0;
+    for (; i + 16 <= channel_count; i += 16) {
+        __m256i words = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + i),
+                            _mm256_or_si256(words, _mm256_slli_epi16(words, 8)));
+    }
+    convert_8_to_16_sse2(source + i, destination + i, channel_count - i);
+}
+
+__attribute__((target("avx2")))
+void convert_16_to_8_avx2(const uint16_t *source, uint8_t *destination, size_t channel_count) {
+    const __m256i bias = _mm256_set1_epi16(128);
+    size_t i = 0;
+    for (; i + 32 <= channel_count; i += 32) {
+        __m256i low = _mm256_adds_epu16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i)), bias);
+        __m256i high = _mm256_adds_epu16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i + 16)), bias);
+        low = _mm256_srli_epi16(_mm256_sub_epi16(low, _mm256_srli_epi16(low, 8)), 8);
+        high = _mm256_srli_epi16(_mm256_sub_epi16(high, _mm256_srli_epi16(high, 8)), 8);
+        // packus interleaves lanes; the permute puts the quadwords back in order.
+        __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + i), bytes);
+    }
+    convert_16_to_8_sse2(source + i, destination + i, channel_count - i);
+}
+#endif
+
+// sRGB tables: 256 entries for decoding, 4096 for encoding indexed by the
+// top 12 bits of a linear value, which round-trips every 8-bit value.
+struct SrgbTables {
+    uint16_t to_linear[256];
+    uint8_t  to_srgb[4096];
+
+    SrgbTables() {
+        for (int i = 0; i < 256; ++i) {
+            double c = i / 255.0;
+            double linear = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+            to_linear[i] = static_cast<uint16_t>(std::lround(linear * 65535.0));
+        }
+        for (int i = 0; i < 4096; ++i) {
+            double linear = (i + 0.5) / 4096.0;
+            double c = linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+            to_srgb[i] = static_cast<uint8_t>(std::lround(c * 255.0));
+        }
+    }
+};
+
+const SrgbTables &srgb_tables() {
+    static const SrgbTables tables;
+    return tables;
+}
+
+struct ConvertFunctions {
+    void (*rgb_to_rgba)(const uint8_t *, uint8_t *, size_t);
+    void (*rgba_to_rgb)(const uint8_t *, uint8_t *, size_t);
+    void (*bgra_to_rgb)(const uint8_t *, uint8_t *, size_t);
+    void (*bgra_to_rgba)(const uint8_t *, uint8_t *, size_t);
+    void (*convert_8_to_16)(const uint8_t *, uint16_t *, size_t);
+    void (*convert_16_to_8)(const uint16_t *, uint8_t *, size_t);
+};
+
+const ConvertFunctions scalar_functions = {
+        rgb_to_rgba_scalar, rgba_to_rgb_scalar, bgra_to_rgb_scalar, bgra_to_rgba_scalar,
+        convert_8_to_16_scalar, convert_16_to_8_scalar
+};
+#if defined(PIXEL_CONVERT_X86)
+const ConvertFunctions sse2_functions = {
+        rgb_to_rgba_scalar, rgba_to_rgb_scalar, bgra_to_rgb_scalar, bgra_to_rgba_sse2,
+        convert_8_to_16_sse2, convert_16_to_8_sse2
+};
+const ConvertFunctions ssse3_functions = {
+        rgb_to_rgba_ssse3, rgba_to_rgb_ssse3, bgra_to_rgb_ssse3, bgra_to_rgba_sse2,
+        convert_8_to_16_sse2, convert_16_to_8_sse2
+};
+const ConvertFunctions avx2_functions = {
+        rgb_to_rgba_avx2, rgba_to_rgb_avx2, bgra_to_rgb_avx2, bgra_to_rgba_avx2,
+        convert_8_to_16_avx2, convert_16_to_8_avx2
+};
+#endif
+
+struct Dispatch {
+    PixelConvertPath        path;
+    const ConvertFunctions *functions;
+};
+
+Dispatch dispatch_for(PixelConvertPath path) {
+    switch (path) {
+#if defined(PIXEL_CONVERT_X86)
+        case PixelConvertPath::AVX2:
+            return {path, &avx2_functions};
+        case PixelConvertPath::SSSE3:
+            return {path, &ssse3_functions};
+        case PixelConvertPath::SSE2:
+            return {path, &sse2_functions};
+#endif
+        default:
+            return {PixelConvertPath::Scalar, &scalar_functions};
+    }
+}
+
+Dispatch &current() {
+    static Dispatch dispatch = dispatch_for(supported_pixel_convert_path());
+    return dispatch;
+}
+
+} // namespace
+
+const char *pixel_convert_path_name(PixelConvertPath path) {
+    switch (path) {
+        case PixelConvertPath::SSE2:
+            return "SSE2";
+        case PixelConvertPath::SSSE3:
+            return "SSSE3";
+        case PixelConvertPath::AVX2:
+            return "AVX2";
+        default:
+            return "scalar";
+    }
+}
+
+PixelConvertPath supported_pixel_convert_path() {
+#if defined(PIXEL_CONVERT_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return PixelConvertPath::AVX2;
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        return PixelConvertPath::SSSE3;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return PixelConvertPath::SSE2;
+    }
+#endif
+    return PixelConvertPath::Scalar;
+}
+
+PixelConvertPath pixel_convert_path() {
+    return current().path;
+}
+
+PixelConvertPath set_pixel_convert_path(PixelConvertPath path) {
+    PixelConvertPath supported = supported_pixel_convert_path();
+    current() = dispatch_for(static_cast<int>(path) < static_cast<int>(supported) ? path : supported);
+    return current().path;
+}
+
+void convert_rgb_to_rgba(const uint8_t *rgb, uint8_t *rgba, size_t pixel_count) {
+    current().functions->rgb_to_rgba(rgb, rgba, pixel_count);
+}
+
+void convert_rgba_to_rgb(const uint8_t *rgba, uint8_t *rgb, size_t pixel_count) {
+    current().functions->rgba_to_rgb(rgba, rgb, pixel_count);
+}
+
+void convert_bgra_to_rgb(const uint8_t *bgra, uint8_t *rgb, size_t pixel_count) {
+    current().functions->bgra_to_rgb(bgra, rgb, pixel_count);
+}
+
+void convert_bgra_to_rgba(const uint8_t *bgra, uint8_t *rgba, size_t pixel_count) {
+    current().functions->bgra_to_rgba(bgra, rgba, pixel_count);
+}
+
+void convert_8_to_16(const uint8_t *source, uint16_t *destination, size_t channel_count) {
+    current().functions->convert_8_to_16(source, destination, channel_count);
+}
+
+void convert_16_to_8(const uint16_t *source, uint8_t *destination, size_t channel_count) {
+    current().functions->convert_16_to_8(source, destination, channel_count);
+}
+
+void convert_srgb_to_linear(const uint8_t *srgb, uint16_t *linear, size_t pixel_count) {
+    const SrgbTables &tables = srgb_tables();
+    for (size_t i = 0; i < pixel_count; ++i) {
+        linear[0] = tables.to_linear[srgb[0]];
+        linear[1] = tables.to_linear[srgb[1]];
+        linear[2] = tables.to_linear[srgb[2]];
+        linear[3] = static_cast<uint16_t>(srgb[3] * 257);
+        srgb += 4;
+        linear += 4;
+    }
+}
+
+void convert_linear_to_srgb(const uint16_t *linear, uint8_t *srgb, size_t pixel_count) {
+    const SrgbTables &tables = srgb_tables();
+    for (size_t i = 0; i < pixel_count; ++i) {
+        srgb[0] = tables.to_srgb[linear[0] >> 4];
+        srgb[1] = tables.to_srgb[linear[1] >> 4];
+        srgb[2] = tables.to_srgb[linear[2] >> 4];
+        srgb[3] = static_cast<uint8_t>((linear[3] * 255u + 32895u) >> 16);
+        linear += 4;
+        srgb += 4;
+    }
+}
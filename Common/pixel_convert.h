@@ -0,0 +1,55 @@
+//
+// Vectorized pixel format conversions for upload and readback paths.
+//
+// Each conversion has a scalar version and, on x86, SSE2/SSSE3 and AVX2
+// versions. The widest path the CPU supports is picked the first time any
+// conversion runs; set_pixel_convert_path() overrides it, e.g. to compare
+// paths. A conversion with no kernel for the chosen path uses the widest
+// narrower one. On ARM, RGB to RGBA uses NEON and the rest is scalar.
+//
+// Buffers are tightly packed and may be unaligned; source and destination
+// must not overlap. Counts are in pixels, except for the 8/16-bit channel
+// conversions, which count channels.
+//
+// sRGB conversions go through lookup tables and are scalar on every path;
+// they treat the fourth channel as linear alpha.
+//
+
+#ifndef COMMON_PIXEL_CONVERT_H
+#define COMMON_PIXEL_CONVERT_H
+
+#include <cstddef>
+#include <cstdint>
+
+enum class PixelConvertPath {
+    Scalar,
+    SSE2,
+    SSSE3,
+    AVX2
+};
+
+const char *pixel_convert_path_name(PixelConvertPath path);
+// Widest path this CPU supports.
+PixelConvertPath supported_pixel_convert_path();
+PixelConvertPath pixel_convert_path();
+// Clamped to what the CPU supports. Not thread-safe with respect to
+// conversions running on other threads.
+PixelConvertPath set_pixel_convert_path(PixelConvertPath path);
+
+// RGB8 to RGBA8 with alpha 255.
+void convert_rgb_to_rgba(const uint8_t *rgb, uint8_t *rgba, size_t pixel_count);
+// RGBA8 to RGB8, dropping alpha.
+void convert_rgba_to_rgb(const uint8_t *rgba, uint8_t *rgb, size_t pixel_count);
+// BGRA8 to RGB8, dropping alpha.
+void convert_bgra_to_rgb(const uint8_t *bgra, uint8_t *rgb, size_t pixel_count);
+// BGRA8 to RGBA8; the same swap also turns RGBA into BGRA.
+void convert_bgra_to_rgba(const uint8_t *bgra, uint8_t *rgba, size_t pixel_count);
+// sRGB-encoded RGBA8 to linear RGBA16.
+void convert_srgb_to_linear(const uint8_t *srgb, uint16_t *linear, size_t pixel_count);
+// Linear RGBA16 to sRGB-encoded RGBA8, rounding to nearest.
+void convert_linear_to_srgb(const uint16_t *linear, uint8_t *srgb, size_t pixel_count);
+// UNORM8 to UNORM16 channels (x * 257) and back, rounding to nearest.
+void convert_8_to_16(const uint8_t *source, uint16_t *destination, size_t channel_count);
+void convert_16_to_8(const uint16_t *source, uint8_t *destination, size_t channel_count);
+
+#endif // COMMON_PIXEL_CONVERT_H
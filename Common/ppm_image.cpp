@@ -0,0 +1,162 @@
+//
+// Memory-mapped PPM/PGM texture loader.
+//
+
+#include "ppm_image.h"
+#include "pixel_convert.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cctype>
+#include <iostream>
+
+namespace {
+
+// Reads the next header field, skipping whitespace and comments. Returns
+// false at the end of the mapping or on a field that is not a number.
+bool read_header_number(const uint8_t *&cursor, const uint8_t *end, uint32_t &value) {
+    for (;;) {
+        while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r' ||
+                                *cursor == '\v' || *cursor == '\f')) {
+            ++cursor;
+        }
+        if (cursor < end && *cursor == '#') {
+            while (cursor < end && *cursor != '\n' && *cursor != '\r') {
+                ++cursor;
+            }
+            continue;
+        }
+        break;
+    }
+    if (cursor == end || *cursor < '0' || *cursor > '9') {
+        return false;
+    }
+    uint64_t number = 0;
+    while (cursor < end && *cursor >= '0' && *cursor <= '9') {
+        number = number * 10 + (*cursor - '0');
+        if (number > UINT32_MAX) {
+            return false;
+        }
+        ++cursor;
+    }
+    value = static_cast<uint32_t>(number);
+    return true;
+}
+
+} // namespace
+
+PpmImage::~PpmImage() {
+    close();
+}
+
+bool PpmImage::open(const char *path) {
+    close();
+    int file = ::open(path, O_RDONLY);
+    if (file < 0) {
+        std::cout << "Could not open " << path << std::endl;
+        return false;
+    }
+    struct stat file_status{};
+    if (fstat(file, &file_status) != 0 || file_status.st_size < 3) {
+        std::cout << "Could not read " << path << std::endl;
+        ::close(file);
+        return false;
+    }
+    mapping_size_ = static_cast<size_t>(file_status.st_size);
+    mapping_ = mmap(nullptr, mapping_size_, PROT_READ, MAP_PRIVATE, file, 0);
+    // The mapping keeps the file referenced.
+    ::close(file);
+    if (mapping_ == MAP_FAILED) {
+        std::cout << "Could not map " << path << std::endl;
+        mapping_ = nullptr;
+        return false;
+    }
+    madvise(mapping_, mapping_size_, MADV_SEQUENTIAL);
+
+    const uint8_t *cursor = static_cast<const uint8_t *>(mapping_);
+    const uint8_t *end = cursor + mapping_size_;
+    if (cursor[0] != 'P' || (cursor[1] != '6' && cursor[1] != '5')) {
+        std::cout << "Unhandled PPM magic number in " << path << std::endl;
+        close();
+        return false;
+    }
+    uint32_t channels = cursor[1] == '6' ? 3 : 1;
+    cursor += 2;
+    uint32_t width, height, max_value;
+    // Exactly one whitespace byte separates maxval from the samples.
+    if (!read_header_number(cursor, end, width) || !read_header_number(cursor, end, height) ||
+        !read_header_number(cursor, end, max_value) || cursor == end || !std::isspace(*cursor)) {
+        std::cout << "Malformed PPM header in " << path << std::endl;
+        close();
+        return false;
+    }
+    ++cursor;
+    if (width == 0 || width > max_dimension || height == 0 || height > max_dimension ||
+        max_value == 0 || max_value > 65535) {
+        std::cout << "Unsupported PPM dimensions or maxval in " << path << ": " << width << "x" << height
+                  << ", " << max_value << std::endl;
+        close();
+        return false;
+    }
+    size_t sample_size = max_value > 255 ? 2 : 1;
+    if (size_t(end - cursor) < size_t(width) * height * channels * sample_size) {
+        std::cout << "Truncated PPM file " << path << std::endl;
+        close();
+        return false;
+    }
+    pixels_ = cursor;
+    width_ = width;
+    height_ = height;
+    max_value_ = max_value;
+    channels_ = channels;
+    return true;
+}
+
+void PpmImage::close() {
+    if (mapping_ != nullptr) {
+        munmap(mapping_, mapping_size_);
+    }
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+    pixels_ = nullptr;
+    width_ = height_ = max_value_ = channels_ = 0;
+}
+
+void PpmImage::read_rgba_rows(uint32_t first_row, uint32_t row_count, void *rgba, size_t row_pitch) const {
+    size_t sample_size = max_value_ > 255 ? 2 : 1;
+    size_t source_row_size = size_t(width_) * channels_ * sample_size;
+    const uint8_t *source = pixels_ + first_row * source_row_size;
+    uint8_t *destination = static_cast<uint8_t *>(rgba);
+
+    if (channels_ == 3 && max_value_ == 255) {
+        for (uint32_t row = 0; row < row_count; ++row) {
+            convert_rgb_to_rgba(source, destination, width_);
+            source += source_row_size;
+            destination += row_pitch;
+        }
+        return;
+    }
+
+    // Samples are rescaled to 0..255, rounding to nearest.
+    uint32_t half = max_value_ / 2;
+    for (uint32_t row = 0; row < row_count; ++row) {
+        const uint8_t *sample = source;
+        uint8_t *pixel = destination;
+        for (uint32_t x = 0; x < width_; ++x) {
+            for (uint32_t channel = 0; channel < channels_; ++channel) {
+                uint32_t value = sample_size == 2 ? (uint32_t(sample[0]) << 8) | sample[1] : sample[0];
+                value = value < max_value_ ? value : max_value_;
+                pixel[channel] = static_cast<uint8_t>((value * 255 + half) / max_value_);
+                sample += sample_size;
+            }
+            if (channels_ == 1) {
+                pixel[1] = pixel[2] = pixel[0];
+            }
+            pixel[3] = 255;
+            pixel += 4;
+        }
+        source += source_row_size;
+        destination += row_pitch;
+    }
+}
@@ -0,0 +1,60 @@
+//
+// Memory-mapped PPM/PGM (binary netpbm) texture loader.
+//
+// open() maps the file once and parses the header: the P6 (RGB) or P5
+// (grayscale) magic number, width, height and maxval, with '#' comments
+// allowed between any two fields. maxval may be anything up to 65535;
+// samples above 255 are two bytes, big-endian. The mapping stays open until
+// close(), so pixel data is read straight from the page cache without a copy
+// into an intermediate buffer.
+//
+// read_rgba_rows() expands any band of rows to RGBA8 with alpha 255 into
+// caller memory at an arbitrary row pitch: mapped image memory or a staging
+// chunk. The common case, 8-bit RGB, goes through convert_rgb_to_rgba();
+// other formats are rescaled per sample.
+//
+
+#ifndef COMMON_PPM_IMAGE_H
+#define COMMON_PPM_IMAGE_H
+
+#include <cstddef>
+#include <cstdint>
+
+class PpmImage {
+public:
+    static constexpr uint32_t max_dimension = 32768;
+
+    PpmImage() = default;
+    ~PpmImage();
+    PpmImage(const PpmImage &) = delete;
+    PpmImage &operator=(const PpmImage &) = delete;
+
+    // Maps the file and validates the header and size. Prints the reason
+    // and returns false on failure.
+    bool open(const char *path);
+    void close();
+    bool is_open() const { return pixels_ != nullptr; }
+
+    uint32_t width() const { return width_; }
+    uint32_t height() const { return height_; }
+    uint32_t max_value() const { return max_value_; }
+    uint32_t channels() const { return channels_; }
+    // Bytes of one RGBA8 row.
+    size_t rgba_row_size() const { return size_t(width_) * 4; }
+
+    // Expands rows [first_row, first_row + row_count) to RGBA8; row i lands
+    // at rgba + i * row_pitch.
+    void read_rgba_rows(uint32_t first_row, uint32_t row_count, void *rgba, size_t row_pitch) const;
+    void read_rgba(void *rgba, size_t row_pitch) const { read_rgba_rows(0, height_, rgba, row_pitch); }
+
+private:
+    void          *mapping_{nullptr};
+    size_t         mapping_size_{0};
+    const uint8_t *pixels_{nullptr};   // first byte after the header
+    uint32_t       width_{0};
+    uint32_t       height_{0};
+    uint32_t       max_value_{0};
+    uint32_t       channels_{0};
+};
+
+#endif // COMMON_PPM_IMAGE_H
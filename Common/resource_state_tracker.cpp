@@ -0,0 +1,464 @@
+//
+// Per-resource access tracking with batched pipeline barriers.
+//
+
+#include "resource_state_tracker.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+bool synchronization2_supported(const std::vector<VkExtensionProperties> &available_extensions) {
+    for (const auto &extension : available_extensions) {
+        if (std::strcmp(extension.extensionName, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+VkAccessFlags2 access_for_layout(VkImageLayout layout) {
+    switch (layout) {
+        case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+            return VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+            return VK_ACCESS_2_TRANSFER_READ_BIT;
+        case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+            return VK_ACCESS_2_SHADER_READ_BIT;
+        case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+            return VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+        case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+            return VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+            return VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_SHADER_READ_BIT;
+        case VK_IMAGE_LAYOUT_PREINITIALIZED:
+            return VK_ACCESS_2_HOST_WRITE_BIT;
+        default:
+            return 0;
+    }
+}
+
+// The low 32 bits of the synchronization2 masks match the legacy bits.
+VkPipelineStageFlags legacy_stage_flags(VkPipelineStageFlags2 stages) {
+    auto legacy = static_cast<VkPipelineStageFlags>(stages & 0xFFFFFFFFull);
+    if ((stages & (VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_RESOLVE_BIT |
+                   VK_PIPELINE_STAGE_2_BLIT_BIT | VK_PIPELINE_STAGE_2_CLEAR_BIT)) != 0) {
+        legacy |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+    }
+    if ((stages & (VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT | VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT)) != 0) {
+        legacy |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+    }
+    if ((stages & VK_PIPELINE_STAGE_2_PRE_RASTERIZATION_SHADERS_BIT) != 0) {
+        legacy |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT |
+                  VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT | VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT;
+    }
+    return legacy;
+}
+
+VkAccessFlags legacy_access_flags(VkAccessFlags2 access) {
+    auto legacy = static_cast<VkAccessFlags>(access & 0xFFFFFFFFull);
+    if ((access & (VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT)) != 0) {
+        legacy |= VK_ACCESS_SHADER_READ_BIT;
+    }
+    if ((access & VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT) != 0) {
+        legacy |= VK_ACCESS_SHADER_WRITE_BIT;
+    }
+    return legacy;
+}
+
+void ResourceStateTracker::track_image(VkImage image, VkImageAspectFlags aspect, uint32_t mip_levels,
+                                       uint32_t array_layers, VkImageLayout initial_layout) {
+    ResourceState initial_state;
+    initial_state.layout = initial_layout;
+    track_image(image, aspect, mip_levels, array_layers, initial_state);
+}
+
+void ResourceStateTracker::track_image(VkImage image, VkImageAspectFlags aspect, uint32_t mip_levels,
+                                       uint32_t array_layers, const ResourceState &initial_state) {
+    ImageState &image_state = images_[image];
+    image_state.aspect = aspect;
+    image_state.mip_levels = mip_levels;
+    image_state.array_layers = array_layers;
+    image_state.subresources.assign(static_cast<size_t>(mip_levels) * array_layers, initial_state);
+    image_state.pending.assign(image_state.subresources.size(), -1);
+}
+
+VkImageLayout ResourceStateTracker::image_layout(VkImage image, uint32_t mip_level, uint32_t array_layer) const {
+    auto found = images_.find(image);
+    if (found == images_.end() || mip_level >= found->second.mip_levels || array_layer >= found->second.array_layers) {
+        return VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+    return found->second.subresources[mip_level * found->second.array_layers + array_layer].layout;
+}
+
+bool ResourceStateTracker::transition(ResourceState &state, VkPipelineStageFlags2 stages, VkAccessFlags2 access,
+                                      VkImageLayout layout, uint32_t queue_family,
+                                      VkAccessFlags2 &src_access, VkPipelineStageFlags2 &src_stages) {
+    bool writes = (access & write_access_mask) != 0;
+    bool layout_change = layout != state.layout;
+    bool ownership_transfer = queue_family != VK_QUEUE_FAMILY_IGNORED &&
+                              state.queue_family != VK_QUEUE_FAMILY_IGNORED &&
+                              queue_family != state.queue_family;
+    bool needed;
+    src_access = 0;
+    src_stages = 0;
+    if (writes || layout_change || ownership_transfer) {
+        // Wait for the last write and for every read since (write-after-read
+        // only needs the execution dependency).
+        src_stages = state.write_stages | state.read_stages;
+        src_access = state.write_access;
+        needed = src_stages != 0 || layout_change || ownership_transfer;
+        state.write_stages = stages;
+        state.write_access = access & write_access_mask;
+        state.read_stages = writes ? 0 : stages;
+        // A new write is visible to nobody yet; a layout transition or
+        // ownership transfer is visible to the stages that waited for it.
+        state.visible_stages = writes ? 0 : stages;
+        state.visible_access = writes ? 0 : access;
+    } else {
+        needed = state.write_stages != 0 &&
+                 ((stages & ~state.visible_stages) != 0 || (access & ~state.visible_access) != 0);
+        if (needed) {
+            src_stages = state.write_stages;
+            src_access = state.write_access;
+            state.visible_stages |= stages;
+            state.visible_access |= access;
+        }
+        state.read_stages |= stages;
+    }
+    if (src_stages == 0) {
+        src_stages = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT;
+    }
+    state.layout = layout;
+    if (queue_family != VK_QUEUE_FAMILY_IGNORED) {
+        state.queue_family = queue_family;
+    }
+    return needed;
+}
+
+void ResourceStateTracker::split(BufferRanges &ranges, VkDeviceSize offset) {
+    auto it = ranges.upper_bound(offset);
+    if (it == ranges.begin()) {
+        return;
+    }
+    --it;
+    if (it->first >= offset || it->second.end <= offset) {
+        return;
+    }
+    BufferRange tail = it->second;
+    it->second.end = offset;
+    BufferRange &inserted = ranges.emplace(offset, tail).first->second;
+    if (inserted.pending >= 0) {
+        pending_ranges_.push_back(&inserted);
+    }
+}
+
+void ResourceStateTracker::use_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size,
+                                      VkPipelineStageFlags2 stages, VkAccessFlags2 access, uint32_t queue_family) {
+    VkDeviceSize end = (size == VK_WHOLE_SIZE) ? VK_WHOLE_SIZE : offset + size;
+    BufferRanges &ranges = buffers_[buffer];
+    split(ranges, offset);
+    split(ranges, end);
+
+    int32_t previous_barrier{-1};
+    VkDeviceSize cursor = offset;
+    auto it = ranges.lower_bound(offset);
+    while (cursor < end) {
+        if (it == ranges.end() || it->first > cursor) {
+            // Never used before.
+            BufferRange fresh;
+            fresh.end = (it == ranges.end()) ? end : std::min(end, it->first);
+            it = ranges.emplace(cursor, fresh).first;
+        }
+        BufferRange &range = it->second;
+        ResourceState &state = range.state;
+
+        if (range.pending >= 0) {
+            // Already waited for in this batch by an earlier use; widen the
+            // barrier to cover this use as well.
+            VkBufferMemoryBarrier2 &barrier = buffer_barriers_[range.pending];
+            barrier.dstStageMask |= stages;
+            barrier.dstAccessMask |= access;
+            if ((access & write_access_mask) != 0) {
+                state.write_stages |= stages;
+                state.write_access |= access & write_access_mask;
+                state.visible_stages = 0;
+                state.visible_access = 0;
+            } else {
+                state.read_stages |= stages;
+            }
+            previous_barrier = -1;
+        } else {
+            uint32_t src_family = state.queue_family;
+            VkAccessFlags2 src_access;
+            VkPipelineStageFlags2 src_stages;
+            if (transition(state, stages, access, VK_IMAGE_LAYOUT_UNDEFINED, queue_family, src_access, src_stages)) {
+                bool ownership_transfer = src_family != state.queue_family && src_family != VK_QUEUE_FAMILY_IGNORED;
+                uint32_t barrier_src_family = ownership_transfer ? src_family : VK_QUEUE_FAMILY_IGNORED;
+                uint32_t barrier_dst_family = ownership_transfer ? state.queue_family : VK_QUEUE_FAMILY_IGNORED;
+                // Neighbouring ranges that needed the same barrier share one.
+                if (previous_barrier >= 0) {
+                    VkBufferMemoryBarrier2 &previous = buffer_barriers_[previous_barrier];
+                    if (previous.offset + previous.size == it->first &&
+                        previous.srcStageMask == src_stages && previous.srcAccessMask == src_access &&
+                        previous.dstStageMask == stages && previous.dstAccessMask == access &&
+                        previous.srcQueueFamilyIndex == barrier_src_family &&
+                        previous.dstQueueFamilyIndex == barrier_dst_family) {
+                        previous.size = (range.end == VK_WHOLE_SIZE) ? VK_WHOLE_SIZE : range.end - previous.offset;
+                        range.pending = previous_barrier;
+                        pending_ranges_.push_back(&range);
+                        cursor = range.end;
+                        ++it;
+                        continue;
+                    }
+                }
+                buffer_barriers_.push_back({
+                        VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+                        nullptr,
+                        src_stages,
+                        src_access,
+                        stages,
+                        access,
+                        barrier_src_family,
+                        barrier_dst_family,
+                        buffer,
+                        it->first,
+                        (range.end == VK_WHOLE_SIZE) ? VK_WHOLE_SIZE : range.end - it->first
+                });
+                previous_barrier = static_cast<int32_t>(buffer_barriers_.size() - 1);
+                range.pending = previous_barrier;
+                pending_ranges_.push_back(&range);
+            } else {
+                previous_barrier = -1;
+            }
+        }
+        cursor = range.end;
+        ++it;
+    }
+}
+
+bool ResourceStateTracker::use_image(VkImage image, const VkImageSubresourceRange &range,
+                                     VkPipelineStageFlags2 stages, VkAccessFlags2 access, VkImageLayout layout,
+                                     uint32_t queue_family) {
+    auto found = images_.find(image);
+    if (found == images_.end()) {
+        std::cout << "Image used before it was registered with the state tracker." << std::endl;
+        return false;
+    }
+    ImageState &image_state = found->second;
+    uint32_t level_count = (range.levelCount == VK_REMAINING_MIP_LEVELS) ?
+                           image_state.mip_levels - range.baseMipLevel : range.levelCount;
+    uint32_t layer_count = (range.layerCount == VK_REMAINING_ARRAY_LAYERS) ?
+                           image_state.array_layers - range.baseArrayLayer : range.layerCount;
+    if (range.baseMipLevel + level_count > image_state.mip_levels ||
+        range.baseArrayLayer + layer_count > image_state.array_layers) {
+        std::cout << "Image subresource range is outside the tracked image." << std::endl;
+        return false;
+    }
+
+    bool merged_pending{false};
+    size_t first_new_barrier = image_barriers_.size();
+    int32_t previous_barrier{-1};
+    for (uint32_t level = range.baseMipLevel; level < range.baseMipLevel + level_count; ++level) {
+        for (uint32_t layer = range.baseArrayLayer; layer < range.baseArrayLayer + layer_count; ++layer) {
+            size_t index = static_cast<size_t>(level) * image_state.array_layers + layer;
+            ResourceState &state = image_state.subresources[index];
+
+            if (image_state.pending[index] >= 0) {
+                VkImageMemoryBarrier2 &barrier = image_barriers_[image_state.pending[index]];
+                if (barrier.newLayout != layout) {
+                    std::cout << "Image subresource used in two layouts by one command." << std::endl;
+                    previous_barrier = -1;
+                    continue;
+                }
+                barrier.dstStageMask |= stages;
+                barrier.dstAccessMask |= access;
+                if ((access & write_access_mask) != 0) {
+                    state.write_stages |= stages;
+                    state.write_access |= access & write_access_mask;
+                    state.visible_stages = 0;
+                    state.visible_access = 0;
+                } else {
+                    state.read_stages |= stages;
+                }
+                merged_pending = true;
+                previous_barrier = -1;
+                continue;
+            }
+
+            VkImageLayout old_layout = state.layout;
+            uint32_t src_family = state.queue_family;
+            VkAccessFlags2 src_access;
+            VkPipelineStageFlags2 src_stages;
+            if (!transition(state, stages, access, layout, queue_family, src_access, src_stages)) {
+                previous_barrier = -1;
+                continue;
+            }
+            bool ownership_transfer = src_family != state.queue_family && src_family != VK_QUEUE_FAMILY_IGNORED;
+            uint32_t barrier_src_family = ownership_transfer ? src_family : VK_QUEUE_FAMILY_IGNORED;
+            uint32_t barrier_dst_family = ownership_transfer ? state.queue_family : VK_QUEUE_FAMILY_IGNORED;
+
+            // Consecutive layers of one mip level that need the same barrier
+            // share it.
+            if (previous_barrier >= 0) {
+                VkImageMemoryBarrier2 &previous = image_barriers_[previous_barrier];
+                if (previous.subresourceRange.baseMipLevel == level &&
+                    previous.subresourceRange.baseArrayLayer + previous.subresourceRange.layerCount == layer &&
+                    previous.srcStageMask == src_stages && previous.srcAccessMask == src_access &&
+                    previous.dstStageMask == stages && previous.dstAccessMask == access &&
+                    previous.oldLayout == old_layout && previous.srcQueueFamilyIndex == barrier_src_family &&
+                    previous.dstQueueFamilyIndex == barrier_dst_family) {
+                    ++previous.subresourceRange.layerCount;
+                    image_state.pending[index] = previous_barrier;
+                    continue;
+                }
+            }
+            image_barriers_.push_back({
+                    VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                    nullptr,
+                    src_stages,
+                    src_access,
+                    stages,
+                    access,
+                    old_layout,
+                    layout,
+                    barrier_src_family,
+                    barrier_dst_family,
+                    image,
+                    {image_state.aspect, level, 1, layer, 1}
+            });
+            previous_barrier = static_cast<int32_t>(image_barriers_.size() - 1);
+            image_state.pending[index] = previous_barrier;
+        }
+        previous_barrier = -1;
+    }
+
+    // Whole mip levels with identical barriers collapse into one barrier.
+    // Only barriers added by this call are touched, so no other image's
+    // pending indices move.
+    if (!merged_pending) {
+        for (size_t i = first_new_barrier + 1; i < image_barriers_.size(); ++i) {
+            VkImageMemoryBarrier2 &previous = image_barriers_[i - 1];
+            VkImageMemoryBarrier2 &current = image_barriers_[i];
+            if (previous.subresourceRange.baseMipLevel + previous.subresourceRange.levelCount ==
+                current.subresourceRange.baseMipLevel &&
+                previous.subresourceRange.baseArrayLayer == current.subresourceRange.baseArrayLayer &&
+                previous.subresourceRange.layerCount == current.subresourceRange.layerCount &&
+                previous.srcStageMask == current.srcStageMask && previous.srcAccessMask == current.srcAccessMask &&
+                previous.dstStageMask == current.dstStageMask && previous.dstAccessMask == current.dstAccessMask &&
+                previous.oldLayout == current.oldLayout && previous.newLayout == current.newLayout &&
+                previous.srcQueueFamilyIndex == current.srcQueueFamilyIndex &&
+                previous.dstQueueFamilyIndex == current.dstQueueFamilyIndex) {
+                previous.subresourceRange.levelCount += current.subresourceRange.levelCount;
+                image_barriers_.erase(image_barriers_.begin() + static_cast<std::ptrdiff_t>(i));
+                // Re-point every subresource at the barriers' new positions.
+                for (auto &pending : image_state.pending) {
+                    if (pending == static_cast<int32_t>(i)) {
+                        pending = static_cast<int32_t>(i - 1);
+                    } else if (pending > static_cast<int32_t>(i)) {
+                        --pending;
+                    }
+                }
+                --i;
+            }
+        }
+    }
+    if (std::find(pending_images_.begin(), pending_images_.end(), image) == pending_images_.end()) {
+        pending_images_.push_back(image);
+    }
+    return true;
+}
+
+void BarrierRecorder::record(VkCommandBuffer command_buffer,
+                             uint32_t buffer_barrier_count, const VkBufferMemoryBarrier2 *buffer_barriers,
+                             uint32_t image_barrier_count, const VkImageMemoryBarrier2 *image_barriers) {
+    if (buffer_barrier_count == 0 && image_barrier_count == 0) {
+        return;
+    }
+    if (synchronization2_) {
+        VkDependencyInfo dependency_info = {
+                VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                nullptr,
+                0,
+                0,
+                nullptr,
+                buffer_barrier_count,
+                buffer_barriers,
+                image_barrier_count,
+                image_barriers
+        };
+        dispatch_->vkCmdPipelineBarrier2KHR(command_buffer, &dependency_info);
+    } else {
+        // One stage pair has to cover every barrier in the call.
+        VkPipelineStageFlags src_stages{0}, dst_stages{0};
+        legacy_buffer_barriers_.clear();
+        legacy_image_barriers_.clear();
+        for (uint32_t i = 0; i < buffer_barrier_count; ++i) {
+            const auto &barrier = buffer_barriers[i];
+            src_stages |= legacy_stage_flags(barrier.srcStageMask);
+            dst_stages |= legacy_stage_flags(barrier.dstStageMask);
+            legacy_buffer_barriers_.push_back({
+                    VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                    nullptr,
+                    legacy_access_flags(barrier.srcAccessMask),
+                    legacy_access_flags(barrier.dstAccessMask),
+                    barrier.srcQueueFamilyIndex,
+                    barrier.dstQueueFamilyIndex,
+                    barrier.buffer,
+                    barrier.offset,
+                    barrier.size
+            });
+        }
+        for (uint32_t i = 0; i < image_barrier_count; ++i) {
+            const auto &barrier = image_barriers[i];
+            src_stages |= legacy_stage_flags(barrier.srcStageMask);
+            dst_stages |= legacy_stage_flags(barrier.dstStageMask);
+            legacy_image_barriers_.push_back({
+                    VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                    nullptr,
+                    legacy_access_flags(barrier.srcAccessMask),
+                    legacy_access_flags(barrier.dstAccessMask),
+                    barrier.oldLayout,
+                    barrier.newLayout,
+                    barrier.srcQueueFamilyIndex,
+                    barrier.dstQueueFamilyIndex,
+                    barrier.image,
+                    barrier.subresourceRange
+            });
+        }
+        // Legacy barriers need a stage on both sides; NONE becomes the
+        // matching end of the pipe.
+        if (src_stages == 0) {
+            src_stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        }
+        if (dst_stages == 0) {
+            dst_stages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        }
+        dispatch_->vkCmdPipelineBarrier(command_buffer, src_stages, dst_stages, 0, 0, nullptr,
+                                        static_cast<uint32_t>(legacy_buffer_barriers_.size()), legacy_buffer_barriers_.data(),
+                                        static_cast<uint32_t>(legacy_image_barriers_.size()), legacy_image_barriers_.data());
+    }
+}
+
+void ResourceStateTracker::flush(VkCommandBuffer command_buffer) {
+    if (!has_pending()) {
+        return;
+    }
+    recorder_.record(command_buffer, static_cast<uint32_t>(buffer_barriers_.size()), buffer_barriers_.data(),
+                     static_cast<uint32_t>(image_barriers_.size()), image_barriers_.data());
+    ++barrier_calls_;
+    barriers_recorded_ += static_cast<uint32_t>(buffer_barriers_.size() + image_barriers_.size());
+
+    for (auto range : pending_ranges_) {
+        range->pending = -1;
+    }
+    for (auto image : pending_images_) {
+        auto found = images_.find(image);
+        if (found != images_.end()) {
+            found->second.pending.assign(found->second.pending.size(), -1);
+        }
+    }
+    buffer_barriers_.clear();
+    image_barriers_.clear();
+    pending_ranges_.clear();
+    pending_images_.clear();
+}
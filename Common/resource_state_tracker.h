@@ -0,0 +1,169 @@
+//
+// Per-resource access tracking with batched pipeline barriers.
+//
+// The tracker remembers, for every buffer range and image subresource, which
+// stages last wrote it and with what access, which stages have read it since,
+// its layout and its owning queue family. Callers declare how the next
+// command will use each resource with use_buffer()/use_image(); the tracker
+// works out whether a barrier is needed at all and with the smallest source
+// and destination masks, and flush() records everything pending as a single
+// vkCmdPipelineBarrier.
+//
+// Read-after-read needs no barrier. A read only waits if the last write has
+// not yet been made visible to that stage and access. Writes wait for the
+// last write and for every read since.
+//
+// Usage per command: use_*() for all resources it touches, flush(), record.
+// A resource may be used more than once between flushes only with the same
+// layout; the uses are merged into one barrier.
+//
+// Masks are synchronization2 (64-bit) flags throughout, so callers can name
+// fine-grained stages such as COPY or INDEX_INPUT. When the device has
+// VK_KHR_synchronization2 enabled, flush() records vkCmdPipelineBarrier2KHR
+// and every barrier keeps its own stage masks. Otherwise the masks are folded
+// to their legacy equivalents and ORed into the stage pair of one
+// vkCmdPipelineBarrier.
+//
+// The tracker is not thread-safe; use one per recording thread.
+//
+
+#ifndef COMMON_RESOURCE_STATE_TRACKER_H
+#define COMMON_RESOURCE_STATE_TRACKER_H
+
+#include "device_dispatch.h"
+#include <map>
+#include <unordered_map>
+
+// Access bits that modify memory.
+constexpr VkAccessFlags2 write_access_mask =
+        VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT |
+        VK_ACCESS_2_HOST_WRITE_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+
+// True if the extension list contains VK_KHR_synchronization2.
+bool synchronization2_supported(const std::vector<VkExtensionProperties> &available_extensions);
+
+// The access a command has to an image in the given layout, for callers that
+// only know the layout.
+VkAccessFlags2 access_for_layout(VkImageLayout layout);
+
+// Nearest legacy masks for synchronization2 masks; split stages and accesses
+// fold into the legacy bit that covers them.
+VkPipelineStageFlags legacy_stage_flags(VkPipelineStageFlags2 stages);
+VkAccessFlags legacy_access_flags(VkAccessFlags2 access);
+
+// Records synchronization2 barriers: through vkCmdPipelineBarrier2KHR when the
+// device has it, otherwise folded into a single vkCmdPipelineBarrier whose
+// stage pair is the union of every barrier's masks.
+class BarrierRecorder {
+public:
+    // use_synchronization2 requires the extension and its feature to be
+    // enabled on the device; it is ignored if vkCmdPipelineBarrier2KHR did not
+    // load.
+    void init(const DeviceDispatch &dispatch, bool use_synchronization2 = false) {
+        dispatch_ = &dispatch;
+        synchronization2_ = use_synchronization2 && dispatch.vkCmdPipelineBarrier2KHR != nullptr;
+    }
+    bool synchronization2() const { return synchronization2_; }
+
+    // Does nothing if both counts are zero.
+    void record(VkCommandBuffer command_buffer,
+                uint32_t buffer_barrier_count, const VkBufferMemoryBarrier2 *buffer_barriers,
+                uint32_t image_barrier_count, const VkImageMemoryBarrier2 *image_barriers);
+
+private:
+    const DeviceDispatch              *dispatch_{nullptr};
+    bool                               synchronization2_{false};
+    // Scratch space for the legacy path.
+    std::vector<VkBufferMemoryBarrier> legacy_buffer_barriers_;
+    std::vector<VkImageMemoryBarrier>  legacy_image_barriers_;
+};
+
+struct ResourceState {
+    VkPipelineStageFlags2 write_stages{0};     // stages of the last write or layout transition
+    VkAccessFlags2        write_access{0};
+    VkPipelineStageFlags2 read_stages{0};      // stages that read since the last write
+    VkPipelineStageFlags2 visible_stages{0};   // stages the last write is visible to
+    VkAccessFlags2        visible_access{0};
+    VkImageLayout         layout{VK_IMAGE_LAYOUT_UNDEFINED};
+    uint32_t              queue_family{VK_QUEUE_FAMILY_IGNORED};
+};
+
+class ResourceStateTracker {
+public:
+    ResourceStateTracker() = default;
+    explicit ResourceStateTracker(const DeviceDispatch &dispatch, bool use_synchronization2 = false) {
+        init(dispatch, use_synchronization2);
+    }
+
+    // See BarrierRecorder::init.
+    void init(const DeviceDispatch &dispatch, bool use_synchronization2 = false) {
+        recorder_.init(dispatch, use_synchronization2);
+    }
+    bool synchronization2() const { return recorder_.synchronization2(); }
+
+    // Images must be registered before use. Registering again resets the
+    // state, e.g. for a swapchain image coming back from the presentation
+    // engine.
+    void track_image(VkImage image, VkImageAspectFlags aspect, uint32_t mip_levels, uint32_t array_layers,
+                     VkImageLayout initial_layout = VK_IMAGE_LAYOUT_UNDEFINED);
+    // As above, for images whose last use happened outside the tracker, e.g.
+    // write_stages set to the stage a swapchain acquire semaphore is waited on.
+    void track_image(VkImage image, VkImageAspectFlags aspect, uint32_t mip_levels, uint32_t array_layers,
+                     const ResourceState &initial_state);
+    bool is_tracked(VkImage image) const { return images_.count(image) != 0; }
+    // Last known layout of a subresource.
+    VkImageLayout image_layout(VkImage image, uint32_t mip_level = 0, uint32_t array_layer = 0) const;
+    // Buffers start out untouched and need no registration. Forget a
+    // resource only while no barriers are pending.
+    void forget(VkBuffer buffer) { buffers_.erase(buffer); }
+    void forget(VkImage image) { images_.erase(image); }
+
+    void use_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size,
+                    VkPipelineStageFlags2 stages, VkAccessFlags2 access,
+                    uint32_t queue_family = VK_QUEUE_FAMILY_IGNORED);
+    bool use_image(VkImage image, const VkImageSubresourceRange &range,
+                   VkPipelineStageFlags2 stages, VkAccessFlags2 access, VkImageLayout layout,
+                   uint32_t queue_family = VK_QUEUE_FAMILY_IGNORED);
+
+    // Records every pending barrier in one call. Does nothing if none are
+    // pending.
+    void flush(VkCommandBuffer command_buffer);
+    bool has_pending() const { return !buffer_barriers_.empty() || !image_barriers_.empty(); }
+
+    uint32_t barrier_calls() const { return barrier_calls_; }
+    uint32_t barriers_recorded() const { return barriers_recorded_; }
+
+private:
+    struct ImageState {
+        VkImageAspectFlags         aspect{0};
+        uint32_t                   mip_levels{1};
+        uint32_t                   array_layers{1};
+        std::vector<ResourceState> subresources;   // mip-major
+        std::vector<int32_t>       pending;        // index into image_barriers_, or -1
+    };
+    struct BufferRange {
+        VkDeviceSize  end{0};
+        ResourceState state;
+        int32_t       pending{-1};                 // index into buffer_barriers_, or -1
+    };
+    using BufferRanges = std::map<VkDeviceSize, BufferRange>;   // keyed by range start
+
+    // Decides whether going from state to the new use needs a barrier, fills
+    // in its masks and updates state. Returns false if no barrier is needed.
+    bool transition(ResourceState &state, VkPipelineStageFlags2 stages, VkAccessFlags2 access, VkImageLayout layout,
+                    uint32_t queue_family, VkAccessFlags2 &src_access, VkPipelineStageFlags2 &src_stages);
+    void split(BufferRanges &ranges, VkDeviceSize offset);
+
+    BarrierRecorder                             recorder_;
+    std::unordered_map<VkBuffer, BufferRanges>  buffers_;
+    std::unordered_map<VkImage, ImageState>     images_;
+    std::vector<VkBufferMemoryBarrier2>         buffer_barriers_;
+    std::vector<VkImageMemoryBarrier2>          image_barriers_;
+    std::vector<BufferRange *>                  pending_ranges_;
+    std::vector<VkImage>                        pending_images_;
+    uint32_t                                    barrier_calls_{0};
+    uint32_t                                    barriers_recorded_{0};
+};
+
+#endif // COMMON_RESOURCE_STATE_TRACKER_H
@@ -0,0 +1,89 @@
+//
+// Frame-partitioned streaming ring buffer.
+//
+
+#include "ring_buffer.h"
+#include <algorithm>
+#include <iostream>
+
+FrameRingBuffer::~FrameRingBuffer() {
+    destroy();
+}
+
+bool FrameRingBuffer::init(MemoryAllocator &allocator,
+                           const DeviceDispatch &dispatch,
+                           const VkPhysicalDeviceLimits &limits,
+                           VkDeviceSize frame_size,
+                           uint32_t frame_count,
+                           VkBufferUsageFlags usage) {
+    if (frame_count == 0 || frame_size == 0) {
+        return false;
+    }
+    uniform_alignment_ = std::max<VkDeviceSize>(limits.minUniformBufferOffsetAlignment, 1);
+    storage_alignment_ = std::max<VkDeviceSize>(limits.minStorageBufferOffsetAlignment, 1);
+    // Partitions start on a boundary that suits every slice kind and lets a
+    // frame be flushed without touching its neighbours.
+    VkDeviceSize partition_alignment = std::max({uniform_alignment_, storage_alignment_,
+                                                 std::max<VkDeviceSize>(limits.nonCoherentAtomSize, 1),
+                                                 VkDeviceSize{4}});
+    frame_size = (frame_size + partition_alignment - 1) / partition_alignment * partition_alignment;
+    // Dynamic offsets are 32-bit.
+    if (frame_size * frame_count > UINT32_MAX) {
+        std::cout << "Ring buffer does not fit in 32-bit dynamic offsets." << std::endl;
+        return false;
+    }
+
+    VkBufferCreateInfo buffer_create_info = {
+            VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            nullptr,
+            0,
+            frame_size * frame_count,
+            usage,
+            VK_SHARING_MODE_EXCLUSIVE,
+            0,
+            nullptr
+    };
+    VkResult result = dispatch.vkCreateBuffer(dispatch.device, &buffer_create_info, nullptr, &buffer_);
+    if (result != VK_SUCCESS) {
+        std::cout << "Could not create a ring buffer." << std::endl;
+        buffer_ = VK_NULL_HANDLE;
+        return false;
+    }
+    result = allocator.allocate_for_buffer(buffer_, MemoryUsage::Dynamic, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, memory_);
+    if (result != VK_SUCCESS) {
+        std::cout << "Could not allocate memory for a ring buffer." << std::endl;
+        dispatch.vkDestroyBuffer(dispatch.device, buffer_, nullptr);
+        buffer_ = VK_NULL_HANDLE;
+        return false;
+    }
+
+    allocator_ = &allocator;
+    dispatch_ = &dispatch;
+    frame_size_ = frame_size;
+    frame_count_ = frame_count;
+    begin_frame(0);
+    return true;
+}
+
+void FrameRingBuffer::destroy() {
+    if (buffer_ == VK_NULL_HANDLE) {
+        return;
+    }
+    dispatch_->vkDestroyBuffer(dispatch_->device, buffer_, nullptr);
+    allocator_->free(memory_);
+    buffer_ = VK_NULL_HANDLE;
+    frame_begin_ = frame_end_ = head_ = 0;
+}
+
+void FrameRingBuffer::begin_frame(uint32_t frame_index) {
+    frame_begin_ = VkDeviceSize{frame_index % frame_count_} * frame_size_;
+    frame_end_ = frame_begin_ + frame_size_;
+    head_ = frame_begin_;
+}
+
+VkResult FrameRingBuffer::flush() {
+    if (head_ == frame_begin_) {
+        return VK_SUCCESS;
+    }
+    return allocator_->flush(memory_, frame_begin_, head_ - frame_begin_);
+}
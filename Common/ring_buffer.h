@@ -0,0 +1,110 @@
+//
+// Persistently mapped, frame-partitioned ring buffer for streaming data.
+//
+// One VkBuffer is split into frame_count equal partitions. Each frame the
+// caller moves to its own partition with begin_frame() and carves aligned
+// slices out of it with a pointer bump; nothing is allocated or mapped per
+// slice. Uniform slices honour minUniformBufferOffsetAlignment so they can be
+// bound through a single UNIFORM_BUFFER_DYNAMIC descriptor whose dynamic
+// offset is the slice offset.
+//
+// A partition is reused frame_count frames later, so the caller must have
+// waited for the GPU work that read it (typically the fence of that frame)
+// before calling begin_frame() for it again.
+//
+
+#ifndef COMMON_RING_BUFFER_H
+#define COMMON_RING_BUFFER_H
+
+#include "memory_allocator.h"
+#include <cstring>
+
+struct RingAllocation {
+    VkBuffer     buffer{VK_NULL_HANDLE};
+    VkDeviceSize offset{0};
+    VkDeviceSize size{0};
+    void        *mapped{nullptr};
+
+    // Offset to pass to vkCmdBindDescriptorSets for a dynamic descriptor.
+    uint32_t dynamic_offset() const { return static_cast<uint32_t>(offset); }
+};
+
+class FrameRingBuffer {
+public:
+    static constexpr VkBufferUsageFlags default_usage =
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+
+    FrameRingBuffer() = default;
+    ~FrameRingBuffer();
+    FrameRingBuffer(const FrameRingBuffer &) = delete;
+    FrameRingBuffer &operator=(const FrameRingBuffer &) = delete;
+
+    bool init(MemoryAllocator &allocator,
+              const DeviceDispatch &dispatch,
+              const VkPhysicalDeviceLimits &limits,
+              VkDeviceSize frame_size,
+              uint32_t frame_count,
+              VkBufferUsageFlags usage = default_usage);
+    void destroy();
+    bool valid() const { return buffer_ != VK_NULL_HANDLE; }
+
+    // Switches to the partition of frame_index % frame_count and empties it.
+    void begin_frame(uint32_t frame_index);
+
+    bool allocate(VkDeviceSize size, VkDeviceSize alignment, RingAllocation &allocation) {
+        VkDeviceSize offset = (head_ + alignment - 1) / alignment * alignment;
+        if (offset + size > frame_end_) {
+            return false;
+        }
+        head_ = offset + size;
+        allocation.buffer = buffer_;
+        allocation.offset = offset;
+        allocation.size = size;
+        allocation.mapped = static_cast<char *>(memory_.mapped) + offset;
+        return true;
+    }
+    bool allocate_uniform(VkDeviceSize size, RingAllocation &allocation) {
+        return allocate(size, uniform_alignment_, allocation);
+    }
+    bool allocate_storage(VkDeviceSize size, RingAllocation &allocation) {
+        return allocate(size, storage_alignment_, allocation);
+    }
+    // Vertex and 32-bit index data only need 4-byte alignment.
+    bool allocate_vertex(VkDeviceSize size, RingAllocation &allocation) {
+        return allocate(size, 4, allocation);
+    }
+
+    // Copies value into a fresh uniform slice.
+    template<typename T>
+    bool push_uniform(const T &value, RingAllocation &allocation) {
+        if (!allocate_uniform(sizeof(T), allocation)) {
+            return false;
+        }
+        std::memcpy(allocation.mapped, &value, sizeof(T));
+        return true;
+    }
+
+    // Makes this frame's writes visible to the device. Does nothing for
+    // host-coherent memory. Call once per frame before submitting.
+    VkResult flush();
+
+    VkBuffer buffer() const { return buffer_; }
+    VkDeviceSize frame_size() const { return frame_size_; }
+    VkDeviceSize frame_used() const { return head_ - frame_begin_; }
+
+private:
+    MemoryAllocator      *allocator_{nullptr};
+    const DeviceDispatch *dispatch_{nullptr};
+    VkBuffer              buffer_{VK_NULL_HANDLE};
+    MemoryAllocation      memory_;
+    VkDeviceSize          frame_size_{0};
+    uint32_t              frame_count_{0};
+    VkDeviceSize          uniform_alignment_{1};
+    VkDeviceSize          storage_alignment_{1};
+    VkDeviceSize          frame_begin_{0};
+    VkDeviceSize          frame_end_{0};
+    VkDeviceSize          head_{0};
+};
+
+#endif // COMMON_RING_BUFFER_H
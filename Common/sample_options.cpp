@@ -0,0 +1,96 @@
+//
+// Command-line options shared by the samples.
+//
+
+#include "sample_options.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+bool parse_presentation_mode(const char *value, PresentationMode &mode) {
+    if (strcmp(value, "1") == 0 || strcmp(value, "offscreen") == 0) {
+        mode = PresentationMode::Offscreen;
+    } else if (strcmp(value, "surface") == 0) {
+        mode = PresentationMode::HeadlessSurface;
+    } else if (strcmp(value, "0") == 0 || strcmp(value, "window") == 0) {
+        mode = PresentationMode::Window;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void print_usage(const char *program) {
+    std::cout << "usage: " << program << " [--headless[=offscreen|surface]] [--frames N]"
+              << " [--capture BASENAME] [--capture-format ppm|raw]" << std::endl;
+}
+
+} // namespace
+
+const char *presentation_mode_name(PresentationMode mode) {
+    switch (mode) {
+        case PresentationMode::Window:          return "window";
+        case PresentationMode::HeadlessSurface: return "headless surface";
+        case PresentationMode::Offscreen:       return "offscreen";
+    }
+    return "unknown";
+}
+
+bool parse_sample_options(int argc, char *argv[], SampleOptions &options) {
+    options = SampleOptions{};
+    const char *environment = getenv("VULKAN_SAMPLES_HEADLESS");
+    if (environment != nullptr && environment[0] != '\0' &&
+        !parse_presentation_mode(environment, options.presentation)) {
+        std::cout << "Ignoring unknown VULKAN_SAMPLES_HEADLESS value '" << environment << "'." << std::endl;
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        const char *argument = argv[i];
+        if (strcmp(argument, "--headless") == 0) {
+            options.presentation = PresentationMode::Offscreen;
+        } else if (strncmp(argument, "--headless=", 11) == 0) {
+            if (!parse_presentation_mode(argument + 11, options.presentation)) {
+                print_usage(argv[0]);
+                return false;
+            }
+        } else if (strcmp(argument, "--frames") == 0 && i + 1 < argc) {
+            char *end = nullptr;
+            unsigned long frame_count = strtoul(argv[++i], &end, 10);
+            if (end == argv[i] || *end != '\0' || frame_count == 0 || frame_count > UINT32_MAX) {
+                print_usage(argv[0]);
+                return false;
+            }
+            options.frame_count = static_cast<uint32_t>(frame_count);
+        } else if (strcmp(argument, "--capture") == 0 && i + 1 < argc) {
+            options.capture_basename = argv[++i];
+        } else if (strcmp(argument, "--capture-format") == 0 && i + 1 < argc) {
+            const char *format = argv[++i];
+            if (strcmp(format, "ppm") == 0) {
+                options.capture_format = CaptureFileFormat::Ppm;
+            } else if (strcmp(format, "raw") == 0) {
+                options.capture_format = CaptureFileFormat::Raw;
+            } else {
+                print_usage(argv[0]);
+                return false;
+            }
+        } else {
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<char const *> presentation_instance_extensions(PresentationMode mode) {
+    switch (mode) {
+        case PresentationMode::Window:
+            return {VK_KHR_SURFACE_EXTENSION_NAME, VK_KHR_XCB_SURFACE_EXTENSION_NAME};
+        case PresentationMode::HeadlessSurface:
+            return {VK_KHR_SURFACE_EXTENSION_NAME, VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME};
+        case PresentationMode::Offscreen:
+            break;
+    }
+    return {};
+}
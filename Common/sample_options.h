@@ -0,0 +1,48 @@
+//
+// Command-line options shared by the samples.
+//
+// --headless[=offscreen|surface]   render without a window (default offscreen)
+// --frames N                       number of frames the frame loop renders
+// --capture BASENAME               write every frame to BASENAME_NNNN.ppm
+// --capture-format ppm|raw         file format of captured frames
+//
+// The VULKAN_SAMPLES_HEADLESS environment variable ("1", "offscreen" or
+// "surface") selects headless rendering too, so CI jobs can run every sample
+// unchanged. Offscreen mode renders into an OffscreenSwapchain and needs no
+// surface or swapchain extensions at all, which makes it usable on any ICD,
+// software ones such as lavapipe included. Surface mode goes through a real
+// VkSwapchainKHR on a VK_EXT_headless_surface surface, which exercises the
+// acquire/present path without a display.
+//
+
+#ifndef COMMON_SAMPLE_OPTIONS_H
+#define COMMON_SAMPLE_OPTIONS_H
+
+#include "frame_capture.h"
+#include "vulkan_dispatch.h"
+
+enum class PresentationMode {
+    Window,             // XCB window and surface
+    HeadlessSurface,    // VK_EXT_headless_surface and a swapchain
+    Offscreen           // OffscreenSwapchain, no WSI
+};
+
+struct SampleOptions {
+    PresentationMode  presentation{PresentationMode::Window};
+    uint32_t          frame_count{0};       // 0: the sample's own default
+    std::string       capture_basename;     // empty: no capture
+    CaptureFileFormat capture_format{CaptureFileFormat::Ppm};
+};
+
+const char *presentation_mode_name(PresentationMode mode);
+
+// Prints usage and returns false on an unknown or malformed argument.
+bool parse_sample_options(int argc, char *argv[], SampleOptions &options);
+
+// Instance extensions needed to present in the given mode.
+std::vector<char const *> presentation_instance_extensions(PresentationMode mode);
+
+// True unless frames go to an OffscreenSwapchain.
+inline bool uses_swapchain(PresentationMode mode) { return mode != PresentationMode::Offscreen; }
+
+#endif // COMMON_SAMPLE_OPTIONS_H
@@ -0,0 +1,103 @@
+//
+// Fixed-size host-visible staging chunks for streaming uploads.
+//
+
+#include "staging_pool.h"
+#include <iostream>
+
+StagingPool::~StagingPool() {
+    destroy();
+}
+
+bool StagingPool::init(const DeviceDispatch &dispatch, MemoryAllocator &allocator, TimelineQueue &timeline,
+                       VkDeviceSize chunk_size, uint32_t chunk_count) {
+    if (chunk_size == 0 || chunk_count == 0) {
+        std::cout << "A staging pool needs at least one non-empty chunk." << std::endl;
+        return false;
+    }
+    dispatch_ = &dispatch;
+    allocator_ = &allocator;
+    timeline_ = &timeline;
+    chunk_size_ = chunk_size;
+    current_ = 0;
+    statistics_ = StagingPoolStatistics{};
+    chunks_.resize(chunk_count);
+    for (auto &chunk : chunks_) {
+        VkBufferCreateInfo buffer_create_info = {
+                VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                nullptr,
+                0,
+                chunk_size,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_SHARING_MODE_EXCLUSIVE,
+                0,
+                nullptr
+        };
+        if (dispatch.vkCreateBuffer(dispatch.device, &buffer_create_info, nullptr, &chunk.buffer) != VK_SUCCESS) {
+            std::cout << "Could not create a staging buffer." << std::endl;
+            destroy();
+            return false;
+        }
+        if (allocator.allocate_for_buffer(chunk.buffer, MemoryUsage::Upload, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+                                          chunk.allocation) != VK_SUCCESS || chunk.allocation.mapped == nullptr) {
+            std::cout << "Could not allocate staging memory." << std::endl;
+            destroy();
+            return false;
+        }
+    }
+    return true;
+}
+
+void StagingPool::destroy() {
+    if (dispatch_ == nullptr) {
+        return;
+    }
+    timeline_->wait_idle();
+    for (auto &chunk : chunks_) {
+        dispatch_->vkDestroyBuffer(dispatch_->device, chunk.buffer, nullptr);
+        if (chunk.allocation.memory != VK_NULL_HANDLE) {
+            allocator_->free(chunk.allocation);
+        }
+    }
+    chunks_.clear();
+    dispatch_ = nullptr;
+    allocator_ = nullptr;
+    timeline_ = nullptr;
+}
+
+bool StagingPool::allocate(VkDeviceSize size, VkDeviceSize granularity, VkDeviceSize alignment, StagingSpan &span) {
+    Chunk &chunk = chunks_[current_];
+    VkDeviceSize offset = (chunk.offset + alignment - 1) / alignment * alignment;
+    if (offset > chunk_size_ || chunk_size_ - offset < granularity) {
+        return false;
+    }
+    VkDeviceSize available = (chunk_size_ - offset) / granularity * granularity;
+    span.buffer = chunk.buffer;
+    span.offset = offset;
+    span.size = size < available ? size : available;
+    span.mapped = static_cast<char *>(chunk.allocation.mapped) + offset;
+    chunk.offset = offset + span.size;
+    statistics_.bytes_staged += span.size;
+    return true;
+}
+
+VkResult StagingPool::flush(const StagingSpan &span) {
+    return allocator_->flush(chunks_[current_].allocation, span.offset, span.size);
+}
+
+VkResult StagingPool::advance() {
+    current_ = (current_ + 1) % static_cast<uint32_t>(chunks_.size());
+    ++statistics_.chunks_filled;
+    Chunk &chunk = chunks_[current_];
+    if (!timeline_->is_complete(chunk.value)) {
+        auto start = Clock::now();
+        VkResult result = timeline_->wait(chunk.value);
+        statistics_.stall_ms += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        ++statistics_.stalls;
+        if (result != VK_SUCCESS) {
+            return result;
+        }
+    }
+    chunk.offset = 0;
+    return VK_SUCCESS;
+}
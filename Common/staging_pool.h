@@ -0,0 +1,96 @@
+//
+// Fixed-size host-visible staging chunks for streaming uploads.
+//
+// The pool owns chunk_count persistently mapped buffers of chunk_size bytes,
+// used as a ring. Uploads are written into the current chunk at increasing
+// offsets. When it runs out, the owner submits the commands that read it and
+// calls advance(), which moves to the next chunk and blocks only if the GPU is
+// still copying out of that one. With two or more chunks the host fills one
+// while the GPU drains another, and uploads of any size stream through
+// chunk_count * chunk_size bytes of host memory.
+//
+// Chunks are stamped with the TimelineQueue value of the last submission that
+// reads them; retire() must be called for every submission that reads the
+// current chunk.
+//
+// The pool is not thread-safe.
+//
+
+#ifndef COMMON_STAGING_POOL_H
+#define COMMON_STAGING_POOL_H
+
+#include "memory_allocator.h"
+#include "timeline_queue.h"
+#include <chrono>
+
+// A piece of a chunk handed out by StagingPool::allocate().
+struct StagingSpan {
+    VkBuffer     buffer{VK_NULL_HANDLE};
+    VkDeviceSize offset{0};
+    VkDeviceSize size{0};
+    void        *mapped{nullptr};   // host pointer to offset
+};
+
+struct StagingPoolStatistics {
+    uint64_t bytes_staged{0};
+    uint32_t chunks_filled{0};   // times the ring moved on
+    uint32_t stalls{0};          // times advance() had to wait for the GPU
+    double   stall_ms{0.0};      // total time advance() waited
+};
+
+class StagingPool {
+public:
+    static constexpr VkDeviceSize default_chunk_size = 8ull * 1024 * 1024;
+    static constexpr uint32_t default_chunk_count = 2;
+
+    StagingPool() = default;
+    ~StagingPool();
+    StagingPool(const StagingPool &) = delete;
+    StagingPool &operator=(const StagingPool &) = delete;
+
+    // timeline is the queue that executes the copies out of the chunks.
+    bool init(const DeviceDispatch &dispatch, MemoryAllocator &allocator, TimelineQueue &timeline,
+              VkDeviceSize chunk_size = default_chunk_size, uint32_t chunk_count = default_chunk_count);
+    // Waits for the timeline and frees every chunk.
+    void destroy();
+
+    // Hands out size bytes of the current chunk, or as many whole multiples of
+    // granularity as are left, starting at a multiple of alignment. Only the
+    // bytes handed out are consumed, so a caller that can only use whole rows
+    // passes the row size and wastes nothing. Returns false if less than
+    // granularity is left; the caller then submits, retires and advances.
+    bool allocate(VkDeviceSize size, VkDeviceSize granularity, VkDeviceSize alignment, StagingSpan &span);
+    // Makes host writes to span visible to the device; call before
+    // advance(). Does nothing for host-coherent memory.
+    VkResult flush(const StagingSpan &span);
+    // Records that the submission with submitted_value reads the current chunk.
+    void retire(uint64_t submitted_value) { chunks_[current_].value = submitted_value; }
+    // Moves to the next chunk, waiting for the GPU to finish reading it.
+    VkResult advance();
+    // True if nothing has been written to the current chunk yet.
+    bool current_empty() const { return chunks_[current_].offset == 0; }
+
+    VkDeviceSize chunk_size() const { return chunk_size_; }
+    uint32_t chunk_count() const { return static_cast<uint32_t>(chunks_.size()); }
+    const StagingPoolStatistics &statistics() const { return statistics_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Chunk {
+        VkBuffer         buffer{VK_NULL_HANDLE};
+        MemoryAllocation allocation;
+        VkDeviceSize     offset{0};    // fill pointer
+        uint64_t         value{0};     // last submission reading the chunk
+    };
+
+    const DeviceDispatch  *dispatch_{nullptr};
+    MemoryAllocator       *allocator_{nullptr};
+    TimelineQueue         *timeline_{nullptr};
+    VkDeviceSize           chunk_size_{0};
+    std::vector<Chunk>     chunks_;
+    uint32_t               current_{0};
+    StagingPoolStatistics  statistics_;
+};
+
+#endif // COMMON_STAGING_POOL_H
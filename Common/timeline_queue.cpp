@@ -0,0 +1,237 @@
+//
+// Timeline-semaphore submission with a fence fallback.
+//
+
+#include "timeline_queue.h"
+#include <cstring>
+#include <iostream>
+
+bool timeline_semaphore_supported(const std::vector<VkExtensionProperties> &available_extensions) {
+    for (const auto &extension : available_extensions) {
+        if (std::strcmp(extension.extensionName, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TimelineQueue::~TimelineQueue() {
+    destroy();
+}
+
+bool TimelineQueue::init(const DeviceDispatch &dispatch, VkQueue queue, bool use_timeline_semaphore) {
+    dispatch_ = &dispatch;
+    queue_ = queue;
+    last_submitted_ = 0;
+    completed_ = 0;
+    if (!use_timeline_semaphore) {
+        return true;
+    }
+    if (dispatch.vkGetSemaphoreCounterValueKHR == nullptr || dispatch.vkWaitSemaphoresKHR == nullptr) {
+        std::cout << "VK_KHR_timeline_semaphore is not enabled on this device." << std::endl;
+        return false;
+    }
+    VkSemaphoreTypeCreateInfo semaphore_type_create_info = {
+            VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+            nullptr,
+            VK_SEMAPHORE_TYPE_TIMELINE,
+            0
+    };
+    VkSemaphoreCreateInfo semaphore_create_info = {
+            VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            &semaphore_type_create_info,
+            0
+    };
+    if (dispatch.vkCreateSemaphore(dispatch.device, &semaphore_create_info, nullptr, &semaphore_) != VK_SUCCESS) {
+        std::cout << "Could not create a timeline semaphore." << std::endl;
+        semaphore_ = VK_NULL_HANDLE;
+        return false;
+    }
+    return true;
+}
+
+void TimelineQueue::destroy() {
+    if (dispatch_ == nullptr) {
+        return;
+    }
+    wait_idle();
+    if (semaphore_ != VK_NULL_HANDLE) {
+        dispatch_->vkDestroySemaphore(dispatch_->device, semaphore_, nullptr);
+        semaphore_ = VK_NULL_HANDLE;
+    }
+    for (const auto &pending : pending_fences_) {
+        dispatch_->vkDestroyFence(dispatch_->device, pending.fence, nullptr);
+    }
+    for (auto fence : free_fences_) {
+        dispatch_->vkDestroyFence(dispatch_->device, fence, nullptr);
+    }
+    for (auto fence : signalled_fences_) {
+        dispatch_->vkDestroyFence(dispatch_->device, fence, nullptr);
+    }
+    pending_fences_.clear();
+    free_fences_.clear();
+    signalled_fences_.clear();
+    dispatch_ = nullptr;
+}
+
+VkFence TimelineQueue::acquire_fence() {
+    if (!free_fences_.empty()) {
+        VkFence fence = free_fences_.back();
+        free_fences_.pop_back();
+        return fence;
+    }
+    VkFenceCreateInfo fence_create_info = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, nullptr, 0};
+    VkFence fence{VK_NULL_HANDLE};
+    if (dispatch_->vkCreateFence(dispatch_->device, &fence_create_info, nullptr, &fence) != VK_SUCCESS) {
+        std::cout << "Could not create a fence." << std::endl;
+        return VK_NULL_HANDLE;
+    }
+    return fence;
+}
+
+// Fences signal in submission order on one queue, so only the oldest ones
+// need checking.
+void TimelineQueue::retire_fences() {
+    while (!pending_fences_.empty() &&
+           dispatch_->vkGetFenceStatus(dispatch_->device, pending_fences_.front().fence) == VK_SUCCESS) {
+        signalled_fences_.push_back(pending_fences_.front().fence);
+        advance_completed(pending_fences_.front().value);
+        pending_fences_.pop_front();
+    }
+    // A wait() outside the lock may still hold any of them, and resetting a
+    // fence under it would block the waiter until the fence is reused.
+    if (waiters_ == 0 && !signalled_fences_.empty()) {
+        dispatch_->vkResetFences(dispatch_->device, static_cast<uint32_t>(signalled_fences_.size()),
+                                 signalled_fences_.data());
+        free_fences_.insert(free_fences_.end(), signalled_fences_.begin(), signalled_fences_.end());
+        signalled_fences_.clear();
+    }
+}
+
+// Another thread may read a newer value at the same time; keep the larger.
+void TimelineQueue::advance_completed(uint64_t value) {
+    uint64_t completed = completed_.load();
+    while (value > completed && !completed_.compare_exchange_weak(completed, value)) {
+    }
+}
+
+VkResult TimelineQueue::submit(uint32_t command_buffer_count, const VkCommandBuffer *command_buffers,
+                               uint64_t &submitted_value,
+                               uint32_t wait_semaphore_count, const VkSemaphore *wait_semaphores,
+                               const VkPipelineStageFlags *wait_stages,
+                               uint32_t signal_semaphore_count, const VkSemaphore *signal_semaphores) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t value = last_submitted_ + 1;
+
+    VkSubmitInfo submit_info = {
+            VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            nullptr,
+            wait_semaphore_count,
+            wait_semaphores,
+            wait_stages,
+            command_buffer_count,
+            command_buffers,
+            signal_semaphore_count,
+            signal_semaphores
+    };
+    VkResult result;
+    if (semaphore_ != VK_NULL_HANDLE) {
+        // The timeline semaphore goes last; values for binary semaphores are
+        // ignored but the arrays must cover every entry.
+        std::vector<VkSemaphore> signals(signal_semaphores, signal_semaphores + signal_semaphore_count);
+        signals.push_back(semaphore_);
+        std::vector<uint64_t> signal_values(signals.size(), 0);
+        signal_values.back() = value;
+        std::vector<uint64_t> wait_values(wait_semaphore_count, 0);
+        VkTimelineSemaphoreSubmitInfo timeline_submit_info = {
+                VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+                nullptr,
+                wait_semaphore_count,
+                wait_values.data(),
+                static_cast<uint32_t>(signal_values.size()),
+                signal_values.data()
+        };
+        submit_info.pNext = &timeline_submit_info;
+        submit_info.signalSemaphoreCount = static_cast<uint32_t>(signals.size());
+        submit_info.pSignalSemaphores = signals.data();
+        result = dispatch_->vkQueueSubmit(queue_, 1, &submit_info, VK_NULL_HANDLE);
+    } else {
+        retire_fences();
+        VkFence fence = acquire_fence();
+        if (fence == VK_NULL_HANDLE) {
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+        result = dispatch_->vkQueueSubmit(queue_, 1, &submit_info, fence);
+        if (result == VK_SUCCESS) {
+            pending_fences_.push_back({value, fence});
+        } else {
+            free_fences_.push_back(fence);
+        }
+    }
+    if (result != VK_SUCCESS) {
+        std::cout << "Error occurred during command buffer submission." << std::endl;
+        return result;
+    }
+    last_submitted_ = value;
+    submitted_value = value;
+    return VK_SUCCESS;
+}
+
+uint64_t TimelineQueue::completed_value() {
+    if (semaphore_ != VK_NULL_HANDLE) {
+        uint64_t value{0};
+        if (dispatch_->vkGetSemaphoreCounterValueKHR(dispatch_->device, semaphore_, &value) == VK_SUCCESS) {
+            advance_completed(value);
+        }
+        return completed_;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    retire_fences();
+    return completed_;
+}
+
+VkResult TimelineQueue::wait(uint64_t value, uint64_t timeout) {
+    if (value <= completed_) {
+        return VK_SUCCESS;
+    }
+    if (value > last_submitted_) {
+        // Never submitted, so it cannot complete; waiting on the semaphore
+        // for it would block until the timeout.
+        return VK_NOT_READY;
+    }
+    if (semaphore_ != VK_NULL_HANDLE) {
+        VkSemaphoreWaitInfo wait_info = {
+                VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                nullptr,
+                0,
+                1,
+                &semaphore_,
+                &value
+        };
+        VkResult result = dispatch_->vkWaitSemaphoresKHR(dispatch_->device, &wait_info, timeout);
+        if (result == VK_SUCCESS) {
+            completed_value();
+        }
+        return result;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    retire_fences();
+    if (value <= completed_) {
+        return VK_SUCCESS;
+    }
+    // Values are consecutive, so the fence for value sits at a fixed distance
+    // from the oldest pending one. submit() records the fence before it
+    // publishes the value, so value, which is submitted but not complete,
+    // is pending.
+    VkFence fence = pending_fences_[value - pending_fences_.front().value].fence;
+    // Block without the lock so submit() and the queries on other threads
+    // keep going; waiters_ stops the fence from being reset meanwhile.
+    ++waiters_;
+    lock.unlock();
+    VkResult result = dispatch_->vkWaitForFences(dispatch_->device, 1, &fence, VK_TRUE, timeout);
+    lock.lock();
+    --waiters_;
+    retire_fences();
+    return result;
+}
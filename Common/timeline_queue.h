@@ -0,0 +1,83 @@
+//
+// Queue submission tracked by a monotonically increasing counter.
+//
+// Every submit() signals the next value of a VK_KHR_timeline_semaphore, so
+// "has the GPU finished this work" becomes "has the counter reached N". The
+// last value read back from the device is cached, which makes is_complete()
+// an integer compare in the common case and lets resource retirement be keyed
+// on submission values instead of fence objects.
+//
+// Devices without the extension get the same interface backed by a small
+// pool of recycled fences, one per submission still in flight.
+//
+
+#ifndef COMMON_TIMELINE_QUEUE_H
+#define COMMON_TIMELINE_QUEUE_H
+
+#include "device_dispatch.h"
+#include <atomic>
+#include <deque>
+#include <mutex>
+
+// True if the extension list contains VK_KHR_timeline_semaphore.
+bool timeline_semaphore_supported(const std::vector<VkExtensionProperties> &available_extensions);
+
+class TimelineQueue {
+public:
+    TimelineQueue() = default;
+    ~TimelineQueue();
+    TimelineQueue(const TimelineQueue &) = delete;
+    TimelineQueue &operator=(const TimelineQueue &) = delete;
+
+    // use_timeline_semaphore requires the extension and its feature to be
+    // enabled on the device.
+    bool init(const DeviceDispatch &dispatch, VkQueue queue, bool use_timeline_semaphore);
+    // Waits for everything submitted through this queue.
+    void destroy();
+
+    // Submits command buffers and returns the value that marks their
+    // completion. Binary semaphores may still be waited on and signalled, for
+    // swapchain acquire and present.
+    VkResult submit(uint32_t command_buffer_count, const VkCommandBuffer *command_buffers,
+                    uint64_t &submitted_value,
+                    uint32_t wait_semaphore_count = 0, const VkSemaphore *wait_semaphores = nullptr,
+                    const VkPipelineStageFlags *wait_stages = nullptr,
+                    uint32_t signal_semaphore_count = 0, const VkSemaphore *signal_semaphores = nullptr);
+
+    // Reads the counter back from the device.
+    uint64_t completed_value();
+    bool is_complete(uint64_t value) {
+        return value <= completed_ || value <= completed_value();
+    }
+    // Returns VK_NOT_READY for a value that has not been submitted.
+    VkResult wait(uint64_t value, uint64_t timeout = UINT64_MAX);
+    VkResult wait_idle() { return wait(last_submitted_); }
+
+    uint64_t last_submitted_value() const { return last_submitted_; }
+    // The timeline semaphore, or VK_NULL_HANDLE on the fence fallback.
+    VkSemaphore semaphore() const { return semaphore_; }
+    VkQueue queue() const { return queue_; }
+
+private:
+    struct PendingFence {
+        uint64_t value;
+        VkFence  fence;
+    };
+
+    VkFence acquire_fence();
+    void retire_fences();
+    void advance_completed(uint64_t value);
+
+    const DeviceDispatch    *dispatch_{nullptr};
+    VkQueue                  queue_{VK_NULL_HANDLE};
+    VkSemaphore              semaphore_{VK_NULL_HANDLE};
+    std::atomic<uint64_t>    last_submitted_{0};
+    std::atomic<uint64_t>    completed_{0};
+    std::deque<PendingFence> pending_fences_;
+    std::vector<VkFence>     free_fences_;
+    std::vector<VkFence>     signalled_fences_;   // retired, reset once no wait() runs
+    uint32_t                 waiters_{0};         // wait() calls blocked on a fence
+    std::mutex               mutex_;
+};
+
+#endif // COMMON_TIMELINE_QUEUE_H
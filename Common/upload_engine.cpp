@@ -0,0 +1,408 @@
+//
+// Buffer and image uploads through a dedicated transfer queue.
+//
+
+#include "upload_engine.h"
+#include <cstring>
+#include <iostream>
+
+uint32_t find_transfer_queue_family(const std::vector<VkQueueFamilyProperties> &queue_families, uint32_t fallback) {
+    for (uint32_t index = 0; index < static_cast<uint32_t>(queue_families.size()); ++index) {
+        VkQueueFlags flags = queue_families[index].queueFlags;
+        if (queue_families[index].queueCount > 0 && (flags & VK_QUEUE_TRANSFER_BIT) != 0 &&
+            (flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) == 0) {
+            return index;
+        }
+    }
+    return fallback;
+}
+
+UploadEngine::~UploadEngine() {
+    destroy();
+}
+
+bool UploadEngine::init(const DeviceDispatch &dispatch, MemoryAllocator &allocator,
+                        VkQueue transfer_queue, uint32_t transfer_queue_family,
+                        TimelineQueue &consumer, uint32_t consumer_queue_family,
+                        bool use_timeline_semaphore, bool use_synchronization2,
+                        VkDeviceSize staging_chunk_size, uint32_t staging_chunk_count) {
+    if (!timeline_.init(dispatch, transfer_queue, use_timeline_semaphore)) {
+        return false;
+    }
+    if (!staging_.init(dispatch, allocator, timeline_, staging_chunk_size, staging_chunk_count)) {
+        timeline_.destroy();
+        return false;
+    }
+    if (!command_buffers_.init(dispatch, transfer_queue_family, command_pool_count)) {
+        std::cout << "Could not create the transfer command pools." << std::endl;
+        staging_.destroy();
+        timeline_.destroy();
+        return false;
+    }
+    flush_count_ = 0;
+    slot_values_.assign(command_pool_count, 0);
+    slot_open_ = false;
+    dispatch_ = &dispatch;
+    consumer_ = &consumer;
+    transfer_family_ = transfer_queue_family;
+    consumer_family_ = consumer_queue_family;
+    recorder_.init(dispatch, use_synchronization2);
+    return true;
+}
+
+void UploadEngine::destroy() {
+    if (dispatch_ == nullptr) {
+        return;
+    }
+    // A batch still being recorded was never submitted and can go at once.
+    if (recording_.command_buffer != VK_NULL_HANDLE) {
+        dispatch_->vkEndCommandBuffer(recording_.command_buffer);
+        recording_ = Batch{};
+    }
+    timeline_.wait_idle();
+    collect();
+    staging_.destroy();
+    if (!waited_semaphores_.empty()) {
+        consumer_->wait(waited_semaphores_.back().consumer_value);
+    }
+    for (const auto &waited : waited_semaphores_) {
+        dispatch_->vkDestroySemaphore(dispatch_->device, waited.semaphore, nullptr);
+    }
+    for (const auto &handoff : handoffs_) {
+        dispatch_->vkDestroySemaphore(dispatch_->device, handoff.semaphore, nullptr);
+    }
+    for (auto semaphore : free_semaphores_) {
+        dispatch_->vkDestroySemaphore(dispatch_->device, semaphore, nullptr);
+    }
+    // Destroying the pools frees every command buffer allocated from them.
+    command_buffers_.destroy();
+    timeline_.destroy();
+
+    slot_values_.clear();
+    slot_open_ = false;
+    release_buffer_barriers_.clear();
+    release_image_barriers_.clear();
+    acquire_buffer_barriers_.clear();
+    acquire_image_barriers_.clear();
+    handoffs_.clear();
+    waited_semaphores_.clear();
+    free_semaphores_.clear();
+    dispatch_ = nullptr;
+    consumer_ = nullptr;
+}
+
+bool UploadEngine::begin_batch() {
+    if (recording_.command_buffer != VK_NULL_HANDLE) {
+        return true;
+    }
+    if (!slot_open_) {
+        // The slot's pool is reset whole, so every batch recorded from it
+        // the last time round must have completed.
+        uint32_t slot = flush_count_ % command_pool_count;
+        if (timeline_.wait(slot_values_[slot]) != VK_SUCCESS ||
+            command_buffers_.begin_frame(flush_count_) != VK_SUCCESS) {
+            std::cout << "Could not recycle a transfer command pool." << std::endl;
+            return false;
+        }
+        slot_open_ = true;
+    }
+    VkCommandBuffer command_buffer{VK_NULL_HANDLE};
+    if (command_buffers_.allocate(command_buffer) != VK_SUCCESS) {
+        std::cout << "Could not allocate a transfer command buffer." << std::endl;
+        return false;
+    }
+    const VkCommandBufferBeginInfo begin_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            nullptr,
+            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            nullptr
+    };
+    if (dispatch_->vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+        std::cout << "Could not begin a transfer command buffer." << std::endl;
+        return false;
+    }
+    recording_.command_buffer = command_buffer;
+    return true;
+}
+
+bool UploadEngine::next_chunk() {
+    uint64_t value;
+    if (submit_batch(false, value) != VK_SUCCESS || staging_.advance() != VK_SUCCESS) {
+        std::cout << "Could not recycle a staging chunk." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool UploadEngine::upload_buffer(VkBuffer buffer, VkDeviceSize offset, const void *data, VkDeviceSize size,
+                                 VkPipelineStageFlags2 dst_stages, VkAccessFlags2 dst_access) {
+    if (size == 0) {
+        return true;
+    }
+    // Streamed in pieces as large as the current chunk has room for.
+    const char *source = static_cast<const char *>(data);
+    VkDeviceSize copied = 0;
+    while (copied < size) {
+        if (!begin_batch()) {
+            return false;
+        }
+        StagingSpan span;
+        if (!staging_.allocate(size - copied, 1, 4, span)) {
+            if (!next_chunk()) {
+                return false;
+            }
+            continue;
+        }
+        std::memcpy(span.mapped, source + copied, span.size);
+        if (staging_.flush(span) != VK_SUCCESS) {
+            return false;
+        }
+        const VkBufferCopy region = {span.offset, offset + copied, span.size};
+        dispatch_->vkCmdCopyBuffer(recording_.command_buffer, span.buffer, buffer, 1, &region);
+        copied += span.size;
+    }
+
+    bool transfer_ownership = dedicated_queue();
+    release_buffer_barriers_.push_back({
+            VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            nullptr,
+            VK_PIPELINE_STAGE_2_COPY_BIT,
+            VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            transfer_ownership ? VK_PIPELINE_STAGE_2_NONE : dst_stages,
+            transfer_ownership ? VK_ACCESS_2_NONE : dst_access,
+            transfer_ownership ? transfer_family_ : VK_QUEUE_FAMILY_IGNORED,
+            transfer_ownership ? consumer_family_ : VK_QUEUE_FAMILY_IGNORED,
+            buffer,
+            offset,
+            size
+    });
+    if (transfer_ownership) {
+        // The acquire's source stages chain it to the semaphore wait.
+        VkBufferMemoryBarrier2 acquire = release_buffer_barriers_.back();
+        acquire.srcStageMask = dst_stages;
+        acquire.srcAccessMask = VK_ACCESS_2_NONE;
+        acquire.dstStageMask = dst_stages;
+        acquire.dstAccessMask = dst_access;
+        acquire_buffer_barriers_.push_back(acquire);
+    }
+    recording_stages_ |= dst_stages;
+    bytes_uploaded_ += size;
+    return true;
+}
+
+bool UploadEngine::upload_image(VkImage image, VkImageAspectFlags aspect, VkExtent3D extent, uint32_t array_layers,
+                                const void *data, VkDeviceSize size, VkImageLayout final_layout,
+                                VkPipelineStageFlags2 dst_stages, VkAccessFlags2 dst_access) {
+    if (array_layers == 0 || extent.height == 0 || size % (array_layers * extent.height) != 0) {
+        std::cout << "Image data does not match its extent." << std::endl;
+        return false;
+    }
+    VkDeviceSize row_size = size / (array_layers * extent.height);
+    const char *source = static_cast<const char *>(data);
+    auto copy_rows = [&](uint32_t layer, uint32_t first_row, uint32_t row_count, void *destination) {
+        std::memcpy(destination, source + (VkDeviceSize(layer) * extent.height + first_row) * row_size,
+                    row_count * row_size);
+    };
+    return upload_image(image, aspect, extent, array_layers, row_size, copy_rows, final_layout, dst_stages, dst_access);
+}
+
+bool UploadEngine::upload_image(VkImage image, VkImageAspectFlags aspect, VkExtent3D extent, uint32_t array_layers,
+                                VkDeviceSize row_size, const RowWriter &write_rows, VkImageLayout final_layout,
+                                VkPipelineStageFlags2 dst_stages, VkAccessFlags2 dst_access) {
+    if (array_layers == 0 || extent.width == 0 || extent.height == 0 || row_size == 0 ||
+        row_size % extent.width != 0) {
+        std::cout << "Image data does not match its extent." << std::endl;
+        return false;
+    }
+    VkDeviceSize texel_size = row_size / extent.width;
+    if (row_size > staging_.chunk_size()) {
+        std::cout << "A row of the image does not fit in a staging chunk." << std::endl;
+        return false;
+    }
+    // Buffer offsets of image copies must be multiples of both 4 and the texel size.
+    VkDeviceSize alignment = texel_size % 4 == 0 ? texel_size : texel_size % 2 == 0 ? texel_size * 2 : texel_size * 4;
+    if (!begin_batch()) {
+        return false;
+    }
+    const VkImageSubresourceRange range = {aspect, 0, 1, 0, array_layers};
+    const VkImageMemoryBarrier2 to_transfer = {
+            VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            nullptr,
+            VK_PIPELINE_STAGE_2_NONE,
+            VK_ACCESS_2_NONE,
+            VK_PIPELINE_STAGE_2_COPY_BIT,
+            VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_QUEUE_FAMILY_IGNORED,
+            VK_QUEUE_FAMILY_IGNORED,
+            image,
+            range
+    };
+    recorder_.record(recording_.command_buffer, 0, nullptr, 1, &to_transfer);
+
+    // Streamed in bands of whole rows; later batches run after the layout
+    // transition because they are submitted to the same queue.
+    for (uint32_t layer = 0; layer < array_layers; ++layer) {
+        uint32_t row = 0;
+        while (row < extent.height) {
+            if (!begin_batch()) {
+                return false;
+            }
+            StagingSpan span;
+            // Whole rows only, so the span is exactly what gets copied.
+            VkDeviceSize remaining = (extent.height - row) * row_size;
+            if (!staging_.allocate(remaining, row_size, alignment, span)) {
+                if (!next_chunk()) {
+                    return false;
+                }
+                continue;
+            }
+            uint32_t rows = static_cast<uint32_t>(span.size / row_size);
+            write_rows(layer, row, rows, span.mapped);
+            if (staging_.flush(span) != VK_SUCCESS) {
+                return false;
+            }
+            const VkBufferImageCopy region = {
+                    span.offset,
+                    0,
+                    0,
+                    {aspect, 0, layer, 1},
+                    {0, static_cast<int32_t>(row), 0},
+                    {extent.width, rows, 1}
+            };
+            dispatch_->vkCmdCopyBufferToImage(recording_.command_buffer, span.buffer, image,
+                                              VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+            row += rows;
+        }
+    }
+
+    // The layout transition is part of the ownership transfer and is
+    // described identically by both halves.
+    bool transfer_ownership = dedicated_queue();
+    release_image_barriers_.push_back({
+            VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            nullptr,
+            VK_PIPELINE_STAGE_2_COPY_BIT,
+            VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            transfer_ownership ? VK_PIPELINE_STAGE_2_NONE : dst_stages,
+            transfer_ownership ? VK_ACCESS_2_NONE : dst_access,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            final_layout,
+            transfer_ownership ? transfer_family_ : VK_QUEUE_FAMILY_IGNORED,
+            transfer_ownership ? consumer_family_ : VK_QUEUE_FAMILY_IGNORED,
+            image,
+            range
+    });
+    if (transfer_ownership) {
+        VkImageMemoryBarrier2 acquire = release_image_barriers_.back();
+        acquire.srcStageMask = dst_stages;
+        acquire.srcAccessMask = VK_ACCESS_2_NONE;
+        acquire.dstStageMask = dst_stages;
+        acquire.dstAccessMask = dst_access;
+        acquire_image_barriers_.push_back(acquire);
+    }
+    recording_stages_ |= dst_stages;
+    bytes_uploaded_ += row_size * extent.height * array_layers;
+    return true;
+}
+
+VkSemaphore UploadEngine::acquire_semaphore() {
+    if (!free_semaphores_.empty()) {
+        VkSemaphore semaphore = free_semaphores_.back();
+        free_semaphores_.pop_back();
+        return semaphore;
+    }
+    VkSemaphoreCreateInfo semaphore_create_info = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, nullptr, 0};
+    VkSemaphore semaphore{VK_NULL_HANDLE};
+    if (dispatch_->vkCreateSemaphore(dispatch_->device, &semaphore_create_info, nullptr, &semaphore) != VK_SUCCESS) {
+        std::cout << "Could not create a semaphore." << std::endl;
+        return VK_NULL_HANDLE;
+    }
+    return semaphore;
+}
+
+VkResult UploadEngine::submit_batch(bool handoff, uint64_t &value) {
+    value = 0;
+    if (recording_.command_buffer == VK_NULL_HANDLE) {
+        return VK_SUCCESS;
+    }
+    if (handoff) {
+        recorder_.record(recording_.command_buffer,
+                         static_cast<uint32_t>(release_buffer_barriers_.size()), release_buffer_barriers_.data(),
+                         static_cast<uint32_t>(release_image_barriers_.size()), release_image_barriers_.data());
+        release_buffer_barriers_.clear();
+        release_image_barriers_.clear();
+    }
+    VkResult result = dispatch_->vkEndCommandBuffer(recording_.command_buffer);
+    if (result != VK_SUCCESS) {
+        std::cout << "Error occurred during transfer command buffer recording." << std::endl;
+        return result;
+    }
+    // A semaphore signal covers everything submitted to the queue before it,
+    // so batches submitted early to free a chunk need none.
+    VkSemaphore semaphore{VK_NULL_HANDLE};
+    if (handoff) {
+        semaphore = acquire_semaphore();
+        if (semaphore == VK_NULL_HANDLE) {
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+    }
+    result = timeline_.submit(1, &recording_.command_buffer, recording_.value, 0, nullptr, nullptr,
+                              handoff ? 1u : 0u, &semaphore);
+    if (result != VK_SUCCESS) {
+        if (handoff) {
+            free_semaphores_.push_back(semaphore);
+        }
+        return result;
+    }
+    value = recording_.value;
+    staging_.retire(value);
+    if (handoff) {
+        handoffs_.push_back({semaphore, recording_stages_});
+        recording_stages_ = 0;
+    }
+    slot_values_[flush_count_ % command_pool_count] = value;
+    if (handoff) {
+        ++flush_count_;
+        slot_open_ = false;
+    }
+    recording_ = Batch{};
+    ++batches_submitted_;
+    return VK_SUCCESS;
+}
+
+VkResult UploadEngine::flush(uint64_t &value) {
+    return submit_batch(true, value);
+}
+
+uint32_t UploadEngine::acquire(VkCommandBuffer command_buffer, std::vector<VkSemaphore> &wait_semaphores,
+                               std::vector<VkPipelineStageFlags> &wait_stages) {
+    if (handoffs_.empty()) {
+        return 0;
+    }
+    recorder_.record(command_buffer,
+                     static_cast<uint32_t>(acquire_buffer_barriers_.size()), acquire_buffer_barriers_.data(),
+                     static_cast<uint32_t>(acquire_image_barriers_.size()), acquire_image_barriers_.data());
+    acquire_buffer_barriers_.clear();
+    acquire_image_barriers_.clear();
+
+    uint64_t consumer_value = consumer_->last_submitted_value() + 1;
+    for (const auto &handoff : handoffs_) {
+        VkPipelineStageFlags stages = legacy_stage_flags(handoff.stages);
+        wait_semaphores.push_back(handoff.semaphore);
+        wait_stages.push_back(stages != 0 ? stages
+                                       : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT));
+        waited_semaphores_.push_back({handoff.semaphore, consumer_value});
+    }
+    uint32_t count = static_cast<uint32_t>(handoffs_.size());
+    handoffs_.clear();
+    return count;
+}
+
+void UploadEngine::collect() {
+    while (!waited_semaphores_.empty() && consumer_->is_complete(waited_semaphores_.front().consumer_value)) {
+        free_semaphores_.push_back(waited_semaphores_.front().semaphore);
+        waited_semaphores_.pop_front();
+    }
+}
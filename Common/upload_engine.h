@@ -0,0 +1,159 @@
+//
+// Buffer and image uploads through a dedicated transfer queue.
+//
+// Staging copies are recorded into one batch command buffer on the transfer
+// queue family and submitted together by flush(), so texture and mesh uploads
+// run next to rendering instead of stalling the graphics queue.
+//
+// When the transfer family differs from the consumer's, the batch releases
+// every destination to the consumer family. The consumer calls acquire()
+// while recording the submission that first uses the data; it records the
+// matching acquire barriers and hands back the semaphores that submission
+// must wait on. On devices without a transfer-only family the engine runs on
+// the consumer's family, the ownership barriers disappear and the semaphore
+// alone orders the two submissions.
+//
+// Destinations must not have been used on another queue family before the
+// upload; images are written from VK_IMAGE_LAYOUT_UNDEFINED, so their previous
+// contents are discarded.
+//
+// Data is staged through a StagingPool, so uploads of any size use a bounded
+// amount of host memory. A batch is submitted early whenever it fills a
+// chunk, letting the GPU copy out of one chunk while the next is written;
+// only the last submission before a consumer waits signals a semaphore.
+//
+// Batch command buffers come from a CommandBufferAllocator with
+// command_pool_count transient pools. Each flush() moves on to the next
+// pool, and a pool is reset in one call once the transfer timeline has
+// passed its last batch, waiting only if the GPU is that many flushes
+// behind. collect() recycles semaphores once the consumer submission that
+// waited on them has completed.
+//
+// The engine is not thread-safe.
+//
+
+#ifndef COMMON_UPLOAD_ENGINE_H
+#define COMMON_UPLOAD_ENGINE_H
+
+#include "command_buffer_allocator.h"
+#include "resource_state_tracker.h"
+#include "staging_pool.h"
+#include <functional>
+
+// Index of a queue family that supports transfers but neither graphics nor
+// compute, or fallback if the device has none.
+uint32_t find_transfer_queue_family(const std::vector<VkQueueFamilyProperties> &queue_families, uint32_t fallback);
+
+class UploadEngine {
+public:
+    // Fills row_count tightly packed rows of one layer, starting at
+    // first_row, into staging memory at destination.
+    using RowWriter = std::function<void(uint32_t layer, uint32_t first_row, uint32_t row_count, void *destination)>;
+
+    static constexpr uint32_t command_pool_count = 3;
+
+    UploadEngine() = default;
+    ~UploadEngine();
+    UploadEngine(const UploadEngine &) = delete;
+    UploadEngine &operator=(const UploadEngine &) = delete;
+
+    // consumer is the queue whose submissions wait for the uploads.
+    // use_timeline_semaphore and use_synchronization2 require the extensions
+    // and features to be enabled on the device.
+    bool init(const DeviceDispatch &dispatch, MemoryAllocator &allocator,
+              VkQueue transfer_queue, uint32_t transfer_queue_family,
+              TimelineQueue &consumer, uint32_t consumer_queue_family,
+              bool use_timeline_semaphore, bool use_synchronization2 = false,
+              VkDeviceSize staging_chunk_size = StagingPool::default_chunk_size,
+              uint32_t staging_chunk_count = StagingPool::default_chunk_count);
+    // Waits for the transfer queue and destroys everything the engine owns.
+    void destroy();
+
+    bool dedicated_queue() const { return transfer_family_ != consumer_family_; }
+
+    // Copies size bytes of data to buffer at offset. dst_stages and
+    // dst_access describe the consumer's first use.
+    bool upload_buffer(VkBuffer buffer, VkDeviceSize offset, const void *data, VkDeviceSize size,
+                       VkPipelineStageFlags2 dst_stages, VkAccessFlags2 dst_access);
+    // Fills mip level 0 of the first array_layers layers of a 2D image from
+    // tightly packed data, one layer after another, and leaves the image in
+    // final_layout. A row of texels must fit in a staging chunk.
+    bool upload_image(VkImage image, VkImageAspectFlags aspect, VkExtent3D extent, uint32_t array_layers,
+                      const void *data, VkDeviceSize size, VkImageLayout final_layout,
+                      VkPipelineStageFlags2 dst_stages, VkAccessFlags2 dst_access);
+    // As above, with each band of rows produced by write_rows directly in
+    // staging memory, e.g. decoded from a file, instead of copied from data.
+    bool upload_image(VkImage image, VkImageAspectFlags aspect, VkExtent3D extent, uint32_t array_layers,
+                      VkDeviceSize row_size, const RowWriter &write_rows, VkImageLayout final_layout,
+                      VkPipelineStageFlags2 dst_stages, VkAccessFlags2 dst_access);
+
+    // Submits every upload queued since the last flush. value is the transfer
+    // timeline value that marks their completion, or 0 if nothing was queued.
+    VkResult flush(uint64_t &value);
+    // Records the acquire half of every flushed upload into command_buffer and
+    // appends the semaphores, with their wait stages, that its submission has
+    // to wait on. That must be the next submission to the consumer queue.
+    // Returns the number of semaphores appended.
+    uint32_t acquire(VkCommandBuffer command_buffer, std::vector<VkSemaphore> &wait_semaphores,
+                     std::vector<VkPipelineStageFlags> &wait_stages);
+    // True if flushed uploads are waiting for acquire().
+    bool acquire_pending() const { return !handoffs_.empty(); }
+    // Recycles the semaphores of completed handoffs. Never blocks.
+    void collect();
+
+    TimelineQueue &timeline() { return timeline_; }
+    const StagingPool &staging() const { return staging_; }
+    VkDeviceSize bytes_uploaded() const { return bytes_uploaded_; }
+    uint32_t batches_submitted() const { return batches_submitted_; }
+
+private:
+    struct Batch {
+        VkCommandBuffer command_buffer{VK_NULL_HANDLE};
+        uint64_t        value{0};
+    };
+    struct Handoff {
+        VkSemaphore           semaphore{VK_NULL_HANDLE};
+        VkPipelineStageFlags2 stages{0};
+    };
+    struct WaitedSemaphore {
+        VkSemaphore semaphore{VK_NULL_HANDLE};
+        uint64_t    consumer_value{0};    // consumer submission that waits on it
+    };
+
+    bool begin_batch();
+    // Submits the batch being recorded; only a handoff signals a semaphore.
+    VkResult submit_batch(bool handoff, uint64_t &value);
+    // Submits what reads the current staging chunk and moves to the next one.
+    bool next_chunk();
+    VkSemaphore acquire_semaphore();
+
+    const DeviceDispatch               *dispatch_{nullptr};
+    TimelineQueue                      *consumer_{nullptr};
+    TimelineQueue                       timeline_;
+    StagingPool                         staging_;
+    BarrierRecorder                     recorder_;
+    uint32_t                            transfer_family_{VK_QUEUE_FAMILY_IGNORED};
+    uint32_t                            consumer_family_{VK_QUEUE_FAMILY_IGNORED};
+    CommandBufferAllocator              command_buffers_;
+    // Flushes so far, which picks the allocator slot; the last value
+    // submitted from each slot; and whether the current slot was reset.
+    uint32_t                            flush_count_{0};
+    std::vector<uint64_t>               slot_values_;
+    bool                                slot_open_{false};
+    Batch                               recording_;
+    VkPipelineStageFlags2               recording_stages_{0};
+    // Release half of each ownership transfer, or the whole barrier when the
+    // families match, for the batch being recorded.
+    std::vector<VkBufferMemoryBarrier2> release_buffer_barriers_;
+    std::vector<VkImageMemoryBarrier2>  release_image_barriers_;
+    // Acquire barriers and semaphores of flushed batches not yet acquired.
+    std::vector<VkBufferMemoryBarrier2> acquire_buffer_barriers_;
+    std::vector<VkImageMemoryBarrier2>  acquire_image_barriers_;
+    std::vector<Handoff>                handoffs_;
+    std::deque<WaitedSemaphore>         waited_semaphores_;
+    std::vector<VkSemaphore>            free_semaphores_;
+    VkDeviceSize                        bytes_uploaded_{0};
+    uint32_t                            batches_submitted_{0};
+};
+
+#endif // COMMON_UPLOAD_ENGINE_H
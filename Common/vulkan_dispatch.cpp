@@ -0,0 +1,152 @@
+//
+// Table-driven loader for the function tables in vulkan_dispatch.h.
+//
+
+#include "vulkan_dispatch.h"
+#include <cstddef>
+#include <cstring>
+#include <dlfcn.h>
+#include <iterator>
+#include <iostream>
+
+namespace {
+
+struct FunctionEntry {
+    char const *name;
+    size_t      offset;     // offset of the slot inside the table struct
+    char const *extension;  // nullptr for core functions
+};
+
+const FunctionEntry global_level_entries[] = {
+#define GLOBAL_LEVEL_VULKAN_FUNCTION( name ) { #name, offsetof(GlobalFunctions, name), nullptr },
+#include "vulkan_functions.inl"
+};
+
+const FunctionEntry instance_level_entries[] = {
+#define INSTANCE_LEVEL_VULKAN_FUNCTION( name ) { #name, offsetof(InstanceFunctions, name), nullptr },
+#define INSTANCE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION( name, extension ) { #name, offsetof(InstanceFunctions, name), extension },
+#include "vulkan_functions.inl"
+};
+
+const FunctionEntry device_level_entries[] = {
+#define DEVICE_LEVEL_VULKAN_FUNCTION( name ) { #name, offsetof(DeviceFunctions, name), nullptr },
+#define DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION( name, extension ) { #name, offsetof(DeviceFunctions, name), extension },
+#include "vulkan_functions.inl"
+};
+
+bool is_extension_enabled(char const *extension, const std::vector<char const *> &enabled_extensions) {
+    for (auto enabled_extension : enabled_extensions) {
+        if (strcmp(enabled_extension, extension) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Resolves every entry into the table it describes. Entries whose extension is
+// not enabled are cleared so that callers can test them against nullptr.
+template<typename Table, size_t Count, typename Resolve>
+bool load_function_table(const FunctionEntry (&entries)[Count], char const *level,
+                         const std::vector<char const *> &enabled_extensions,
+                         Table &table, Resolve resolve) {
+    auto *base = reinterpret_cast<unsigned char *>(&table);
+    for (const auto &entry : entries) {
+        PFN_vkVoidFunction function{nullptr};
+        if (entry.extension == nullptr || is_extension_enabled(entry.extension, enabled_extensions)) {
+            function = resolve(entry.name);
+            if (function == nullptr) {
+                std::cout << "Could not load " << level << " Vulkan function named: " << entry.name << "." << std::endl;
+                return false;
+            }
+        }
+        std::memcpy(base + entry.offset, &function, sizeof(function));
+    }
+    return true;
+}
+
+} // namespace
+
+void *load_vulkan_library() {
+    void *vulkan_library = dlopen("libvulkan.so.1", RTLD_NOW);
+    if (vulkan_library == nullptr) {
+        std::cout << "Could not connect with a Vulkan Runtime library." << std::endl;
+        return nullptr;
+    }
+    std::cout << "Connect with a Vulkan Runtime library successfully." << std::endl;
+    return vulkan_library;
+}
+
+void unload_vulkan_library(void *&vulkan_library) {
+    if (vulkan_library != nullptr) {
+        dlclose(vulkan_library);
+        vulkan_library = nullptr;
+    }
+}
+
+PFN_vkGetInstanceProcAddr load_exported_vulkan_function(void *vulkan_library) {
+    if (vulkan_library == nullptr) {
+        return nullptr;
+    }
+    auto vkGetInstanceProcAddr = reinterpret_cast<PFN_vkGetInstanceProcAddr>(dlsym(vulkan_library, "vkGetInstanceProcAddr"));
+    if (vkGetInstanceProcAddr == nullptr) {
+        std::cout << "Could not find vkGetInstanceProcAddr in Vulkan Runtime library." << std::endl;
+    }
+    return vkGetInstanceProcAddr;
+}
+
+bool load_global_level_functions(PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr,
+                                 GlobalFunctions &functions) {
+    if (vkGetInstanceProcAddr == nullptr) {
+        return false;
+    }
+    return load_function_table(global_level_entries, "global level", {}, functions,
+                               [&](char const *name) { return vkGetInstanceProcAddr(nullptr, name); });
+}
+
+bool load_instance_level_functions(PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr,
+                                   VkInstance instance,
+                                   const std::vector<char const *> &enabled_extensions,
+                                   InstanceFunctions &functions) {
+    if (vkGetInstanceProcAddr == nullptr || instance == VK_NULL_HANDLE) {
+        return false;
+    }
+    return load_function_table(instance_level_entries, "instance-level", enabled_extensions, functions,
+                               [&](char const *name) { return vkGetInstanceProcAddr(instance, name); });
+}
+
+bool load_device_level_functions(PFN_vkGetDeviceProcAddr vkGetDeviceProcAddr,
+                                 VkDevice logical_device,
+                                 const std::vector<char const *> &enabled_extensions,
+                                 DeviceFunctions &functions) {
+    if (vkGetDeviceProcAddr == nullptr || logical_device == VK_NULL_HANDLE) {
+        return false;
+    }
+    return load_function_table(device_level_entries, "device-level", enabled_extensions, functions,
+                               [&](char const *name) { return vkGetDeviceProcAddr(logical_device, name); });
+}
+
+bool enable_physical_device_properties2(const std::vector<VkExtensionProperties> &available_extensions,
+                                        std::vector<char const *> &instance_extensions) {
+    if (is_extension_enabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME, instance_extensions)) {
+        return true;
+    }
+    for (const auto &extension : available_extensions) {
+        if (strcmp(extension.extensionName, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0) {
+            instance_extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t global_level_function_count() {
+    return static_cast<uint32_t>(std::size(global_level_entries));
+}
+
+uint32_t instance_level_function_count() {
+    return static_cast<uint32_t>(std::size(instance_level_entries));
+}
+
+uint32_t device_level_function_count() {
+    return static_cast<uint32_t>(std::size(device_level_entries));
+}
@@ -0,0 +1,67 @@
+//
+// Function tables filled from vulkan_functions.inl.
+//
+// Each level (global, instance, device) gets one contiguous struct of
+// function pointers. The loaders walk a compile-time table of
+// {name, offset, extension} entries and resolve every symbol exactly once,
+// so the samples no longer keep dozens of scattered PFN_* locals.
+//
+
+#ifndef COMMON_VULKAN_DISPATCH_H
+#define COMMON_VULKAN_DISPATCH_H
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+
+struct GlobalFunctions {
+#define GLOBAL_LEVEL_VULKAN_FUNCTION( name ) PFN_##name name;
+#include "vulkan_functions.inl"
+};
+
+struct InstanceFunctions {
+#define INSTANCE_LEVEL_VULKAN_FUNCTION( name ) PFN_##name name;
+#define INSTANCE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION( name, extension ) PFN_##name name;
+#include "vulkan_functions.inl"
+};
+
+struct DeviceFunctions {
+#define DEVICE_LEVEL_VULKAN_FUNCTION( name ) PFN_##name name;
+#define DEVICE_LEVEL_VULKAN_FUNCTION_FROM_EXTENSION( name, extension ) PFN_##name name;
+#include "vulkan_functions.inl"
+};
+
+void *load_vulkan_library();
+void unload_vulkan_library(void *&vulkan_library);
+
+// Returns nullptr (and prints why) if the library does not export it.
+PFN_vkGetInstanceProcAddr load_exported_vulkan_function(void *vulkan_library);
+
+bool load_global_level_functions(PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr,
+                                 GlobalFunctions &functions);
+
+// Functions that belong to an extension are only resolved when the extension
+// is in enabled_extensions; otherwise they stay nullptr.
+bool load_instance_level_functions(PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr,
+                                   VkInstance instance,
+                                   const std::vector<char const *> &enabled_extensions,
+                                   InstanceFunctions &functions);
+
+bool load_device_level_functions(PFN_vkGetDeviceProcAddr vkGetDeviceProcAddr,
+                                 VkDevice logical_device,
+                                 const std::vector<char const *> &enabled_extensions,
+                                 DeviceFunctions &functions);
+
+// Appends VK_KHR_get_physical_device_properties2 to instance_extensions if
+// the implementation has it and returns whether it is enabled. On a Vulkan 1.0
+// instance, device extensions such as VK_KHR_timeline_semaphore and
+// VK_KHR_synchronization2 may only be enabled when it is.
+bool enable_physical_device_properties2(const std::vector<VkExtensionProperties> &available_extensions,
+                                        std::vector<char const *> &instance_extensions);
+
+// Number of entries in each table, used to report per-symbol load cost.
+uint32_t global_level_function_count();
+uint32_t instance_level_function_count();
+uint32_t device_level_function_count();
+
+#endif // COMMON_VULKAN_DISPATCH_H
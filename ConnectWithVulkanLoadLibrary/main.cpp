@@ -1,33 +1,9 @@
 #include <iostream>
-#include <dlfcn.h>
 #include <vulkan/vulkan.h>
+#include "device_dispatch.h"
 #include <vector>
 #include <cstring>
 
-void *load_vulkan_library(){
-    void *vulkan_library = dlopen("libvulkan.so.1", RTLD_NOW);
-    if (vulkan_library == nullptr){
-        std::cout << "Could not connect with a Vulkan Runtime library." <<
-                  std::endl;
-        return nullptr;
-    }
-    std::cout << "Connect with a Vulkan Runtime library successfully." <<
-              std::endl;
-    return vulkan_library;
-}
-
-// create global level function
-void create_global_level_func(PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr){
-    if (vkGetInstanceProcAddr != nullptr){
-        PFN_vkEnumerateInstanceExtensionProperties vkEnumerateInstanceExtensionProperties =
-                reinterpret_cast<PFN_vkEnumerateInstanceExtensionProperties>(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceExtensionProperties"));
-        PFN_vkEnumerateInstanceLayerProperties  vkEnumerateInstanceLayerProperties =
-                reinterpret_cast< PFN_vkEnumerateInstanceLayerProperties >(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceLayerProperties"));
-        PFN_vkCreateInstance vkCreateInstance =
-                reinterpret_cast<PFN_vkCreateInstance>(vkGetInstanceProcAddr(nullptr, "vkCreateInstance"));
-    }
-}
-
 struct QueueInfo {
     uint32_t FamilyIndex;
     std::vector<float> Priorities;
@@ -36,32 +12,25 @@ struct QueueInfo {
 int main() {
     std::cout << "Hello, World!" << std::endl;
     void *vulkan_library = load_vulkan_library();
-    PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr = reinterpret_cast<PFN_vkGetInstanceProcAddr>(dlsym(vulkan_library, "vkGetInstanceProcAddr"));
+    auto vkGetInstanceProcAddr = load_exported_vulkan_function(vulkan_library);
     if (vkGetInstanceProcAddr == nullptr){
-        std::cout << "Could not find vkGetInstanceProcAddr in Vulkan Runtime library.\n";
         return -1;
     }
-    PFN_vkEnumerateInstanceExtensionProperties vkEnumerateInstanceExtensionProperties{};
-    PFN_vkEnumerateInstanceLayerProperties  vkEnumerateInstanceLayerProperties;
-    PFN_vkCreateInstance vkCreateInstance;
-    if (vkGetInstanceProcAddr != nullptr){
-        vkEnumerateInstanceExtensionProperties =
-                reinterpret_cast<PFN_vkEnumerateInstanceExtensionProperties>(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceExtensionProperties"));
-        vkEnumerateInstanceLayerProperties =
-                reinterpret_cast< PFN_vkEnumerateInstanceLayerProperties >(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceLayerProperties"));
-        vkCreateInstance =
-                reinterpret_cast<PFN_vkCreateInstance>(vkGetInstanceProcAddr(nullptr, "vkCreateInstance"));
+    // Load Global Level Functions
+    GlobalFunctions global_functions{};
+    if (!load_global_level_functions(vkGetInstanceProcAddr, global_functions)){
+        return -1;
     }
     uint32_t extensions_count;
-    if (vkEnumerateInstanceExtensionProperties != nullptr){
-        VkResult result = vkEnumerateInstanceExtensionProperties(nullptr, &extensions_count, nullptr);
+    if (global_functions.vkEnumerateInstanceExtensionProperties != nullptr){
+        VkResult result = global_functions.vkEnumerateInstanceExtensionProperties(nullptr, &extensions_count, nullptr);
         if( (result != VK_SUCCESS) || (extensions_count == 0)) {
             std::cout << "Could not get the number of Instance extensions." <<
                       std::endl;
             return -1;
         }
         std::vector<VkExtensionProperties> available_extensions(extensions_count);
-        result = vkEnumerateInstanceExtensionProperties(nullptr, &extensions_count, &available_extensions[0]);
+        result = global_functions.vkEnumerateInstanceExtensionProperties(nullptr, &extensions_count, &available_extensions[0]);
         if( (result != VK_SUCCESS) || (extensions_count == 0) ) {
             std::cout << "Could not enumerate Instance extensions." << std::endl;
             return -1;
@@ -103,87 +72,42 @@ int main() {
         instance_create_info.ppEnabledExtensionNames = desired_extensions.empty() ? nullptr : &desired_extensions[0];
 
         VkInstance instance;
-        result = vkCreateInstance(&instance_create_info, nullptr, &instance);
+        result = global_functions.vkCreateInstance(&instance_create_info, nullptr, &instance);
         if( (result != VK_SUCCESS) || (instance == VK_NULL_HANDLE) ) {
             std::cout << "Could not create Vulkan Instance." << std::endl;
             return -1;
         }
 
         // instance level
-        PFN_vkEnumeratePhysicalDevices vkEnumeratePhysicalDevices;
-        vkEnumeratePhysicalDevices =
-                reinterpret_cast<PFN_vkEnumeratePhysicalDevices>(vkGetInstanceProcAddr(instance, "vkEnumeratePhysicalDevices"));
-        PFN_vkGetPhysicalDeviceProperties vkGetPhysicalDeviceProperties;
-        vkGetPhysicalDeviceProperties =
-                reinterpret_cast<PFN_vkGetPhysicalDeviceProperties>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties"));
-        PFN_vkGetPhysicalDeviceFeatures vkGetPhysicalDeviceFeatures;
-        vkGetPhysicalDeviceFeatures =
-                reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures"));
-        PFN_vkCreateDevice vkCreateDevice;
-        vkCreateDevice =
-                reinterpret_cast<PFN_vkCreateDevice>(vkGetInstanceProcAddr(instance, "vkCreateDevice"));
-        PFN_vkDestroyInstance vkDestroyInstance;
-        vkDestroyInstance =
-                reinterpret_cast<PFN_vkDestroyInstance>(vkGetInstanceProcAddr(instance, "vkDestroyInstance"));
-        PFN_vkGetDeviceProcAddr vkGetDeviceProcAddr;
-        vkGetDeviceProcAddr =
-                reinterpret_cast<PFN_vkGetDeviceProcAddr>(vkGetInstanceProcAddr(instance, "vkGetDeviceProcAddr"));
-
-        // physical device extension
-        PFN_vkGetPhysicalDeviceSurfaceSupportKHR vkGetPhysicalDeviceSurfaceSupportKHR;
-        PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR vkGetPhysicalDeviceSurfaceCapabilitiesKHR;
-        PFN_vkGetPhysicalDeviceSurfaceFormatsKHR vkGetPhysicalDeviceSurfaceFormatsKHR;
-        for( auto & enabled_extension : desired_extensions ) {
-            if( std::string( enabled_extension ) == std::string( VK_KHR_SURFACE_EXTENSION_NAME ) ) {
-                vkGetPhysicalDeviceSurfaceSupportKHR = (PFN_vkGetPhysicalDeviceSurfaceSupportKHR)vkGetInstanceProcAddr( instance, "vkGetPhysicalDeviceSurfaceSupportKHR" );
-                if( vkGetPhysicalDeviceSurfaceSupportKHR == nullptr ) {
-                    std::cout << "Could not load instance-level Vulkan function named: vkGetPhysicalDeviceSurfaceSupportKHR" << std::endl;
-                    return -1;
-                }
-                vkGetPhysicalDeviceSurfaceCapabilitiesKHR = (PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR)vkGetInstanceProcAddr( instance, "vkGetPhysicalDeviceSurfaceCapabilitiesKHR" );
-                if( vkGetPhysicalDeviceSurfaceCapabilitiesKHR == nullptr ) {
-                    std::cout << "Could not load instance-level Vulkan function named: vkGetPhysicalDeviceSurfaceCapabilitiesKHR" << std::endl;
-                    return -1;
-                }
-                vkGetPhysicalDeviceSurfaceFormatsKHR = (PFN_vkGetPhysicalDeviceSurfaceFormatsKHR)vkGetInstanceProcAddr( instance, "vkGetPhysicalDeviceSurfaceFormatsKHR" );
-                if( vkGetPhysicalDeviceSurfaceFormatsKHR == nullptr ) {
-                    std::cout << "Could not load instance-level Vulkan function named: vkGetPhysicalDeviceSurfaceFormatsKHR" << std::endl;
-                    return -1;
-                }
-            }
+        InstanceFunctions instance_functions{};
+        if (!load_instance_level_functions(vkGetInstanceProcAddr, instance, desired_extensions, instance_functions)){
+            return -1;
         }
         // Enumerate available physical devices
         uint32_t devices_count{0};
-        result = vkEnumeratePhysicalDevices(instance, &devices_count, nullptr);
+        result = instance_functions.vkEnumeratePhysicalDevices(instance, &devices_count, nullptr);
         if( (result != VK_SUCCESS) || (devices_count == 0) ) {
             std::cout << "Could not get the number of available physical devices." << std::endl;
             return -1;
         }
         std::vector<VkPhysicalDevice> physical_devices(devices_count);
-        result = vkEnumeratePhysicalDevices(instance, &devices_count, physical_devices.data());
+        result = instance_functions.vkEnumeratePhysicalDevices(instance, &devices_count, physical_devices.data());
         if( (result != VK_SUCCESS) || (devices_count == 0) ) {
             std::cout << "Could not enumerate physical devices." << std::endl;
             return -1;
         }
 
-        // enumerate physical device
-        PFN_vkEnumerateDeviceExtensionProperties vkEnumerateDeviceExtensionProperties;
-        vkEnumerateDeviceExtensionProperties =
-                reinterpret_cast<PFN_vkEnumerateDeviceExtensionProperties>(vkGetInstanceProcAddr(instance, "vkEnumerateDeviceExtensionProperties"));
-        PFN_vkGetPhysicalDeviceQueueFamilyProperties vkGetPhysicalDeviceQueueFamilyProperties;
-        vkGetPhysicalDeviceQueueFamilyProperties =
-                reinterpret_cast<PFN_vkGetPhysicalDeviceQueueFamilyProperties>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceQueueFamilyProperties"));
         for (auto physical_device : physical_devices) {
             // physical device extension properties
             uint32_t DeviceExtensionProperties_extensions_count = 0;
-            result = vkEnumerateDeviceExtensionProperties( physical_device, nullptr,
-                                                           &DeviceExtensionProperties_extensions_count, nullptr );
+            result = instance_functions.vkEnumerateDeviceExtensionProperties( physical_device, nullptr,
+                                                                              &DeviceExtensionProperties_extensions_count, nullptr );
             if( (result != VK_SUCCESS) || (DeviceExtensionProperties_extensions_count == 0) ) {
                 std::cout << "Could not get the number of device extensions." << std::endl;
                 return -1;
             }
             std::vector<VkExtensionProperties> available_extensions_DeviceExtensionProperties(DeviceExtensionProperties_extensions_count);
-            result = vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &DeviceExtensionProperties_extensions_count, available_extensions_DeviceExtensionProperties.data());
+            result = instance_functions.vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &DeviceExtensionProperties_extensions_count, available_extensions_DeviceExtensionProperties.data());
             if( (result != VK_SUCCESS) || (extensions_count == 0) ) {
                 std::cout << "Could not enumerate device extensions." << std::endl;
                 return -1;
@@ -209,8 +133,8 @@ int main() {
             //Getting features and properties of a physical device
             VkPhysicalDeviceFeatures device_features;
             VkPhysicalDeviceProperties device_properties;
-            vkGetPhysicalDeviceFeatures(physical_device, &device_features);
-            vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+            instance_functions.vkGetPhysicalDeviceFeatures(physical_device, &device_features);
+            instance_functions.vkGetPhysicalDeviceProperties(physical_device, &device_properties);
 
             if (device_features.geometryShader){
                 device_features = {};   // keep only geometryShader of device_features
@@ -221,9 +145,9 @@ int main() {
 
             // Checking available queue families and their properties
             uint32_t queue_families_count;
-            vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, nullptr);
+            instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, nullptr);
             std::vector<VkQueueFamilyProperties> queue_families(queue_families_count);
-            vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, queue_families.data());
+            instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, queue_families.data());
 
             //Selecting the index of a queue family with
             //the desired capabilities
@@ -277,105 +201,36 @@ int main() {
             device_create_info.pEnabledFeatures = &device_features;
 
             VkDevice logical_device;
-            result = vkCreateDevice(physical_device, &device_create_info, nullptr, &logical_device);
+            result = instance_functions.vkCreateDevice(physical_device, &device_create_info, nullptr, &logical_device);
             if( (result != VK_SUCCESS) || (logical_device == VK_NULL_HANDLE) ) {
                 std::cout << "Could not create logical device." << std::endl;
                 return -1;
             }
             // Load device level function
-            PFN_vkGetDeviceQueue vkGetDeviceQueue;
-            vkGetDeviceQueue =
-                    reinterpret_cast<PFN_vkGetDeviceQueue>(vkGetDeviceProcAddr(logical_device, "vkGetDeviceQueue"));
-            if( vkGetDeviceQueue == nullptr ) {
-                std::cout << "Could not load device-level Vulkan function named: vkGetDeviceQueue." << std::endl;
-                return -1;
-            }
-            PFN_vkDeviceWaitIdle vkDeviceWaitIdle;
-            vkDeviceWaitIdle =
-                    reinterpret_cast<PFN_vkDeviceWaitIdle>(vkGetDeviceProcAddr(logical_device, "vkDeviceWaitIdle"));
-            if( vkDeviceWaitIdle == nullptr ) {
-                std::cout << "Could not load device-level Vulkan function named: vkDeviceWaitIdle." << std::endl;
-                return -1;
-            }
-            PFN_vkDestroyDevice vkDestroyDevice;
-            vkDestroyDevice =
-                    reinterpret_cast<PFN_vkDestroyDevice>(vkGetDeviceProcAddr(logical_device, "vkDestroyDevice"));
-            if( vkDestroyDevice == nullptr ) {
-                std::cout << "Could not load device-level Vulkan function named: vkDestroyDevice." << std::endl;
-                return -1;
-            }
-            PFN_vkCreateBuffer vkCreateBuffer;
-            vkCreateBuffer =
-                    reinterpret_cast<PFN_vkCreateBuffer>(vkGetDeviceProcAddr(logical_device, "vkCreateBuffer"));
-            if( vkCreateBuffer == nullptr ) {
-                std::cout << "Could not load device-level Vulkan function named: vkCreateBuffer." << std::endl;
-                return -1;
-            }
-            PFN_vkGetBufferMemoryRequirements vkGetBufferMemoryRequirements;
-            vkGetBufferMemoryRequirements =
-                    reinterpret_cast<PFN_vkGetBufferMemoryRequirements>(vkGetDeviceProcAddr(logical_device, "vkGetBufferMemoryRequirements"));
-            if( vkGetBufferMemoryRequirements == nullptr ) {
-                std::cout << "Could not load device-level Vulkan function named: vkGetBufferMemoryRequirements." << std::endl;
-                return -1;
-            }
-
-            // Load device level function from extension
-            PFN_vkCreateSwapchainKHR vkCreateSwapchainKHR;
-            vkCreateSwapchainKHR =
-                    reinterpret_cast<PFN_vkCreateSwapchainKHR>(vkGetDeviceProcAddr(logical_device, "vkCreateSwapchainKHR"));
-            if( vkCreateSwapchainKHR == nullptr ) {
-                std::cout << "Could not load device-level Vulkan function named: vkCreateSwapchainKHR." << std::endl;
-                return -1;
-            }
-            PFN_vkGetSwapchainImagesKHR vkGetSwapchainImagesKHR;
-            vkGetSwapchainImagesKHR =
-                    reinterpret_cast<PFN_vkGetSwapchainImagesKHR>(vkGetDeviceProcAddr(logical_device, "vkGetSwapchainImagesKHR"));
-            if( vkGetSwapchainImagesKHR == nullptr ) {
-                std::cout << "Could not load device-level Vulkan function named: vkGetSwapchainImagesKHR." << std::endl;
-                return -1;
-            }
-            PFN_vkAcquireNextImageKHR vkAcquireNextImageKHR;
-            vkAcquireNextImageKHR =
-                    reinterpret_cast<PFN_vkAcquireNextImageKHR>(vkGetDeviceProcAddr(logical_device, "vkAcquireNextImageKHR"));
-            if( vkGetSwapchainImagesKHR == nullptr ) {
-                std::cout << "Could not load device-level Vulkan function named: vkAcquireNextImageKHR." << std::endl;
-                return -1;
-            }
-            PFN_vkQueuePresentKHR vkQueuePresentKHR;
-            vkQueuePresentKHR =
-                    reinterpret_cast<PFN_vkQueuePresentKHR>(vkGetDeviceProcAddr(logical_device, "vkQueuePresentKHR"));
-            if( vkQueuePresentKHR == nullptr ) {
-                std::cout << "Could not load device-level Vulkan function named: vkQueuePresentKHR." << std::endl;
-                return -1;
-            }
-            PFN_vkDestroySwapchainKHR vkDestroySwapchainKHR;
-            vkDestroySwapchainKHR =
-                    reinterpret_cast<PFN_vkDestroySwapchainKHR>(vkGetDeviceProcAddr(logical_device, "vkDestroySwapchainKHR"));
-            if( vkDestroySwapchainKHR == nullptr ) {
-                std::cout << "Could not load device-level Vulkan function named: vkDestroySwapchainKHR." << std::endl;
+            DeviceDispatch device_functions;
+            if (!create_device_dispatch(instance_functions.vkGetDeviceProcAddr, logical_device,
+                                        desired_extensions_DeviceExtensionProperties, device_functions)){
                 return -1;
             }
 
             // create a logical device with geometry shaders, graphics and compute queues
             VkQueue graphics_queue, compute_queue;
-            vkGetDeviceQueue(logical_device, queue_family_graphics_index, 0, &graphics_queue);
-            vkGetDeviceQueue(logical_device, queue_family_compute_index, 0, &compute_queue);
+            device_functions.vkGetDeviceQueue(logical_device, queue_family_graphics_index, 0, &graphics_queue);
+            device_functions.vkGetDeviceQueue(logical_device, queue_family_compute_index, 0, &compute_queue);
 
             // destroy a local device
             if (logical_device){
-                vkDestroyDevice(logical_device, nullptr);
+                device_functions.vkDestroyDevice(logical_device, nullptr);
+                destroy_device_dispatch(device_functions);
                 logical_device = VK_NULL_HANDLE;
             }
             // destroy a vulkan instance
             if (instance){
-                vkDestroyInstance(instance, nullptr);
+                instance_functions.vkDestroyInstance(instance, nullptr);
                 instance = VK_NULL_HANDLE;
             }
             // Release a Vulkan Loader Library
-            if (vulkan_library){
-                dlclose(vulkan_library);
-                vulkan_library = nullptr;
-            }
+            unload_vulkan_library(vulkan_library);
             return 0;
         }
     }
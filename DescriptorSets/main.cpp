@@ -1,7 +1,9 @@
 #include <iostream>
 #include <vector>
 #include <vulkan/vulkan.h>
-#include <dlfcn.h>
+#include "device_dispatch.h"
+#include "memory_type_resolver.h"
+#include "object_cache.h"
 #include <cstring>
 
 struct WindowParameters{
@@ -45,18 +47,6 @@ struct ImageTransition{
     VkImageAspectFlags aspect;
 };
 
-void *load_vulkan_library(){
-    void *vulkan_library = dlopen("libvulkan.so.1", RTLD_NOW);
-    if (vulkan_library == nullptr){
-        std::cout << "Could not connect with a Vulkan Runtime library." <<
-                  std::endl;
-        return nullptr;
-    }
-    std::cout << "Connect with a Vulkan Runtime library successfully." <<
-              std::endl;
-    return vulkan_library;
-}
-
 void init_window(struct WindowParameters &info) {
     uint32_t width{64};
     uint32_t height{64};
@@ -97,7 +87,7 @@ void init_window(struct WindowParameters &info) {
     }
 }
 
-void SetBufferMemoryBarrier( PFN_vkCmdPipelineBarrier vkCmdPipelineBarrier,
+void SetBufferMemoryBarrier( const DeviceFunctions        &device_functions,
                              VkCommandBuffer               command_buffer,
                              VkPipelineStageFlags          generating_stages,
                              VkPipelineStageFlags          consuming_stages,
@@ -119,49 +109,26 @@ void SetBufferMemoryBarrier( PFN_vkCmdPipelineBarrier vkCmdPipelineBarrier,
     }
 
     if( !buffer_memory_barriers.empty() ) {
-        vkCmdPipelineBarrier( command_buffer, generating_stages, consuming_stages, 0, 0, nullptr, static_cast<uint32_t>(buffer_memory_barriers.size()), buffer_memory_barriers.data(), 0, nullptr );
+        device_functions.vkCmdPipelineBarrier( command_buffer, generating_stages, consuming_stages, 0, 0, nullptr, static_cast<uint32_t>(buffer_memory_barriers.size()), buffer_memory_barriers.data(), 0, nullptr );
     }
 }
 
 int main() {
     // Load vulkan library
     void *vulkan_library = load_vulkan_library();
-    auto vkGetInstanceProcAddr = reinterpret_cast<PFN_vkGetInstanceProcAddr>(dlsym(vulkan_library, "vkGetInstanceProcAddr"));
+    auto vkGetInstanceProcAddr = load_exported_vulkan_function(vulkan_library);
     if (vkGetInstanceProcAddr == nullptr){
-        std::cout << "Could not find vkGetInstanceProcAddr in Vulkan Runtime library.\n";
         return -1;
     }
     /// Load Global Level Functions
-    PFN_vkEnumerateInstanceExtensionProperties vkEnumerateInstanceExtensionProperties{};
-    if (vkGetInstanceProcAddr != nullptr){
-        vkEnumerateInstanceExtensionProperties =
-                reinterpret_cast<PFN_vkEnumerateInstanceExtensionProperties>(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceExtensionProperties"));
-        if (vkEnumerateInstanceExtensionProperties == nullptr){
-            std::cout << "Could not load global level Vulkan function named: vkEnumerateInstanceExtensionProperties." << std::endl;
-            return -1;
-        }
-    }
-    PFN_vkEnumerateInstanceLayerProperties  vkEnumerateInstanceLayerProperties;
-    if (vkGetInstanceProcAddr != nullptr){
-        vkEnumerateInstanceLayerProperties =
-                reinterpret_cast< PFN_vkEnumerateInstanceLayerProperties >(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceLayerProperties"));
-        if (vkEnumerateInstanceLayerProperties == nullptr){
-            std::cout << "Could not load global level Vulkan function named: vkEnumerateInstanceLayerProperties." << std::endl;
-            return 1;
-        }
-    }
-    PFN_vkCreateInstance vkCreateInstance;
-    if (vkGetInstanceProcAddr != nullptr){
-        vkCreateInstance = reinterpret_cast<PFN_vkCreateInstance>(vkGetInstanceProcAddr(nullptr, "vkCreateInstance"));
-        if (vkCreateInstance == nullptr){
-            std::cout << "Could not load global level Vulkan function named: vkCreateInstance." << std::endl;
-            return -1;
-        }
+    GlobalFunctions global_functions{};
+    if (!load_global_level_functions(vkGetInstanceProcAddr, global_functions)){
+        return -1;
     }
     // Get available_extensions
     uint32_t extensions_count{};
-    if (vkEnumerateInstanceExtensionProperties != nullptr) {
-        VkResult result = vkEnumerateInstanceExtensionProperties(nullptr, &extensions_count, nullptr);
+    if (global_functions.vkEnumerateInstanceExtensionProperties != nullptr) {
+        VkResult result = global_functions.vkEnumerateInstanceExtensionProperties(nullptr, &extensions_count, nullptr);
         if( (result != VK_SUCCESS) || (extensions_count == 0)) {
             std::cout << "Could not get the number of Instance extensions." <<
                       std::endl;
@@ -169,8 +136,8 @@ int main() {
         }
     }
     std::vector<VkExtensionProperties> available_extensions(extensions_count);
-    if (vkEnumerateInstanceExtensionProperties != nullptr) {
-        VkResult result = vkEnumerateInstanceExtensionProperties(nullptr, &extensions_count, available_extensions.data());
+    if (global_functions.vkEnumerateInstanceExtensionProperties != nullptr) {
+        VkResult result = global_functions.vkEnumerateInstanceExtensionProperties(nullptr, &extensions_count, available_extensions.data());
         if ((result != VK_SUCCESS) || (extensions_count == 0)) {
             std::cout << "Could not enumerate Instance extensions." << std::endl;
             return -1;
@@ -215,8 +182,8 @@ int main() {
     instance_create_info.ppEnabledExtensionNames = desired_extensions.empty() ? nullptr : desired_extensions.data();
 
     VkInstance instance{};
-    if (vkCreateInstance != nullptr){
-        VkResult result = vkCreateInstance(&instance_create_info, nullptr, &instance);
+    if (global_functions.vkCreateInstance != nullptr){
+        VkResult result = global_functions.vkCreateInstance(&instance_create_info, nullptr, &instance);
         if( (result != VK_SUCCESS) || (instance == VK_NULL_HANDLE) ) {
             std::cout << "Could not create Vulkan Instance." << std::endl;
             return -1;
@@ -224,78 +191,10 @@ int main() {
     }
 
     /// Load instance level function
-    PFN_vkCreateXcbSurfaceKHR vkCreateXcbSurfaceKHR;
-    vkCreateXcbSurfaceKHR =
-            reinterpret_cast<PFN_vkCreateXcbSurfaceKHR>(vkGetInstanceProcAddr(instance, "vkCreateXcbSurfaceKHR"));
-    if (vkCreateXcbSurfaceKHR == nullptr){
-        std::cout << "Could not load instance level Vulkan function named: vkCreateXcbSurfaceKHR." << std::endl;
-        return 1;
-    }
-    PFN_vkEnumeratePhysicalDevices vkEnumeratePhysicalDevices;
-    vkEnumeratePhysicalDevices =
-            reinterpret_cast<PFN_vkEnumeratePhysicalDevices>(vkGetInstanceProcAddr(instance, "vkEnumeratePhysicalDevices"));
-    PFN_vkGetPhysicalDeviceProperties vkGetPhysicalDeviceProperties;
-    vkGetPhysicalDeviceProperties =
-            reinterpret_cast<PFN_vkGetPhysicalDeviceProperties>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties"));
-    PFN_vkGetPhysicalDeviceFeatures vkGetPhysicalDeviceFeatures;
-    vkGetPhysicalDeviceFeatures =
-            reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures"));
-    PFN_vkCreateDevice vkCreateDevice;
-    vkCreateDevice =
-            reinterpret_cast<PFN_vkCreateDevice>(vkGetInstanceProcAddr(instance, "vkCreateDevice"));
-    PFN_vkDestroyInstance vkDestroyInstance;
-    vkDestroyInstance =
-            reinterpret_cast<PFN_vkDestroyInstance>(vkGetInstanceProcAddr(instance, "vkDestroyInstance"));
-    PFN_vkGetDeviceProcAddr vkGetDeviceProcAddr;
-    vkGetDeviceProcAddr =
-            reinterpret_cast<PFN_vkGetDeviceProcAddr>(vkGetInstanceProcAddr(instance, "vkGetDeviceProcAddr"));
-    // Load physical device extension function
-    PFN_vkGetPhysicalDeviceSurfaceSupportKHR vkGetPhysicalDeviceSurfaceSupportKHR;
-    PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR vkGetPhysicalDeviceSurfaceCapabilitiesKHR;
-    PFN_vkGetPhysicalDeviceSurfaceFormatsKHR vkGetPhysicalDeviceSurfaceFormatsKHR;
-    for( auto & enabled_extension : desired_extensions ) {
-        if( std::string( enabled_extension ) == std::string( VK_KHR_SURFACE_EXTENSION_NAME ) ) {
-            vkGetPhysicalDeviceSurfaceSupportKHR = (PFN_vkGetPhysicalDeviceSurfaceSupportKHR)vkGetInstanceProcAddr( instance, "vkGetPhysicalDeviceSurfaceSupportKHR" );
-            if( vkGetPhysicalDeviceSurfaceSupportKHR == nullptr ) {
-                std::cout << "Could not load instance-level Vulkan function named: vkGetPhysicalDeviceSurfaceSupportKHR" << std::endl;
-                return -1;
-            }
-            vkGetPhysicalDeviceSurfaceCapabilitiesKHR = (PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR)vkGetInstanceProcAddr( instance, "vkGetPhysicalDeviceSurfaceCapabilitiesKHR" );
-            if( vkGetPhysicalDeviceSurfaceCapabilitiesKHR == nullptr ) {
-                std::cout << "Could not load instance-level Vulkan function named: vkGetPhysicalDeviceSurfaceCapabilitiesKHR" << std::endl;
-                return -1;
-            }
-            vkGetPhysicalDeviceSurfaceFormatsKHR = (PFN_vkGetPhysicalDeviceSurfaceFormatsKHR)vkGetInstanceProcAddr( instance, "vkGetPhysicalDeviceSurfaceFormatsKHR" );
-            if( vkGetPhysicalDeviceSurfaceFormatsKHR == nullptr ) {
-                std::cout << "Could not load instance-level Vulkan function named: vkGetPhysicalDeviceSurfaceFormatsKHR" << std::endl;
-                return -1;
-            }
-        }
-    }
-
-    PFN_vkEnumerateDeviceExtensionProperties vkEnumerateDeviceExtensionProperties;
-    vkEnumerateDeviceExtensionProperties =
-            reinterpret_cast<PFN_vkEnumerateDeviceExtensionProperties>(vkGetInstanceProcAddr(instance, "vkEnumerateDeviceExtensionProperties"));
-    PFN_vkGetPhysicalDeviceQueueFamilyProperties vkGetPhysicalDeviceQueueFamilyProperties;
-    vkGetPhysicalDeviceQueueFamilyProperties =
-            reinterpret_cast<PFN_vkGetPhysicalDeviceQueueFamilyProperties>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceQueueFamilyProperties"));
-    PFN_vkGetPhysicalDeviceSurfacePresentModesKHR vkGetPhysicalDeviceSurfacePresentModesKHR;
-    vkGetPhysicalDeviceSurfacePresentModesKHR =
-            reinterpret_cast<PFN_vkGetPhysicalDeviceSurfacePresentModesKHR>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceSurfacePresentModesKHR"));
-    if (vkGetPhysicalDeviceSurfacePresentModesKHR == nullptr){
-        std::cout << "Could not load device-level Vulkan function named: vkGetPhysicalDeviceSurfacePresentModesKHR" << std::endl;
+    InstanceFunctions instance_functions{};
+    if (!load_instance_level_functions(vkGetInstanceProcAddr, instance, desired_extensions, instance_functions)){
         return -1;
     }
-    PFN_vkDestroySurfaceKHR vkDestroySurfaceKHR;
-    vkDestroySurfaceKHR =
-            reinterpret_cast<PFN_vkDestroySurfaceKHR>(vkGetInstanceProcAddr(instance, "vkDestroySurfaceKHR"));
-    if (vkDestroySurfaceKHR == nullptr){
-        std::cout << "Could not load device-level Vulkan function named: vkDestroySurfaceKHR" << std::endl;
-        return -1;
-    }
-    PFN_vkGetPhysicalDeviceMemoryProperties vkGetPhysicalDeviceMemoryProperties;
-    vkGetPhysicalDeviceMemoryProperties =
-            reinterpret_cast<PFN_vkGetPhysicalDeviceMemoryProperties>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties"));
 
     // create a presentation surface
     int nScreenNum = 0;
@@ -325,7 +224,7 @@ int main() {
     surface_create_info.window = window_parameters.window;
 
     VkSurfaceKHR presentation_surface{VK_NULL_HANDLE};
-    VkResult result = vkCreateXcbSurfaceKHR(instance, &surface_create_info, nullptr, &presentation_surface);
+    VkResult result = instance_functions.vkCreateXcbSurfaceKHR(instance, &surface_create_info, nullptr, &presentation_surface);
     if( (VK_SUCCESS != result) || (VK_NULL_HANDLE == presentation_surface) ) {
         std::cout << "Could not create presentation surface." << std::endl;
         return -1;
@@ -333,13 +232,13 @@ int main() {
 
     //Get physical device
     uint32_t devices_count{0};
-    result = vkEnumeratePhysicalDevices(instance, &devices_count, nullptr);
+    result = instance_functions.vkEnumeratePhysicalDevices(instance, &devices_count, nullptr);
     if( (result != VK_SUCCESS) || (devices_count == 0) ) {
         std::cout << "Could not get the number of available physical devices." << std::endl;
         return -1;
     }
     std::vector<VkPhysicalDevice> physical_devices(devices_count);
-    result = vkEnumeratePhysicalDevices(instance, &devices_count, physical_devices.data());
+    result = instance_functions.vkEnumeratePhysicalDevices(instance, &devices_count, physical_devices.data());
     if( (result != VK_SUCCESS) || (devices_count == 0) ) {
         std::cout << "Could not enumerate physical devices." << std::endl;
         return -1;
@@ -347,13 +246,13 @@ int main() {
     // select a queue family that supports presentation to a given surface
     for (auto physical_device : physical_devices) {
         uint32_t queue_families_count;
-        vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, nullptr);
+        instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, nullptr);
         if( queue_families_count == 0 ) {
             std::cout << "Could not get the number of queue families." << std::endl;
             return -1;
         }
         std::vector<VkQueueFamilyProperties> queue_families(queue_families_count);
-        vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, queue_families.data());
+        instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, queue_families.data());
         if( queue_families_count == 0 ) {
             std::cout << "Could not acquire properties of queue families." << std::endl;
             return -1;
@@ -378,7 +277,7 @@ int main() {
         b_found = false;
         for( uint32_t index = 0; index < static_cast<uint32_t>(queue_families.size()); ++index ) {
             VkBool32 presentation_supported = VK_FALSE;
-            result = vkGetPhysicalDeviceSurfaceSupportKHR( physical_device, index, presentation_surface, &presentation_supported );
+            result = instance_functions.vkGetPhysicalDeviceSurfaceSupportKHR( physical_device, index, presentation_surface, &presentation_supported );
             if( (VK_SUCCESS == result) && (VK_TRUE == presentation_supported) ) {
                 PresentQueueFamilyIndex = index;
                 b_found = true;
@@ -398,14 +297,14 @@ int main() {
         //Creating a logical device with WSI extensions enabled
         // physical device extension properties
         uint32_t DeviceExtensionProperties_extensions_count = 0;
-        result = vkEnumerateDeviceExtensionProperties( physical_device, nullptr,
-                                                       &DeviceExtensionProperties_extensions_count, nullptr );
+        result = instance_functions.vkEnumerateDeviceExtensionProperties( physical_device, nullptr,
+                                                                          &DeviceExtensionProperties_extensions_count, nullptr );
         if( (result != VK_SUCCESS) || (DeviceExtensionProperties_extensions_count == 0) ) {
             std::cout << "Could not get the number of device extensions." << std::endl;
             return -1;
         }
         std::vector<VkExtensionProperties> available_extensions_DeviceExtensionProperties(DeviceExtensionProperties_extensions_count);
-        result = vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &DeviceExtensionProperties_extensions_count, available_extensions_DeviceExtensionProperties.data());
+        result = instance_functions.vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &DeviceExtensionProperties_extensions_count, available_extensions_DeviceExtensionProperties.data());
         if( (result != VK_SUCCESS) || (extensions_count == 0) ) {
             std::cout << "Could not enumerate device extensions." << std::endl;
             return -1;
@@ -443,8 +342,8 @@ int main() {
         //Getting features and properties of a physical device
         VkPhysicalDeviceFeatures device_features;
         VkPhysicalDeviceProperties device_properties;
-        vkGetPhysicalDeviceFeatures(physical_device, &device_features);
-        vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+        instance_functions.vkGetPhysicalDeviceFeatures(physical_device, &device_features);
+        instance_functions.vkGetPhysicalDeviceProperties(physical_device, &device_properties);
 
         if (device_features.geometryShader){
             device_features = {};   // keep only geometryShader of device_features
@@ -466,299 +365,15 @@ int main() {
         device_create_info.ppEnabledExtensionNames = desired_extensions_DeviceExtensionProperties.empty() ? nullptr : desired_extensions_DeviceExtensionProperties.data();
         device_create_info.pEnabledFeatures = &device_features;
         VkDevice logical_device;
-        result = vkCreateDevice(physical_device, &device_create_info, nullptr, &logical_device);
+        result = instance_functions.vkCreateDevice(physical_device, &device_create_info, nullptr, &logical_device);
         if( (result != VK_SUCCESS) || (logical_device == VK_NULL_HANDLE) ) {
             std::cout << "Could not create logical device." << std::endl;
             return -1;
         }
         // Load device level functions
-        PFN_vkGetDeviceQueue vkGetDeviceQueue;
-        vkGetDeviceQueue =
-                reinterpret_cast<PFN_vkGetDeviceQueue>(vkGetDeviceProcAddr(logical_device, "vkGetDeviceQueue"));
-        if( vkGetDeviceQueue == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkGetDeviceQueue." << std::endl;
-            return -1;
-        }
-        PFN_vkDeviceWaitIdle vkDeviceWaitIdle;
-        vkDeviceWaitIdle =
-                reinterpret_cast<PFN_vkDeviceWaitIdle>(vkGetDeviceProcAddr(logical_device, "vkDeviceWaitIdle"));
-        if( vkDeviceWaitIdle == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkDeviceWaitIdle." << std::endl;
-            return -1;
-        }
-        PFN_vkDestroyDevice vkDestroyDevice;
-        vkDestroyDevice =
-                reinterpret_cast<PFN_vkDestroyDevice>(vkGetDeviceProcAddr(logical_device, "vkDestroyDevice"));
-        if( vkDestroyDevice == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkDestroyDevice." << std::endl;
-            return -1;
-        }
-        PFN_vkCreateBuffer vkCreateBuffer;
-        vkCreateBuffer =
-                reinterpret_cast<PFN_vkCreateBuffer>(vkGetDeviceProcAddr(logical_device, "vkCreateBuffer"));
-        if( vkCreateBuffer == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCreateBuffer." << std::endl;
-            return -1;
-        }
-        PFN_vkGetBufferMemoryRequirements vkGetBufferMemoryRequirements;
-        vkGetBufferMemoryRequirements =
-                reinterpret_cast<PFN_vkGetBufferMemoryRequirements>(vkGetDeviceProcAddr(logical_device, "vkGetBufferMemoryRequirements"));
-        if( vkGetBufferMemoryRequirements == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkGetBufferMemoryRequirements." << std::endl;
-            return -1;
-        }
-
-        // Load device level function from extension
-        PFN_vkCreateSwapchainKHR vkCreateSwapchainKHR;
-        vkCreateSwapchainKHR =
-                reinterpret_cast<PFN_vkCreateSwapchainKHR>(vkGetDeviceProcAddr(logical_device, "vkCreateSwapchainKHR"));
-        if( vkCreateSwapchainKHR == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCreateSwapchainKHR." << std::endl;
-            return -1;
-        }
-        PFN_vkGetSwapchainImagesKHR vkGetSwapchainImagesKHR;
-        vkGetSwapchainImagesKHR =
-                reinterpret_cast<PFN_vkGetSwapchainImagesKHR>(vkGetDeviceProcAddr(logical_device, "vkGetSwapchainImagesKHR"));
-        if( vkGetSwapchainImagesKHR == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkGetSwapchainImagesKHR." << std::endl;
-            return -1;
-        }
-        PFN_vkAcquireNextImageKHR vkAcquireNextImageKHR;
-        vkAcquireNextImageKHR =
-                reinterpret_cast<PFN_vkAcquireNextImageKHR>(vkGetDeviceProcAddr(logical_device, "vkAcquireNextImageKHR"));
-        if( vkAcquireNextImageKHR == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkAcquireNextImageKHR." << std::endl;
-            return -1;
-        }
-        PFN_vkQueuePresentKHR vkQueuePresentKHR;
-        vkQueuePresentKHR =
-                reinterpret_cast<PFN_vkQueuePresentKHR>(vkGetDeviceProcAddr(logical_device, "vkQueuePresentKHR"));
-        if( vkQueuePresentKHR == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkQueuePresentKHR." << std::endl;
-            return -1;
-        }
-        PFN_vkDestroySwapchainKHR vkDestroySwapchainKHR;
-        vkDestroySwapchainKHR =
-                reinterpret_cast<PFN_vkDestroySwapchainKHR>(vkGetDeviceProcAddr(logical_device, "vkDestroySwapchainKHR"));
-        if( vkDestroySwapchainKHR == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkDestroySwapchainKHR." << std::endl;
-            return -1;
-        }
-        PFN_vkCreateSemaphore vkCreateSemaphore;
-        vkCreateSemaphore =
-                reinterpret_cast<PFN_vkCreateSemaphore>(vkGetDeviceProcAddr(logical_device, "vkCreateSemaphore"));
-        if( vkCreateSemaphore == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCreateSemaphore." << std::endl;
-            return -1;
-        }
-        PFN_vkCreateFence vkCreateFence;
-        vkCreateFence =
-                reinterpret_cast<PFN_vkCreateFence>(vkGetDeviceProcAddr(logical_device, "vkCreateFence"));
-        if( vkCreateFence == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCreateFence." << std::endl;
-            return -1;
-        }
-        PFN_vkCreateCommandPool vkCreateCommandPool;
-        vkCreateCommandPool =
-                reinterpret_cast<PFN_vkCreateCommandPool>(vkGetDeviceProcAddr(logical_device, "vkCreateCommandPool"));
-        if( vkCreateCommandPool == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCreateCommandPool." << std::endl;
-            return -1;
-        }
-        PFN_vkAllocateCommandBuffers vkAllocateCommandBuffers;
-        vkAllocateCommandBuffers =
-                reinterpret_cast<PFN_vkAllocateCommandBuffers>(vkGetDeviceProcAddr(logical_device, "vkAllocateCommandBuffers"));
-        if( vkAllocateCommandBuffers == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkAllocateCommandBuffers." << std::endl;
-            return -1;
-        }
-        PFN_vkBeginCommandBuffer vkBeginCommandBuffer;
-        vkBeginCommandBuffer =
-                reinterpret_cast<PFN_vkBeginCommandBuffer>(vkGetDeviceProcAddr(logical_device, "vkBeginCommandBuffer"));
-        if( vkBeginCommandBuffer == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkBeginCommandBuffer." << std::endl;
-            return -1;
-        }
-        PFN_vkEndCommandBuffer vkEndCommandBuffer;
-        vkEndCommandBuffer =
-                reinterpret_cast<PFN_vkEndCommandBuffer>(vkGetDeviceProcAddr(logical_device, "vkEndCommandBuffer"));
-        if( vkEndCommandBuffer == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkEndCommandBuffer." << std::endl;
-            return -1;
-        }
-        PFN_vkResetCommandBuffer vkResetCommandBuffer;
-        vkResetCommandBuffer =
-                reinterpret_cast<PFN_vkResetCommandBuffer>(vkGetDeviceProcAddr(logical_device, "vkResetCommandBuffer"));
-        if( vkResetCommandBuffer == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkResetCommandBuffer." << std::endl;
-            return -1;
-        }
-        PFN_vkResetCommandPool vkResetCommandPool;
-        vkResetCommandPool =
-                reinterpret_cast<PFN_vkResetCommandPool>(vkGetDeviceProcAddr(logical_device, "vkResetCommandPool"));
-        if( vkResetCommandPool == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkResetCommandPool." << std::endl;
-            return -1;
-        }
-        PFN_vkWaitForFences vkWaitForFences;
-        vkWaitForFences =
-                reinterpret_cast<PFN_vkWaitForFences>(vkGetDeviceProcAddr(logical_device, "vkWaitForFences"));
-        if( vkWaitForFences == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkWaitForFences." << std::endl;
-            return -1;
-        }
-        PFN_vkQueueSubmit vkQueueSubmit;
-        vkQueueSubmit =
-                reinterpret_cast<PFN_vkQueueSubmit>(vkGetDeviceProcAddr(logical_device, "vkQueueSubmit"));
-        if( vkQueueSubmit == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkQueueSubmit." << std::endl;
-            return -1;
-        }
-        PFN_vkQueueWaitIdle vkQueueWaitIdle;
-        vkQueueWaitIdle =
-                reinterpret_cast<PFN_vkQueueWaitIdle>(vkGetDeviceProcAddr(logical_device, "vkQueueWaitIdle"));
-        if( vkQueueWaitIdle == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkQueueWaitIdle." << std::endl;
-            return -1;
-        }
-        PFN_vkDestroyFence vkDestroyFence;
-        vkDestroyFence =
-                reinterpret_cast<PFN_vkDestroyFence>(vkGetDeviceProcAddr(logical_device, "vkDestroyFence"));
-        if( vkDestroyFence == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkDestroyFence." << std::endl;
-            return -1;
-        }
-        PFN_vkDestroySemaphore vkDestroySemaphore;
-        vkDestroySemaphore =
-                reinterpret_cast<PFN_vkDestroySemaphore>(vkGetDeviceProcAddr(logical_device, "vkDestroySemaphore"));
-        if( vkDestroySemaphore == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkDestroySemaphore." << std::endl;
-            return -1;
-        }
-        PFN_vkFreeCommandBuffers vkFreeCommandBuffers;
-        vkFreeCommandBuffers =
-                reinterpret_cast<PFN_vkFreeCommandBuffers>(vkGetDeviceProcAddr(logical_device, "vkFreeCommandBuffers"));
-        if( vkFreeCommandBuffers == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkFreeCommandBuffers." << std::endl;
-            return -1;
-        }
-        PFN_vkDestroyCommandPool vkDestroyCommandPool;
-        vkDestroyCommandPool =
-                reinterpret_cast<PFN_vkDestroyCommandPool>(vkGetDeviceProcAddr(logical_device, "vkDestroyCommandPool"));
-        if( vkDestroyCommandPool == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkDestroyCommandPool." << std::endl;
-            return -1;
-        }
-        PFN_vkAllocateMemory vkAllocateMemory;
-        vkAllocateMemory =
-                reinterpret_cast<PFN_vkAllocateMemory>(vkGetDeviceProcAddr(logical_device, "vkAllocateMemory"));
-        if( vkAllocateMemory == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkAllocateMemory." << std::endl;
-            return -1;
-        }
-        PFN_vkBindBufferMemory vkBindBufferMemory;
-        vkBindBufferMemory =
-                reinterpret_cast<PFN_vkBindBufferMemory>(vkGetDeviceProcAddr(logical_device, "vkBindBufferMemory"));
-        if( vkBindBufferMemory == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkBindBufferMemory." << std::endl;
-            return -1;
-        }
-        PFN_vkCmdPipelineBarrier vkCmdPipelineBarrier;
-        vkCmdPipelineBarrier =
-                reinterpret_cast<PFN_vkCmdPipelineBarrier>(vkGetDeviceProcAddr(logical_device, "vkCmdPipelineBarrier"));
-        if( vkCmdPipelineBarrier == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCmdPipelineBarrier." << std::endl;
-            return -1;
-        }
-        PFN_vkCreateBufferView vkCreateBufferView;
-        vkCreateBufferView =
-                reinterpret_cast<PFN_vkCreateBufferView>(vkGetDeviceProcAddr(logical_device, "vkCreateBufferView"));
-        if( vkCreateBufferView == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCreateBufferView." << std::endl;
-            return -1;
-        }
-        PFN_vkCreateImage vkCreateImage;
-        vkCreateImage =
-                reinterpret_cast<PFN_vkCreateImage>(vkGetDeviceProcAddr(logical_device, "vkCreateImage"));
-        if( vkCreateImage == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCreateImage." << std::endl;
-            return -1;
-        }
-        PFN_vkGetImageMemoryRequirements vkGetImageMemoryRequirements;
-        vkGetImageMemoryRequirements =
-                reinterpret_cast<PFN_vkGetImageMemoryRequirements>(vkGetDeviceProcAddr(logical_device, "vkGetImageMemoryRequirements"));
-        if( vkGetImageMemoryRequirements == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkGetImageMemoryRequirements." << std::endl;
-            return -1;
-        }
-        PFN_vkBindImageMemory vkBindImageMemory;
-        vkBindImageMemory =
-                reinterpret_cast<PFN_vkBindImageMemory>(vkGetDeviceProcAddr(logical_device, "vkBindImageMemory"));
-        if( vkBindImageMemory == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkBindImageMemory." << std::endl;
-            return -1;
-        }
-        PFN_vkCreateImageView vkCreateImageView;
-        vkCreateImageView =
-                reinterpret_cast<PFN_vkCreateImageView>(vkGetDeviceProcAddr(logical_device, "vkCreateImageView"));
-        if( vkCreateImageView == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCreateImageView." << std::endl;
-            return -1;
-        }
-        PFN_vkMapMemory vkMapMemory;
-        vkMapMemory =
-                reinterpret_cast<PFN_vkMapMemory>(vkGetDeviceProcAddr(logical_device, "vkMapMemory"));
-        if( vkMapMemory == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkMapMemory." << std::endl;
-            return -1;
-        }
-        PFN_vkFlushMappedMemoryRanges vkFlushMappedMemoryRanges;
-        vkFlushMappedMemoryRanges =
-                reinterpret_cast<PFN_vkFlushMappedMemoryRanges>(vkGetDeviceProcAddr(logical_device, "vkFlushMappedMemoryRanges"));
-        if( vkFlushMappedMemoryRanges == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkFlushMappedMemoryRanges." << std::endl;
-            return -1;
-        }
-        PFN_vkUnmapMemory vkUnmapMemory;
-        vkUnmapMemory =
-                reinterpret_cast<PFN_vkUnmapMemory>(vkGetDeviceProcAddr(logical_device, "vkUnmapMemory"));
-        if( vkUnmapMemory == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkUnmapMemory." << std::endl;
-            return -1;
-        }
-        PFN_vkCmdCopyBuffer vkCmdCopyBuffer;
-        vkCmdCopyBuffer =
-                reinterpret_cast<PFN_vkCmdCopyBuffer>(vkGetDeviceProcAddr(logical_device, "vkCmdCopyBuffer"));
-        if( vkCmdCopyBuffer == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCmdCopyBuffer." << std::endl;
-            return -1;
-        }
-        PFN_vkCmdCopyBufferToImage vkCmdCopyBufferToImage;
-        vkCmdCopyBufferToImage =
-                reinterpret_cast<PFN_vkCmdCopyBufferToImage>(vkGetDeviceProcAddr(logical_device, "vkCmdCopyBufferToImage"));
-        if( vkCmdCopyBufferToImage == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCmdCopyBufferToImage." << std::endl;
-            return -1;
-        }
-        PFN_vkCmdCopyImageToBuffer vkCmdCopyImageToBuffer;
-        vkCmdCopyImageToBuffer =
-                reinterpret_cast<PFN_vkCmdCopyImageToBuffer>(vkGetDeviceProcAddr(logical_device, "vkCmdCopyImageToBuffer"));
-        if( vkCmdCopyImageToBuffer == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCmdCopyImageToBuffer." << std::endl;
-            return -1;
-        }
-        PFN_vkCreateSampler vkCreateSampler;
-        vkCreateSampler =
-                reinterpret_cast<PFN_vkCreateSampler>(vkGetDeviceProcAddr(logical_device, "vkCreateSampler"));
-        if( vkCreateSampler == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCreateSampler." << std::endl;
-            return -1;
-        }
-        PFN_vkGetPhysicalDeviceFormatProperties vkGetPhysicalDeviceFormatProperties;
-        vkGetPhysicalDeviceFormatProperties =
-                reinterpret_cast<PFN_vkGetPhysicalDeviceFormatProperties>(vkGetDeviceProcAddr(logical_device, "vkGetPhysicalDeviceFormatProperties"));
-        if( vkGetPhysicalDeviceFormatProperties == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkGetPhysicalDeviceFormatProperties." << std::endl;
+        DeviceDispatch device_functions;
+        if (!create_device_dispatch(instance_functions.vkGetDeviceProcAddr, logical_device,
+                                    desired_extensions_DeviceExtensionProperties, device_functions)){
             return -1;
         }
 
@@ -776,7 +391,7 @@ int main() {
         buffer_create_info.pQueueFamilyIndices = nullptr;
 
         VkBuffer buffer;
-        result = vkCreateBuffer(logical_device, &buffer_create_info, nullptr, &buffer);
+        result = device_functions.vkCreateBuffer(logical_device, &buffer_create_info, nullptr, &buffer);
         if( VK_SUCCESS != result ) {
             std::cout << "Could not create a buffer." << std::endl;
             return -1;
@@ -784,14 +399,14 @@ int main() {
 
         VkBuffer source_buffer, destination_buffer;
         buffer_create_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-        result = vkCreateBuffer(logical_device, &buffer_create_info, nullptr, &source_buffer);
+        result = device_functions.vkCreateBuffer(logical_device, &buffer_create_info, nullptr, &source_buffer);
         if( VK_SUCCESS != result ) {
             std::cout << "Could not create a buffer." << std::endl;
             return -1;
         }
 
         buffer_create_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-        result = vkCreateBuffer(logical_device, &buffer_create_info, nullptr, &destination_buffer);
+        result = device_functions.vkCreateBuffer(logical_device, &buffer_create_info, nullptr, &destination_buffer);
         if( VK_SUCCESS != result ) {
             std::cout << "Could not create a buffer." << std::endl;
             return -1;
@@ -799,32 +414,33 @@ int main() {
 
         VkBuffer staging_buffer;
         buffer_create_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-        result = vkCreateBuffer(logical_device, &buffer_create_info, nullptr, &staging_buffer);
+        result = device_functions.vkCreateBuffer(logical_device, &buffer_create_info, nullptr, &staging_buffer);
         if( VK_SUCCESS != result ) {
             std::cout << "Could not create a buffer." << std::endl;
             return -1;
         }
         // Allocating and binding a memory object for a buffer
         VkPhysicalDeviceMemoryProperties physical_device_memory_properties;
-        vkGetPhysicalDeviceMemoryProperties(physical_device, &physical_device_memory_properties);
+        instance_functions.vkGetPhysicalDeviceMemoryProperties(physical_device, &physical_device_memory_properties);
+        MemoryTypeResolver memory_type_resolver;
+        memory_type_resolver.init(physical_device_memory_properties);
         VkMemoryRequirements memory_requirements;
-        vkGetBufferMemoryRequirements(logical_device, buffer, &memory_requirements);
+        device_functions.vkGetBufferMemoryRequirements(logical_device, buffer, &memory_requirements);
         VkDeviceMemory memory_object{VK_NULL_HANDLE};
         VkMemoryPropertyFlagBits memory_properties{VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT};
-        for (uint32_t type = 0; type < physical_device_memory_properties.memoryTypeCount; ++type) {
-            if ((memory_requirements.memoryTypeBits&(1<<type)) && (physical_device_memory_properties.memoryTypes[type].propertyFlags & memory_properties) == memory_properties){
-                VkMemoryAllocateInfo buffer_memory_allocate_info{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, nullptr, memory_requirements.size, type};
-                result = vkAllocateMemory(logical_device, &buffer_memory_allocate_info, nullptr, &memory_object);
-                if (VK_SUCCESS == result){
-                    break;
-                }
+        MemoryTypeCandidates memory_types = memory_type_resolver.candidates(memory_requirements.memoryTypeBits, memory_properties, 0, MemoryUsage::Upload);
+        for (uint32_t i = 0; i < memory_types.count; ++i) {
+            VkMemoryAllocateInfo buffer_memory_allocate_info{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, nullptr, memory_requirements.size, memory_types.types[i]};
+            result = device_functions.vkAllocateMemory(logical_device, &buffer_memory_allocate_info, nullptr, &memory_object);
+            if (VK_SUCCESS == result){
+                break;
             }
         }
         if (memory_object == VK_NULL_HANDLE){
             std::cout << "Could not allocate memory for a buffer.\n";
             return -1;
         }
-        result = vkBindBufferMemory(logical_device, staging_buffer, memory_object, 0);
+        result = device_functions.vkBindBufferMemory(logical_device, staging_buffer, memory_object, 0);
         if (result != VK_SUCCESS){
             std::cout << "Could not bind memory object to a buffer.\n";
             return -1;
@@ -850,19 +466,19 @@ int main() {
 
         // Get Device Queue
         VkQueue GraphicsQueue;
-        vkGetDeviceQueue( logical_device, GraphicsQueueFamilyIndex, 0, &GraphicsQueue );
+        device_functions.vkGetDeviceQueue( logical_device, GraphicsQueueFamilyIndex, 0, &GraphicsQueue );
         VkQueue PresentQueue;
-        vkGetDeviceQueue( logical_device, PresentQueueFamilyIndex, 0, &PresentQueue );
+        device_functions.vkGetDeviceQueue( logical_device, PresentQueueFamilyIndex, 0, &PresentQueue );
         //Selecting a desired presentation mode
         uint32_t present_modes_count{};
-        result = vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, presentation_surface, &present_modes_count, nullptr);
+        result = instance_functions.vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, presentation_surface, &present_modes_count, nullptr);
         if (result != VK_SUCCESS || present_modes_count==0){
             std::cout << "Could not get the number of supported present modes." <<
                       std::endl;
             return -1;
         }
         std::vector<VkPresentModeKHR> present_modes(present_modes_count);
-        result = vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, presentation_surface, &present_modes_count, present_modes.data());
+        result = instance_functions.vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, presentation_surface, &present_modes_count, present_modes.data());
         if( (VK_SUCCESS != result) ||  (0 == present_modes_count) ) {
             std::cout << "Could not enumerate present modes." << std::endl;
             return -1;
@@ -894,7 +510,7 @@ int main() {
         }
         //Getting the capabilities of a presentation surface
         VkSurfaceCapabilitiesKHR surface_capabilities;
-        result = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, presentation_surface, &surface_capabilities);
+        result = instance_functions.vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, presentation_surface, &surface_capabilities);
         if( VK_SUCCESS != result ) {
             std::cout << "Could not get the capabilities of a presentation surface." << std::endl;
             return -1;
@@ -937,13 +553,13 @@ int main() {
         // Selecting a format of swapchain images
         VkSurfaceFormatKHR desired_surface_format{ VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };  // image format and color-space pair
         uint32_t formats_count;
-        result = vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, presentation_surface, &formats_count, nullptr);
+        result = instance_functions.vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, presentation_surface, &formats_count, nullptr);
         if (result != VK_SUCCESS || formats_count == 0){
             std::cout << "Could not get the number of supported present formats." << std::endl;
             return -1;
         }
         std::vector<VkSurfaceFormatKHR> surface_formats(formats_count);
-        result = vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, presentation_surface, &formats_count, surface_formats.data());
+        result = instance_functions.vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, presentation_surface, &formats_count, surface_formats.data());
         if (result != VK_SUCCESS || formats_count == 0){
             std::cout << "Could not get the number of supported present formats." << std::endl;
             return -1;
@@ -1001,24 +617,24 @@ int main() {
         swapchain_create_info.clipped = VK_TRUE;
         swapchain_create_info.oldSwapchain = old_swapchain;
         VkSwapchainKHR swapchain;
-        result = vkCreateSwapchainKHR(logical_device, &swapchain_create_info, nullptr, &swapchain);
+        result = device_functions.vkCreateSwapchainKHR(logical_device, &swapchain_create_info, nullptr, &swapchain);
         if (result != VK_SUCCESS || swapchain == VK_NULL_HANDLE){
             std::cout << "couldn't create a swapchain\n";
             return -1;
         }
         if (old_swapchain != VK_NULL_HANDLE){
-            vkDestroySwapchainKHR(logical_device, old_swapchain, nullptr);
+            device_functions.vkDestroySwapchainKHR(logical_device, old_swapchain, nullptr);
             old_swapchain = VK_NULL_HANDLE;
         }
         // Getting handles of swapchain images
         uint32_t images_count;
-        result = vkGetSwapchainImagesKHR(logical_device, swapchain, &images_count, nullptr);
+        result = device_functions.vkGetSwapchainImagesKHR(logical_device, swapchain, &images_count, nullptr);
         if (result != VK_SUCCESS || images_count == 0){
             std::cout << "could not get the number of swapchain images.\n";
             return -1;
         }
         std::vector<VkImage> swapchain_images(images_count);
-        result = vkGetSwapchainImagesKHR(logical_device, swapchain, &images_count, swapchain_images.data());
+        result = device_functions.vkGetSwapchainImagesKHR(logical_device, swapchain, &images_count, swapchain_images.data());
         if (result != VK_SUCCESS || images_count == 0){
             std::cout << "could not enumerate swapchain images.\n";
             return -1;
@@ -1026,7 +642,7 @@ int main() {
         // Acquiring a swapchain image
         VkSemaphore semaphore;
         VkSemaphoreCreateInfo semaphore_create_info{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, nullptr, 0};
-        result = vkCreateSemaphore(logical_device, &semaphore_create_info, nullptr, &semaphore);
+        result = device_functions.vkCreateSemaphore(logical_device, &semaphore_create_info, nullptr, &semaphore);
         if( VK_SUCCESS != result ) {
             std::cout << "Could not create a semaphore." << std::endl;
             return -1;
@@ -1036,13 +652,13 @@ int main() {
         fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
         fence_create_info.pNext = nullptr;
         fence_create_info.flags = 0;
-        result = vkCreateFence(logical_device, &fence_create_info, nullptr, &fence);
+        result = device_functions.vkCreateFence(logical_device, &fence_create_info, nullptr, &fence);
         if( VK_SUCCESS != result ) {
             std::cout << "Could not create a fence." << std::endl;
             return -1;
         }
         uint32_t image_index;
-        result = vkAcquireNextImageKHR(logical_device, swapchain, 2000000000, semaphore, fence, &image_index);  // 2000000000 : 2s
+        result = device_functions.vkAcquireNextImageKHR(logical_device, swapchain, 2000000000, semaphore, fence, &image_index);  // 2000000000 : 2s
         if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR){
             std::cout << "could not vkAcquireNextImageKHR swapchain images.\n";
             return -1;
@@ -1052,11 +668,12 @@ int main() {
         VkCommandPoolCreateInfo command_pool_create_info;
         command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
         command_pool_create_info.pNext = nullptr;
-        command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        // The buffers are recorded once and never reset on their own
+        command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
         command_pool_create_info.queueFamilyIndex = GraphicsQueueFamilyIndex;
 
         VkCommandPool command_pool;
-        result = vkCreateCommandPool(logical_device, &command_pool_create_info, nullptr, &command_pool);
+        result = device_functions.vkCreateCommandPool(logical_device, &command_pool_create_info, nullptr, &command_pool);
         if( VK_SUCCESS != result ) {
             std::cout << "Could not create command pool." << std::endl;
             return -1;
@@ -1069,7 +686,7 @@ int main() {
         command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
         command_buffer_allocate_info.commandBufferCount = 5;
         std::vector<VkCommandBuffer> command_buffers{5};
-        result = vkAllocateCommandBuffers(logical_device, &command_buffer_allocate_info, command_buffers.data());
+        result = device_functions.vkAllocateCommandBuffers(logical_device, &command_buffer_allocate_info, command_buffers.data());
         if (result != VK_SUCCESS){
             std::cout << "could not allocate command buffers.\n";
             return -1;
@@ -1087,7 +704,7 @@ int main() {
         buffer_view_create_info.range = memory_range;
 
         VkBufferView buffer_view;
-        result = vkCreateBufferView(logical_device, &buffer_view_create_info, nullptr, &buffer_view);
+        result = device_functions.vkCreateBufferView(logical_device, &buffer_view_create_info, nullptr, &buffer_view);
         if (result != VK_SUCCESS){
             std::cout << "Could not create buffer view.\n";
             return -1;
@@ -1116,7 +733,7 @@ int main() {
         image_create_info.pQueueFamilyIndices = nullptr;
         image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
         VkImage image;
-        result = vkCreateImage(logical_device, &image_create_info, nullptr, &image);
+        result = device_functions.vkCreateImage(logical_device, &image_create_info, nullptr, &image);
         if( VK_SUCCESS != result ) {
             std::cout << "Could not create an image." << std::endl;
             return -1;
@@ -1139,7 +756,7 @@ int main() {
         dst_image_create_info.pQueueFamilyIndices = nullptr;
         dst_image_create_info.initialLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
         VkImage destination_image;
-        result = vkCreateImage(logical_device, &dst_image_create_info, nullptr, &destination_image);
+        result = device_functions.vkCreateImage(logical_device, &dst_image_create_info, nullptr, &destination_image);
         if( VK_SUCCESS != result ) {
             std::cout << "Could not create an dest image." << std::endl;
             return -1;
@@ -1162,28 +779,27 @@ int main() {
         source_image_create_info.pQueueFamilyIndices = nullptr;
         source_image_create_info.initialLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
         VkImage source_image;
-        result = vkCreateImage(logical_device, &source_image_create_info, nullptr, &source_image);
+        result = device_functions.vkCreateImage(logical_device, &source_image_create_info, nullptr, &source_image);
         if( VK_SUCCESS != result ) {
             std::cout << "Could not create an dest image." << std::endl;
             return -1;
         }
 
         // Allocating and binding a memory object to an image
-        vkGetImageMemoryRequirements(logical_device, image, &memory_requirements);
-        for (uint32_t type = 0; type < physical_device_memory_properties.memoryTypeCount; ++type) {
-            if ((memory_requirements.memoryTypeBits&(1<<type)) && (physical_device_memory_properties.memoryTypes[type].propertyFlags & memory_properties) == memory_properties){
-                VkMemoryAllocateInfo image_memory_allocate_info{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, nullptr, memory_requirements.size, type};
-                result = vkAllocateMemory(logical_device, &image_memory_allocate_info, nullptr, &memory_object);
-                if (VK_SUCCESS == result){
-                    break;
-                }
+        device_functions.vkGetImageMemoryRequirements(logical_device, image, &memory_requirements);
+        memory_types = memory_type_resolver.candidates(memory_requirements.memoryTypeBits, memory_properties, 0, MemoryUsage::GpuOnly);
+        for (uint32_t i = 0; i < memory_types.count; ++i) {
+            VkMemoryAllocateInfo image_memory_allocate_info{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, nullptr, memory_requirements.size, memory_types.types[i]};
+            result = device_functions.vkAllocateMemory(logical_device, &image_memory_allocate_info, nullptr, &memory_object);
+            if (VK_SUCCESS == result){
+                break;
             }
         }
         if (memory_object == VK_NULL_HANDLE){
             std::cout << "Could not allocate memory for an image.\n";
             return -1;
         }
-        result = vkBindImageMemory(logical_device, image, memory_object, 0);
+        result = device_functions.vkBindImageMemory(logical_device, image, memory_object, 0);
         if (result != VK_SUCCESS){
             std::cout << "Could not bind memory object to an image.\n";
             return -1;
@@ -1204,7 +820,7 @@ int main() {
         image_view_create_info.subresourceRange.baseArrayLayer = 0;
         image_view_create_info.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
         VkImageView image_view;
-        result = vkCreateImageView(logical_device, &image_view_create_info, nullptr, &image_view);
+        result = device_functions.vkCreateImageView(logical_device, &image_view_create_info, nullptr, &image_view);
         if (result != VK_SUCCESS){
             std::cout << "Could not create an image view.\n";
             return -1;
@@ -1224,7 +840,7 @@ int main() {
         image_cubemap_view_create_info.subresourceRange.baseArrayLayer = 0;
         image_cubemap_view_create_info.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
         VkImageView image_cubemap_view;
-        result = vkCreateImageView(logical_device, &image_cubemap_view_create_info, nullptr, &image_cubemap_view);
+        result = device_functions.vkCreateImageView(logical_device, &image_cubemap_view_create_info, nullptr, &image_cubemap_view);
         if (result != VK_SUCCESS){
             std::cout << "Could not create an image view.\n";
             return -1;
@@ -1257,7 +873,7 @@ int main() {
         // Mapping, updating and unmapping host-visible memory
         VkDeviceSize offset, data_size;
         void* data{nullptr}, *local_pointer{nullptr};
-        result = vkMapMemory(logical_device, memory_object, offset, data_size, 0, &local_pointer);
+        result = device_functions.vkMapMemory(logical_device, memory_object, offset, data_size, 0, &local_pointer);
         if (result != VK_SUCCESS){
             std::cout << "Could not vkMapMemory\n";
             return -1;
@@ -1271,12 +887,12 @@ int main() {
         mapped_memory_range.offset = offset;
         mapped_memory_range.size = data_size;
         memory_ranges.push_back(mapped_memory_range);
-        result = vkFlushMappedMemoryRanges(logical_device, memory_ranges.size(), memory_ranges.data());
+        result = device_functions.vkFlushMappedMemoryRanges(logical_device, memory_ranges.size(), memory_ranges.data());
         if (result != VK_SUCCESS){
             std::cout << "Could not vkFlushMappedMemoryRanges\n";
             return -1;
         }
-        vkUnmapMemory(logical_device, memory_object);
+        device_functions.vkUnmapMemory(logical_device, memory_object);
 
         // Creating a sampler
         VkSamplerCreateInfo sampler_create_info{
@@ -1299,8 +915,11 @@ int main() {
             VK_BORDER_COLOR_INT_OPAQUE_BLACK,
             false
         };
+        // Equivalent create infos get the same sampler back from the cache
+        ObjectCache object_cache;
+        object_cache.init(device_functions);
         VkSampler sampler;
-        result = vkCreateSampler(logical_device, &sampler_create_info, nullptr, &sampler);
+        result = object_cache.get_sampler(sampler_create_info, sampler);
         if (VK_SUCCESS != result){
             std::cout << "Could not create sampler." << std::endl;
             return -1;
@@ -1309,8 +928,8 @@ int main() {
         // Creating a sampled image
         VkFormat format{VK_FORMAT_R8G8B8A8_UNORM};
         VkFormatProperties format_properties;
-        vkGetPhysicalDeviceFormatProperties( physical_device, format,
-                                             &format_properties );
+        instance_functions.vkGetPhysicalDeviceFormatProperties( physical_device, format,
+                                                                &format_properties );
         if (!(format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)){
             std::cout << "Provided format is not supported for a sampled image." << std::endl;
             return -1;
@@ -1324,8 +943,8 @@ int main() {
         VkCommandBuffer command_buffer = command_buffers[0];
 
         VkPipelineStageFlags generating_stages{VK_PIPELINE_STAGE_ALL_COMMANDS_BIT}, consuming_stages{VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT};
-        vkCmdPipelineBarrier(command_buffer, generating_stages, consuming_stages, 0, 0, nullptr, buffer_memory_barriers.size(), buffer_memory_barriers.data(), 0 ,
-                             nullptr);
+        device_functions.vkCmdPipelineBarrier(command_buffer, generating_stages, consuming_stages, 0, 0, nullptr, buffer_memory_barriers.size(), buffer_memory_barriers.data(), 0 ,
+                                              nullptr);
 
         VkCommandBufferInheritanceInfo *secondary_command_buffer{nullptr};
         VkCommandBufferBeginInfo command_buffer_begin_info;
@@ -1333,23 +952,23 @@ int main() {
         command_buffer_begin_info.pNext = nullptr;
         command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
         command_buffer_begin_info.pInheritanceInfo = secondary_command_buffer;
-        result = vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info);
+        result = device_functions.vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info);
         if (result != VK_SUCCESS){
             std::cout << "Could not begin command buffer recording operation.\n";
             return -1;
         }
 
-        vkCmdPipelineBarrier(command_buffer, generating_stages, consuming_stages, 0, 0, nullptr, 0, nullptr, image_memory_barriers.size(), image_memory_barriers.data());
+        device_functions.vkCmdPipelineBarrier(command_buffer, generating_stages, consuming_stages, 0, 0, nullptr, 0, nullptr, image_memory_barriers.size(), image_memory_barriers.data());
 
         // do something
 
-        SetBufferMemoryBarrier(vkCmdPipelineBarrier, command_buffer, generating_stages, VK_PIPELINE_STAGE_TRANSFER_BIT, {{destination_buffer, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED}});
+        SetBufferMemoryBarrier(device_functions, command_buffer, generating_stages, VK_PIPELINE_STAGE_TRANSFER_BIT, {{destination_buffer, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED}});
         std::vector<VkBufferCopy> regions{{0, offset, data_size}};
-        vkCmdCopyBuffer(command_buffer, source_buffer, destination_buffer, regions.size(), regions.data());
-        SetBufferMemoryBarrier(vkCmdPipelineBarrier, command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, consuming_stages, {{destination_buffer, VK_ACCESS_TRANSFER_WRITE_BIT, 0, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED}});
+        device_functions.vkCmdCopyBuffer(command_buffer, source_buffer, destination_buffer, regions.size(), regions.data());
+        SetBufferMemoryBarrier(device_functions, command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, consuming_stages, {{destination_buffer, VK_ACCESS_TRANSFER_WRITE_BIT, 0, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED}});
 
         // Copying data from buffer to image
-        SetBufferMemoryBarrier(vkCmdPipelineBarrier, command_buffer, generating_stages, VK_PIPELINE_STAGE_TRANSFER_BIT, {{destination_buffer, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED}});
+        SetBufferMemoryBarrier(device_functions, command_buffer, generating_stages, VK_PIPELINE_STAGE_TRANSFER_BIT, {{destination_buffer, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED}});
         std::vector<VkBufferImageCopy> buffer_image_copy_regions;
         VkBufferImageCopy buffer_image_copy;
         buffer_image_copy.bufferOffset = 0;
@@ -1359,12 +978,12 @@ int main() {
         buffer_image_copy.imageOffset = {0, 0, 1};
         buffer_image_copy.imageExtent = { 64, 64, 1 };
         buffer_image_copy_regions.push_back(buffer_image_copy);
-        vkCmdCopyBufferToImage(command_buffer, source_buffer, destination_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, buffer_image_copy_regions.size(),
-                               buffer_image_copy_regions.data());
-        SetBufferMemoryBarrier(vkCmdPipelineBarrier, command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, consuming_stages, {{destination_buffer, VK_ACCESS_TRANSFER_WRITE_BIT, 0, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED}});
+        device_functions.vkCmdCopyBufferToImage(command_buffer, source_buffer, destination_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, buffer_image_copy_regions.size(),
+                                                buffer_image_copy_regions.data());
+        SetBufferMemoryBarrier(device_functions, command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, consuming_stages, {{destination_buffer, VK_ACCESS_TRANSFER_WRITE_BIT, 0, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED}});
 
         // Copying data from an image to a buffer
-        SetBufferMemoryBarrier(vkCmdPipelineBarrier, command_buffer, generating_stages, VK_PIPELINE_STAGE_TRANSFER_BIT, {{destination_buffer, 0, VK_ACCESS_TRANSFER_READ_BIT, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED}});
+        SetBufferMemoryBarrier(device_functions, command_buffer, generating_stages, VK_PIPELINE_STAGE_TRANSFER_BIT, {{destination_buffer, 0, VK_ACCESS_TRANSFER_READ_BIT, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED}});
         std::vector<VkBufferImageCopy> image_buffer_copy_regions;
         VkBufferImageCopy image_buffer_copy;
         image_buffer_copy.bufferOffset = 0;
@@ -1374,12 +993,12 @@ int main() {
         image_buffer_copy.imageOffset = {0, 0, 1};
         image_buffer_copy.imageExtent = { 64, 64, 1 };
         image_buffer_copy_regions.push_back(image_buffer_copy);
-        vkCmdCopyImageToBuffer(command_buffer, source_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, destination_buffer, image_buffer_copy_regions.size(),
-                               image_buffer_copy_regions.data());
-        SetBufferMemoryBarrier(vkCmdPipelineBarrier, command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, consuming_stages, {{destination_buffer, VK_ACCESS_TRANSFER_READ_BIT, 0, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED}});
+        device_functions.vkCmdCopyImageToBuffer(command_buffer, source_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, destination_buffer, image_buffer_copy_regions.size(),
+                                                image_buffer_copy_regions.data());
+        SetBufferMemoryBarrier(device_functions, command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, consuming_stages, {{destination_buffer, VK_ACCESS_TRANSFER_READ_BIT, 0, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED}});
 
         // Ending a command buffer recording operation
-        result = vkEndCommandBuffer(command_buffer);
+        result = device_functions.vkEndCommandBuffer(command_buffer);
         if (result != VK_SUCCESS){
             std::cout << "Error occurred during command buffer recording.\n";
             return -1;
@@ -1388,7 +1007,7 @@ int main() {
         //Submitting command buffers to a queue
         VkSemaphore rendering_semaphore;
         VkSemaphoreCreateInfo semaphore_create_info2{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, nullptr, 0};
-        result = vkCreateSemaphore(logical_device, &semaphore_create_info2, nullptr, &rendering_semaphore);
+        result = device_functions.vkCreateSemaphore(logical_device, &semaphore_create_info2, nullptr, &rendering_semaphore);
         if( VK_SUCCESS != result ) {
             std::cout << "Could not create a semaphore." << std::endl;
             return -1;
@@ -1408,7 +1027,7 @@ int main() {
         submit_info.signalSemaphoreCount = static_cast<uint32_t >(rendering_semaphores.size());
         submit_info.pSignalSemaphores = rendering_semaphores.data();
 
-        result = vkQueueSubmit(PresentQueue, 1, &submit_info, VK_NULL_HANDLE);
+        result = device_functions.vkQueueSubmit(PresentQueue, 1, &submit_info, VK_NULL_HANDLE);
         if( VK_SUCCESS != result ) {
             std::cout << "Error occurred during command buffer submission." <<
                       std::endl;
@@ -1419,7 +1038,7 @@ int main() {
         std::vector<VkFence> fences{fence};
         VkBool32 wait_for_all{VK_TRUE};
         uint64_t timeout{2000000000};
-        result = vkWaitForFences(logical_device, static_cast<uint32_t>(fences.size()), fences.data(), wait_for_all, timeout);
+        result = device_functions.vkWaitForFences(logical_device, static_cast<uint32_t>(fences.size()), fences.data(), wait_for_all, timeout);
         if (result != VK_SUCCESS){
             std::cout << "Waiting on fence failed.\n";
             return -1;
@@ -1436,52 +1055,47 @@ int main() {
         present_info.pSwapchains = swapchains.data();
         present_info.pImageIndices = image_indices.data();
         present_info.pResults = nullptr;
-        result = vkQueuePresentKHR(PresentQueue, &present_info);
+        result = device_functions.vkQueuePresentKHR(PresentQueue, &present_info);
         if (result != VK_SUCCESS){
             std::cout << "could not vkQueuePresentKHR present images.\n";
             return -1;
         }
         // Waiting until all commands submitted to a queue are finished
-        result = vkQueueWaitIdle(GraphicsQueue);
+        result = device_functions.vkQueueWaitIdle(GraphicsQueue);
         if (result != VK_SUCCESS){
             std::cout << "Waiting for all operations submitted to queue failed.\n";
             return -1;
         }
         // Waiting for all submitted commands to be finished
-        result = vkDeviceWaitIdle(logical_device);
+        result = device_functions.vkDeviceWaitIdle(logical_device);
         if (result != VK_SUCCESS){
             std::cout << "Waiting on a device failed.\n";
             return -1;
         }
         // Destroy fence
         if (fence != VK_NULL_HANDLE){
-            vkDestroyFence(logical_device, fence, nullptr);
+            device_functions.vkDestroyFence(logical_device, fence, nullptr);
             fence = VK_NULL_HANDLE;
         }
 
         // Destroy semaphore
         if (semaphore != VK_NULL_HANDLE){
-            vkDestroySemaphore(logical_device, semaphore, nullptr);
+            device_functions.vkDestroySemaphore(logical_device, semaphore, nullptr);
             semaphore = VK_NULL_HANDLE;
         }
-        // Freeing command buffers
-        if (!command_buffers.empty()){
-            vkFreeCommandBuffers(logical_device, command_pool, command_buffers.size(), command_buffers.data());
-            command_buffers.clear();
-        }
-        // Destroying a command pool
+        // Destroying a command pool, which frees its command buffers
         if (command_pool != VK_NULL_HANDLE){
-            vkDestroyCommandPool(logical_device, command_pool, nullptr);
+            device_functions.vkDestroyCommandPool(logical_device, command_pool, nullptr);
             command_pool = VK_NULL_HANDLE;
         }
         // Destroying a swapchain
         if (swapchain != VK_NULL_HANDLE){
-            vkDestroySwapchainKHR(logical_device, swapchain, nullptr);
+            device_functions.vkDestroySwapchainKHR(logical_device, swapchain, nullptr);
             swapchain = VK_NULL_HANDLE;
         }
         // Destroying a presentation surface
         if (presentation_surface != VK_NULL_HANDLE){
-            vkDestroySurfaceKHR(instance, presentation_surface, nullptr);
+            instance_functions.vkDestroySurfaceKHR(instance, presentation_surface, nullptr);
             presentation_surface = VK_NULL_HANDLE;
         }
     }
@@ -30,39 +30,14 @@ Inititalize Swapchain
 //#include "util_init.hpp"
 #include <cassert>
 #include <cstdlib>
-#include <dlfcn.h>
 #include <vulkan/vulkan.h>
 #include <iostream>
 #include "util.hpp"
 
-void *g_vulkan_library;
-PFN_vkGetInstanceProcAddr g_vkGetInstanceProcAddr;
-
-void *load_vulkan_library(){
-    void *vulkan_library = dlopen("libvulkan.so.1", RTLD_NOW);
-    if (vulkan_library == nullptr){
-        std::cout << "Could not connect with a Vulkan Runtime library." << std::endl;
-        return nullptr;
-    }
-    std::cout << "Connect with a Vulkan Runtime library successfully." <<
-              std::endl;
-    return vulkan_library;
-}
-
 /*
  * TODO: function description here
  */
-VkResult init_global_extension_properties(layer_properties &layer_props) {
-    PFN_vkEnumerateInstanceExtensionProperties vkEnumerateInstanceExtensionProperties{};
-    if (g_vkGetInstanceProcAddr != nullptr){
-        vkEnumerateInstanceExtensionProperties =
-                reinterpret_cast<PFN_vkEnumerateInstanceExtensionProperties>(g_vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceExtensionProperties"));
-        if (vkEnumerateInstanceExtensionProperties == nullptr){
-            std::cout << "Could not load global level Vulkan function named: vkEnumerateInstanceExtensionProperties." << std::endl;
-            return VK_ERROR_UNKNOWN;
-        }
-    }
-
+VkResult init_global_extension_properties(struct sample_info &info, layer_properties &layer_props) {
     VkExtensionProperties *instance_extensions;
     uint32_t instance_extension_count;
     VkResult res;
@@ -71,7 +46,7 @@ VkResult init_global_extension_properties(layer_properties &layer_props) {
     layer_name = layer_props.properties.layerName;
 
     do {
-        res = vkEnumerateInstanceExtensionProperties(layer_name, &instance_extension_count, NULL);
+        res = info.global_functions.vkEnumerateInstanceExtensionProperties(layer_name, &instance_extension_count, NULL);
         if (res) return res;
 
         if (instance_extension_count == 0) {
@@ -80,23 +55,13 @@ VkResult init_global_extension_properties(layer_properties &layer_props) {
 
         layer_props.instance_extensions.resize(instance_extension_count);
         instance_extensions = layer_props.instance_extensions.data();
-        res = vkEnumerateInstanceExtensionProperties(layer_name, &instance_extension_count, instance_extensions);
+        res = info.global_functions.vkEnumerateInstanceExtensionProperties(layer_name, &instance_extension_count, instance_extensions);
     } while (res == VK_INCOMPLETE);
 
     return res;
 }
 
 VkResult init_global_layer_properties(struct sample_info &info) {
-    PFN_vkEnumerateInstanceLayerProperties  vkEnumerateInstanceLayerProperties;
-    if (g_vkGetInstanceProcAddr != nullptr){
-        vkEnumerateInstanceLayerProperties =
-                reinterpret_cast< PFN_vkEnumerateInstanceLayerProperties >(g_vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceLayerProperties"));
-        if (vkEnumerateInstanceLayerProperties == nullptr){
-            std::cout << "Could not load global level Vulkan function named: vkEnumerateInstanceLayerProperties." << std::endl;
-            return VK_ERROR_UNKNOWN;
-        }
-    }
-
     uint32_t instance_layer_count;
     VkLayerProperties *vk_props = nullptr;
     VkResult res;
@@ -124,7 +89,7 @@ VkResult init_global_layer_properties(struct sample_info &info) {
      * of layers went down or is smaller than the size given.
      */
     do {
-        res = vkEnumerateInstanceLayerProperties(&instance_layer_count, nullptr);
+        res = info.global_functions.vkEnumerateInstanceLayerProperties(&instance_layer_count, nullptr);
         if (res) return res;
 
         if (instance_layer_count == 0) {
@@ -133,7 +98,7 @@ VkResult init_global_layer_properties(struct sample_info &info) {
 
         vk_props = (VkLayerProperties *)realloc(vk_props, instance_layer_count * sizeof(VkLayerProperties));
 
-        res = vkEnumerateInstanceLayerProperties(&instance_layer_count, vk_props);
+        res = info.global_functions.vkEnumerateInstanceLayerProperties(&instance_layer_count, vk_props);
     } while (res == VK_INCOMPLETE);
 
     /*
@@ -142,7 +107,7 @@ VkResult init_global_layer_properties(struct sample_info &info) {
     for (uint32_t i = 0; i < instance_layer_count; i++) {
         layer_properties layer_props;
         layer_props.properties = vk_props[i];
-        res = init_global_extension_properties(layer_props);
+        res = init_global_extension_properties(info, layer_props);
         if (res) return res;
         info.instance_layer_properties.push_back(layer_props);
     }
@@ -173,16 +138,6 @@ void init_device_extension_names(struct sample_info &info) {
 
 
 VkResult init_instance(struct sample_info &info, char const *const app_short_name) {
-    PFN_vkCreateInstance vkCreateInstance;
-    if (g_vkGetInstanceProcAddr != nullptr){
-        vkCreateInstance =
-                reinterpret_cast<PFN_vkCreateInstance>(g_vkGetInstanceProcAddr(nullptr, "vkCreateInstance"));
-        if (vkCreateInstance == nullptr){
-            std::cout << "Could not load global level Vulkan function named: vkCreateInstance." << std::endl;
-            return VK_ERROR_UNKNOWN;
-        }
-    }
-
     VkApplicationInfo app_info = {};
     app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
     app_info.pNext = NULL;
@@ -202,7 +157,7 @@ VkResult init_instance(struct sample_info &info, char const *const app_short_nam
     inst_info.enabledExtensionCount = info.instance_extension_names.size();
     inst_info.ppEnabledExtensionNames = info.instance_extension_names.data();
 
-    VkResult res = vkCreateInstance(&inst_info, NULL, &info.inst);
+    VkResult res = info.global_functions.vkCreateInstance(&inst_info, NULL, &info.inst);
     assert(res == VK_SUCCESS);
 
     return res;
@@ -210,10 +165,6 @@ VkResult init_instance(struct sample_info &info, char const *const app_short_nam
 
 
 VkResult init_device_extension_properties(struct sample_info &info, layer_properties &layer_props) {
-    PFN_vkEnumerateDeviceExtensionProperties vkEnumerateDeviceExtensionProperties;
-    vkEnumerateDeviceExtensionProperties =
-            reinterpret_cast<PFN_vkEnumerateDeviceExtensionProperties>(g_vkGetInstanceProcAddr(info.inst, "vkEnumerateDeviceExtensionProperties"));
-
     VkExtensionProperties *device_extensions;
     uint32_t device_extension_count;
     VkResult res;
@@ -222,7 +173,7 @@ VkResult init_device_extension_properties(struct sample_info &info, layer_proper
     layer_name = layer_props.properties.layerName;
 
     do {
-        res = vkEnumerateDeviceExtensionProperties(info.gpus[0], layer_name, &device_extension_count, NULL);
+        res = info.instance_functions.vkEnumerateDeviceExtensionProperties(info.gpus[0], layer_name, &device_extension_count, NULL);
         if (res) return res;
 
         if (device_extension_count == 0) {
@@ -231,45 +182,31 @@ VkResult init_device_extension_properties(struct sample_info &info, layer_proper
 
         layer_props.device_extensions.resize(device_extension_count);
         device_extensions = layer_props.device_extensions.data();
-        res = vkEnumerateDeviceExtensionProperties(info.gpus[0], layer_name, &device_extension_count, device_extensions);
+        res = info.instance_functions.vkEnumerateDeviceExtensionProperties(info.gpus[0], layer_name, &device_extension_count, device_extensions);
     } while (res == VK_INCOMPLETE);
 
     return res;
 }
 
 VkResult init_enumerate_device(struct sample_info &info, uint32_t gpu_count) {
-    PFN_vkEnumeratePhysicalDevices vkEnumeratePhysicalDevices;
-    vkEnumeratePhysicalDevices =
-            reinterpret_cast<PFN_vkEnumeratePhysicalDevices>(g_vkGetInstanceProcAddr(info.inst, "vkEnumeratePhysicalDevices"));
-
-    PFN_vkGetPhysicalDeviceQueueFamilyProperties vkGetPhysicalDeviceQueueFamilyProperties;
-    vkGetPhysicalDeviceQueueFamilyProperties =
-            reinterpret_cast<PFN_vkGetPhysicalDeviceQueueFamilyProperties>(g_vkGetInstanceProcAddr(info.inst, "vkGetPhysicalDeviceQueueFamilyProperties"));
-    PFN_vkGetPhysicalDeviceMemoryProperties vkGetPhysicalDeviceMemoryProperties;
-    vkGetPhysicalDeviceMemoryProperties =
-            reinterpret_cast<PFN_vkGetPhysicalDeviceMemoryProperties>(g_vkGetInstanceProcAddr(info.inst, "vkGetPhysicalDeviceMemoryProperties"));
-    PFN_vkGetPhysicalDeviceProperties vkGetPhysicalDeviceProperties;
-    vkGetPhysicalDeviceProperties =
-            reinterpret_cast<PFN_vkGetPhysicalDeviceProperties>(g_vkGetInstanceProcAddr(info.inst, "vkGetPhysicalDeviceProperties"));
-
     uint32_t const U_ASSERT_ONLY req_count = gpu_count;
-    VkResult res = vkEnumeratePhysicalDevices(info.inst, &gpu_count, nullptr);
+    VkResult res = info.instance_functions.vkEnumeratePhysicalDevices(info.inst, &gpu_count, nullptr);
     assert(gpu_count);
     info.gpus.resize(gpu_count);
 
-    res = vkEnumeratePhysicalDevices(info.inst, &gpu_count, info.gpus.data());
+    res = info.instance_functions.vkEnumeratePhysicalDevices(info.inst, &gpu_count, info.gpus.data());
     assert(!res && gpu_count >= req_count);
 
-    vkGetPhysicalDeviceQueueFamilyProperties(info.gpus[0], &info.queue_family_count, nullptr);
+    info.instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(info.gpus[0], &info.queue_family_count, nullptr);
     assert(info.queue_family_count >= 1);
 
     info.queue_props.resize(info.queue_family_count);
-    vkGetPhysicalDeviceQueueFamilyProperties(info.gpus[0], &info.queue_family_count, info.queue_props.data());
+    info.instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(info.gpus[0], &info.queue_family_count, info.queue_props.data());
     assert(info.queue_family_count >= 1);
 
     /* This is as good a place as any to do this */
-    vkGetPhysicalDeviceMemoryProperties(info.gpus[0], &info.memory_properties);
-    vkGetPhysicalDeviceProperties(info.gpus[0], &info.gpu_props);
+    info.instance_functions.vkGetPhysicalDeviceMemoryProperties(info.gpus[0], &info.memory_properties);
+    info.instance_functions.vkGetPhysicalDeviceProperties(info.gpus[0], &info.gpu_props);
     /* query device extensions for enabled layers */
     for (auto &layer_props : info.instance_layer_properties) {
         init_device_extension_properties(info, layer_props);
@@ -363,10 +300,6 @@ void init_window(struct sample_info &info) {
 }
 
 VkResult init_device(struct sample_info &info) {
-    PFN_vkCreateDevice vkCreateDevice;
-    vkCreateDevice =
-            reinterpret_cast<PFN_vkCreateDevice>(g_vkGetInstanceProcAddr(info.inst, "vkCreateDevice"));
-
     VkResult res;
     VkDeviceQueueCreateInfo queue_info = {};
 
@@ -386,7 +319,7 @@ VkResult init_device(struct sample_info &info) {
     device_info.ppEnabledExtensionNames = device_info.enabledExtensionCount ? info.device_extension_names.data() : NULL;
     device_info.pEnabledFeatures = NULL;
 
-    res = vkCreateDevice(info.gpus[0], &device_info, NULL, &info.device);
+    res = info.instance_functions.vkCreateDevice(info.gpus[0], &device_info, NULL, &info.device);
     assert(res == VK_SUCCESS);
 
     return res;
@@ -394,47 +327,21 @@ VkResult init_device(struct sample_info &info) {
 
 int main(int argc, char *argv[]) {
     // Load vulkan library
-    void* vulkan_library = load_vulkan_library();
-    g_vulkan_library = vulkan_library;
-    PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr = reinterpret_cast<PFN_vkGetInstanceProcAddr>(dlsym(vulkan_library, "vkGetInstanceProcAddr"));
-    g_vkGetInstanceProcAddr = vkGetInstanceProcAddr;
+    void *vulkan_library = load_vulkan_library();
+    auto vkGetInstanceProcAddr = load_exported_vulkan_function(vulkan_library);
     if (vkGetInstanceProcAddr == nullptr){
-        std::cout << "Could not find vkGetInstanceProcAddr in Vulkan Runtime library.\n";
         return -1;
     }
-    // Load Global Level Functions
-    PFN_vkEnumerateInstanceExtensionProperties vkEnumerateInstanceExtensionProperties{};
-    if (vkGetInstanceProcAddr != nullptr){
-        vkEnumerateInstanceExtensionProperties =
-                reinterpret_cast<PFN_vkEnumerateInstanceExtensionProperties>(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceExtensionProperties"));
-        if (vkEnumerateInstanceExtensionProperties == nullptr){
-            std::cout << "Could not load global level Vulkan function named: vkEnumerateInstanceExtensionProperties." << std::endl;
-            return -1;
-        }
-    }
-    PFN_vkEnumerateInstanceLayerProperties  vkEnumerateInstanceLayerProperties;
-    if (vkGetInstanceProcAddr != nullptr){
-        vkEnumerateInstanceLayerProperties =
-                reinterpret_cast< PFN_vkEnumerateInstanceLayerProperties >(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceLayerProperties"));
-        if (vkEnumerateInstanceLayerProperties == nullptr){
-            std::cout << "Could not load global level Vulkan function named: vkEnumerateInstanceLayerProperties." << std::endl;
-            return 1;
-        }
-    }
-    PFN_vkCreateInstance vkCreateInstance;
-    if (vkGetInstanceProcAddr != nullptr){
-        vkCreateInstance =
-                reinterpret_cast<PFN_vkCreateInstance>(vkGetInstanceProcAddr(nullptr, "vkCreateInstance"));
-        if (vkCreateInstance == nullptr){
-            std::cout << "Could not load global level Vulkan function named: vkCreateInstance." << std::endl;
-            return -1;
-        }
-    }
 
     VkResult res;
     struct sample_info info = {};
     char sample_title[] = "Swapchain Initialization Sample";
 
+    // Load Global Level Functions
+    if (!load_global_level_functions(vkGetInstanceProcAddr, info.global_functions)){
+        return -1;
+    }
+
     /*
      * Set up swapchain:
      * - Get supported uses for all queues
@@ -453,54 +360,17 @@ int main(int argc, char *argv[]) {
     init_instance_extension_names(info);
     init_device_extension_names(info);
     init_instance(info, sample_title);
-    init_enumerate_device(info, 1);
-    init_window_size(info, 64, 64);
-    init_connection(info);
-    init_window(info);
 
     // Load instance level function
-    PFN_vkCreateXcbSurfaceKHR vkCreateXcbSurfaceKHR;
-    vkCreateXcbSurfaceKHR =
-            reinterpret_cast<PFN_vkCreateXcbSurfaceKHR>(vkGetInstanceProcAddr(info.inst, "vkCreateXcbSurfaceKHR"));
-    if (vkCreateXcbSurfaceKHR == nullptr){
-        std::cout << "Could not load instance level Vulkan function named: vkCreateXcbSurfaceKHR." << std::endl;
-        return 1;
-    }
-
-    // Load physical device extension function
-    PFN_vkGetPhysicalDeviceSurfaceSupportKHR vkGetPhysicalDeviceSurfaceSupportKHR;
-    PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR vkGetPhysicalDeviceSurfaceCapabilitiesKHR;
-    PFN_vkGetPhysicalDeviceSurfaceFormatsKHR vkGetPhysicalDeviceSurfaceFormatsKHR;
-
-    vkGetPhysicalDeviceSurfaceSupportKHR = (PFN_vkGetPhysicalDeviceSurfaceSupportKHR)vkGetInstanceProcAddr( info.inst, "vkGetPhysicalDeviceSurfaceSupportKHR" );
-    if( vkGetPhysicalDeviceSurfaceSupportKHR == nullptr ) {
-        std::cout << "Could not load instance-level Vulkan function named: vkGetPhysicalDeviceSurfaceSupportKHR" << std::endl;
-        return -1;
-    }
-    vkGetPhysicalDeviceSurfaceCapabilitiesKHR = (PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR)vkGetInstanceProcAddr( info.inst, "vkGetPhysicalDeviceSurfaceCapabilitiesKHR" );
-    if( vkGetPhysicalDeviceSurfaceCapabilitiesKHR == nullptr ) {
-        std::cout << "Could not load instance-level Vulkan function named: vkGetPhysicalDeviceSurfaceCapabilitiesKHR" << std::endl;
-        return -1;
-    }
-    vkGetPhysicalDeviceSurfaceFormatsKHR = (PFN_vkGetPhysicalDeviceSurfaceFormatsKHR)vkGetInstanceProcAddr( info.inst, "vkGetPhysicalDeviceSurfaceFormatsKHR" );
-    if( vkGetPhysicalDeviceSurfaceFormatsKHR == nullptr ) {
-        std::cout << "Could not load instance-level Vulkan function named: vkGetPhysicalDeviceSurfaceFormatsKHR" << std::endl;
+    if (!load_instance_level_functions(vkGetInstanceProcAddr, info.inst, info.instance_extension_names,
+                                       info.instance_functions)){
         return -1;
     }
 
-    PFN_vkEnumerateDeviceExtensionProperties vkEnumerateDeviceExtensionProperties;
-    vkEnumerateDeviceExtensionProperties =
-            reinterpret_cast<PFN_vkEnumerateDeviceExtensionProperties>(vkGetInstanceProcAddr(info.inst, "vkEnumerateDeviceExtensionProperties"));
-    PFN_vkGetPhysicalDeviceQueueFamilyProperties vkGetPhysicalDeviceQueueFamilyProperties;
-    vkGetPhysicalDeviceQueueFamilyProperties =
-            reinterpret_cast<PFN_vkGetPhysicalDeviceQueueFamilyProperties>(vkGetInstanceProcAddr(info.inst, "vkGetPhysicalDeviceQueueFamilyProperties"));
-    PFN_vkGetPhysicalDeviceSurfacePresentModesKHR vkGetPhysicalDeviceSurfacePresentModesKHR;
-    vkGetPhysicalDeviceSurfacePresentModesKHR =
-            reinterpret_cast<PFN_vkGetPhysicalDeviceSurfacePresentModesKHR>(vkGetInstanceProcAddr(info.inst, "vkGetPhysicalDeviceSurfacePresentModesKHR"));
-    if (vkGetPhysicalDeviceSurfacePresentModesKHR == nullptr){
-        std::cout << "Could not load device-level Vulkan function named: vkGetPhysicalDeviceSurfacePresentModesKHR" << std::endl;
-        return -1;
-    }
+    init_enumerate_device(info, 1);
+    init_window_size(info, 64, 64);
+    init_connection(info);
+    init_window(info);
 
 /* VULKAN_KEY_START */
 // Construct the surface description:
@@ -510,37 +380,35 @@ int main(int argc, char *argv[]) {
     createInfo.pNext = NULL;
     createInfo.hinstance = info.connection;
     createInfo.hwnd = info.window;
-    res = vkCreateWin32SurfaceKHR(info.inst, &createInfo, NULL, &info.surface);
+    res = info.instance_functions.vkCreateWin32SurfaceKHR(info.inst, &createInfo, NULL, &info.surface);
 #elif defined(__ANDROID__)
-    GET_INSTANCE_PROC_ADDR(info.inst, CreateAndroidSurfaceKHR);
-
     VkAndroidSurfaceCreateInfoKHR createInfo;
     createInfo.sType = VK_STRUCTURE_TYPE_ANDROID_SURFACE_CREATE_INFO_KHR;
     createInfo.pNext = nullptr;
     createInfo.flags = 0;
     createInfo.window = AndroidGetApplicationWindow();
-    res = info.fpCreateAndroidSurfaceKHR(info.inst, &createInfo, nullptr, &info.surface);
+    res = info.instance_functions.vkCreateAndroidSurfaceKHR(info.inst, &createInfo, nullptr, &info.surface);
 #elif defined(VK_USE_PLATFORM_WAYLAND_KHR)
     VkWaylandSurfaceCreateInfoKHR createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_WAYLAND_SURFACE_CREATE_INFO_KHR;
     createInfo.pNext = NULL;
     createInfo.display = info.display;
     createInfo.surface = info.window;
-    res = vkCreateWaylandSurfaceKHR(info.inst, &createInfo, NULL, &info.surface);
+    res = info.instance_functions.vkCreateWaylandSurfaceKHR(info.inst, &createInfo, NULL, &info.surface);
 #else
     VkXcbSurfaceCreateInfoKHR createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_XCB_SURFACE_CREATE_INFO_KHR;
     createInfo.pNext = NULL;
     createInfo.connection = info.connection;
     createInfo.window = info.window;
-    res = vkCreateXcbSurfaceKHR(info.inst, &createInfo, NULL, &info.surface);
+    res = info.instance_functions.vkCreateXcbSurfaceKHR(info.inst, &createInfo, NULL, &info.surface);
 #endif  // _WIN32
     assert(res == VK_SUCCESS);
 
     // Iterate over each queue to learn whether it supports presenting:
     VkBool32 *pSupportsPresent = (VkBool32 *)malloc(info.queue_family_count * sizeof(VkBool32));
     for (uint32_t i = 0; i < info.queue_family_count; i++) {
-        vkGetPhysicalDeviceSurfaceSupportKHR(info.gpus[0], i, info.surface, &pSupportsPresent[i]);
+        info.instance_functions.vkGetPhysicalDeviceSurfaceSupportKHR(info.gpus[0], i, info.surface, &pSupportsPresent[i]);
     }
 
     // Search for a graphics and a present queue in the array of queue
@@ -580,12 +448,18 @@ int main(int argc, char *argv[]) {
 
     init_device(info);
 
+    // Load device level functions
+    if (!create_device_dispatch(info.instance_functions.vkGetDeviceProcAddr, info.device,
+                                info.device_extension_names, info.device_dispatch)){
+        return -1;
+    }
+
     // Get the list of VkFormats that are supported:
     uint32_t formatCount;
-    res = vkGetPhysicalDeviceSurfaceFormatsKHR(info.gpus[0], info.surface, &formatCount, NULL);
+    res = info.instance_functions.vkGetPhysicalDeviceSurfaceFormatsKHR(info.gpus[0], info.surface, &formatCount, NULL);
     assert(res == VK_SUCCESS);
     VkSurfaceFormatKHR *surfFormats = (VkSurfaceFormatKHR *)malloc(formatCount * sizeof(VkSurfaceFormatKHR));
-    res = vkGetPhysicalDeviceSurfaceFormatsKHR(info.gpus[0], info.surface, &formatCount, surfFormats);
+    res = info.instance_functions.vkGetPhysicalDeviceSurfaceFormatsKHR(info.gpus[0], info.surface, &formatCount, surfFormats);
     assert(res == VK_SUCCESS);
     // If the format list includes just one entry of VK_FORMAT_UNDEFINED,
     // the surface has no preferred format.  Otherwise, at least one
@@ -600,15 +474,15 @@ int main(int argc, char *argv[]) {
 
     VkSurfaceCapabilitiesKHR surfCapabilities;
 
-    res = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(info.gpus[0], info.surface, &surfCapabilities);
+    res = info.instance_functions.vkGetPhysicalDeviceSurfaceCapabilitiesKHR(info.gpus[0], info.surface, &surfCapabilities);
     assert(res == VK_SUCCESS);
 
     uint32_t presentModeCount;
-    res = vkGetPhysicalDeviceSurfacePresentModesKHR(info.gpus[0], info.surface, &presentModeCount, NULL);
+    res = info.instance_functions.vkGetPhysicalDeviceSurfacePresentModesKHR(info.gpus[0], info.surface, &presentModeCount, NULL);
     assert(res == VK_SUCCESS);
     VkPresentModeKHR *presentModes = (VkPresentModeKHR *)malloc(presentModeCount * sizeof(VkPresentModeKHR));
 
-    res = vkGetPhysicalDeviceSurfacePresentModesKHR(info.gpus[0], info.surface, &presentModeCount, presentModes);
+    res = info.instance_functions.vkGetPhysicalDeviceSurfacePresentModesKHR(info.gpus[0], info.surface, &presentModeCount, presentModes);
     assert(res == VK_SUCCESS);
 
     VkExtent2D swapchainExtent;
@@ -696,107 +570,15 @@ int main(int argc, char *argv[]) {
         swapchain_ci.pQueueFamilyIndices = queueFamilyIndices;
     }
 
-    // Load instance level function
-    PFN_vkEnumeratePhysicalDevices vkEnumeratePhysicalDevices;
-    vkEnumeratePhysicalDevices =
-            reinterpret_cast<PFN_vkEnumeratePhysicalDevices>(vkGetInstanceProcAddr(info.inst, "vkEnumeratePhysicalDevices"));
-    PFN_vkGetPhysicalDeviceProperties vkGetPhysicalDeviceProperties;
-    vkGetPhysicalDeviceProperties =
-            reinterpret_cast<PFN_vkGetPhysicalDeviceProperties>(vkGetInstanceProcAddr(info.inst, "vkGetPhysicalDeviceProperties"));
-    PFN_vkGetPhysicalDeviceFeatures vkGetPhysicalDeviceFeatures;
-    vkGetPhysicalDeviceFeatures =
-            reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures>(vkGetInstanceProcAddr(info.inst, "vkGetPhysicalDeviceFeatures"));
-    PFN_vkCreateDevice vkCreateDevice;
-    vkCreateDevice =
-            reinterpret_cast<PFN_vkCreateDevice>(vkGetInstanceProcAddr(info.inst, "vkCreateDevice"));
-    PFN_vkDestroyInstance vkDestroyInstance;
-    vkDestroyInstance =
-            reinterpret_cast<PFN_vkDestroyInstance>(vkGetInstanceProcAddr(info.inst, "vkDestroyInstance"));
-    PFN_vkGetDeviceProcAddr vkGetDeviceProcAddr;
-    vkGetDeviceProcAddr =
-            reinterpret_cast<PFN_vkGetDeviceProcAddr>(vkGetInstanceProcAddr(info.inst, "vkGetDeviceProcAddr"));
-    PFN_vkDestroySurfaceKHR vkDestroySurfaceKHR;
-    vkDestroySurfaceKHR =
-            reinterpret_cast<PFN_vkDestroySurfaceKHR>(vkGetInstanceProcAddr(info.inst, "vkDestroySurfaceKHR"));
-    if( vkDestroySurfaceKHR == nullptr ) {
-        std::cout << "Could not load device-level Vulkan function named: vkDestroySurfaceKHR." << std::endl;
-        return -1;
-    }
-    // Load device level function from extension
-    PFN_vkCreateSwapchainKHR vkCreateSwapchainKHR;
-    vkCreateSwapchainKHR =
-            reinterpret_cast<PFN_vkCreateSwapchainKHR>(vkGetDeviceProcAddr(info.device, "vkCreateSwapchainKHR"));
-    if( vkCreateSwapchainKHR == nullptr ) {
-        std::cout << "Could not load device-level Vulkan function named: vkCreateSwapchainKHR." << std::endl;
-        return -1;
-    }
-    PFN_vkGetSwapchainImagesKHR vkGetSwapchainImagesKHR;
-    vkGetSwapchainImagesKHR =
-            reinterpret_cast<PFN_vkGetSwapchainImagesKHR>(vkGetDeviceProcAddr(info.device, "vkGetSwapchainImagesKHR"));
-    if( vkGetSwapchainImagesKHR == nullptr ) {
-        std::cout << "Could not load device-level Vulkan function named: vkGetSwapchainImagesKHR." << std::endl;
-        return -1;
-    }
-    PFN_vkAcquireNextImageKHR vkAcquireNextImageKHR;
-    vkAcquireNextImageKHR =
-            reinterpret_cast<PFN_vkAcquireNextImageKHR>(vkGetDeviceProcAddr(info.device, "vkAcquireNextImageKHR"));
-    if( vkGetSwapchainImagesKHR == nullptr ) {
-        std::cout << "Could not load device-level Vulkan function named: vkAcquireNextImageKHR." << std::endl;
-        return -1;
-    }
-    PFN_vkQueuePresentKHR vkQueuePresentKHR;
-    vkQueuePresentKHR =
-            reinterpret_cast<PFN_vkQueuePresentKHR>(vkGetDeviceProcAddr(info.device, "vkQueuePresentKHR"));
-    if( vkQueuePresentKHR == nullptr ) {
-        std::cout << "Could not load device-level Vulkan function named: vkQueuePresentKHR." << std::endl;
-        return -1;
-    }
-    PFN_vkDestroySwapchainKHR vkDestroySwapchainKHR;
-    vkDestroySwapchainKHR =
-            reinterpret_cast<PFN_vkDestroySwapchainKHR>(vkGetDeviceProcAddr(info.device, "vkDestroySwapchainKHR"));
-    if( vkDestroySwapchainKHR == nullptr ) {
-        std::cout << "Could not load device-level Vulkan function named: vkDestroySwapchainKHR." << std::endl;
-        return -1;
-    }
-    PFN_vkCreateImageView vkCreateImageView;
-    vkCreateImageView =
-            reinterpret_cast<PFN_vkCreateImageView>(vkGetDeviceProcAddr(info.device, "vkCreateImageView"));
-    if( vkCreateImageView == nullptr ) {
-        std::cout << "Could not load device-level Vulkan function named: vkCreateImageView." << std::endl;
-        return -1;
-    }
-    PFN_vkDestroyImageView vkDestroyImageView;
-    vkDestroyImageView =
-            reinterpret_cast<PFN_vkDestroyImageView>(vkGetDeviceProcAddr(info.device, "vkDestroyImageView"));
-    if( vkDestroyImageView == nullptr ) {
-        std::cout << "Could not load device-level Vulkan function named: vkDestroyImageView." << std::endl;
-        return -1;
-    }
-
-    PFN_vkDestroyDevice vkDestroyDevice;
-    vkDestroyDevice =
-            reinterpret_cast<PFN_vkDestroyDevice>(vkGetDeviceProcAddr(info.device, "vkDestroyDevice"));
-    if( vkDestroyDevice == nullptr ) {
-        std::cout << "Could not load device-level Vulkan function named: vkDestroyDevice." << std::endl;
-        return -1;
-    }
-    PFN_vkDeviceWaitIdle vkDeviceWaitIdle;
-    vkDeviceWaitIdle =
-            reinterpret_cast<PFN_vkDeviceWaitIdle>(vkGetDeviceProcAddr(info.device, "vkDeviceWaitIdle"));
-    if( vkDeviceWaitIdle == nullptr ) {
-        std::cout << "Could not load device-level Vulkan function named: vkDeviceWaitIdle." << std::endl;
-        return -1;
-    }
-
-    res = vkCreateSwapchainKHR(info.device, &swapchain_ci, NULL, &info.swap_chain);
+    res = info.device_dispatch.vkCreateSwapchainKHR(info.device, &swapchain_ci, NULL, &info.swap_chain);
     assert(res == VK_SUCCESS);
 
-    res = vkGetSwapchainImagesKHR(info.device, info.swap_chain, &info.swapchainImageCount, NULL);
+    res = info.device_dispatch.vkGetSwapchainImagesKHR(info.device, info.swap_chain, &info.swapchainImageCount, NULL);
     assert(res == VK_SUCCESS);
 
     VkImage *swapchainImages = (VkImage *)malloc(info.swapchainImageCount * sizeof(VkImage));
     assert(swapchainImages);
-    res = vkGetSwapchainImagesKHR(info.device, info.swap_chain, &info.swapchainImageCount, swapchainImages);
+    res = info.device_dispatch.vkGetSwapchainImagesKHR(info.device, info.swap_chain, &info.swapchainImageCount, swapchainImages);
     assert(res == VK_SUCCESS);
 
     info.buffers.resize(info.swapchainImageCount);
@@ -823,7 +605,7 @@ int main(int argc, char *argv[]) {
         color_image_view.subresourceRange.baseArrayLayer = 0;
         color_image_view.subresourceRange.layerCount = 1;
 
-        res = vkCreateImageView(info.device, &color_image_view, nullptr, &info.buffers[i].view);
+        res = info.device_dispatch.vkCreateImageView(info.device, &color_image_view, nullptr, &info.buffers[i].view);
         assert(res == VK_SUCCESS);
     }
 
@@ -831,18 +613,20 @@ int main(int argc, char *argv[]) {
 
     /* Clean Up */
     for (uint32_t i = 0; i < info.swapchainImageCount; i++) {
-        vkDestroyImageView(info.device, info.buffers[i].view, nullptr);
+        info.device_dispatch.vkDestroyImageView(info.device, info.buffers[i].view, nullptr);
     }
-    vkDestroySwapchainKHR(info.device, info.swap_chain, nullptr);
+    info.device_dispatch.vkDestroySwapchainKHR(info.device, info.swap_chain, nullptr);
 
-    vkDeviceWaitIdle(info.device);
-    vkDestroyDevice(info.device, nullptr);
+    info.device_dispatch.vkDeviceWaitIdle(info.device);
+    info.device_dispatch.vkDestroyDevice(info.device, nullptr);
+    destroy_device_dispatch(info.device_dispatch);
 
-    vkDestroySurfaceKHR(info.inst, info.surface, nullptr);
+    info.instance_functions.vkDestroySurfaceKHR(info.inst, info.surface, nullptr);
     xcb_destroy_window(info.connection, info.window);
     xcb_disconnect(info.connection);
 
-    vkDestroyInstance(info.inst, nullptr);
+    info.instance_functions.vkDestroyInstance(info.inst, nullptr);
+    unload_vulkan_library(vulkan_library);
 
     return 0;
 }
@@ -1,6 +1,6 @@
 #include <iostream>
-#include <dlfcn.h>
 #include <vulkan/vulkan.h>
+#include "device_dispatch.h"
 #include <vector>
 #include <cstring>
 
@@ -16,18 +16,6 @@ struct PresentInfo{
     uint32_t image_index;
 };
 
-void *load_vulkan_library(){
-    void *vulkan_library = dlopen("libvulkan.so.1", RTLD_NOW);
-    if (vulkan_library == nullptr){
-        std::cout << "Could not connect with a Vulkan Runtime library." <<
-                  std::endl;
-        return nullptr;
-    }
-    std::cout << "Connect with a Vulkan Runtime library successfully." <<
-              std::endl;
-    return vulkan_library;
-}
-
 struct QueueInfo {
     uint32_t FamilyIndex;
     std::vector<float> Priorities;
@@ -76,43 +64,19 @@ void init_window(struct WindowParameters &info) {
 int main() {
     // Load vulkan library
     void *vulkan_library = load_vulkan_library();
-    PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr = reinterpret_cast<PFN_vkGetInstanceProcAddr>(dlsym(vulkan_library, "vkGetInstanceProcAddr"));
+    auto vkGetInstanceProcAddr = load_exported_vulkan_function(vulkan_library);
     if (vkGetInstanceProcAddr == nullptr){
-        std::cout << "Could not find vkGetInstanceProcAddr in Vulkan Runtime library.\n";
         return -1;
     }
     // Load Global Level Functions
-    PFN_vkEnumerateInstanceExtensionProperties vkEnumerateInstanceExtensionProperties{};
-    if (vkGetInstanceProcAddr != nullptr){
-        vkEnumerateInstanceExtensionProperties =
-                reinterpret_cast<PFN_vkEnumerateInstanceExtensionProperties>(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceExtensionProperties"));
-        if (vkEnumerateInstanceExtensionProperties == nullptr){
-            std::cout << "Could not load global level Vulkan function named: vkEnumerateInstanceExtensionProperties." << std::endl;
-            return -1;
-        }
-    }
-    PFN_vkEnumerateInstanceLayerProperties  vkEnumerateInstanceLayerProperties;
-    if (vkGetInstanceProcAddr != nullptr){
-        vkEnumerateInstanceLayerProperties =
-                reinterpret_cast< PFN_vkEnumerateInstanceLayerProperties >(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceLayerProperties"));
-        if (vkEnumerateInstanceLayerProperties == nullptr){
-            std::cout << "Could not load global level Vulkan function named: vkEnumerateInstanceLayerProperties." << std::endl;
-            return 1;
-        }
-    }
-    PFN_vkCreateInstance vkCreateInstance;
-    if (vkGetInstanceProcAddr != nullptr){
-        vkCreateInstance =
-                reinterpret_cast<PFN_vkCreateInstance>(vkGetInstanceProcAddr(nullptr, "vkCreateInstance"));
-        if (vkCreateInstance == nullptr){
-            std::cout << "Could not load global level Vulkan function named: vkCreateInstance." << std::endl;
-            return -1;
-        }
+    GlobalFunctions global_functions{};
+    if (!load_global_level_functions(vkGetInstanceProcAddr, global_functions)){
+        return -1;
     }
     // Get available_extensions
     uint32_t extensions_count{};
-    if (vkEnumerateInstanceExtensionProperties != nullptr) {
-        VkResult result = vkEnumerateInstanceExtensionProperties(nullptr, &extensions_count, nullptr);
+    if (global_functions.vkEnumerateInstanceExtensionProperties != nullptr) {
+        VkResult result = global_functions.vkEnumerateInstanceExtensionProperties(nullptr, &extensions_count, nullptr);
         if( (result != VK_SUCCESS) || (extensions_count == 0)) {
             std::cout << "Could not get the number of Instance extensions." <<
                       std::endl;
@@ -120,8 +84,8 @@ int main() {
         }
     }
     std::vector<VkExtensionProperties> available_extensions(extensions_count);
-    if (vkEnumerateInstanceExtensionProperties != nullptr) {
-        VkResult result = vkEnumerateInstanceExtensionProperties(nullptr, &extensions_count, available_extensions.data());
+    if (global_functions.vkEnumerateInstanceExtensionProperties != nullptr) {
+        VkResult result = global_functions.vkEnumerateInstanceExtensionProperties(nullptr, &extensions_count, available_extensions.data());
         if ((result != VK_SUCCESS) || (extensions_count == 0)) {
             std::cout << "Could not enumerate Instance extensions." << std::endl;
             return -1;
@@ -165,8 +129,8 @@ int main() {
     instance_create_info.ppEnabledExtensionNames = desired_extensions.empty() ? nullptr : desired_extensions.data();
 
     VkInstance instance;
-    if (vkCreateInstance != nullptr){
-        VkResult result = vkCreateInstance(&instance_create_info, nullptr, &instance);
+    if (global_functions.vkCreateInstance != nullptr){
+        VkResult result = global_functions.vkCreateInstance(&instance_create_info, nullptr, &instance);
         if( (result != VK_SUCCESS) || (instance == VK_NULL_HANDLE) ) {
             std::cout << "Could not create Vulkan Instance." << std::endl;
             return -1;
@@ -174,12 +138,9 @@ int main() {
     }
 
     // Load instance level function
-    PFN_vkCreateXcbSurfaceKHR vkCreateXcbSurfaceKHR;
-    vkCreateXcbSurfaceKHR =
-            reinterpret_cast<PFN_vkCreateXcbSurfaceKHR>(vkGetInstanceProcAddr(instance, "vkCreateXcbSurfaceKHR"));
-    if (vkCreateXcbSurfaceKHR == nullptr){
-        std::cout << "Could not load instance level Vulkan function named: vkCreateXcbSurfaceKHR." << std::endl;
-        return 1;
+    InstanceFunctions instance_functions{};
+    if (!load_instance_level_functions(vkGetInstanceProcAddr, instance, desired_extensions, instance_functions)){
+        return -1;
     }
 
     // create a presentation surface
@@ -210,85 +171,21 @@ int main() {
     surface_create_info.window = window_parameters.window;
 
     VkSurfaceKHR presentation_surface{VK_NULL_HANDLE};
-    VkResult result = vkCreateXcbSurfaceKHR(instance, &surface_create_info, nullptr, &presentation_surface);
+    VkResult result = instance_functions.vkCreateXcbSurfaceKHR(instance, &surface_create_info, nullptr, &presentation_surface);
     if( (VK_SUCCESS != result) || (VK_NULL_HANDLE == presentation_surface) ) {
         std::cout << "Could not create presentation surface." << std::endl;
         return -1;
     }
 
-    // Load instance level function
-    PFN_vkEnumeratePhysicalDevices vkEnumeratePhysicalDevices;
-    vkEnumeratePhysicalDevices =
-            reinterpret_cast<PFN_vkEnumeratePhysicalDevices>(vkGetInstanceProcAddr(instance, "vkEnumeratePhysicalDevices"));
-    PFN_vkGetPhysicalDeviceProperties vkGetPhysicalDeviceProperties;
-    vkGetPhysicalDeviceProperties =
-            reinterpret_cast<PFN_vkGetPhysicalDeviceProperties>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties"));
-    PFN_vkGetPhysicalDeviceFeatures vkGetPhysicalDeviceFeatures;
-    vkGetPhysicalDeviceFeatures =
-            reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures"));
-    PFN_vkCreateDevice vkCreateDevice;
-    vkCreateDevice =
-            reinterpret_cast<PFN_vkCreateDevice>(vkGetInstanceProcAddr(instance, "vkCreateDevice"));
-    PFN_vkDestroyInstance vkDestroyInstance;
-    vkDestroyInstance =
-            reinterpret_cast<PFN_vkDestroyInstance>(vkGetInstanceProcAddr(instance, "vkDestroyInstance"));
-    PFN_vkGetDeviceProcAddr vkGetDeviceProcAddr;
-    vkGetDeviceProcAddr =
-            reinterpret_cast<PFN_vkGetDeviceProcAddr>(vkGetInstanceProcAddr(instance, "vkGetDeviceProcAddr"));
-    // Load physical device extension function
-    PFN_vkGetPhysicalDeviceSurfaceSupportKHR vkGetPhysicalDeviceSurfaceSupportKHR;
-    PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR vkGetPhysicalDeviceSurfaceCapabilitiesKHR;
-    PFN_vkGetPhysicalDeviceSurfaceFormatsKHR vkGetPhysicalDeviceSurfaceFormatsKHR;
-    for( auto & enabled_extension : desired_extensions ) {
-        if( std::string( enabled_extension ) == std::string( VK_KHR_SURFACE_EXTENSION_NAME ) ) {
-            vkGetPhysicalDeviceSurfaceSupportKHR = (PFN_vkGetPhysicalDeviceSurfaceSupportKHR)vkGetInstanceProcAddr( instance, "vkGetPhysicalDeviceSurfaceSupportKHR" );
-            if( vkGetPhysicalDeviceSurfaceSupportKHR == nullptr ) {
-                std::cout << "Could not load instance-level Vulkan function named: vkGetPhysicalDeviceSurfaceSupportKHR" << std::endl;
-                return -1;
-            }
-            vkGetPhysicalDeviceSurfaceCapabilitiesKHR = (PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR)vkGetInstanceProcAddr( instance, "vkGetPhysicalDeviceSurfaceCapabilitiesKHR" );
-            if( vkGetPhysicalDeviceSurfaceCapabilitiesKHR == nullptr ) {
-                std::cout << "Could not load instance-level Vulkan function named: vkGetPhysicalDeviceSurfaceCapabilitiesKHR" << std::endl;
-                return -1;
-            }
-            vkGetPhysicalDeviceSurfaceFormatsKHR = (PFN_vkGetPhysicalDeviceSurfaceFormatsKHR)vkGetInstanceProcAddr( instance, "vkGetPhysicalDeviceSurfaceFormatsKHR" );
-            if( vkGetPhysicalDeviceSurfaceFormatsKHR == nullptr ) {
-                std::cout << "Could not load instance-level Vulkan function named: vkGetPhysicalDeviceSurfaceFormatsKHR" << std::endl;
-                return -1;
-            }
-        }
-    }
-
-    PFN_vkEnumerateDeviceExtensionProperties vkEnumerateDeviceExtensionProperties;
-    vkEnumerateDeviceExtensionProperties =
-            reinterpret_cast<PFN_vkEnumerateDeviceExtensionProperties>(vkGetInstanceProcAddr(instance, "vkEnumerateDeviceExtensionProperties"));
-    PFN_vkGetPhysicalDeviceQueueFamilyProperties vkGetPhysicalDeviceQueueFamilyProperties;
-    vkGetPhysicalDeviceQueueFamilyProperties =
-            reinterpret_cast<PFN_vkGetPhysicalDeviceQueueFamilyProperties>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceQueueFamilyProperties"));
-    PFN_vkGetPhysicalDeviceSurfacePresentModesKHR vkGetPhysicalDeviceSurfacePresentModesKHR;
-    vkGetPhysicalDeviceSurfacePresentModesKHR =
-            reinterpret_cast<PFN_vkGetPhysicalDeviceSurfacePresentModesKHR>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceSurfacePresentModesKHR"));
-    if (vkGetPhysicalDeviceSurfacePresentModesKHR == nullptr){
-        std::cout << "Could not load device-level Vulkan function named: vkGetPhysicalDeviceSurfacePresentModesKHR" << std::endl;
-        return -1;
-    }
-    PFN_vkDestroySurfaceKHR vkDestroySurfaceKHR;
-    vkDestroySurfaceKHR =
-            reinterpret_cast<PFN_vkDestroySurfaceKHR>(vkGetInstanceProcAddr(instance, "vkDestroySurfaceKHR"));
-    if (vkDestroySurfaceKHR == nullptr){
-        std::cout << "Could not load device-level Vulkan function named: vkDestroySurfaceKHR" << std::endl;
-        return -1;
-    }
-
     //Get physical device
     uint32_t devices_count{0};
-    result = vkEnumeratePhysicalDevices(instance, &devices_count, nullptr);
+    result = instance_functions.vkEnumeratePhysicalDevices(instance, &devices_count, nullptr);
     if( (result != VK_SUCCESS) || (devices_count == 0) ) {
         std::cout << "Could not get the number of available physical devices." << std::endl;
         return -1;
     }
     std::vector<VkPhysicalDevice> physical_devices(devices_count);
-    result = vkEnumeratePhysicalDevices(instance, &devices_count, physical_devices.data());
+    result = instance_functions.vkEnumeratePhysicalDevices(instance, &devices_count, physical_devices.data());
     if( (result != VK_SUCCESS) || (devices_count == 0) ) {
         std::cout << "Could not enumerate physical devices." << std::endl;
         return -1;
@@ -296,13 +193,13 @@ int main() {
     // select a queue family that supports presentation to a given surface
     for (auto physical_device : physical_devices) {
         uint32_t queue_families_count;
-        vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, nullptr);
+        instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, nullptr);
         if( queue_families_count == 0 ) {
             std::cout << "Could not get the number of queue families." << std::endl;
             return -1;
         }
         std::vector<VkQueueFamilyProperties> queue_families(queue_families_count);
-        vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, queue_families.data());
+        instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, queue_families.data());
         if( queue_families_count == 0 ) {
             std::cout << "Could not acquire properties of queue families." << std::endl;
             return -1;
@@ -327,7 +224,7 @@ int main() {
         b_found = false;
         for( uint32_t index = 0; index < static_cast<uint32_t>(queue_families.size()); ++index ) {
             VkBool32 presentation_supported = VK_FALSE;
-            result = vkGetPhysicalDeviceSurfaceSupportKHR( physical_device, index, presentation_surface, &presentation_supported );
+            result = instance_functions.vkGetPhysicalDeviceSurfaceSupportKHR( physical_device, index, presentation_surface, &presentation_supported );
             if( (VK_SUCCESS == result) && (VK_TRUE == presentation_supported) ) {
                 PresentQueueFamilyIndex = index;
                 b_found = true;
@@ -347,14 +244,14 @@ int main() {
         //Creating a logical device with WSI extensions enabled
         // physical device extension properties
         uint32_t DeviceExtensionProperties_extensions_count = 0;
-        result = vkEnumerateDeviceExtensionProperties( physical_device, nullptr,
-                                                       &DeviceExtensionProperties_extensions_count, nullptr );
+        result = instance_functions.vkEnumerateDeviceExtensionProperties( physical_device, nullptr,
+                                                                          &DeviceExtensionProperties_extensions_count, nullptr );
         if( (result != VK_SUCCESS) || (DeviceExtensionProperties_extensions_count == 0) ) {
             std::cout << "Could not get the number of device extensions." << std::endl;
             return -1;
         }
         std::vector<VkExtensionProperties> available_extensions_DeviceExtensionProperties(DeviceExtensionProperties_extensions_count);
-        result = vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &DeviceExtensionProperties_extensions_count, available_extensions_DeviceExtensionProperties.data());
+        result = instance_functions.vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &DeviceExtensionProperties_extensions_count, available_extensions_DeviceExtensionProperties.data());
         if( (result != VK_SUCCESS) || (extensions_count == 0) ) {
             std::cout << "Could not enumerate device extensions." << std::endl;
             return -1;
@@ -392,8 +289,8 @@ int main() {
         //Getting features and properties of a physical device
         VkPhysicalDeviceFeatures device_features;
         VkPhysicalDeviceProperties device_properties;
-        vkGetPhysicalDeviceFeatures(physical_device, &device_features);
-        vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+        instance_functions.vkGetPhysicalDeviceFeatures(physical_device, &device_features);
+        instance_functions.vkGetPhysicalDeviceProperties(physical_device, &device_properties);
 
         if (device_features.geometryShader){
             device_features = {};   // keep only geometryShader of device_features
@@ -415,114 +312,33 @@ int main() {
         device_create_info.ppEnabledExtensionNames = desired_extensions_DeviceExtensionProperties.empty() ? nullptr : desired_extensions_DeviceExtensionProperties.data();
         device_create_info.pEnabledFeatures = &device_features;
         VkDevice logical_device;
-        result = vkCreateDevice(physical_device, &device_create_info, nullptr, &logical_device);
+        result = instance_functions.vkCreateDevice(physical_device, &device_create_info, nullptr, &logical_device);
         if( (result != VK_SUCCESS) || (logical_device == VK_NULL_HANDLE) ) {
             std::cout << "Could not create logical device." << std::endl;
             return -1;
         }
         // Load device level functions
-        PFN_vkGetDeviceQueue vkGetDeviceQueue;
-        vkGetDeviceQueue =
-                reinterpret_cast<PFN_vkGetDeviceQueue>(vkGetDeviceProcAddr(logical_device, "vkGetDeviceQueue"));
-        if( vkGetDeviceQueue == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkGetDeviceQueue." << std::endl;
-            return -1;
-        }
-        PFN_vkDeviceWaitIdle vkDeviceWaitIdle;
-        vkDeviceWaitIdle =
-                reinterpret_cast<PFN_vkDeviceWaitIdle>(vkGetDeviceProcAddr(logical_device, "vkDeviceWaitIdle"));
-        if( vkDeviceWaitIdle == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkDeviceWaitIdle." << std::endl;
-            return -1;
-        }
-        PFN_vkDestroyDevice vkDestroyDevice;
-        vkDestroyDevice =
-                reinterpret_cast<PFN_vkDestroyDevice>(vkGetDeviceProcAddr(logical_device, "vkDestroyDevice"));
-        if( vkDestroyDevice == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkDestroyDevice." << std::endl;
-            return -1;
-        }
-        PFN_vkCreateBuffer vkCreateBuffer;
-        vkCreateBuffer =
-                reinterpret_cast<PFN_vkCreateBuffer>(vkGetDeviceProcAddr(logical_device, "vkCreateBuffer"));
-        if( vkCreateBuffer == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCreateBuffer." << std::endl;
-            return -1;
-        }
-        PFN_vkGetBufferMemoryRequirements vkGetBufferMemoryRequirements;
-        vkGetBufferMemoryRequirements =
-                reinterpret_cast<PFN_vkGetBufferMemoryRequirements>(vkGetDeviceProcAddr(logical_device, "vkGetBufferMemoryRequirements"));
-        if( vkGetBufferMemoryRequirements == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkGetBufferMemoryRequirements." << std::endl;
-            return -1;
-        }
-
-        // Load device level function from extension
-        PFN_vkCreateSwapchainKHR vkCreateSwapchainKHR;
-        vkCreateSwapchainKHR =
-                reinterpret_cast<PFN_vkCreateSwapchainKHR>(vkGetDeviceProcAddr(logical_device, "vkCreateSwapchainKHR"));
-        if( vkCreateSwapchainKHR == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCreateSwapchainKHR." << std::endl;
-            return -1;
-        }
-        PFN_vkGetSwapchainImagesKHR vkGetSwapchainImagesKHR;
-        vkGetSwapchainImagesKHR =
-                reinterpret_cast<PFN_vkGetSwapchainImagesKHR>(vkGetDeviceProcAddr(logical_device, "vkGetSwapchainImagesKHR"));
-        if( vkGetSwapchainImagesKHR == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkGetSwapchainImagesKHR." << std::endl;
-            return -1;
-        }
-        PFN_vkAcquireNextImageKHR vkAcquireNextImageKHR;
-        vkAcquireNextImageKHR =
-                reinterpret_cast<PFN_vkAcquireNextImageKHR>(vkGetDeviceProcAddr(logical_device, "vkAcquireNextImageKHR"));
-        if( vkAcquireNextImageKHR == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkAcquireNextImageKHR." << std::endl;
-            return -1;
-        }
-        PFN_vkQueuePresentKHR vkQueuePresentKHR;
-        vkQueuePresentKHR =
-                reinterpret_cast<PFN_vkQueuePresentKHR>(vkGetDeviceProcAddr(logical_device, "vkQueuePresentKHR"));
-        if( vkQueuePresentKHR == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkQueuePresentKHR." << std::endl;
-            return -1;
-        }
-        PFN_vkDestroySwapchainKHR vkDestroySwapchainKHR;
-        vkDestroySwapchainKHR =
-                reinterpret_cast<PFN_vkDestroySwapchainKHR>(vkGetDeviceProcAddr(logical_device, "vkDestroySwapchainKHR"));
-        if( vkDestroySwapchainKHR == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkDestroySwapchainKHR." << std::endl;
-            return -1;
-        }
-        PFN_vkCreateSemaphore vkCreateSemaphore;
-        vkCreateSemaphore =
-                reinterpret_cast<PFN_vkCreateSemaphore>(vkGetDeviceProcAddr(logical_device, "vkCreateSemaphore"));
-        if( vkCreateSemaphore == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCreateSemaphore." << std::endl;
-            return -1;
-        }
-        PFN_vkCreateFence vkCreateFence;
-        vkCreateFence =
-                reinterpret_cast<PFN_vkCreateFence>(vkGetDeviceProcAddr(logical_device, "vkCreateFence"));
-        if( vkCreateFence == nullptr ) {
-            std::cout << "Could not load device-level Vulkan function named: vkCreateFence." << std::endl;
+        DeviceDispatch device_functions;
+        if (!create_device_dispatch(instance_functions.vkGetDeviceProcAddr, logical_device,
+                                    desired_extensions_DeviceExtensionProperties, device_functions)){
             return -1;
         }
 
         // Get Device Queue
         VkQueue GraphicsQueue;
-        vkGetDeviceQueue( logical_device, GraphicsQueueFamilyIndex, 0, &GraphicsQueue );
+        device_functions.vkGetDeviceQueue( logical_device, GraphicsQueueFamilyIndex, 0, &GraphicsQueue );
         VkQueue PresentQueue;
-        vkGetDeviceQueue( logical_device, PresentQueueFamilyIndex, 0, &PresentQueue );
+        device_functions.vkGetDeviceQueue( logical_device, PresentQueueFamilyIndex, 0, &PresentQueue );
         //Selecting a desired presentation mode
         uint32_t present_modes_count{};
-        result = vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, presentation_surface, &present_modes_count, nullptr);
+        result = instance_functions.vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, presentation_surface, &present_modes_count, nullptr);
         if (result != VK_SUCCESS || present_modes_count==0){
             std::cout << "Could not get the number of supported present modes." <<
                       std::endl;
             return -1;
         }
         std::vector<VkPresentModeKHR> present_modes(present_modes_count);
-        result = vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, presentation_surface, &present_modes_count, present_modes.data());
+        result = instance_functions.vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, presentation_surface, &present_modes_count, present_modes.data());
         if( (VK_SUCCESS != result) ||  (0 == present_modes_count) ) {
             std::cout << "Could not enumerate present modes." << std::endl;
             return -1;
@@ -554,7 +370,7 @@ int main() {
         }
         //Getting the capabilities of a presentation surface
         VkSurfaceCapabilitiesKHR surface_capabilities;
-        result = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, presentation_surface, &surface_capabilities);
+        result = instance_functions.vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, presentation_surface, &surface_capabilities);
         if( VK_SUCCESS != result ) {
             std::cout << "Could not get the capabilities of a presentation surface." << std::endl;
             return -1;
@@ -597,13 +413,13 @@ int main() {
         // Selecting a format of swapchain images
         VkSurfaceFormatKHR desired_surface_format{ VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };  // image format and color-space pair
         uint32_t formats_count;
-        result = vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, presentation_surface, &formats_count, nullptr);
+        result = instance_functions.vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, presentation_surface, &formats_count, nullptr);
         if (result != VK_SUCCESS || formats_count == 0){
             std::cout << "Could not get the number of supported present formats." << std::endl;
             return -1;
         }
         std::vector<VkSurfaceFormatKHR> surface_formats(formats_count);
-        result = vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, presentation_surface, &formats_count, surface_formats.data());
+        result = instance_functions.vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, presentation_surface, &formats_count, surface_formats.data());
         if (result != VK_SUCCESS || formats_count == 0){
             std::cout << "Could not get the number of supported present formats." << std::endl;
             return -1;
@@ -661,24 +477,24 @@ int main() {
         swapchain_create_info.clipped = VK_TRUE;
         swapchain_create_info.oldSwapchain = old_swapchain;
         VkSwapchainKHR swapchain;
-        result = vkCreateSwapchainKHR(logical_device, &swapchain_create_info, nullptr, &swapchain);
+        result = device_functions.vkCreateSwapchainKHR(logical_device, &swapchain_create_info, nullptr, &swapchain);
         if (result != VK_SUCCESS || swapchain == VK_NULL_HANDLE){
             std::cout << "couldn't create a swapchain\n";
             return -1;
         }
         if (old_swapchain != VK_NULL_HANDLE){
-            vkDestroySwapchainKHR(logical_device, old_swapchain, nullptr);
+            device_functions.vkDestroySwapchainKHR(logical_device, old_swapchain, nullptr);
             old_swapchain = VK_NULL_HANDLE;
         }
         // Getting handles of swapchain images
         uint32_t images_count;
-        result = vkGetSwapchainImagesKHR(logical_device, swapchain, &images_count, nullptr);
+        result = device_functions.vkGetSwapchainImagesKHR(logical_device, swapchain, &images_count, nullptr);
         if (result != VK_SUCCESS || images_count == 0){
             std::cout << "could not get the number of swapchain images.\n";
             return -1;
         }
         std::vector<VkImage> swapchain_images(images_count);
-        result = vkGetSwapchainImagesKHR(logical_device, swapchain, &images_count, swapchain_images.data());
+        result = device_functions.vkGetSwapchainImagesKHR(logical_device, swapchain, &images_count, swapchain_images.data());
         if (result != VK_SUCCESS || images_count == 0){
             std::cout << "could not enumerate swapchain images.\n";
             return -1;
@@ -686,7 +502,7 @@ int main() {
         // Acquiring a swapchain image
         VkSemaphore semaphore;
         VkSemaphoreCreateInfo semaphore_create_info{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, nullptr, 0};
-        result = vkCreateSemaphore(logical_device, &semaphore_create_info, nullptr, &semaphore);
+        result = device_functions.vkCreateSemaphore(logical_device, &semaphore_create_info, nullptr, &semaphore);
         if( VK_SUCCESS != result ) {
             std::cout << "Could not create a semaphore." << std::endl;
             return -1;
@@ -696,13 +512,13 @@ int main() {
         fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
         fence_create_info.pNext = nullptr;
         fence_create_info.flags = 0;
-        result = vkCreateFence(logical_device, &fence_create_info, nullptr, &fence);
+        result = device_functions.vkCreateFence(logical_device, &fence_create_info, nullptr, &fence);
         if( VK_SUCCESS != result ) {
             std::cout << "Could not create a fence." << std::endl;
             return -1;
         }
         uint32_t image_index;
-        result = vkAcquireNextImageKHR(logical_device, swapchain, 2000000000, semaphore, fence, &image_index);  // 2000000000 : 2s
+        result = device_functions.vkAcquireNextImageKHR(logical_device, swapchain, 2000000000, semaphore, fence, &image_index);  // 2000000000 : 2s
         if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR){
             std::cout << "could not vkAcquireNextImageKHR swapchain images.\n";
             return -1;
@@ -711,7 +527,7 @@ int main() {
         // Presenting an image
         VkSemaphore rendering_semaphore;
         VkSemaphoreCreateInfo semaphore_create_info2{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, nullptr, 0};
-        result = vkCreateSemaphore(logical_device, &semaphore_create_info2, nullptr, &rendering_semaphore);
+        result = device_functions.vkCreateSemaphore(logical_device, &semaphore_create_info2, nullptr, &rendering_semaphore);
         if( VK_SUCCESS != result ) {
             std::cout << "Could not create a semaphore." << std::endl;
             return -1;
@@ -728,19 +544,19 @@ int main() {
         present_info.pSwapchains = swapchains.data();
         present_info.pImageIndices = image_indices.data();
         present_info.pResults = nullptr;
-        result = vkQueuePresentKHR(PresentQueue, &present_info);
+        result = device_functions.vkQueuePresentKHR(PresentQueue, &present_info);
         if (result != VK_SUCCESS){
             std::cout << "could not vkQueuePresentKHR present images.\n";
             return -1;
         }
         // Destroying a swapchain
         if (swapchain != VK_NULL_HANDLE){
-            vkDestroySwapchainKHR(logical_device, swapchain, nullptr);
+            device_functions.vkDestroySwapchainKHR(logical_device, swapchain, nullptr);
             swapchain = VK_NULL_HANDLE;
         }
         // Destroying a presentation surface
         if (presentation_surface != VK_NULL_HANDLE){
-            vkDestroySurfaceKHR(instance, presentation_surface, nullptr);
+            instance_functions.vkDestroySurfaceKHR(instance, presentation_surface, nullptr);
             presentation_surface = VK_NULL_HANDLE;
         }
 
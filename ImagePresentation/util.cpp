@@ -108,19 +108,9 @@ std::string get_data_dir(std::string filename) {
 }
 
 bool memory_type_from_properties(struct sample_info &info, uint32_t typeBits, VkFlags requirements_mask, uint32_t *typeIndex) {
-    // Search memtypes to find first index with those properties
-    for (uint32_t i = 0; i < info.memory_properties.memoryTypeCount; i++) {
-        if ((typeBits & 1) == 1) {
-            // Type is available, does it match user properties?
-            if ((info.memory_properties.memoryTypes[i].propertyFlags & requirements_mask) == requirements_mask) {
-                *typeIndex = i;
-                return true;
-            }
-        }
-        typeBits >>= 1;
-    }
-    // No memory types matched, return failure
-    return false;
+    // Best-ranked type among those with the requested properties
+    return info.memory_allocator.memory_type_resolver().resolve(typeBits, requirements_mask, 0, MemoryUsage::Unknown,
+                                                                *typeIndex);
 }
 
 void set_image_layout(struct sample_info &info, VkImage image, VkImageAspectFlags aspectMask, VkImageLayout old_image_layout,
@@ -130,144 +120,56 @@ void set_image_layout(struct sample_info &info, VkImage image, VkImageAspectFlag
     assert(info.cmd != VK_NULL_HANDLE);
     assert(info.graphics_queue != VK_NULL_HANDLE);
 
-    VkImageMemoryBarrier image_memory_barrier = {};
-    image_memory_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    image_memory_barrier.pNext = NULL;
-    image_memory_barrier.srcAccessMask = 0;
-    image_memory_barrier.dstAccessMask = 0;
-    image_memory_barrier.oldLayout = old_image_layout;
-    image_memory_barrier.newLayout = new_image_layout;
-    image_memory_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    image_memory_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    image_memory_barrier.image = image;
-    image_memory_barrier.subresourceRange.aspectMask = aspectMask;
-    image_memory_barrier.subresourceRange.baseMipLevel = 0;
-    image_memory_barrier.subresourceRange.levelCount = 1;
-    image_memory_barrier.subresourceRange.baseArrayLayer = 0;
-    image_memory_barrier.subresourceRange.layerCount = 1;
-
-    switch (old_image_layout) {
-        case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
-            image_memory_barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-            break;
-
-        case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
-            image_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            break;
-
-        case VK_IMAGE_LAYOUT_PREINITIALIZED:
-            image_memory_barrier.srcAccessMask = VK_ACCESS_HOST_WRITE_BIT;
-            break;
-
-        default:
-            break;
-    }
-
-    switch (new_image_layout) {
-        case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
-            image_memory_barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            break;
-
-        case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
-            image_memory_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-            break;
-
-        case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
-            image_memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-            break;
-
-        case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
-            image_memory_barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-            break;
+    /*
+     * The caller knows what last touched the image, so seed the tracker with
+     * that: src_stages did whatever the old layout implies.
+     */
+    ResourceState state;
+    state.write_stages = src_stages;
+    state.write_access = access_for_layout(old_image_layout) & write_access_mask;
+    state.layout = old_image_layout;
+    info.state_tracker.track_image(image, aspectMask, 1, 1, state);
+
+    VkImageSubresourceRange range = {aspectMask, 0, 1, 0, 1};
+    set_image_layout(info, image, range, new_image_layout, dest_stages);
+}
 
-        case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
-            image_memory_barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-            break;
+void set_image_layout(struct sample_info &info, VkImage image, const VkImageSubresourceRange &range,
+                      VkImageLayout new_image_layout, VkPipelineStageFlags dest_stages) {
+    /* DEPENDS on info.cmd initialized and image known to info.state_tracker */
 
-        default:
-            break;
-    }
+    assert(info.cmd != VK_NULL_HANDLE);
 
-    vkCmdPipelineBarrier(info.cmd, src_stages, dest_stages, 0, 0, NULL, 0, NULL, 1, &image_memory_barrier);
+    /* Source masks come from the tracked state; nothing is recorded if the
+     * subresources are already in place */
+    bool U_ASSERT_ONLY tracked = info.state_tracker.use_image(image, range, dest_stages, access_for_layout(new_image_layout),
+                                                              new_image_layout);
+    assert(tracked);
+    info.state_tracker.flush(info.cmd);
 }
 
 bool read_ppm(char const *const filename, int &width, int &height, uint64_t rowPitch, unsigned char *dataPtr) {
     // PPM format expected from http://netpbm.sourceforge.net/doc/ppm.html
-    //  1. magic number
-    //  2. whitespace
-    //  3. width
-    //  4. whitespace
-    //  5. height
-    //  6. whitespace
-    //  7. max color value
-    //  8. whitespace
-    //  7. data
-
-    // Comments are not supported, but are detected and we kick out
-    // Only 8 bits per channel is supported
+    // Binary P6 and P5 files with comments and any maxval up to 65535 are
+    // supported; see PpmImage.
     // If dataPtr is nullptr, only width and height are returned
+    // Callers that need both should use PpmImage directly and map the file once
 
-    // Read in values from the PPM file as characters to check for comments
-    char magicStr[3] = {}, heightStr[6] = {}, widthStr[6] = {}, formatStr[6] = {};
-
-#ifndef __ANDROID__
-    FILE *fPtr = fopen(filename, "rb");
-#else
-    FILE *fPtr = AndroidFopen(filename, "rb");
-#endif
-    if (!fPtr) {
+    PpmImage image;
+    if (!image.open(filename)) {
         printf("Bad filename in read_ppm: %s\n", filename);
         return false;
     }
 
-    // Read the four values from file, accounting with any and all whitepace
-    int U_ASSERT_ONLY count = fscanf(fPtr, "%s %s %s %s ", magicStr, widthStr, heightStr, formatStr);
-    assert(count == 4);
-
-    // Kick out if comments present
-    if (magicStr[0] == '#' || widthStr[0] == '#' || heightStr[0] == '#' || formatStr[0] == '#') {
-        printf("Unhandled comment in PPM file\n");
-        return false;
-    }
-
-    // Only one magic value is valid
-    if (strncmp(magicStr, "P6", sizeof(magicStr))) {
-        printf("Unhandled PPM magic number: %s\n", magicStr);
-        return false;
-    }
-
-    width = atoi(widthStr);
-    height = atoi(heightStr);
-
-    // Ensure we got something sane for width/height
-    static const int saneDimension = 32768;  //??
-    if (width <= 0 || width > saneDimension) {
-        printf("Width seems wrong.  Update read_ppm if not: %u\n", width);
-        return false;
-    }
-    if (height <= 0 || height > saneDimension) {
-        printf("Height seems wrong.  Update read_ppm if not: %u\n", height);
-        return false;
-    }
+    width = static_cast<int>(image.width());
+    height = static_cast<int>(image.height());
 
     if (dataPtr == nullptr) {
         // If no destination pointer, caller only wanted dimensions
         return true;
     }
 
-    // Now read the data
-    for (int y = 0; y < height; y++) {
-        unsigned char *rowPtr = dataPtr;
-        for (int x = 0; x < width; x++) {
-            count = fread(rowPtr, 3, 1, fPtr);
-            assert(count == 1);
-            rowPtr[3] = 255; /* Alpha of 1 */
-            rowPtr += 4;
-        }
-        dataPtr += rowPitch;
-    }
-    fclose(fPtr);
-
+    image.read_rgba(dataPtr, rowPitch);
     return true;
 }
 
@@ -387,60 +289,15 @@ void process_command_line_args(struct sample_info &info, int argc, char *argv[])
 }
 
 void write_ppm(struct sample_info &info, const char *basename) {
-    string filename;
-    int x, y;
     VkResult res;
 
-    VkImageCreateInfo image_create_info = {};
-    image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-    image_create_info.pNext = NULL;
-    image_create_info.imageType = VK_IMAGE_TYPE_2D;
-    image_create_info.format = info.format;
-    image_create_info.extent.width = info.width;
-    image_create_info.extent.height = info.height;
-    image_create_info.extent.depth = 1;
-    image_create_info.mipLevels = 1;
-    image_create_info.arrayLayers = 1;
-    image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
-    image_create_info.tiling = VK_IMAGE_TILING_LINEAR;
-    image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    image_create_info.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-    image_create_info.queueFamilyIndexCount = 0;
-    image_create_info.pQueueFamilyIndices = NULL;
-    image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    image_create_info.flags = 0;
-
-    VkMemoryAllocateInfo mem_alloc = {};
-    mem_alloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    mem_alloc.pNext = NULL;
-    mem_alloc.allocationSize = 0;
-    mem_alloc.memoryTypeIndex = 0;
-
-    VkImage mappableImage;
-    VkDeviceMemory mappableMemory;
-
-    /* Create a mappable image */
-    res = vkCreateImage(info.device, &image_create_info, NULL, &mappableImage);
-    assert(res == VK_SUCCESS);
-
-    VkMemoryRequirements mem_reqs;
-    vkGetImageMemoryRequirements(info.device, mappableImage, &mem_reqs);
-
-    mem_alloc.allocationSize = mem_reqs.size;
-
-    /* Find the memory type that is host mappable */
-    bool U_ASSERT_ONLY pass = memory_type_from_properties(
-        info, mem_reqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        &mem_alloc.memoryTypeIndex);
-    assert(pass && "No mappable, coherent memory");
-
-    /* allocate memory */
-    res = vkAllocateMemory(info.device, &mem_alloc, NULL, &(mappableMemory));
-    assert(res == VK_SUCCESS);
-
-    /* bind memory */
-    res = vkBindImageMemory(info.device, mappableImage, mappableMemory, 0);
-    assert(res == VK_SUCCESS);
+    /* Read back through a one-buffer frame capture and wait for the file */
+    FrameCapture capture;
+    if (!capture.init(info.device_dispatch, info.memory_allocator, info.graphics_timeline, info.format,
+                      {static_cast<uint32_t>(info.width), static_cast<uint32_t>(info.height)}, CaptureFileFormat::Ppm, 1)) {
+        printf("Unrecognized image format - will not write image files");
+        return;
+    }
 
     VkCommandBufferBeginInfo cmd_buf_info = {};
     cmd_buf_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -448,121 +305,33 @@ void write_ppm(struct sample_info &info, const char *basename) {
     cmd_buf_info.flags = 0;
     cmd_buf_info.pInheritanceInfo = NULL;
 
-    res = vkBeginCommandBuffer(info.cmd, &cmd_buf_info);
-    set_image_layout(info, mappableImage, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
-                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
-
+    /* info.cmd_pool only holds info.cmd, whose last submission has completed */
+    res = info.device_dispatch.vkResetCommandPool(info.device, info.cmd_pool, 0);
+    assert(res == VK_SUCCESS);
+    res = info.device_dispatch.vkBeginCommandBuffer(info.cmd, &cmd_buf_info);
+    assert(res == VK_SUCCESS);
     set_image_layout(info, info.buffers[info.current_buffer].image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
                      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
 
-    VkImageCopy copy_region;
-    copy_region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    copy_region.srcSubresource.mipLevel = 0;
-    copy_region.srcSubresource.baseArrayLayer = 0;
-    copy_region.srcSubresource.layerCount = 1;
-    copy_region.srcOffset.x = 0;
-    copy_region.srcOffset.y = 0;
-    copy_region.srcOffset.z = 0;
-    copy_region.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    copy_region.dstSubresource.mipLevel = 0;
-    copy_region.dstSubresource.baseArrayLayer = 0;
-    copy_region.dstSubresource.layerCount = 1;
-    copy_region.dstOffset.x = 0;
-    copy_region.dstOffset.y = 0;
-    copy_region.dstOffset.z = 0;
-    copy_region.extent.width = info.width;
-    copy_region.extent.height = info.height;
-    copy_region.extent.depth = 1;
-
-    /* Put the copy command into the command buffer */
-    vkCmdCopyImage(info.cmd, info.buffers[info.current_buffer].image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, mappableImage,
-                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy_region);
-
-    set_image_layout(info, mappableImage, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL,
-                     VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT);
-
-    res = vkEndCommandBuffer(info.cmd);
+    /* Put the copy into the buffer and its host barrier into the command buffer */
+    bool recorded = capture.capture(info.cmd, info.buffers[info.current_buffer].image, basename);
+
+    res = info.device_dispatch.vkEndCommandBuffer(info.cmd);
     assert(res == VK_SUCCESS);
+    if (!recorded) {
+        return;
+    }
     const VkCommandBuffer cmd_bufs[] = {info.cmd};
-    VkFenceCreateInfo fenceInfo;
-    VkFence cmdFence;
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.pNext = NULL;
-    fenceInfo.flags = 0;
-    vkCreateFence(info.device, &fenceInfo, NULL, &cmdFence);
-
-    VkSubmitInfo submit_info[1] = {};
-    submit_info[0].pNext = NULL;
-    submit_info[0].sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submit_info[0].waitSemaphoreCount = 0;
-    submit_info[0].pWaitSemaphores = NULL;
-    submit_info[0].pWaitDstStageMask = NULL;
-    submit_info[0].commandBufferCount = 1;
-    submit_info[0].pCommandBuffers = cmd_bufs;
-    submit_info[0].signalSemaphoreCount = 0;
-    submit_info[0].pSignalSemaphores = NULL;
 
     /* Queue the command buffer for execution */
-    res = vkQueueSubmit(info.graphics_queue, 1, submit_info, cmdFence);
+    uint64_t submitted_value;
+    res = info.graphics_timeline.submit(1, cmd_bufs, submitted_value);
     assert(res == VK_SUCCESS);
+    capture.submitted(submitted_value);
 
-    /* Make sure command buffer is finished before mapping */
-    do {
-        res = vkWaitForFences(info.device, 1, &cmdFence, VK_TRUE, FENCE_TIMEOUT);
-    } while (res == VK_TIMEOUT);
-    assert(res == VK_SUCCESS);
-
-    vkDestroyFence(info.device, cmdFence, NULL);
-
-    filename.append(basename);
-    filename.append(".ppm");
-
-    VkImageSubresource subres = {};
-    subres.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    subres.mipLevel = 0;
-    subres.arrayLayer = 0;
-    VkSubresourceLayout sr_layout;
-    vkGetImageSubresourceLayout(info.device, mappableImage, &subres, &sr_layout);
-
-    char *ptr;
-    res = vkMapMemory(info.device, mappableMemory, 0, mem_reqs.size, 0, (void **)&ptr);
-    assert(res == VK_SUCCESS);
-
-    ptr += sr_layout.offset;
-    ofstream file(filename.c_str(), ios::binary);
-
-    file << "P6\n";
-    file << info.width << " ";
-    file << info.height << "\n";
-    file << 255 << "\n";
-
-    for (y = 0; y < info.height; y++) {
-        const int *row = (const int *)ptr;
-        int swapped;
-
-        if (info.format == VK_FORMAT_B8G8R8A8_UNORM || info.format == VK_FORMAT_B8G8R8A8_SRGB) {
-            for (x = 0; x < info.width; x++) {
-                swapped = (*row & 0xff00ff00) | (*row & 0x000000ff) << 16 | (*row & 0x00ff0000) >> 16;
-                file.write((char *)&swapped, 3);
-                row++;
-            }
-        } else if (info.format == VK_FORMAT_R8G8B8A8_UNORM) {
-            for (x = 0; x < info.width; x++) {
-                file.write((char *)row, 3);
-                row++;
-            }
-        } else {
-            printf("Unrecognized image format - will not write image files");
-            break;
-        }
-
-        ptr += sr_layout.rowPitch;
-    }
-
-    file.close();
-    vkUnmapMemory(info.device, mappableMemory);
-    vkDestroyImage(info.device, mappableImage, NULL);
-    vkFreeMemory(info.device, mappableMemory, NULL);
+    /* The worker converts to RGB and writes the file; wait for it */
+    capture.flush();
+    capture.destroy();
 }
 
 std::string get_file_directory() {
@@ -52,6 +52,18 @@
 #endif
 
 #include <vulkan/vulkan.h>
+#include "deferred_deletion.h"
+#include "descriptor_allocator.h"
+#include "descriptor_writer.h"
+#include "frame_capture.h"
+#include "object_cache.h"
+#include "pipeline_builder.h"
+#include "pipeline_cache.h"
+#include "ppm_image.h"
+#include "resource_state_tracker.h"
+#include "ring_buffer.h"
+#include "timeline_queue.h"
+#include "upload_engine.h"
 
 /* Number of descriptor sets needs to be the same at alloc,       */
 /* pipeline layout creation, and descriptor set layout creation   */
@@ -70,25 +82,10 @@
 /* Amount of time, in nanoseconds, to wait for a command buffer to complete */
 #define FENCE_TIMEOUT 100000000
 
-#define GET_INSTANCE_PROC_ADDR(inst, entrypoint)                               \
-    {                                                                          \
-        info.fp##entrypoint =                                                  \
-            (PFN_vk##entrypoint)vkGetInstanceProcAddr(inst, "vk" #entrypoint); \
-        if (info.fp##entrypoint == NULL) {                                     \
-            std::cout << "vkGetDeviceProcAddr failed to find vk" #entrypoint;  \
-            exit(-1);                                                          \
-        }                                                                      \
-    }
-
-#define GET_DEVICE_PROC_ADDR(dev, entrypoint)                                  \
-    {                                                                          \
-        info.fp##entrypoint =                                                  \
-            (PFN_vk##entrypoint)vkGetDeviceProcAddr(dev, "vk" #entrypoint);    \
-        if (info.fp##entrypoint == NULL) {                                     \
-            std::cout << "vkGetDeviceProcAddr failed to find vk" #entrypoint;  \
-            exit(-1);                                                          \
-        }                                                                      \
-    }
+/* Streaming ring buffer for per-frame uniforms and dynamic geometry.  */
+/* A frame's partition is reused FRAME_RING_FRAME_COUNT frames later.  */
+#define FRAME_RING_FRAME_COUNT 2
+#define FRAME_RING_FRAME_SIZE (256 * 1024)
 
 #if defined(NDEBUG) && defined(__GNUC__)
 #define U_ASSERT_ONLY __attribute__((unused))
@@ -103,7 +100,7 @@ std::string get_data_dir(std::string filename);
  * structure to track all objects related to a texture.
  */
 struct texture_object {
-    VkSampler sampler;
+    VkSampler sampler; // shared, owned by sample_info::object_cache
 
     VkImage image;
     VkImageLayout imageLayout;
@@ -112,8 +109,8 @@ struct texture_object {
     VkBuffer buffer;
     VkDeviceSize buffer_size;
 
-    VkDeviceMemory image_memory;
-    VkDeviceMemory buffer_memory;
+    MemoryAllocation image_allocation;
+    MemoryAllocation buffer_allocation;
     VkImageView view;
     int32_t tex_width, tex_height;
 };
@@ -149,8 +146,6 @@ struct sample_info {
     HWND window;                 // hWnd - window handle
 #elif defined(VK_USE_PLATFORM_METAL_EXT)
     void *caMetalLayer;
-#elif defined(__ANDROID__)
-    PFN_vkCreateAndroidSurfaceKHR fpCreateAndroidSurfaceKHR;
 #elif defined(VK_USE_PLATFORM_WAYLAND_KHR)
     wl_display *display;
     wl_registry *registry;
@@ -164,6 +159,25 @@ struct sample_info {
     xcb_window_t window;
     xcb_intern_atom_reply_t *atom_wm_delete_window;
 #endif // _WIN32
+    void *vulkan_library;
+    PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr;
+    GlobalFunctions global_functions;
+    InstanceFunctions instance_functions;
+    DeviceDispatch device_dispatch;
+    MemoryAllocator memory_allocator;
+    FrameRingBuffer frame_ring;
+    bool physical_device_properties2_enabled;
+    bool timeline_semaphore_enabled;
+    bool synchronization2_enabled;
+    bool descriptor_update_template_enabled;
+    TimelineQueue graphics_timeline;
+    DeferredDeletionQueue deletion_queue;
+    ResourceStateTracker state_tracker;
+    UploadEngine upload_engine;
+    /* Scratch for the upload semaphores an acquire submission waits on */
+    std::vector<VkSemaphore> upload_wait_semaphores;
+    std::vector<VkPipelineStageFlags> upload_wait_stages;
+
     VkSurfaceKHR surface;
     bool prepared;
     bool use_staging_buffer;
@@ -181,8 +195,10 @@ struct sample_info {
     VkDevice device;
     VkQueue graphics_queue;
     VkQueue present_queue;
+    VkQueue transfer_queue;
     uint32_t graphics_queue_family_index;
     uint32_t present_queue_family_index;
+    uint32_t transfer_queue_family_index;
     VkPhysicalDeviceProperties gpu_props;
     std::vector<VkQueueFamilyProperties> queue_props;
     VkPhysicalDeviceMemoryProperties memory_properties;
@@ -197,20 +213,26 @@ struct sample_info {
     VkSemaphore imageAcquiredSemaphore;
 
     VkCommandPool cmd_pool;
+    /* Upload acquires are recorded here at submission time, see
+       submit_upload_acquires() in util_init.cpp */
+    VkCommandPool upload_acquire_pool;
+    VkCommandBuffer upload_acquire_cmd;
+    uint64_t upload_acquire_value;
 
     struct {
         VkFormat format;
 
         VkImage image;
-        VkDeviceMemory mem;
+        MemoryAllocation allocation;
         VkImageView view;
     } depth;
 
     std::vector<struct texture_object> textures;
 
+    /* This frame's slice of frame_ring, written by update_uniform_buffer()
+       and bound by execute_bind_descriptor_sets() */
     struct {
-        VkBuffer buf;
-        VkDeviceMemory mem;
+        RingAllocation allocation;
         VkDescriptorBufferInfo buffer_info;
     } uniform_data;
 
@@ -220,7 +242,7 @@ struct sample_info {
 
     struct {
         VkBuffer buf;
-        VkDeviceMemory mem;
+        MemoryAllocation allocation;
         VkDescriptorBufferInfo buffer_info;
     } vertex_buffer;
     VkVertexInputBindingDescription vi_binding;
@@ -233,15 +255,18 @@ struct sample_info {
     glm::mat4 MVP;
 
     VkCommandBuffer cmd; // Buffer for initialization commands
+    ObjectCache object_cache; // owns the layouts, render pass and pipeline below
     VkPipelineLayout pipeline_layout;
     std::vector<VkDescriptorSetLayout> desc_layout;
     VkPipelineCache pipelineCache;
+    PipelineCache pipeline_cache; // owns pipelineCache and persists it
     VkRenderPass render_pass;
     VkPipeline pipeline;
 
     VkPipelineShaderStageCreateInfo shaderStages[2];
 
-    VkDescriptorPool desc_pool;
+    DescriptorAllocator descriptor_allocator;
+    DescriptorWriter descriptor_writer;
     std::vector<VkDescriptorSet> desc_set;
 
     PFN_vkCreateDebugReportCallbackEXT dbgCreateDebugReportCallback;
@@ -267,6 +292,10 @@ void set_image_layout(struct sample_info &demo, VkImage image,
                       VkImageLayout new_image_layout,
                       VkPipelineStageFlags src_stages,
                       VkPipelineStageFlags dest_stages);
+void set_image_layout(struct sample_info &info, VkImage image,
+                      const VkImageSubresourceRange &range,
+                      VkImageLayout new_image_layout,
+                      VkPipelineStageFlags dest_stages);
 
 bool read_ppm(char const *const filename, int &width, int &height,
               uint64_t rowPitch, unsigned char *dataPtr);
@@ -23,7 +23,10 @@ VULKAN_SAMPLE_DESCRIPTION
 samples "init" utility functions
 */
 
+#include <chrono>
+#include <cstddef>
 #include <cstdlib>
+#include <iomanip>
 #include <assert.h>
 #include <string.h>
 #include "util_init.hpp"
@@ -38,7 +41,7 @@ using namespace std;
 /*
  * TODO: function description here
  */
-VkResult init_global_extension_properties(layer_properties &layer_props) {
+VkResult init_global_extension_properties(struct sample_info &info, layer_properties &layer_props) {
     VkExtensionProperties *instance_extensions;
     uint32_t instance_extension_count;
     VkResult res;
@@ -47,7 +50,7 @@ VkResult init_global_extension_properties(layer_properties &layer_props) {
     layer_name = layer_props.properties.layerName;
 
     do {
-        res = vkEnumerateInstanceExtensionProperties(layer_name, &instance_extension_count, NULL);
+        res = info.global_functions.vkEnumerateInstanceExtensionProperties(layer_name, &instance_extension_count, NULL);
         if (res) return res;
 
         if (instance_extension_count == 0) {
@@ -56,7 +59,7 @@ VkResult init_global_extension_properties(layer_properties &layer_props) {
 
         layer_props.instance_extensions.resize(instance_extension_count);
         instance_extensions = layer_props.instance_extensions.data();
-        res = vkEnumerateInstanceExtensionProperties(layer_name, &instance_extension_count, instance_extensions);
+        res = info.global_functions.vkEnumerateInstanceExtensionProperties(layer_name, &instance_extension_count, instance_extensions);
     } while (res == VK_INCOMPLETE);
 
     return res;
@@ -79,6 +82,11 @@ VkResult init_global_layer_properties(struct sample_info &info) {
     }
     LOGI("Loaded Vulkan APIs.");
 #endif
+    info.vulkan_library = load_vulkan_library();
+    info.vkGetInstanceProcAddr = load_exported_vulkan_function(info.vulkan_library);
+    if (!load_global_level_functions(info.vkGetInstanceProcAddr, info.global_functions)) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
 
     /*
      * It's possible, though very rare, that the number of
@@ -93,7 +101,7 @@ VkResult init_global_layer_properties(struct sample_info &info) {
      * of layers went down or is smaller than the size given.
      */
     do {
-        res = vkEnumerateInstanceLayerProperties(&instance_layer_count, NULL);
+        res = info.global_functions.vkEnumerateInstanceLayerProperties(&instance_layer_count, NULL);
         if (res) return res;
 
         if (instance_layer_count == 0) {
@@ -102,7 +110,7 @@ VkResult init_global_layer_properties(struct sample_info &info) {
 
         vk_props = (VkLayerProperties *)realloc(vk_props, instance_layer_count * sizeof(VkLayerProperties));
 
-        res = vkEnumerateInstanceLayerProperties(&instance_layer_count, vk_props);
+        res = info.global_functions.vkEnumerateInstanceLayerProperties(&instance_layer_count, vk_props);
     } while (res == VK_INCOMPLETE);
 
     /*
@@ -111,7 +119,7 @@ VkResult init_global_layer_properties(struct sample_info &info) {
     for (uint32_t i = 0; i < instance_layer_count; i++) {
         layer_properties layer_props;
         layer_props.properties = vk_props[i];
-        res = init_global_extension_properties(layer_props);
+        res = init_global_extension_properties(info, layer_props);
         if (res) return res;
         info.instance_layer_properties.push_back(layer_props);
     }
@@ -129,7 +137,7 @@ VkResult init_device_extension_properties(struct sample_info &info, layer_proper
     layer_name = layer_props.properties.layerName;
 
     do {
-        res = vkEnumerateDeviceExtensionProperties(info.gpus[0], layer_name, &device_extension_count, NULL);
+        res = info.instance_functions.vkEnumerateDeviceExtensionProperties(info.gpus[0], layer_name, &device_extension_count, NULL);
         if (res) return res;
 
         if (device_extension_count == 0) {
@@ -138,7 +146,7 @@ VkResult init_device_extension_properties(struct sample_info &info, layer_proper
 
         layer_props.device_extensions.resize(device_extension_count);
         device_extensions = layer_props.device_extensions.data();
-        res = vkEnumerateDeviceExtensionProperties(info.gpus[0], layer_name, &device_extension_count, device_extensions);
+        res = info.instance_functions.vkEnumerateDeviceExtensionProperties(info.gpus[0], layer_name, &device_extension_count, device_extensions);
     } while (res == VK_INCOMPLETE);
 
     return res;
@@ -191,6 +199,17 @@ VkResult init_instance(struct sample_info &info, char const *const app_short_nam
     app_info.engineVersion = 1;
     app_info.apiVersion = VK_API_VERSION_1_0;
 
+    /* Timeline semaphores and synchronization2 need
+       VK_KHR_get_physical_device_properties2 on a 1.0 instance */
+    uint32_t instance_extension_count = 0;
+    info.global_functions.vkEnumerateInstanceExtensionProperties(NULL, &instance_extension_count, NULL);
+    info.instance_extension_properties.resize(instance_extension_count);
+    info.global_functions.vkEnumerateInstanceExtensionProperties(NULL, &instance_extension_count,
+                                                                 info.instance_extension_properties.data());
+    info.instance_extension_properties.resize(instance_extension_count);
+    info.physical_device_properties2_enabled =
+        enable_physical_device_properties2(info.instance_extension_properties, info.instance_extension_names);
+
     VkInstanceCreateInfo inst_info = {};
     inst_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     inst_info.pNext = NULL;
@@ -201,9 +220,14 @@ VkResult init_instance(struct sample_info &info, char const *const app_short_nam
     inst_info.enabledExtensionCount = info.instance_extension_names.size();
     inst_info.ppEnabledExtensionNames = info.instance_extension_names.data();
 
-    VkResult res = vkCreateInstance(&inst_info, NULL, &info.inst);
+    VkResult res = info.global_functions.vkCreateInstance(&inst_info, NULL, &info.inst);
     assert(res == VK_SUCCESS);
 
+    if (!load_instance_level_functions(info.vkGetInstanceProcAddr, info.inst, info.instance_extension_names,
+                                       info.instance_functions)) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
     return res;
 }
 
@@ -222,40 +246,111 @@ VkResult init_device(struct sample_info &info) {
     queue_info.pQueuePriorities = queue_priorities;
     queue_info.queueFamilyIndex = info.graphics_queue_family_index;
 
+    /* Uploads go through a transfer-only queue family when the device has one */
+    info.transfer_queue_family_index = find_transfer_queue_family(info.queue_props, info.graphics_queue_family_index);
+    VkDeviceQueueCreateInfo queue_infos[2] = {queue_info, queue_info};
+    queue_infos[1].queueFamilyIndex = info.transfer_queue_family_index;
+
     VkDeviceCreateInfo device_info = {};
     device_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     device_info.pNext = NULL;
-    device_info.queueCreateInfoCount = 1;
-    device_info.pQueueCreateInfos = &queue_info;
+    device_info.queueCreateInfoCount = info.transfer_queue_family_index != info.graphics_queue_family_index ? 2 : 1;
+    device_info.pQueueCreateInfos = queue_infos;
+    /* Track submissions with a timeline semaphore where the device has one */
+    uint32_t available_extension_count = 0;
+    info.instance_functions.vkEnumerateDeviceExtensionProperties(info.gpus[0], NULL, &available_extension_count, NULL);
+    std::vector<VkExtensionProperties> available_extensions(available_extension_count);
+    info.instance_functions.vkEnumerateDeviceExtensionProperties(info.gpus[0], NULL, &available_extension_count,
+                                                                 available_extensions.data());
+    info.timeline_semaphore_enabled =
+        info.physical_device_properties2_enabled && timeline_semaphore_supported(available_extensions);
+    /* Same for synchronization2, which lets every barrier carry its own stage masks */
+    info.synchronization2_enabled =
+        info.physical_device_properties2_enabled && synchronization2_supported(available_extensions);
+    /* And for update templates, which write a whole descriptor set in one call */
+    info.descriptor_update_template_enabled = descriptor_update_template_supported(available_extensions);
+    void *feature_chain = NULL;
+    VkPhysicalDeviceTimelineSemaphoreFeatures timeline_features = {};
+    timeline_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    timeline_features.pNext = NULL;
+    timeline_features.timelineSemaphore = VK_TRUE;
+    VkPhysicalDeviceSynchronization2Features synchronization2_features = {};
+    synchronization2_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES;
+    synchronization2_features.pNext = NULL;
+    synchronization2_features.synchronization2 = VK_TRUE;
+    if (info.timeline_semaphore_enabled) {
+        bool requested = false;
+        for (const char *name : info.device_extension_names) {
+            requested = requested || strcmp(name, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) == 0;
+        }
+        if (!requested) {
+            info.device_extension_names.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+        }
+        timeline_features.pNext = feature_chain;
+        feature_chain = &timeline_features;
+    }
+    if (info.synchronization2_enabled) {
+        bool requested = false;
+        for (const char *name : info.device_extension_names) {
+            requested = requested || strcmp(name, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME) == 0;
+        }
+        if (!requested) {
+            info.device_extension_names.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+        }
+        synchronization2_features.pNext = feature_chain;
+        feature_chain = &synchronization2_features;
+    }
+    if (info.descriptor_update_template_enabled) {
+        bool requested = false;
+        for (const char *name : info.device_extension_names) {
+            requested = requested || strcmp(name, VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME) == 0;
+        }
+        if (!requested) {
+            info.device_extension_names.push_back(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+        }
+    }
+    device_info.pNext = feature_chain;
+
     device_info.enabledExtensionCount = info.device_extension_names.size();
     device_info.ppEnabledExtensionNames = device_info.enabledExtensionCount ? info.device_extension_names.data() : NULL;
     device_info.pEnabledFeatures = NULL;
 
-    res = vkCreateDevice(info.gpus[0], &device_info, NULL, &info.device);
+    res = info.instance_functions.vkCreateDevice(info.gpus[0], &device_info, NULL, &info.device);
     assert(res == VK_SUCCESS);
 
+    if (!create_device_dispatch(info.instance_functions.vkGetDeviceProcAddr, info.device, info.device_extension_names,
+                                info.device_dispatch)) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    if (!info.memory_allocator.init(info.device_dispatch, info.memory_properties, info.gpu_props.limits)) {
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    info.state_tracker.init(info.device_dispatch, info.synchronization2_enabled);
+    info.object_cache.init(info.device_dispatch);
+    info.descriptor_writer.init(info.device_dispatch, info.descriptor_update_template_enabled);
+
     return res;
 }
 
 VkResult init_enumerate_device(struct sample_info &info, uint32_t gpu_count) {
     uint32_t const U_ASSERT_ONLY req_count = gpu_count;
-    VkResult res = vkEnumeratePhysicalDevices(info.inst, &gpu_count, NULL);
+    VkResult res = info.instance_functions.vkEnumeratePhysicalDevices(info.inst, &gpu_count, NULL);
     assert(gpu_count);
     info.gpus.resize(gpu_count);
 
-    res = vkEnumeratePhysicalDevices(info.inst, &gpu_count, info.gpus.data());
+    res = info.instance_functions.vkEnumeratePhysicalDevices(info.inst, &gpu_count, info.gpus.data());
     assert(!res && gpu_count >= req_count);
 
-    vkGetPhysicalDeviceQueueFamilyProperties(info.gpus[0], &info.queue_family_count, NULL);
+    info.instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(info.gpus[0], &info.queue_family_count, NULL);
     assert(info.queue_family_count >= 1);
 
     info.queue_props.resize(info.queue_family_count);
-    vkGetPhysicalDeviceQueueFamilyProperties(info.gpus[0], &info.queue_family_count, info.queue_props.data());
+    info.instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(info.gpus[0], &info.queue_family_count, info.queue_props.data());
     assert(info.queue_family_count >= 1);
 
     /* This is as good a place as any to do this */
-    vkGetPhysicalDeviceMemoryProperties(info.gpus[0], &info.memory_properties);
-    vkGetPhysicalDeviceProperties(info.gpus[0], &info.gpu_props);
+    info.instance_functions.vkGetPhysicalDeviceMemoryProperties(info.gpus[0], &info.memory_properties);
+    info.instance_functions.vkGetPhysicalDeviceProperties(info.gpus[0], &info.gpu_props);
     /* query device extensions for enabled layers */
     for (auto &layer_props : info.instance_layer_properties) {
         init_device_extension_properties(info, layer_props);
@@ -273,11 +368,11 @@ void init_queue_family_index(struct sample_info &info) {
      * family
      */
 
-    vkGetPhysicalDeviceQueueFamilyProperties(info.gpus[0], &info.queue_family_count, NULL);
+    info.instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(info.gpus[0], &info.queue_family_count, NULL);
     assert(info.queue_family_count >= 1);
 
     info.queue_props.resize(info.queue_family_count);
-    vkGetPhysicalDeviceQueueFamilyProperties(info.gpus[0], &info.queue_family_count, info.queue_props.data());
+    info.instance_functions.vkGetPhysicalDeviceQueueFamilyProperties(info.gpus[0], &info.queue_family_count, info.queue_props.data());
     assert(info.queue_family_count >= 1);
 
     bool U_ASSERT_ONLY found = false;
@@ -296,7 +391,7 @@ VkResult init_debug_report_callback(struct sample_info &info, PFN_vkDebugReportC
     VkDebugReportCallbackEXT debug_report_callback;
 
     info.dbgCreateDebugReportCallback =
-        (PFN_vkCreateDebugReportCallbackEXT)vkGetInstanceProcAddr(info.inst, "vkCreateDebugReportCallbackEXT");
+        (PFN_vkCreateDebugReportCallbackEXT)info.vkGetInstanceProcAddr(info.inst, "vkCreateDebugReportCallbackEXT");
     if (!info.dbgCreateDebugReportCallback) {
         std::cout << "GetInstanceProcAddr: Unable to find "
                      "vkCreateDebugReportCallbackEXT function."
@@ -306,7 +401,7 @@ VkResult init_debug_report_callback(struct sample_info &info, PFN_vkDebugReportC
     std::cout << "Got dbgCreateDebugReportCallback function\n";
 
     info.dbgDestroyDebugReportCallback =
-        (PFN_vkDestroyDebugReportCallbackEXT)vkGetInstanceProcAddr(info.inst, "vkDestroyDebugReportCallbackEXT");
+        (PFN_vkDestroyDebugReportCallbackEXT)info.vkGetInstanceProcAddr(info.inst, "vkDestroyDebugReportCallbackEXT");
     if (!info.dbgDestroyDebugReportCallback) {
         std::cout << "GetInstanceProcAddr: Unable to find "
                      "vkDestroyDebugReportCallbackEXT function."
@@ -482,7 +577,7 @@ void init_window(struct sample_info &info) {
 }
 
 void destroy_window(struct sample_info &info) {
-    vkDestroySurfaceKHR(info.inst, info.surface, NULL);
+    info.instance_functions.vkDestroySurfaceKHR(info.inst, info.surface, NULL);
     DestroyWindow(info.window);
 }
 
@@ -574,7 +669,7 @@ void init_window(struct sample_info &info) {
 }
 
 void destroy_window(struct sample_info &info) {
-    vkDestroySurfaceKHR(info.inst, info.surface, NULL);
+    info.instance_functions.vkDestroySurfaceKHR(info.inst, info.surface, NULL);
     xcb_destroy_window(info.connection, info.window);
     xcb_disconnect(info.connection);
 }
@@ -592,14 +687,13 @@ void init_window_size(struct sample_info &info, int32_t default_width, int32_t d
 
 void init_depth_buffer(struct sample_info &info) {
     VkResult U_ASSERT_ONLY res;
-    bool U_ASSERT_ONLY pass;
     VkImageCreateInfo image_info = {};
     VkFormatProperties props;
 
     /* allow custom depth formats */
 #ifdef __ANDROID__
     // Depth format needs to be VK_FORMAT_D24_UNORM_S8_UINT on Android (if available).
-    vkGetPhysicalDeviceFormatProperties(info.gpus[0], VK_FORMAT_D24_UNORM_S8_UINT, &props);
+    info.instance_functions.vkGetPhysicalDeviceFormatProperties(info.gpus[0], VK_FORMAT_D24_UNORM_S8_UINT, &props);
     if ((props.linearTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) ||
         (props.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT))
         info.depth.format = VK_FORMAT_D24_UNORM_S8_UINT;
@@ -612,7 +706,7 @@ void init_depth_buffer(struct sample_info &info) {
 #endif
 
     const VkFormat depth_format = info.depth.format;
-    vkGetPhysicalDeviceFormatProperties(info.gpus[0], depth_format, &props);
+    info.instance_functions.vkGetPhysicalDeviceFormatProperties(info.gpus[0], depth_format, &props);
     if (props.linearTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) {
         image_info.tiling = VK_IMAGE_TILING_LINEAR;
     } else if (props.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) {
@@ -668,31 +762,19 @@ void init_depth_buffer(struct sample_info &info) {
         view_info.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
     }
 
-    VkMemoryRequirements mem_reqs;
 
     /* Create image */
-    res = vkCreateImage(info.device, &image_info, NULL, &info.depth.image);
-    assert(res == VK_SUCCESS);
-
-    vkGetImageMemoryRequirements(info.device, info.depth.image, &mem_reqs);
-
-    mem_alloc.allocationSize = mem_reqs.size;
-    /* Use the memory properties to determine the type of memory required */
-    pass =
-        memory_type_from_properties(info, mem_reqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &mem_alloc.memoryTypeIndex);
-    assert(pass);
-
-    /* Allocate memory */
-    res = vkAllocateMemory(info.device, &mem_alloc, NULL, &info.depth.mem);
+    res = info.device_dispatch.vkCreateImage(info.device, &image_info, NULL, &info.depth.image);
     assert(res == VK_SUCCESS);
 
-    /* Bind memory */
-    res = vkBindImageMemory(info.device, info.depth.image, info.depth.mem, 0);
+    /* Allocate and bind memory; depth buffers are large, so give them their own */
+    res = info.memory_allocator.allocate_for_image(info.depth.image, image_info.tiling, MemoryUsage::GpuOnly,
+                                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, info.depth.allocation, true);
     assert(res == VK_SUCCESS);
 
     /* Create image view */
     view_info.image = info.depth.image;
-    res = vkCreateImageView(info.device, &view_info, NULL, &info.depth.view);
+    res = info.device_dispatch.vkCreateImageView(info.device, &view_info, NULL, &info.depth.view);
     assert(res == VK_SUCCESS);
 }
 
@@ -713,44 +795,42 @@ void init_swapchain_extension(struct sample_info &info) {
     createInfo.pNext = NULL;
     createInfo.hinstance = info.connection;
     createInfo.hwnd = info.window;
-    res = vkCreateWin32SurfaceKHR(info.inst, &createInfo, NULL, &info.surface);
+    res = info.instance_functions.vkCreateWin32SurfaceKHR(info.inst, &createInfo, NULL, &info.surface);
 #elif defined(__ANDROID__)
-    GET_INSTANCE_PROC_ADDR(info.inst, CreateAndroidSurfaceKHR);
-
     VkAndroidSurfaceCreateInfoKHR createInfo;
     createInfo.sType = VK_STRUCTURE_TYPE_ANDROID_SURFACE_CREATE_INFO_KHR;
     createInfo.pNext = nullptr;
     createInfo.flags = 0;
     createInfo.window = AndroidGetApplicationWindow();
-    res = info.fpCreateAndroidSurfaceKHR(info.inst, &createInfo, nullptr, &info.surface);
+    res = info.instance_functions.vkCreateAndroidSurfaceKHR(info.inst, &createInfo, nullptr, &info.surface);
 #elif defined(VK_USE_PLATFORM_METAL_EXT)
     VkMetalSurfaceCreateInfoEXT createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_METAL_SURFACE_CREATE_INFO_EXT;
     createInfo.pNext = NULL;
     createInfo.flags = 0;
     createInfo.pLayer = info.caMetalLayer;
-    res = vkCreateMetalSurfaceEXT(info.inst, &createInfo, NULL, &info.surface);
+    res = info.instance_functions.vkCreateMetalSurfaceEXT(info.inst, &createInfo, NULL, &info.surface);
 #elif defined(VK_USE_PLATFORM_WAYLAND_KHR)
     VkWaylandSurfaceCreateInfoKHR createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_WAYLAND_SURFACE_CREATE_INFO_KHR;
     createInfo.pNext = NULL;
     createInfo.display = info.display;
     createInfo.surface = info.window;
-    res = vkCreateWaylandSurfaceKHR(info.inst, &createInfo, NULL, &info.surface);
+    res = info.instance_functions.vkCreateWaylandSurfaceKHR(info.inst, &createInfo, NULL, &info.surface);
 #else
     VkXcbSurfaceCreateInfoKHR createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_XCB_SURFACE_CREATE_INFO_KHR;
     createInfo.pNext = NULL;
     createInfo.connection = info.connection;
     createInfo.window = info.window;
-    res = vkCreateXcbSurfaceKHR(info.inst, &createInfo, NULL, &info.surface);
+    res = info.instance_functions.vkCreateXcbSurfaceKHR(info.inst, &createInfo, NULL, &info.surface);
 #endif  // __ANDROID__  && _WIN32
     assert(res == VK_SUCCESS);
 
     // Iterate over each queue to learn whether it supports presenting:
     VkBool32 *pSupportsPresent = (VkBool32 *)malloc(info.queue_family_count * sizeof(VkBool32));
     for (uint32_t i = 0; i < info.queue_family_count; i++) {
-        vkGetPhysicalDeviceSurfaceSupportKHR(info.gpus[0], i, info.surface, &pSupportsPresent[i]);
+        info.instance_functions.vkGetPhysicalDeviceSurfaceSupportKHR(info.gpus[0], i, info.surface, &pSupportsPresent[i]);
     }
 
     // Search for a graphics and a present queue in the array of queue
@@ -789,10 +869,10 @@ void init_swapchain_extension(struct sample_info &info) {
 
     // Get the list of VkFormats that are supported:
     uint32_t formatCount;
-    res = vkGetPhysicalDeviceSurfaceFormatsKHR(info.gpus[0], info.surface, &formatCount, NULL);
+    res = info.instance_functions.vkGetPhysicalDeviceSurfaceFormatsKHR(info.gpus[0], info.surface, &formatCount, NULL);
     assert(res == VK_SUCCESS);
     VkSurfaceFormatKHR *surfFormats = (VkSurfaceFormatKHR *)malloc(formatCount * sizeof(VkSurfaceFormatKHR));
-    res = vkGetPhysicalDeviceSurfaceFormatsKHR(info.gpus[0], info.surface, &formatCount, surfFormats);
+    res = info.instance_functions.vkGetPhysicalDeviceSurfaceFormatsKHR(info.gpus[0], info.surface, &formatCount, surfFormats);
     assert(res == VK_SUCCESS);
 
     // If the device supports our preferred surface format, use it.
@@ -819,20 +899,62 @@ void init_presentable_image(struct sample_info &info) {
     imageAcquiredSemaphoreCreateInfo.pNext = NULL;
     imageAcquiredSemaphoreCreateInfo.flags = 0;
 
-    res = vkCreateSemaphore(info.device, &imageAcquiredSemaphoreCreateInfo, NULL, &info.imageAcquiredSemaphore);
+    res = info.device_dispatch.vkCreateSemaphore(info.device, &imageAcquiredSemaphoreCreateInfo, NULL, &info.imageAcquiredSemaphore);
     assert(!res);
 
     // Get the index of the next available swapchain image:
-    res = vkAcquireNextImageKHR(info.device, info.swap_chain, UINT64_MAX, info.imageAcquiredSemaphore, VK_NULL_HANDLE,
+    res = info.device_dispatch.vkAcquireNextImageKHR(info.device, info.swap_chain, UINT64_MAX, info.imageAcquiredSemaphore, VK_NULL_HANDLE,
                                 &info.current_buffer);
     // TODO: Deal with the VK_SUBOPTIMAL_KHR and VK_ERROR_OUT_OF_DATE_KHR
     // return codes
     assert(!res);
 }
 
+/*
+ * Records the acquire half of every upload flushed so far into
+ * info.upload_acquire_cmd and submits it, waiting on the uploads, ahead of
+ * the caller's submission. Barriers order everything submitted after them
+ * on the queue, so the uploads belong to the graphics family before any
+ * command the caller submits runs, however its command buffer was recorded.
+ */
+static void submit_upload_acquires(struct sample_info &info) {
+    VkResult U_ASSERT_ONLY res;
+
+    if (!info.upload_engine.acquire_pending()) {
+        return;
+    }
+    /* The previous acquire has to be done with the buffer before its pool is reset */
+    do {
+        res = info.graphics_timeline.wait(info.upload_acquire_value, FENCE_TIMEOUT);
+    } while (res == VK_TIMEOUT);
+    assert(res == VK_SUCCESS);
+    res = info.device_dispatch.vkResetCommandPool(info.device, info.upload_acquire_pool, 0);
+    assert(res == VK_SUCCESS);
+
+    VkCommandBufferBeginInfo cmd_buf_info = {};
+    cmd_buf_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    cmd_buf_info.pNext = NULL;
+    cmd_buf_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    cmd_buf_info.pInheritanceInfo = NULL;
+    res = info.device_dispatch.vkBeginCommandBuffer(info.upload_acquire_cmd, &cmd_buf_info);
+    assert(res == VK_SUCCESS);
+    info.upload_wait_semaphores.clear();
+    info.upload_wait_stages.clear();
+    info.upload_engine.acquire(info.upload_acquire_cmd, info.upload_wait_semaphores, info.upload_wait_stages);
+    res = info.device_dispatch.vkEndCommandBuffer(info.upload_acquire_cmd);
+    assert(res == VK_SUCCESS);
+
+    res = info.graphics_timeline.submit(1, &info.upload_acquire_cmd, info.upload_acquire_value,
+                                        static_cast<uint32_t>(info.upload_wait_semaphores.size()),
+                                        info.upload_wait_semaphores.data(), info.upload_wait_stages.data());
+    assert(res == VK_SUCCESS);
+}
+
 void execute_queue_cmdbuf(struct sample_info &info, const VkCommandBuffer *cmd_bufs, VkFence &fence) {
     VkResult U_ASSERT_ONLY res;
 
+    submit_upload_acquires(info);
+
     VkPipelineStageFlags pipe_stage_flags = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
     VkSubmitInfo submit_info[1] = {};
     submit_info[0].pNext = NULL;
@@ -847,7 +969,7 @@ void execute_queue_cmdbuf(struct sample_info &info, const VkCommandBuffer *cmd_b
     submit_info[0].pSignalSemaphores = NULL;
 
     /* Queue the command buffer for execution */
-    res = vkQueueSubmit(info.graphics_queue, 1, submit_info, fence);
+    res = info.device_dispatch.vkQueueSubmit(info.graphics_queue, 1, submit_info, fence);
     assert(!res);
 }
 void execute_pre_present_barrier(struct sample_info &info) {
@@ -869,7 +991,7 @@ void execute_pre_present_barrier(struct sample_info &info) {
     prePresentBarrier.subresourceRange.baseArrayLayer = 0;
     prePresentBarrier.subresourceRange.layerCount = 1;
     prePresentBarrier.image = info.buffers[info.current_buffer].image;
-    vkCmdPipelineBarrier(info.cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, NULL,
+    info.device_dispatch.vkCmdPipelineBarrier(info.cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, NULL,
                          0, NULL, 1, &prePresentBarrier);
 }
 void execute_present_image(struct sample_info &info) {
@@ -887,7 +1009,7 @@ void execute_present_image(struct sample_info &info) {
     present.waitSemaphoreCount = 0;
     present.pResults = NULL;
 
-    res = vkQueuePresentKHR(info.present_queue, &present);
+    res = info.device_dispatch.vkQueuePresentKHR(info.present_queue, &present);
     // TODO: Deal with the VK_SUBOPTIMAL_WSI and VK_ERROR_OUT_OF_DATE_WSI
     // return codes
     assert(!res);
@@ -899,15 +1021,15 @@ void init_swap_chain(struct sample_info &info, VkImageUsageFlags usageFlags) {
     VkResult U_ASSERT_ONLY res;
     VkSurfaceCapabilitiesKHR surfCapabilities;
 
-    res = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(info.gpus[0], info.surface, &surfCapabilities);
+    res = info.instance_functions.vkGetPhysicalDeviceSurfaceCapabilitiesKHR(info.gpus[0], info.surface, &surfCapabilities);
     assert(res == VK_SUCCESS);
 
     uint32_t presentModeCount;
-    res = vkGetPhysicalDeviceSurfacePresentModesKHR(info.gpus[0], info.surface, &presentModeCount, NULL);
+    res = info.instance_functions.vkGetPhysicalDeviceSurfacePresentModesKHR(info.gpus[0], info.surface, &presentModeCount, NULL);
     assert(res == VK_SUCCESS);
     VkPresentModeKHR *presentModes = (VkPresentModeKHR *)malloc(presentModeCount * sizeof(VkPresentModeKHR));
     assert(presentModes);
-    res = vkGetPhysicalDeviceSurfacePresentModesKHR(info.gpus[0], info.surface, &presentModeCount, presentModes);
+    res = info.instance_functions.vkGetPhysicalDeviceSurfacePresentModesKHR(info.gpus[0], info.surface, &presentModeCount, presentModes);
     assert(res == VK_SUCCESS);
 
     VkExtent2D swapchainExtent;
@@ -1000,15 +1122,15 @@ void init_swap_chain(struct sample_info &info, VkImageUsageFlags usageFlags) {
         swapchain_ci.pQueueFamilyIndices = queueFamilyIndices;
     }
 
-    res = vkCreateSwapchainKHR(info.device, &swapchain_ci, NULL, &info.swap_chain);
+    res = info.device_dispatch.vkCreateSwapchainKHR(info.device, &swapchain_ci, NULL, &info.swap_chain);
     assert(res == VK_SUCCESS);
 
-    res = vkGetSwapchainImagesKHR(info.device, info.swap_chain, &info.swapchainImageCount, NULL);
+    res = info.device_dispatch.vkGetSwapchainImagesKHR(info.device, info.swap_chain, &info.swapchainImageCount, NULL);
     assert(res == VK_SUCCESS);
 
     VkImage *swapchainImages = (VkImage *)malloc(info.swapchainImageCount * sizeof(VkImage));
     assert(swapchainImages);
-    res = vkGetSwapchainImagesKHR(info.device, info.swap_chain, &info.swapchainImageCount, swapchainImages);
+    res = info.device_dispatch.vkGetSwapchainImagesKHR(info.device, info.swap_chain, &info.swapchainImageCount, swapchainImages);
     assert(res == VK_SUCCESS);
 
     for (uint32_t i = 0; i < info.swapchainImageCount; i++) {
@@ -1034,7 +1156,7 @@ void init_swap_chain(struct sample_info &info, VkImageUsageFlags usageFlags) {
 
         color_image_view.image = sc_buffer.image;
 
-        res = vkCreateImageView(info.device, &color_image_view, NULL, &sc_buffer.view);
+        res = info.device_dispatch.vkCreateImageView(info.device, &color_image_view, NULL, &sc_buffer.view);
         info.buffers.push_back(sc_buffer);
         assert(res == VK_SUCCESS);
     }
@@ -1047,8 +1169,6 @@ void init_swap_chain(struct sample_info &info, VkImageUsageFlags usageFlags) {
 }
 
 void init_uniform_buffer(struct sample_info &info) {
-    VkResult U_ASSERT_ONLY res;
-    bool U_ASSERT_ONLY pass;
     float fov = glm::radians(45.0f);
     if (info.width > info.height) {
         fov *= static_cast<float>(info.height) / static_cast<float>(info.width);
@@ -1062,59 +1182,50 @@ void init_uniform_buffer(struct sample_info &info) {
     // Vulkan clip space has inverted Y and half Z.
     info.Clip = glm::mat4(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.5f, 0.0f, 0.0f, 0.0f, 0.5f, 1.0f);
 
-    info.MVP = info.Clip * info.Projection * info.View * info.Model;
-
     /* VULKAN_KEY_START */
-    VkBufferCreateInfo buf_info = {};
-    buf_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    buf_info.pNext = NULL;
-    buf_info.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-    buf_info.size = sizeof(info.MVP);
-    buf_info.queueFamilyIndexCount = 0;
-    buf_info.pQueueFamilyIndices = NULL;
-    buf_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    buf_info.flags = 0;
-    res = vkCreateBuffer(info.device, &buf_info, NULL, &info.uniform_data.buf);
-    assert(res == VK_SUCCESS);
-
-    VkMemoryRequirements mem_reqs;
-    vkGetBufferMemoryRequirements(info.device, info.uniform_data.buf, &mem_reqs);
-
-    VkMemoryAllocateInfo alloc_info = {};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.pNext = NULL;
-    alloc_info.memoryTypeIndex = 0;
-
-    alloc_info.allocationSize = mem_reqs.size;
-    pass = memory_type_from_properties(info, mem_reqs.memoryTypeBits,
-                                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                       &alloc_info.memoryTypeIndex);
-    assert(pass && "No mappable, coherent memory");
+    if (!info.frame_ring.valid()) {
+        bool U_ASSERT_ONLY pass = info.frame_ring.init(info.memory_allocator, info.device_dispatch, info.gpu_props.limits,
+                                                       FRAME_RING_FRAME_SIZE, FRAME_RING_FRAME_COUNT);
+        assert(pass && "No mappable memory");
+    }
 
-    res = vkAllocateMemory(info.device, &alloc_info, NULL, &(info.uniform_data.mem));
-    assert(res == VK_SUCCESS);
+    /* The descriptor covers one slice; the dynamic offset picks which one */
+    info.uniform_data.buffer_info.buffer = info.frame_ring.buffer();
+    info.uniform_data.buffer_info.offset = 0;
+    info.uniform_data.buffer_info.range = sizeof(info.MVP);
 
-    uint8_t *pData;
-    res = vkMapMemory(info.device, info.uniform_data.mem, 0, mem_reqs.size, 0, (void **)&pData);
-    assert(res == VK_SUCCESS);
+    update_uniform_buffer(info, 0);
+}
 
-    memcpy(pData, &info.MVP, sizeof(info.MVP));
+void update_uniform_buffer(struct sample_info &info, uint32_t frame_index) {
+    /* DEPENDS on init_uniform_buffer(); the GPU must be done with the frame
+     * FRAME_RING_FRAME_COUNT frames back, which used the same partition */
+    VkResult U_ASSERT_ONLY res;
 
-    vkUnmapMemory(info.device, info.uniform_data.mem);
+    info.MVP = info.Clip * info.Projection * info.View * info.Model;
 
-    res = vkBindBufferMemory(info.device, info.uniform_data.buf, info.uniform_data.mem, 0);
+    info.frame_ring.begin_frame(frame_index);
+    bool U_ASSERT_ONLY pass = info.frame_ring.push_uniform(info.MVP, info.uniform_data.allocation);
+    assert(pass);
+    res = info.frame_ring.flush();
     assert(res == VK_SUCCESS);
+}
 
-    info.uniform_data.buffer_info.buffer = info.uniform_data.buf;
-    info.uniform_data.buffer_info.offset = 0;
-    info.uniform_data.buffer_info.range = sizeof(info.MVP);
+void execute_bind_descriptor_sets(struct sample_info &info) {
+    /* DEPENDS on init_descriptor_set() and update_uniform_buffer() */
+    /* The MVP binding is UNIFORM_BUFFER_DYNAMIC, so every bind names this
+     * frame's slice of the ring */
+    const uint32_t dynamic_offset = info.uniform_data.allocation.dynamic_offset();
+    info.device_dispatch.vkCmdBindDescriptorSets(info.cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, info.pipeline_layout, 0,
+                                                 static_cast<uint32_t>(info.desc_set.size()), info.desc_set.data(), 1,
+                                                 &dynamic_offset);
 }
 
 void init_descriptor_and_pipeline_layouts(struct sample_info &info, bool use_texture,
                                           VkDescriptorSetLayoutCreateFlags descSetLayoutCreateFlags) {
     VkDescriptorSetLayoutBinding layout_bindings[2];
     layout_bindings[0].binding = 0;
-    layout_bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    layout_bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
     layout_bindings[0].descriptorCount = 1;
     layout_bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
     layout_bindings[0].pImmutableSamplers = NULL;
@@ -1139,7 +1250,7 @@ void init_descriptor_and_pipeline_layouts(struct sample_info &info, bool use_tex
     VkResult U_ASSERT_ONLY res;
 
     info.desc_layout.resize(NUM_DESCRIPTOR_SETS);
-    res = vkCreateDescriptorSetLayout(info.device, &descriptor_layout, NULL, info.desc_layout.data());
+    res = info.object_cache.get_descriptor_set_layout(descriptor_layout, info.desc_layout[0]);
     assert(res == VK_SUCCESS);
 
     /* Now use the descriptor layout to create a pipeline layout */
@@ -1151,7 +1262,7 @@ void init_descriptor_and_pipeline_layouts(struct sample_info &info, bool use_tex
     pPipelineLayoutCreateInfo.setLayoutCount = NUM_DESCRIPTOR_SETS;
     pPipelineLayoutCreateInfo.pSetLayouts = info.desc_layout.data();
 
-    res = vkCreatePipelineLayout(info.device, &pPipelineLayoutCreateInfo, NULL, &info.pipeline_layout);
+    res = info.object_cache.get_pipeline_layout(pPipelineLayoutCreateInfo, info.pipeline_layout);
     assert(res == VK_SUCCESS);
 }
 
@@ -1226,7 +1337,7 @@ void init_renderpass(struct sample_info &info, bool include_depth, bool clear, V
     rp_info.dependencyCount = 1;
     rp_info.pDependencies = &subpass_dependency;
 
-    res = vkCreateRenderPass(info.device, &rp_info, NULL, &info.render_pass);
+    res = info.object_cache.get_render_pass(rp_info, info.render_pass);
     assert(res == VK_SUCCESS);
 }
 
@@ -1254,7 +1365,7 @@ void init_framebuffers(struct sample_info &info, bool include_depth) {
 
     for (i = 0; i < info.swapchainImageCount; i++) {
         attachments[0] = info.buffers[i].view;
-        res = vkCreateFramebuffer(info.device, &fb_info, NULL, &info.framebuffers[i]);
+        res = info.device_dispatch.vkCreateFramebuffer(info.device, &fb_info, NULL, &info.framebuffers[i]);
         assert(res == VK_SUCCESS);
     }
 }
@@ -1266,9 +1377,13 @@ void init_command_pool(struct sample_info &info) {
     cmd_pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     cmd_pool_info.pNext = NULL;
     cmd_pool_info.queueFamilyIndex = info.graphics_queue_family_index;
-    cmd_pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    /* info.cmd is re-recorded by resetting the whole pool, see
+       reset_command_pool(), so no per-buffer reset is needed */
+    cmd_pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
 
-    res = vkCreateCommandPool(info.device, &cmd_pool_info, NULL, &info.cmd_pool);
+    res = info.device_dispatch.vkCreateCommandPool(info.device, &cmd_pool_info, NULL, &info.cmd_pool);
+    assert(res == VK_SUCCESS);
+    res = info.device_dispatch.vkCreateCommandPool(info.device, &cmd_pool_info, NULL, &info.upload_acquire_pool);
     assert(res == VK_SUCCESS);
 }
 
@@ -1283,121 +1398,119 @@ void init_command_buffer(struct sample_info &info) {
     cmd.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
     cmd.commandBufferCount = 1;
 
-    res = vkAllocateCommandBuffers(info.device, &cmd, &info.cmd);
+    res = info.device_dispatch.vkAllocateCommandBuffers(info.device, &cmd, &info.cmd);
+    assert(res == VK_SUCCESS);
+
+    cmd.commandPool = info.upload_acquire_pool;
+    res = info.device_dispatch.vkAllocateCommandBuffers(info.device, &cmd, &info.upload_acquire_cmd);
+    assert(res == VK_SUCCESS);
+}
+
+void reset_command_pool(struct sample_info &info) {
+    /* info.cmd is the pool's only buffer, so this resets it in one call
+       without the driver tracking buffers individually. The caller must have
+       waited for info.cmd's last submission. */
+    VkResult U_ASSERT_ONLY res = info.device_dispatch.vkResetCommandPool(info.device, info.cmd_pool, 0);
     assert(res == VK_SUCCESS);
 }
+
 void execute_begin_command_buffer(struct sample_info &info) {
     /* DEPENDS on init_command_buffer() */
     VkResult U_ASSERT_ONLY res;
 
+    reset_command_pool(info);
+
     VkCommandBufferBeginInfo cmd_buf_info = {};
     cmd_buf_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     cmd_buf_info.pNext = NULL;
     cmd_buf_info.flags = 0;
     cmd_buf_info.pInheritanceInfo = NULL;
 
-    res = vkBeginCommandBuffer(info.cmd, &cmd_buf_info);
+    res = info.device_dispatch.vkBeginCommandBuffer(info.cmd, &cmd_buf_info);
     assert(res == VK_SUCCESS);
 }
 
 void execute_end_command_buffer(struct sample_info &info) {
     VkResult U_ASSERT_ONLY res;
 
-    res = vkEndCommandBuffer(info.cmd);
+    res = info.device_dispatch.vkEndCommandBuffer(info.cmd);
     assert(res == VK_SUCCESS);
 }
 
 void execute_queue_command_buffer(struct sample_info &info) {
     VkResult U_ASSERT_ONLY res;
 
+    submit_upload_acquires(info);
+
     /* Queue the command buffer for execution */
     const VkCommandBuffer cmd_bufs[] = {info.cmd};
-    VkFenceCreateInfo fenceInfo;
-    VkFence drawFence;
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.pNext = NULL;
-    fenceInfo.flags = 0;
-    vkCreateFence(info.device, &fenceInfo, NULL, &drawFence);
-
-    VkPipelineStageFlags pipe_stage_flags = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    VkSubmitInfo submit_info[1] = {};
-    submit_info[0].pNext = NULL;
-    submit_info[0].sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submit_info[0].waitSemaphoreCount = 0;
-    submit_info[0].pWaitSemaphores = NULL;
-    submit_info[0].pWaitDstStageMask = &pipe_stage_flags;
-    submit_info[0].commandBufferCount = 1;
-    submit_info[0].pCommandBuffers = cmd_bufs;
-    submit_info[0].signalSemaphoreCount = 0;
-    submit_info[0].pSignalSemaphores = NULL;
-
-    res = vkQueueSubmit(info.graphics_queue, 1, submit_info, drawFence);
+    uint64_t submitted_value;
+    res = info.graphics_timeline.submit(1, cmd_bufs, submitted_value);
     assert(res == VK_SUCCESS);
 
     do {
-        res = vkWaitForFences(info.device, 1, &drawFence, VK_TRUE, FENCE_TIMEOUT);
+        res = info.graphics_timeline.wait(submitted_value, FENCE_TIMEOUT);
     } while (res == VK_TIMEOUT);
     assert(res == VK_SUCCESS);
 
-    vkDestroyFence(info.device, drawFence, NULL);
+    /* Anything retired by earlier submissions can go now */
+    info.deletion_queue.collect();
+    info.upload_engine.collect();
 }
 
 void init_device_queue(struct sample_info &info) {
     /* DEPENDS on init_swapchain_extension() */
 
-    vkGetDeviceQueue(info.device, info.graphics_queue_family_index, 0, &info.graphics_queue);
+    info.device_dispatch.vkGetDeviceQueue(info.device, info.graphics_queue_family_index, 0, &info.graphics_queue);
     if (info.graphics_queue_family_index == info.present_queue_family_index) {
         info.present_queue = info.graphics_queue;
     } else {
-        vkGetDeviceQueue(info.device, info.present_queue_family_index, 0, &info.present_queue);
+        info.device_dispatch.vkGetDeviceQueue(info.device, info.present_queue_family_index, 0, &info.present_queue);
     }
+    bool U_ASSERT_ONLY pass = info.graphics_timeline.init(info.device_dispatch, info.graphics_queue, info.timeline_semaphore_enabled);
+    assert(pass);
+    pass = info.deletion_queue.init(info.device_dispatch, info.graphics_timeline, &info.memory_allocator);
+    assert(pass);
+
+    /* Same queue as graphics_queue when there is no transfer-only family */
+    info.device_dispatch.vkGetDeviceQueue(info.device, info.transfer_queue_family_index, 0, &info.transfer_queue);
+    pass = info.upload_engine.init(info.device_dispatch, info.memory_allocator, info.transfer_queue,
+                                   info.transfer_queue_family_index, info.graphics_timeline,
+                                   info.graphics_queue_family_index, info.timeline_semaphore_enabled,
+                                   info.synchronization2_enabled);
+    assert(pass);
 }
 
 void init_vertex_buffer(struct sample_info &info, const void *vertexData, uint32_t dataSize, uint32_t dataStride,
                         bool use_texture) {
+    /* DEPENDS on init_device_queue() */
     VkResult U_ASSERT_ONLY res;
-    bool U_ASSERT_ONLY pass;
 
     VkBufferCreateInfo buf_info = {};
     buf_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     buf_info.pNext = NULL;
-    buf_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    buf_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
     buf_info.size = dataSize;
     buf_info.queueFamilyIndexCount = 0;
     buf_info.pQueueFamilyIndices = NULL;
     buf_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     buf_info.flags = 0;
-    res = vkCreateBuffer(info.device, &buf_info, NULL, &info.vertex_buffer.buf);
+    res = info.device_dispatch.vkCreateBuffer(info.device, &buf_info, NULL, &info.vertex_buffer.buf);
     assert(res == VK_SUCCESS);
 
-    VkMemoryRequirements mem_reqs;
-    vkGetBufferMemoryRequirements(info.device, info.vertex_buffer.buf, &mem_reqs);
-
-    VkMemoryAllocateInfo alloc_info = {};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.pNext = NULL;
-    alloc_info.memoryTypeIndex = 0;
-
-    alloc_info.allocationSize = mem_reqs.size;
-    pass = memory_type_from_properties(info, mem_reqs.memoryTypeBits,
-                                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                       &alloc_info.memoryTypeIndex);
-    assert(pass && "No mappable, coherent memory");
-
-    res = vkAllocateMemory(info.device, &alloc_info, NULL, &(info.vertex_buffer.mem));
+    res = info.memory_allocator.allocate_for_buffer(info.vertex_buffer.buf, MemoryUsage::GpuOnly, 0, info.vertex_buffer.allocation);
     assert(res == VK_SUCCESS);
-    info.vertex_buffer.buffer_info.range = mem_reqs.size;
+    info.vertex_buffer.buffer_info.range = info.vertex_buffer.allocation.size;
     info.vertex_buffer.buffer_info.offset = 0;
 
-    uint8_t *pData;
-    res = vkMapMemory(info.device, info.vertex_buffer.mem, 0, mem_reqs.size, 0, (void **)&pData);
-    assert(res == VK_SUCCESS);
-
-    memcpy(pData, vertexData, dataSize);
-
-    vkUnmapMemory(info.device, info.vertex_buffer.mem);
-
-    res = vkBindBufferMemory(info.device, info.vertex_buffer.buf, info.vertex_buffer.mem, 0);
+    /* Copied on the transfer queue; acquired, after waiting for the copy,
+     * right before the next submission of info.cmd */
+    bool U_ASSERT_ONLY pass = info.upload_engine.upload_buffer(info.vertex_buffer.buf, 0, vertexData, dataSize,
+                                                               VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT,
+                                                               VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT);
+    assert(pass);
+    uint64_t upload_value;
+    res = info.upload_engine.flush(upload_value);
     assert(res == VK_SUCCESS);
 
     info.vi_binding.binding = 0;
@@ -1418,24 +1531,17 @@ void init_descriptor_pool(struct sample_info &info, bool use_texture) {
     /* DEPENDS on init_uniform_buffer() and
      * init_descriptor_and_pipeline_layouts() */
 
-    VkResult U_ASSERT_ONLY res;
-    VkDescriptorPoolSize type_count[2];
-    type_count[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    type_count[0].descriptorCount = 1;
+    bool U_ASSERT_ONLY initialized;
+    std::vector<DescriptorPoolRatio> ratios;
+    ratios.push_back({VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f});
     if (use_texture) {
-        type_count[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        type_count[1].descriptorCount = 1;
+        ratios.push_back({VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f});
     }
 
-    VkDescriptorPoolCreateInfo descriptor_pool = {};
-    descriptor_pool.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    descriptor_pool.pNext = NULL;
-    descriptor_pool.maxSets = 1;
-    descriptor_pool.poolSizeCount = use_texture ? 2 : 1;
-    descriptor_pool.pPoolSizes = type_count;
-
-    res = vkCreateDescriptorPool(info.device, &descriptor_pool, NULL, &info.desc_pool);
-    assert(res == VK_SUCCESS);
+    /* Pools start with room for the sample's own sets and grow when more are
+     * allocated */
+    initialized = info.descriptor_allocator.init(info.device_dispatch, ratios, NUM_DESCRIPTOR_SETS);
+    assert(initialized);
 }
 
 void init_descriptor_set(struct sample_info &info, bool use_texture) {
@@ -1443,41 +1549,30 @@ void init_descriptor_set(struct sample_info &info, bool use_texture) {
 
     VkResult U_ASSERT_ONLY res;
 
-    VkDescriptorSetAllocateInfo alloc_info[1];
-    alloc_info[0].sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    alloc_info[0].pNext = NULL;
-    alloc_info[0].descriptorPool = info.desc_pool;
-    alloc_info[0].descriptorSetCount = NUM_DESCRIPTOR_SETS;
-    alloc_info[0].pSetLayouts = info.desc_layout.data();
-
     info.desc_set.resize(NUM_DESCRIPTOR_SETS);
-    res = vkAllocateDescriptorSets(info.device, alloc_info, info.desc_set.data());
-    assert(res == VK_SUCCESS);
-
-    VkWriteDescriptorSet writes[2];
-
-    writes[0] = {};
-    writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    writes[0].pNext = NULL;
-    writes[0].dstSet = info.desc_set[0];
-    writes[0].descriptorCount = 1;
-    writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    writes[0].pBufferInfo = &info.uniform_data.buffer_info;
-    writes[0].dstArrayElement = 0;
-    writes[0].dstBinding = 0;
+    for (int i = 0; i < NUM_DESCRIPTOR_SETS; i++) {
+        res = info.descriptor_allocator.allocate(info.desc_layout[i], info.desc_set[i]);
+        assert(res == VK_SUCCESS);
+    }
 
+    /* The set's descriptors in one block, as the update template reads them */
+    struct SetDescriptors {
+        VkDescriptorBufferInfo uniform;
+        VkDescriptorImageInfo texture;
+    } descriptors = {info.uniform_data.buffer_info, info.texture_data.image_info};
+    std::vector<VkDescriptorUpdateTemplateEntry> entries = {
+        {0, 0, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, offsetof(SetDescriptors, uniform), 0}};
     if (use_texture) {
-        writes[1] = {};
-        writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        writes[1].dstSet = info.desc_set[0];
-        writes[1].dstBinding = 1;
-        writes[1].descriptorCount = 1;
-        writes[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        writes[1].pImageInfo = &info.texture_data.image_info;
-        writes[1].dstArrayElement = 0;
+        entries.push_back({1, 0, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, offsetof(SetDescriptors, texture), 0});
     }
 
-    vkUpdateDescriptorSets(info.device, use_texture ? 2 : 1, writes, 0, NULL);
+    /* Only the first call for this layout creates the template; later ones
+     * get the same one back */
+    DescriptorTemplate descriptor_template;
+    res = info.descriptor_writer.create_template(info.desc_layout[0], entries, descriptor_template);
+    assert(res == VK_SUCCESS);
+    info.descriptor_writer.write(descriptor_template, info.desc_set[0], &descriptors);
+    info.descriptor_writer.flush();
 }
 
 void init_shaders(struct sample_info &info, const VkShaderModuleCreateInfo *vertShaderCI,
@@ -1491,7 +1586,7 @@ void init_shaders(struct sample_info &info, const VkShaderModuleCreateInfo *vert
         info.shaderStages[0].flags = 0;
         info.shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
         info.shaderStages[0].pName = "main";
-        res = vkCreateShaderModule(info.device, vertShaderCI, NULL, &info.shaderStages[0].module);
+        res = info.object_cache.get_shader_module(*vertShaderCI, info.shaderStages[0].module);
         assert(res == VK_SUCCESS);
     }
 
@@ -1503,54 +1598,45 @@ void init_shaders(struct sample_info &info, const VkShaderModuleCreateInfo *vert
         info.shaderStages[1].flags = 0;
         info.shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
         info.shaderStages[1].pName = "main";
-        res = vkCreateShaderModule(info.device, fragShaderCI, NULL, &info.shaderStages[1].module);
+        res = info.object_cache.get_shader_module(*fragShaderCI, info.shaderStages[1].module);
         assert(res == VK_SUCCESS);
     }
 }
 
 void init_pipeline_cache(struct sample_info &info) {
-    VkResult U_ASSERT_ONLY res;
+    /* Start warm from the cache the last run saved, if this device and driver wrote it */
+    bool U_ASSERT_ONLY pass =
+        info.pipeline_cache.init(info.device_dispatch, info.gpu_props, get_file_directory() + "pipeline_cache.bin");
+    assert(pass);
+    info.pipelineCache = info.pipeline_cache.handle();
 
-    VkPipelineCacheCreateInfo pipelineCache;
-    pipelineCache.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-    pipelineCache.pNext = NULL;
-    pipelineCache.initialDataSize = 0;
-    pipelineCache.pInitialData = NULL;
-    pipelineCache.flags = 0;
-    res = vkCreatePipelineCache(info.device, &pipelineCache, NULL, &info.pipelineCache);
-    assert(res == VK_SUCCESS);
+    if (info.pipeline_cache.loaded()) {
+        std::cout << "Loaded " << info.pipeline_cache.loaded_bytes() << " bytes of pipeline cache" << std::endl;
+    } else {
+        std::cout << "Starting with an empty pipeline cache (" << info.pipeline_cache.rejection()
+                  << "), pipelineCacheUUID " << std::hex << std::setfill('0');
+        print_UUID(info.gpu_props.pipelineCacheUUID);
+        std::cout << std::dec << std::setfill(' ') << std::endl;
+    }
 }
 
-void init_pipeline(struct sample_info &info, VkBool32 include_depth, VkBool32 include_vi) {
-    VkResult U_ASSERT_ONLY res;
-
-    VkDynamicState dynamicStateEnables[2];  // Viewport + Scissor
-    VkPipelineDynamicStateCreateInfo dynamicState = {};
-    memset(dynamicStateEnables, 0, sizeof dynamicStateEnables);
-    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    dynamicState.pNext = NULL;
-    dynamicState.pDynamicStates = dynamicStateEnables;
-    dynamicState.dynamicStateCount = 0;
-
-    VkPipelineVertexInputStateCreateInfo vi;
-    memset(&vi, 0, sizeof(vi));
-    vi.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+void init_pipeline_description(struct sample_info &info, VkBool32 include_depth, VkBool32 include_vi,
+                               GraphicsPipelineDescription &description) {
+    description = GraphicsPipelineDescription{};
+    description.stages.assign(info.shaderStages, info.shaderStages + 2);
     if (include_vi) {
-        vi.pNext = NULL;
-        vi.flags = 0;
-        vi.vertexBindingDescriptionCount = 1;
-        vi.pVertexBindingDescriptions = &info.vi_binding;
-        vi.vertexAttributeDescriptionCount = 2;
-        vi.pVertexAttributeDescriptions = info.vi_attribs;
+        description.vertex_bindings.push_back(info.vi_binding);
+        description.vertex_attributes.assign(info.vi_attribs, info.vi_attribs + 2);
     }
-    VkPipelineInputAssemblyStateCreateInfo ia;
+
+    VkPipelineInputAssemblyStateCreateInfo &ia = description.input_assembly;
     ia.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
     ia.pNext = NULL;
     ia.flags = 0;
     ia.primitiveRestartEnable = VK_FALSE;
     ia.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 
-    VkPipelineRasterizationStateCreateInfo rs;
+    VkPipelineRasterizationStateCreateInfo &rs = description.rasterization;
     rs.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
     rs.pNext = NULL;
     rs.flags = 0;
@@ -1565,21 +1651,20 @@ void init_pipeline(struct sample_info &info, VkBool32 include_depth, VkBool32 in
     rs.depthBiasSlopeFactor = 0;
     rs.lineWidth = 1.0f;
 
-    VkPipelineColorBlendStateCreateInfo cb;
+    VkPipelineColorBlendStateCreateInfo &cb = description.color_blend;
     cb.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
     cb.flags = 0;
     cb.pNext = NULL;
-    VkPipelineColorBlendAttachmentState att_state[1];
-    att_state[0].colorWriteMask = 0xf;
-    att_state[0].blendEnable = VK_FALSE;
-    att_state[0].alphaBlendOp = VK_BLEND_OP_ADD;
-    att_state[0].colorBlendOp = VK_BLEND_OP_ADD;
-    att_state[0].srcColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-    att_state[0].dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-    att_state[0].srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    att_state[0].dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    cb.attachmentCount = 1;
-    cb.pAttachments = att_state;
+    VkPipelineColorBlendAttachmentState att_state;
+    att_state.colorWriteMask = 0xf;
+    att_state.blendEnable = VK_FALSE;
+    att_state.alphaBlendOp = VK_BLEND_OP_ADD;
+    att_state.colorBlendOp = VK_BLEND_OP_ADD;
+    att_state.srcColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+    att_state.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+    att_state.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    att_state.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    description.blend_attachments.push_back(att_state);
     cb.logicOpEnable = VK_FALSE;
     cb.logicOp = VK_LOGIC_OP_NO_OP;
     cb.blendConstants[0] = 1.0f;
@@ -1587,17 +1672,11 @@ void init_pipeline(struct sample_info &info, VkBool32 include_depth, VkBool32 in
     cb.blendConstants[2] = 1.0f;
     cb.blendConstants[3] = 1.0f;
 
-    VkPipelineViewportStateCreateInfo vp = {};
-    vp.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    vp.pNext = NULL;
-    vp.flags = 0;
+    description.viewport_count = NUM_VIEWPORTS;
+    description.scissor_count = NUM_SCISSORS;
 #ifndef __ANDROID__
-    vp.viewportCount = NUM_VIEWPORTS;
-    dynamicStateEnables[dynamicState.dynamicStateCount++] = VK_DYNAMIC_STATE_VIEWPORT;
-    vp.scissorCount = NUM_SCISSORS;
-    dynamicStateEnables[dynamicState.dynamicStateCount++] = VK_DYNAMIC_STATE_SCISSOR;
-    vp.pScissors = NULL;
-    vp.pViewports = NULL;
+    description.dynamic_states.push_back(VK_DYNAMIC_STATE_VIEWPORT);
+    description.dynamic_states.push_back(VK_DYNAMIC_STATE_SCISSOR);
 #else
     // Temporary disabling dynamic viewport on Android because some of drivers doesn't
     // support the feature.
@@ -1613,12 +1692,10 @@ void init_pipeline(struct sample_info &info, VkBool32 include_depth, VkBool32 in
     scissor.extent.height = info.height;
     scissor.offset.x = 0;
     scissor.offset.y = 0;
-    vp.viewportCount = NUM_VIEWPORTS;
-    vp.scissorCount = NUM_SCISSORS;
-    vp.pScissors = &scissor;
-    vp.pViewports = &viewports;
+    description.viewports.push_back(viewports);
+    description.scissors.push_back(scissor);
 #endif
-    VkPipelineDepthStencilStateCreateInfo ds;
+    VkPipelineDepthStencilStateCreateInfo &ds = description.depth_stencil;
     ds.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
     ds.pNext = NULL;
     ds.flags = 0;
@@ -1639,7 +1716,7 @@ void init_pipeline(struct sample_info &info, VkBool32 include_depth, VkBool32 in
     ds.stencilTestEnable = VK_FALSE;
     ds.front = ds.back;
 
-    VkPipelineMultisampleStateCreateInfo ms;
+    VkPipelineMultisampleStateCreateInfo &ms = description.multisample;
     ms.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
     ms.pNext = NULL;
     ms.flags = 0;
@@ -1650,29 +1727,30 @@ void init_pipeline(struct sample_info &info, VkBool32 include_depth, VkBool32 in
     ms.alphaToOneEnable = VK_FALSE;
     ms.minSampleShading = 0.0;
 
-    VkGraphicsPipelineCreateInfo pipeline;
-    pipeline.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipeline.pNext = NULL;
-    pipeline.layout = info.pipeline_layout;
-    pipeline.basePipelineHandle = VK_NULL_HANDLE;
-    pipeline.basePipelineIndex = 0;
-    pipeline.flags = 0;
-    pipeline.pVertexInputState = &vi;
-    pipeline.pInputAssemblyState = &ia;
-    pipeline.pRasterizationState = &rs;
-    pipeline.pColorBlendState = &cb;
-    pipeline.pTessellationState = NULL;
-    pipeline.pMultisampleState = &ms;
-    pipeline.pDynamicState = &dynamicState;
-    pipeline.pViewportState = &vp;
-    pipeline.pDepthStencilState = &ds;
-    pipeline.pStages = info.shaderStages;
-    pipeline.stageCount = 2;
-    pipeline.renderPass = info.render_pass;
-    pipeline.subpass = 0;
-
-    res = vkCreateGraphicsPipelines(info.device, info.pipelineCache, 1, &pipeline, NULL, &info.pipeline);
+    description.flags = 0;
+    description.layout = info.pipeline_layout;
+    description.render_pass = info.render_pass;
+    description.subpass = 0;
+}
+
+void init_pipeline(struct sample_info &info, VkBool32 include_depth, VkBool32 include_vi) {
+    VkResult U_ASSERT_ONLY res;
+
+    GraphicsPipelineDescription description;
+    init_pipeline_description(info, include_depth, include_vi, description);
+
+    uint64_t compiled = info.object_cache.statistics().pipelines.misses;
+    auto start = std::chrono::steady_clock::now();
+    res = info.object_cache.get_graphics_pipeline(info.pipelineCache, description, info.pipeline);
     assert(res == VK_SUCCESS);
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    /* An object cache hit never reaches vkCreateGraphicsPipelines, so only a
+     * miss says anything about the on-disk pipeline cache */
+    if (info.object_cache.statistics().pipelines.misses != compiled) {
+        std::cout << "Pipeline creation (" << (info.pipeline_cache.loaded() ? "warm" : "cold")
+                  << " pipeline cache): " << elapsed_ms << " ms" << std::endl;
+    }
 }
 
 void init_sampler(struct sample_info &info, VkSampler &sampler) {
@@ -1695,13 +1773,12 @@ void init_sampler(struct sample_info &info, VkSampler &sampler) {
     samplerCreateInfo.compareEnable = VK_FALSE;
     samplerCreateInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
 
-    /* create sampler */
-    res = vkCreateSampler(info.device, &samplerCreateInfo, NULL, &sampler);
+    /* Textures with the same filtering share one sampler, owned by the cache */
+    res = info.object_cache.get_sampler(samplerCreateInfo, sampler);
     assert(res == VK_SUCCESS);
 }
 void init_buffer(struct sample_info &info, texture_object &texObj) {
     VkResult U_ASSERT_ONLY res;
-    bool U_ASSERT_ONLY pass;
 
     VkBufferCreateInfo buffer_create_info = {};
     buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -1712,37 +1789,19 @@ void init_buffer(struct sample_info &info, texture_object &texObj) {
     buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     buffer_create_info.queueFamilyIndexCount = 0;
     buffer_create_info.pQueueFamilyIndices = NULL;
-    res = vkCreateBuffer(info.device, &buffer_create_info, NULL, &texObj.buffer);
+    res = info.device_dispatch.vkCreateBuffer(info.device, &buffer_create_info, NULL, &texObj.buffer);
     assert(res == VK_SUCCESS);
 
-    VkMemoryAllocateInfo mem_alloc = {};
-    mem_alloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    mem_alloc.pNext = NULL;
-    mem_alloc.allocationSize = 0;
-    mem_alloc.memoryTypeIndex = 0;
-
-    VkMemoryRequirements mem_reqs;
-    vkGetBufferMemoryRequirements(info.device, texObj.buffer, &mem_reqs);
-    mem_alloc.allocationSize = mem_reqs.size;
-    texObj.buffer_size = mem_reqs.size;
-
+    /* allocate and bind memory */
     VkFlags requirements = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-    pass = memory_type_from_properties(info, mem_reqs.memoryTypeBits, requirements, &mem_alloc.memoryTypeIndex);
-    assert(pass && "No mappable, coherent memory");
-
-    /* allocate memory */
-    res = vkAllocateMemory(info.device, &mem_alloc, NULL, &(texObj.buffer_memory));
-    assert(res == VK_SUCCESS);
-
-    /* bind memory */
-    res = vkBindBufferMemory(info.device, texObj.buffer, texObj.buffer_memory, 0);
-    assert(res == VK_SUCCESS);
+    res = info.memory_allocator.allocate_for_buffer(texObj.buffer, MemoryUsage::Upload, requirements, texObj.buffer_allocation);
+    assert(res == VK_SUCCESS && "No mappable, coherent memory");
+    texObj.buffer_size = texObj.buffer_allocation.size;
 }
 
 void init_image(struct sample_info &info, texture_object &texObj, const char *textureName, VkImageUsageFlags extraUsages,
                 VkFormatFeatureFlags extraFeatures) {
     VkResult U_ASSERT_ONLY res;
-    bool U_ASSERT_ONLY pass;
     std::string filename = get_base_data_dir();
 
     if (textureName == nullptr)
@@ -1750,34 +1809,38 @@ void init_image(struct sample_info &info, texture_object &texObj, const char *te
     else
         filename.append(textureName);
 
-    if (!read_ppm(filename.c_str(), texObj.tex_width, texObj.tex_height, 0, NULL)) {
+    /* The file stays mapped until the pixels have been expanded into
+     * staging or image memory */
+    PpmImage ppm;
+    if (!ppm.open(filename.c_str())) {
         std::cout << "Try relative path\n";
         filename = "../../API-Samples/data/";
         if (textureName == nullptr)
             filename.append("lunarg.ppm");
         else
             filename.append(textureName);
-        if (!read_ppm(filename.c_str(), texObj.tex_width, texObj.tex_height, 0, NULL)) {
+        if (!ppm.open(filename.c_str())) {
             std::cout << "Could not read texture file " << filename;
             exit(-1);
         }
     }
+    texObj.tex_width = static_cast<int>(ppm.width());
+    texObj.tex_height = static_cast<int>(ppm.height());
 
     VkFormatProperties formatProps;
-    vkGetPhysicalDeviceFormatProperties(info.gpus[0], VK_FORMAT_R8G8B8A8_UNORM, &formatProps);
+    info.instance_functions.vkGetPhysicalDeviceFormatProperties(info.gpus[0], VK_FORMAT_R8G8B8A8_UNORM, &formatProps);
 
     /* See if we can use a linear tiled image for a texture, if not, we will
      * need a staging buffer for the texture data */
     VkFormatFeatureFlags allFeatures = (VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | extraFeatures);
     texObj.needs_staging = ((formatProps.linearTilingFeatures & allFeatures) != allFeatures);
 
+    /* Staging memory belongs to the upload engine */
+    texObj.buffer = VK_NULL_HANDLE;
+    texObj.buffer_allocation = MemoryAllocation{};
     if (texObj.needs_staging) {
         assert((formatProps.optimalTilingFeatures & allFeatures) == allFeatures);
-        init_buffer(info, texObj);
         extraUsages |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-    } else {
-        texObj.buffer = VK_NULL_HANDLE;
-        texObj.buffer_memory = VK_NULL_HANDLE;
     }
 
     VkImageCreateInfo image_create_info = {};
@@ -1799,138 +1862,87 @@ void init_image(struct sample_info &info, texture_object &texObj, const char *te
     image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     image_create_info.flags = 0;
 
-    VkMemoryAllocateInfo mem_alloc = {};
-    mem_alloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    mem_alloc.pNext = NULL;
-    mem_alloc.allocationSize = 0;
-    mem_alloc.memoryTypeIndex = 0;
-
-    VkMemoryRequirements mem_reqs;
-
-    res = vkCreateImage(info.device, &image_create_info, NULL, &texObj.image);
+    res = info.device_dispatch.vkCreateImage(info.device, &image_create_info, NULL, &texObj.image);
     assert(res == VK_SUCCESS);
 
-    vkGetImageMemoryRequirements(info.device, texObj.image, &mem_reqs);
-
-    mem_alloc.allocationSize = mem_reqs.size;
-
+    /* allocate and bind memory */
     VkFlags requirements = texObj.needs_staging ? 0 : (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    pass = memory_type_from_properties(info, mem_reqs.memoryTypeBits, requirements, &mem_alloc.memoryTypeIndex);
-    assert(pass);
-
-    /* allocate memory */
-    res = vkAllocateMemory(info.device, &mem_alloc, NULL, &(texObj.image_memory));
+    MemoryUsage usage = texObj.needs_staging ? MemoryUsage::GpuOnly : MemoryUsage::Dynamic;
+    res = info.memory_allocator.allocate_for_image(texObj.image, image_create_info.tiling, usage, requirements,
+                                                   texObj.image_allocation);
     assert(res == VK_SUCCESS);
 
-    /* bind memory */
-    res = vkBindImageMemory(info.device, texObj.image, texObj.image_memory, 0);
-    assert(res == VK_SUCCESS);
-
-    res = vkEndCommandBuffer(info.cmd);
-    assert(res == VK_SUCCESS);
-    const VkCommandBuffer cmd_bufs[] = {info.cmd};
-    VkFenceCreateInfo fenceInfo;
-    VkFence cmdFence;
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.pNext = NULL;
-    fenceInfo.flags = 0;
-    vkCreateFence(info.device, &fenceInfo, NULL, &cmdFence);
+    texObj.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    if (texObj.needs_staging) {
+        /* Copy on the transfer queue without waiting for it; the image is
+         * acquired right before the next submission of info.cmd. Rows
+         * are expanded from the mapped file straight into staging memory */
+        VkExtent3D extent = {ppm.width(), ppm.height(), 1};
+        VkDeviceSize row_size = ppm.rgba_row_size();
+        bool U_ASSERT_ONLY pass = info.upload_engine.upload_image(
+            texObj.image, VK_IMAGE_ASPECT_COLOR_BIT, extent, 1, row_size,
+            [&](uint32_t, uint32_t first_row, uint32_t row_count, void *destination) {
+                ppm.read_rgba_rows(first_row, row_count, destination, row_size);
+            },
+            texObj.imageLayout, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT);
+        assert(pass);
+        uint64_t upload_value;
+        res = info.upload_engine.flush(upload_value);
+        assert(res == VK_SUCCESS);
 
-    VkSubmitInfo submit_info[1] = {};
-    submit_info[0].pNext = NULL;
-    submit_info[0].sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submit_info[0].waitSemaphoreCount = 0;
-    submit_info[0].pWaitSemaphores = NULL;
-    submit_info[0].pWaitDstStageMask = NULL;
-    submit_info[0].commandBufferCount = 1;
-    submit_info[0].pCommandBuffers = cmd_bufs;
-    submit_info[0].signalSemaphoreCount = 0;
-    submit_info[0].pSignalSemaphores = NULL;
+        /* The acquire left it readable by fragment shaders */
+        ResourceState acquired_state;
+        acquired_state.write_stages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+        acquired_state.visible_stages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+        acquired_state.visible_access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+        acquired_state.layout = texObj.imageLayout;
+        info.state_tracker.track_image(texObj.image, VK_IMAGE_ASPECT_COLOR_BIT, 1, 1, acquired_state);
+    } else {
+        res = info.device_dispatch.vkEndCommandBuffer(info.cmd);
+        assert(res == VK_SUCCESS);
 
-    /* Queue the command buffer for execution */
-    res = vkQueueSubmit(info.graphics_queue, 1, submit_info, cmdFence);
-    assert(res == VK_SUCCESS);
+        submit_upload_acquires(info);
 
-    VkImageSubresource subres = {};
-    subres.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    subres.mipLevel = 0;
-    subres.arrayLayer = 0;
+        /* Queue the command buffer for execution */
+        const VkCommandBuffer cmd_bufs[] = {info.cmd};
+        uint64_t submitted_value;
+        res = info.graphics_timeline.submit(1, cmd_bufs, submitted_value);
+        assert(res == VK_SUCCESS);
 
-    VkSubresourceLayout layout = {};
-    void *data;
-    if (!texObj.needs_staging) {
         /* Get the subresource layout so we know what the row pitch is */
-        vkGetImageSubresourceLayout(info.device, texObj.image, &subres, &layout);
-    }
-
-    /* Make sure command buffer is finished before mapping */
-    do {
-        res = vkWaitForFences(info.device, 1, &cmdFence, VK_TRUE, FENCE_TIMEOUT);
-    } while (res == VK_TIMEOUT);
-    assert(res == VK_SUCCESS);
-
-    vkDestroyFence(info.device, cmdFence, NULL);
-
-    if (texObj.needs_staging) {
-        res = vkMapMemory(info.device, texObj.buffer_memory, 0, texObj.buffer_size, 0, &data);
-    } else {
-        res = vkMapMemory(info.device, texObj.image_memory, 0, mem_reqs.size, 0, &data);
-    }
-    assert(res == VK_SUCCESS);
+        VkImageSubresource subres = {};
+        subres.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        subres.mipLevel = 0;
+        subres.arrayLayer = 0;
+        VkSubresourceLayout layout = {};
+        info.device_dispatch.vkGetImageSubresourceLayout(info.device, texObj.image, &subres, &layout);
+
+        /* Make sure command buffer is finished before mapping */
+        do {
+            res = info.graphics_timeline.wait(submitted_value, FENCE_TIMEOUT);
+        } while (res == VK_TIMEOUT);
+        assert(res == VK_SUCCESS);
 
-    /* Read the ppm file into the mappable image's memory */
-    if (!read_ppm(filename.c_str(), texObj.tex_width, texObj.tex_height,
-                  texObj.needs_staging ? (texObj.tex_width * 4) : layout.rowPitch, (unsigned char *)data)) {
-        std::cout << "Could not load texture file lunarg.ppm\n";
-        exit(-1);
-    }
+        /* Host-visible allocations stay mapped for their whole lifetime */
+        assert(texObj.image_allocation.mapped != nullptr);
+        void *data = static_cast<char *>(texObj.image_allocation.mapped) + layout.offset;
 
-    vkUnmapMemory(info.device, texObj.needs_staging ? texObj.buffer_memory : texObj.image_memory);
+        /* Expand the ppm file into the mappable image's memory */
+        ppm.read_rgba(data, layout.rowPitch);
 
-    VkCommandBufferBeginInfo cmd_buf_info = {};
-    cmd_buf_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    cmd_buf_info.pNext = NULL;
-    cmd_buf_info.flags = 0;
-    cmd_buf_info.pInheritanceInfo = NULL;
+        VkCommandBufferBeginInfo cmd_buf_info = {};
+        cmd_buf_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        cmd_buf_info.pNext = NULL;
+        cmd_buf_info.flags = 0;
+        cmd_buf_info.pInheritanceInfo = NULL;
 
-    res = vkResetCommandBuffer(info.cmd, 0);
-    res = vkBeginCommandBuffer(info.cmd, &cmd_buf_info);
-    assert(res == VK_SUCCESS);
+        reset_command_pool(info);
+        res = info.device_dispatch.vkBeginCommandBuffer(info.cmd, &cmd_buf_info);
+        assert(res == VK_SUCCESS);
 
-    if (!texObj.needs_staging) {
         /* If we can use the linear tiled image as a texture, just do it */
-        texObj.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
         set_image_layout(info, texObj.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_PREINITIALIZED, texObj.imageLayout,
                          VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
-    } else {
-        /* Since we're going to blit to the texture image, set its layout to
-         * DESTINATION_OPTIMAL */
-        set_image_layout(info, texObj.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
-                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
-
-        VkBufferImageCopy copy_region;
-        copy_region.bufferOffset = 0;
-        copy_region.bufferRowLength = texObj.tex_width;
-        copy_region.bufferImageHeight = texObj.tex_height;
-        copy_region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        copy_region.imageSubresource.mipLevel = 0;
-        copy_region.imageSubresource.baseArrayLayer = 0;
-        copy_region.imageSubresource.layerCount = 1;
-        copy_region.imageOffset.x = 0;
-        copy_region.imageOffset.y = 0;
-        copy_region.imageOffset.z = 0;
-        copy_region.imageExtent.width = texObj.tex_width;
-        copy_region.imageExtent.height = texObj.tex_height;
-        copy_region.imageExtent.depth = 1;
-
-        /* Put the copy command into the command buffer */
-        vkCmdCopyBufferToImage(info.cmd, texObj.buffer, texObj.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy_region);
-
-        /* Set the layout for the texture image from DESTINATION_OPTIMAL to
-         * SHADER_READ_ONLY */
-        texObj.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        set_image_layout(info, texObj.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, texObj.imageLayout,
-                         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
     }
 
     VkImageViewCreateInfo view_info = {};
@@ -1951,7 +1963,7 @@ void init_image(struct sample_info &info, texture_object &texObj, const char *te
 
     /* create image view */
     view_info.image = texObj.image;
-    res = vkCreateImageView(info.device, &view_info, NULL, &texObj.view);
+    res = info.device_dispatch.vkCreateImageView(info.device, &view_info, NULL, &texObj.view);
     assert(res == VK_SUCCESS);
 }
 
@@ -1984,7 +1996,7 @@ void init_viewports(struct sample_info &info) {
     info.viewport.maxDepth = (float)1.0f;
     info.viewport.x = 0;
     info.viewport.y = 0;
-    vkCmdSetViewport(info.cmd, 0, NUM_VIEWPORTS, &info.viewport);
+    info.device_dispatch.vkCmdSetViewport(info.cmd, 0, NUM_VIEWPORTS, &info.viewport);
 #endif
 }
 
@@ -1997,7 +2009,7 @@ void init_scissors(struct sample_info &info) {
     info.scissor.extent.height = info.height;
     info.scissor.offset.x = 0;
     info.scissor.offset.y = 0;
-    vkCmdSetScissor(info.cmd, 0, NUM_SCISSORS, &info.scissor);
+    info.device_dispatch.vkCmdSetScissor(info.cmd, 0, NUM_SCISSORS, &info.scissor);
 #endif
 }
 
@@ -2006,7 +2018,7 @@ void init_fence(struct sample_info &info, VkFence &fence) {
     fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
     fenceInfo.pNext = NULL;
     fenceInfo.flags = 0;
-    vkCreateFence(info.device, &fenceInfo, NULL, &fence);
+    info.device_dispatch.vkCreateFence(info.device, &fenceInfo, NULL, &fence);
 }
 
 void init_submit_info(struct sample_info &info, VkSubmitInfo &submit_info, VkPipelineStageFlags &pipe_stage_flags) {
@@ -2054,75 +2066,114 @@ void init_render_pass_begin_info(struct sample_info &info, VkRenderPassBeginInfo
     rp_begin.pClearValues = nullptr;
 }
 
-void destroy_pipeline(struct sample_info &info) { vkDestroyPipeline(info.device, info.pipeline, NULL); }
+/*
+ * Pipelines, layouts and render passes come from info.object_cache, which
+ * hands the same object to every identical request and destroys them all in
+ * destroy_device(); these only drop the sample's reference.
+ */
+void destroy_pipeline(struct sample_info &info) { info.pipeline = VK_NULL_HANDLE; }
 
-void destroy_pipeline_cache(struct sample_info &info) { vkDestroyPipelineCache(info.device, info.pipelineCache, NULL); }
+void destroy_pipeline_cache(struct sample_info &info) {
+    /* Saves the cache for the next run before destroying it */
+    info.pipeline_cache.destroy();
+    info.pipelineCache = VK_NULL_HANDLE;
+}
 
 void destroy_uniform_buffer(struct sample_info &info) {
-    vkDestroyBuffer(info.device, info.uniform_data.buf, NULL);
-    vkFreeMemory(info.device, info.uniform_data.mem, NULL);
+    info.frame_ring.destroy();
+    info.uniform_data.allocation = RingAllocation{};
 }
 
 void destroy_descriptor_and_pipeline_layouts(struct sample_info &info) {
-    for (int i = 0; i < NUM_DESCRIPTOR_SETS; i++) vkDestroyDescriptorSetLayout(info.device, info.desc_layout[i], NULL);
-    vkDestroyPipelineLayout(info.device, info.pipeline_layout, NULL);
+    info.desc_layout.clear();
+    info.pipeline_layout = VK_NULL_HANDLE;
 }
 
-void destroy_descriptor_pool(struct sample_info &info) { vkDestroyDescriptorPool(info.device, info.desc_pool, NULL); }
+void destroy_descriptor_pool(struct sample_info &info) {
+    info.descriptor_allocator.destroy();
+    info.desc_set.clear();
+}
 
 void destroy_shaders(struct sample_info &info) {
-    vkDestroyShaderModule(info.device, info.shaderStages[0].module, NULL);
-    vkDestroyShaderModule(info.device, info.shaderStages[1].module, NULL);
+    /* The modules belong to info.object_cache: cached pipelines are keyed on
+     * their handles, so they live until the cache is destroyed */
+    info.shaderStages[0].module = VK_NULL_HANDLE;
+    info.shaderStages[1].module = VK_NULL_HANDLE;
 }
 
 void destroy_command_buffer(struct sample_info &info) {
-    VkCommandBuffer cmd_bufs[1] = {info.cmd};
-    vkFreeCommandBuffers(info.device, info.cmd_pool, 1, cmd_bufs);
+    /* Never freed on their own: destroy_command_pool() frees them with the pools */
+    info.cmd = VK_NULL_HANDLE;
+    info.upload_acquire_cmd = VK_NULL_HANDLE;
 }
 
-void destroy_command_pool(struct sample_info &info) { vkDestroyCommandPool(info.device, info.cmd_pool, NULL); }
+void destroy_command_pool(struct sample_info &info) {
+    info.device_dispatch.vkDestroyCommandPool(info.device, info.upload_acquire_pool, NULL);
+    info.device_dispatch.vkDestroyCommandPool(info.device, info.cmd_pool, NULL);
+}
 
+/*
+ * Resources that are recreated at run time (depth buffer, vertex buffer,
+ * swapchain, framebuffers, textures) are handed to the deletion queue with
+ * the last submitted value instead of being destroyed on the spot, so
+ * recreating them never needs an idle wait. Handles go through the
+ * VkObjectType form, the one 32-bit builds have.
+ */
 void destroy_depth_buffer(struct sample_info &info) {
-    vkDestroyImageView(info.device, info.depth.view, NULL);
-    vkDestroyImage(info.device, info.depth.image, NULL);
-    vkFreeMemory(info.device, info.depth.mem, NULL);
+    uint64_t last_use = info.graphics_timeline.last_submitted_value();
+    info.deletion_queue.push(VK_OBJECT_TYPE_IMAGE_VIEW, (uint64_t)info.depth.view, last_use);
+    info.deletion_queue.push(VK_OBJECT_TYPE_IMAGE, (uint64_t)info.depth.image, last_use);
+    info.deletion_queue.push(info.depth.allocation, last_use);
 }
 
 void destroy_vertex_buffer(struct sample_info &info) {
-    vkDestroyBuffer(info.device, info.vertex_buffer.buf, NULL);
-    vkFreeMemory(info.device, info.vertex_buffer.mem, NULL);
+    uint64_t last_use = info.graphics_timeline.last_submitted_value();
+    info.deletion_queue.push(VK_OBJECT_TYPE_BUFFER, (uint64_t)info.vertex_buffer.buf, last_use);
+    info.deletion_queue.push(info.vertex_buffer.allocation, last_use);
 }
 
 void destroy_swap_chain(struct sample_info &info) {
+    uint64_t last_use = info.graphics_timeline.last_submitted_value();
     for (uint32_t i = 0; i < info.swapchainImageCount; i++) {
-        vkDestroyImageView(info.device, info.buffers[i].view, NULL);
+        info.deletion_queue.push(VK_OBJECT_TYPE_IMAGE_VIEW, (uint64_t)info.buffers[i].view, last_use);
     }
-    vkDestroySwapchainKHR(info.device, info.swap_chain, NULL);
+    info.deletion_queue.push(VK_OBJECT_TYPE_SWAPCHAIN_KHR, (uint64_t)info.swap_chain, last_use);
 }
 
 void destroy_framebuffers(struct sample_info &info) {
+    uint64_t last_use = info.graphics_timeline.last_submitted_value();
     for (uint32_t i = 0; i < info.swapchainImageCount; i++) {
-        vkDestroyFramebuffer(info.device, info.framebuffers[i], NULL);
+        info.deletion_queue.push(VK_OBJECT_TYPE_FRAMEBUFFER, (uint64_t)info.framebuffers[i], last_use);
     }
     free(info.framebuffers);
 }
 
-void destroy_renderpass(struct sample_info &info) { vkDestroyRenderPass(info.device, info.render_pass, NULL); }
+void destroy_renderpass(struct sample_info &info) { info.render_pass = VK_NULL_HANDLE; }
 
 void destroy_device(struct sample_info &info) {
-    vkDeviceWaitIdle(info.device);
-    vkDestroyDevice(info.device, NULL);
+    info.device_dispatch.vkDeviceWaitIdle(info.device);
+    info.upload_engine.destroy();
+    info.descriptor_writer.destroy();
+    info.object_cache.destroy();
+    info.deletion_queue.destroy();
+    info.graphics_timeline.destroy();
+    info.memory_allocator.destroy();
+    info.device_dispatch.vkDestroyDevice(info.device, NULL);
+    destroy_device_dispatch(info.device_dispatch);
 }
 
-void destroy_instance(struct sample_info &info) { vkDestroyInstance(info.inst, NULL); }
+void destroy_instance(struct sample_info &info) {
+    info.instance_functions.vkDestroyInstance(info.inst, NULL);
+    unload_vulkan_library(info.vulkan_library);
+}
 
 void destroy_textures(struct sample_info &info) {
     for (size_t i = 0; i < info.textures.size(); i++) {
-        vkDestroySampler(info.device, info.textures[i].sampler, NULL);
-        vkDestroyImageView(info.device, info.textures[i].view, NULL);
-        vkDestroyImage(info.device, info.textures[i].image, NULL);
-        vkFreeMemory(info.device, info.textures[i].image_memory, NULL);
-        vkDestroyBuffer(info.device, info.textures[i].buffer, NULL);
-        vkFreeMemory(info.device, info.textures[i].buffer_memory, NULL);
+        uint64_t last_use = info.graphics_timeline.last_submitted_value();
+        info.deletion_queue.push(VK_OBJECT_TYPE_IMAGE_VIEW, (uint64_t)info.textures[i].view, last_use);
+        info.deletion_queue.push(VK_OBJECT_TYPE_IMAGE, (uint64_t)info.textures[i].image, last_use);
+        info.deletion_queue.push(info.textures[i].image_allocation, last_use);
+        info.deletion_queue.push(VK_OBJECT_TYPE_BUFFER, (uint64_t)info.textures[i].buffer, last_use);
+        info.deletion_queue.push(info.textures[i].buffer_allocation, last_use);
     }
 }
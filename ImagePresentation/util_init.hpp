@@ -25,7 +25,7 @@
 
 // Make sure functions start with init, execute, or destroy to assist codegen
 
-VkResult init_global_extension_properties(layer_properties &layer_props);
+VkResult init_global_extension_properties(struct sample_info &info, layer_properties &layer_props);
 
 VkResult init_global_layer_properties(sample_info &info);
 
@@ -52,6 +52,7 @@ void execute_present_image(struct sample_info &info);
 void init_swapchain_extension(struct sample_info &info);
 void init_command_pool(struct sample_info &info);
 void init_command_buffer(struct sample_info &info);
+void reset_command_pool(struct sample_info &info);
 void execute_begin_command_buffer(struct sample_info &info);
 void execute_end_command_buffer(struct sample_info &info);
 void execute_queue_command_buffer(struct sample_info &info);
@@ -62,6 +63,8 @@ void init_swap_chain(
                                    VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
 void init_depth_buffer(struct sample_info &info);
 void init_uniform_buffer(struct sample_info &info);
+void update_uniform_buffer(struct sample_info &info, uint32_t frame_index);
+void execute_bind_descriptor_sets(struct sample_info &info);
 void init_descriptor_and_pipeline_layouts(struct sample_info &info, bool use_texture,
                                           VkDescriptorSetLayoutCreateFlags descSetLayoutCreateFlags = 0);
 void init_renderpass(struct sample_info &info, bool include_depth, bool clear = true,
@@ -76,6 +79,9 @@ void init_descriptor_set(struct sample_info &info, bool use_texture);
 void init_shaders(struct sample_info &info, const VkShaderModuleCreateInfo *vertShaderCI,
                   const VkShaderModuleCreateInfo *fragShaderCI);
 void init_pipeline_cache(struct sample_info &info);
+void init_pipeline_description(struct sample_info &info, VkBool32 include_depth,
+                               VkBool32 include_vi,
+                               GraphicsPipelineDescription &description);
 void init_pipeline(struct sample_info &info, VkBool32 include_depth,
                    VkBool32 include_vi = true);
 void init_sampler(struct sample_info &info, VkSampler &sampler);